@@ -7,14 +7,35 @@
 
 #include <imgui.h>
 #include <reshade.hpp>
+#include "api_trace_buffer.hpp"
 #include <mutex>
-#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <algorithm>
 #include <unordered_set>
 #include <cassert>
 
+using api_trace::thread_buffer;
+
+/// <summary>
+/// Releases the buffer of a thread on thread exit, so that it can be reused by another one.
+/// </summary>
+struct thread_buffer_owner
+{
+	~thread_buffer_owner()
+	{
+		if (buffer != nullptr)
+			buffer->in_use.store(false, std::memory_order_release);
+	}
+
+	thread_buffer *buffer = nullptr;
+};
+
 namespace
 {
-	bool s_do_capture = false;
+	std::atomic<bool> s_do_capture = false;
 	std::vector<std::string> s_capture_log;
 	std::mutex s_mutex;
 
@@ -22,225 +43,160 @@ namespace
 	std::unordered_set<uint64_t> s_resources;
 	std::unordered_set<uint64_t> s_resource_views;
 	std::unordered_set<uint64_t> s_pipelines;
+
+	std::mutex s_thread_buffers_mutex;
+	std::vector<std::unique_ptr<thread_buffer>> s_thread_buffers;
+	thread_local thread_buffer_owner s_thread_buffer;
+
+	std::thread s_capture_thread;
+	std::atomic<bool> s_capture_finished = false;
+	api_trace::capture_header s_capture_header;
+	std::vector<api_trace::record> s_capture_records;
 }
 
-static inline auto to_string(reshade::api::shader_stage value)
+static thread_buffer *get_thread_buffer()
 {
-	switch (value)
+	if (s_thread_buffer.buffer != nullptr)
+		return s_thread_buffer.buffer;
+
+	const std::lock_guard<std::mutex> lock(s_thread_buffers_mutex);
+
+	thread_buffer *buffer = nullptr;
+
+	// Reuse buffer of a thread that exited and whose records were all read already
+	for (const std::unique_ptr<thread_buffer> &existing_buffer : s_thread_buffers)
 	{
-	case reshade::api::shader_stage::vertex:
-		return "vertex";
-	case reshade::api::shader_stage::hull:
-		return "hull";
-	case reshade::api::shader_stage::domain:
-		return "domain";
-	case reshade::api::shader_stage::geometry:
-		return "geometry";
-	case reshade::api::shader_stage::pixel:
-		return "pixel";
-	case reshade::api::shader_stage::compute:
-		return "compute";
-	case reshade::api::shader_stage::all:
-		return "all";
-	case reshade::api::shader_stage::all_graphics:
-		return "all_graphics";
-	default:
-		return "unknown";
+		if (!existing_buffer->in_use.load(std::memory_order_acquire) &&
+			existing_buffer->read_index.load(std::memory_order_acquire) == existing_buffer->write_index.load(std::memory_order_relaxed))
+		{
+			buffer = existing_buffer.get();
+			buffer->in_use.store(true, std::memory_order_relaxed);
+			break;
+		}
 	}
+
+	if (buffer == nullptr)
+		buffer = s_thread_buffers.emplace_back(std::make_unique<thread_buffer>()).get();
+
+	buffer->thread_id = GetCurrentThreadId();
+
+	return s_thread_buffer.buffer = buffer;
 }
-static inline auto to_string(reshade::api::pipeline_stage value)
+
+/// <summary>
+/// Writes a command to the trace buffer of the calling thread, followed by data records holding the specified additional data.
+/// This never blocks: If the capture thread cannot keep up and the buffer is full, the command is dropped.
+/// </summary>
+static void push_record(api_trace::record_type type, reshade::api::command_list *cmd_list, std::initializer_list<uint64_t> args, uint16_t count = 0, const void *data = nullptr, size_t data_size = 0)
 {
-	switch (value)
-	{
-	case reshade::api::pipeline_stage::vertex_shader:
-		return "vertex_shader";
-	case reshade::api::pipeline_stage::hull_shader:
-		return "hull_shader";
-	case reshade::api::pipeline_stage::domain_shader:
-		return "domain_shader";
-	case reshade::api::pipeline_stage::geometry_shader:
-		return "geometry_shader";
-	case reshade::api::pipeline_stage::pixel_shader:
-		return "pixel_shader";
-	case reshade::api::pipeline_stage::compute_shader:
-		return "compute_shader";
-	case reshade::api::pipeline_stage::input_assembler:
-		return "input_assembler";
-	case reshade::api::pipeline_stage::stream_output:
-		return "stream_output";
-	case reshade::api::pipeline_stage::rasterizer:
-		return "rasterizer";
-	case reshade::api::pipeline_stage::depth_stencil:
-		return "depth_stencil";
-	case reshade::api::pipeline_stage::output_merger:
-		return "output_merger";
-	case reshade::api::pipeline_stage::all:
-		return "all";
-	case reshade::api::pipeline_stage::all_graphics:
-		return "all_graphics";
-	case reshade::api::pipeline_stage::all_shader_stages:
-		return "all_shader_stages";
-	default:
-		return "unknown";
-	}
+	api_trace::write_records(*get_thread_buffer(), std::chrono::steady_clock::now().time_since_epoch().count(), type, reinterpret_cast<uintptr_t>(cmd_list), args, count, data, data_size);
 }
-static inline auto to_string(reshade::api::descriptor_type value)
+
+static void drain_thread_buffers(FILE *file)
 {
-	switch (value)
+	std::vector<thread_buffer *> buffers;
+	{	const std::lock_guard<std::mutex> lock(s_thread_buffers_mutex);
+
+		buffers.reserve(s_thread_buffers.size());
+		for (const std::unique_ptr<thread_buffer> &buffer : s_thread_buffers)
+			buffers.push_back(buffer.get());
+	}
+
+	for (thread_buffer *const buffer : buffers)
 	{
-	case reshade::api::descriptor_type::sampler:
-		return "sampler";
-	case reshade::api::descriptor_type::sampler_with_resource_view:
-		return "sampler_with_resource_view";
-	case reshade::api::descriptor_type::shader_resource_view:
-		return "shader_resource_view";
-	case reshade::api::descriptor_type::unordered_access_view:
-		return "unordered_access_view";
-	case reshade::api::descriptor_type::constant_buffer:
-		return "constant_buffer";
-	default:
-		return "unknown";
+		const size_t offset = s_capture_records.size();
+		if (api_trace::read_records(*buffer, s_capture_records) == 0)
+			continue;
+
+		s_capture_header.dropped_records += buffer->dropped_records.exchange(0, std::memory_order_relaxed);
+
+		if (file != nullptr)
+			fwrite(s_capture_records.data() + offset, sizeof(api_trace::record), s_capture_records.size() - offset, file);
 	}
 }
-static inline auto to_string(reshade::api::dynamic_state value)
+
+static void capture_thread_main(FILE *file)
 {
-	switch (value)
+	do
 	{
-	default:
-	case reshade::api::dynamic_state::unknown:
-		return "unknown";
-	case reshade::api::dynamic_state::alpha_test_enable:
-		return "alpha_test_enable";
-	case reshade::api::dynamic_state::alpha_reference_value:
-		return "alpha_reference_value";
-	case reshade::api::dynamic_state::alpha_func:
-		return "alpha_func";
-	case reshade::api::dynamic_state::srgb_write_enable:
-		return "srgb_write_enable";
-	case reshade::api::dynamic_state::primitive_topology:
-		return "primitive_topology";
-	case reshade::api::dynamic_state::sample_mask:
-		return "sample_mask";
-	case reshade::api::dynamic_state::alpha_to_coverage_enable:
-		return "alpha_to_coverage_enable";
-	case reshade::api::dynamic_state::blend_enable:
-		return "blend_enable";
-	case reshade::api::dynamic_state::logic_op_enable:
-		return "logic_op_enable";
-	case reshade::api::dynamic_state::color_blend_op:
-		return "color_blend_op";
-	case reshade::api::dynamic_state::source_color_blend_factor:
-		return "src_color_blend_factor";
-	case reshade::api::dynamic_state::dest_color_blend_factor:
-		return "dst_color_blend_factor";
-	case reshade::api::dynamic_state::alpha_blend_op:
-		return "alpha_blend_op";
-	case reshade::api::dynamic_state::source_alpha_blend_factor:
-		return "src_alpha_blend_factor";
-	case reshade::api::dynamic_state::dest_alpha_blend_factor:
-		return "dst_alpha_blend_factor";
-	case reshade::api::dynamic_state::logic_op:
-		return "logic_op";
-	case reshade::api::dynamic_state::blend_constant:
-		return "blend_constant";
-	case reshade::api::dynamic_state::render_target_write_mask:
-		return "render_target_write_mask";
-	case reshade::api::dynamic_state::fill_mode:
-		return "fill_mode";
-	case reshade::api::dynamic_state::cull_mode:
-		return "cull_mode";
-	case reshade::api::dynamic_state::front_counter_clockwise:
-		return "front_counter_clockwise";
-	case reshade::api::dynamic_state::depth_bias:
-		return "depth_bias";
-	case reshade::api::dynamic_state::depth_bias_clamp:
-		return "depth_bias_clamp";
-	case reshade::api::dynamic_state::depth_bias_slope_scaled:
-		return "depth_bias_slope_scaled";
-	case reshade::api::dynamic_state::depth_clip_enable:
-		return "depth_clip_enable";
-	case reshade::api::dynamic_state::scissor_enable:
-		return "scissor_enable";
-	case reshade::api::dynamic_state::multisample_enable:
-		return "multisample_enable";
-	case reshade::api::dynamic_state::antialiased_line_enable:
-		return "antialiased_line_enable";
-	case reshade::api::dynamic_state::depth_enable:
-		return "depth_enable";
-	case reshade::api::dynamic_state::depth_write_mask:
-		return "depth_write_mask";
-	case reshade::api::dynamic_state::depth_func:
-		return "depth_func";
-	case reshade::api::dynamic_state::stencil_enable:
-		return "stencil_enable";
-	case reshade::api::dynamic_state::stencil_read_mask:
-		return "stencil_read_mask";
-	case reshade::api::dynamic_state::stencil_write_mask:
-		return "stencil_write_mask";
-	case reshade::api::dynamic_state::stencil_reference_value:
-		return "stencil_reference_value";
-	case reshade::api::dynamic_state::front_stencil_func:
-		return "front_stencil_func";
-	case reshade::api::dynamic_state::front_stencil_pass_op:
-		return "front_stencil_pass_op";
-	case reshade::api::dynamic_state::front_stencil_fail_op:
-		return "front_stencil_fail_op";
-	case reshade::api::dynamic_state::front_stencil_depth_fail_op:
-		return "front_stencil_depth_fail_op";
-	case reshade::api::dynamic_state::back_stencil_func:
-		return "back_stencil_func";
-	case reshade::api::dynamic_state::back_stencil_pass_op:
-		return "back_stencil_pass_op";
-	case reshade::api::dynamic_state::back_stencil_fail_op:
-		return "back_stencil_fail_op";
-	case reshade::api::dynamic_state::back_stencil_depth_fail_op:
-		return "back_stencil_depth_fail_op";
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		drain_thread_buffers(file);
+	}
+	while (s_do_capture.load(std::memory_order_acquire));
+
+	// Pick up records that were written right before the capture was stopped
+	drain_thread_buffers(file);
+
+	if (file != nullptr)
+	{
+		s_capture_header.num_records = s_capture_records.size();
+
+		// Update header with the final record count
+		fseek(file, 0, SEEK_SET);
+		fwrite(&s_capture_header, sizeof(s_capture_header), 1, file);
+		fclose(file);
 	}
+
+	s_capture_finished.store(true, std::memory_order_release);
 }
-static inline auto to_string(reshade::api::resource_usage value)
+
+static void start_capture()
 {
-	switch (value)
-	{
-	default:
-	case reshade::api::resource_usage::undefined:
-		return "undefined";
-	case reshade::api::resource_usage::index_buffer:
-		return "index_buffer";
-	case reshade::api::resource_usage::vertex_buffer:
-		return "vertex_buffer";
-	case reshade::api::resource_usage::constant_buffer:
-		return "constant_buffer";
-	case reshade::api::resource_usage::stream_output:
-		return "stream_output";
-	case reshade::api::resource_usage::indirect_argument:
-		return "indirect_argument";
-	case reshade::api::resource_usage::depth_stencil:
-	case reshade::api::resource_usage::depth_stencil_read:
-	case reshade::api::resource_usage::depth_stencil_write:
-		return "depth_stencil";
-	case reshade::api::resource_usage::render_target:
-		return "render_target";
-	case reshade::api::resource_usage::shader_resource:
-	case reshade::api::resource_usage::shader_resource_pixel:
-	case reshade::api::resource_usage::shader_resource_non_pixel:
-		return "shader_resource";
-	case reshade::api::resource_usage::unordered_access:
-		return "unordered_access";
-	case reshade::api::resource_usage::copy_dest:
-		return "copy_dest";
-	case reshade::api::resource_usage::copy_source:
-		return "copy_source";
-	case reshade::api::resource_usage::resolve_dest:
-		return "resolve_dest";
-	case reshade::api::resource_usage::resolve_source:
-		return "resolve_source";
-	case reshade::api::resource_usage::general:
-		return "general";
-	case reshade::api::resource_usage::present:
-		return "present";
-	case reshade::api::resource_usage::cpu_access:
-		return "cpu_access";
+	s_capture_log.clear();
+	s_capture_records.clear();
+
+	s_capture_header = {};
+	s_capture_header.ticks_per_second = std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
+
+	// Discard anything that was written after the last capture was stopped
+	{	const std::lock_guard<std::mutex> lock(s_thread_buffers_mutex);
+
+		for (const std::unique_ptr<thread_buffer> &buffer : s_thread_buffers)
+		{
+			buffer->read_index.store(buffer->write_index.load(std::memory_order_acquire), std::memory_order_release);
+			buffer->dropped_records.store(0, std::memory_order_relaxed);
+		}
 	}
+
+	FILE *file = nullptr;
+	if (fopen_s(&file, "api_trace.bin", "wb") == 0)
+		fwrite(&s_capture_header, sizeof(s_capture_header), 1, file);
+	else
+		reshade::log_message(2, "Failed to open capture file \"api_trace.bin\" for writing.");
+
+	s_capture_finished.store(false, std::memory_order_relaxed);
+	s_do_capture.store(true, std::memory_order_release);
+
+	s_capture_thread = std::thread(capture_thread_main, file);
+}
+
+static void finish_capture()
+{
+	s_capture_thread.join();
+
+	// Records are in order per thread, so sort them to get the order between threads (keeping data records after the command they belong to)
+	std::stable_sort(s_capture_records.begin(), s_capture_records.end(),
+		[](const api_trace::record &lhs, const api_trace::record &rhs) {
+			return lhs.timestamp < rhs.timestamp || (lhs.timestamp == rhs.timestamp && lhs.thread_id < rhs.thread_id);
+		});
+
+	s_capture_log.reserve(s_capture_records.size());
+	for (const api_trace::record *it = s_capture_records.data(), *end = it + s_capture_records.size(); it != end;)
+		s_capture_log.push_back(api_trace::format_record(it, end));
+}
+
+/// <summary>
+/// Stops a capture that is still in progress (e.g. because no more frames are presented) and waits for the capture thread to exit.
+/// </summary>
+static void stop_capture()
+{
+	if (!s_capture_thread.joinable())
+		return;
+
+	s_do_capture.store(false, std::memory_order_release);
+
+	finish_capture();
 }
 
 static void on_init_swapchain(reshade::api::swapchain *swapchain)
@@ -273,6 +229,14 @@ static void on_destroy_swapchain(reshade::api::swapchain *swapchain)
 			s_resource_views.erase(buffer.handle);
 	}
 }
+static void on_destroy_device(reshade::api::device *)
+{
+	stop_capture();
+}
+static void on_destroy_effect_runtime(reshade::api::effect_runtime *)
+{
+	stop_capture();
+}
 static void on_init_sampler(reshade::api::device *device, const reshade::api::sampler_desc &desc, reshade::api::sampler handle)
 {
 	const std::lock_guard<std::mutex> lock(s_mutex);
@@ -327,113 +291,110 @@ static void on_destroy_pipeline(reshade::api::device *device, reshade::api::pipe
 	s_pipelines.erase(handle.handle);
 }
 
-static void on_barrier(reshade::api::command_list *, uint32_t num_resources, const reshade::api::resource *resources, const reshade::api::resource_usage *old_states, const reshade::api::resource_usage *new_states)
+
+static void on_barrier(reshade::api::command_list *cmd_list, uint32_t num_resources, const reshade::api::resource *resources, const reshade::api::resource_usage *old_states, const reshade::api::resource_usage *new_states)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
-	for (uint32_t i = 0; i < num_resources; ++i)
-		assert(resources[i] == 0 || s_resources.find(resources[i].handle) != s_resources.end());
+#ifndef NDEBUG
+	{	const std::lock_guard<std::mutex> lock(s_mutex);
+
+		for (uint32_t i = 0; i < num_resources; ++i)
+			assert(resources[i] == 0 || s_resources.find(resources[i].handle) != s_resources.end());
+	}
+#endif
 
-	std::stringstream s;
 	for (uint32_t i = 0; i < num_resources; ++i)
-		s << "barrier(" << (void *)resources[i].handle << ", " << to_string(old_states[i]) << ", " << to_string(new_states[i]) << ")" << std::endl;
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+		push_record(api_trace::record_type::barrier, cmd_list, { resources[i].handle, static_cast<uint64_t>(old_states[i]), static_cast<uint64_t>(new_states[i]) });
 }
 
-static void on_begin_render_pass(reshade::api::command_list *, uint32_t count, const reshade::api::render_pass_render_target_desc *rts, const reshade::api::render_pass_depth_stencil_desc *ds)
+static void on_begin_render_pass(reshade::api::command_list *cmd_list, uint32_t count, const reshade::api::render_pass_render_target_desc *rts, const reshade::api::render_pass_depth_stencil_desc *ds)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
-	std::stringstream s; s << "begin_render_pass(" << count << ", { ";
-	for (uint32_t i = 0; i < count; ++i)
-		s << (void *)rts[i].view.handle << ", ";
-	s << " }, " << (ds != nullptr ? (void *)ds->view.handle : 0) << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	uint64_t rtvs[8] = {};
+	for (uint32_t i = 0; i < count && i < 8; ++i)
+		rtvs[i] = rts[i].view.handle;
+
+	push_record(api_trace::record_type::begin_render_pass, cmd_list, { ds != nullptr ? ds->view.handle : 0 }, static_cast<uint16_t>(count), rtvs, std::min(count, 8u) * sizeof(uint64_t));
 }
-static void on_end_render_pass(reshade::api::command_list *)
+static void on_end_render_pass(reshade::api::command_list *cmd_list)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
-	std::stringstream s; s << "end_render_pass()";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::end_render_pass, cmd_list, {});
 }
-static void on_bind_render_targets_and_depth_stencil(reshade::api::command_list *, uint32_t count, const reshade::api::resource_view *rtvs, reshade::api::resource_view dsv)
+static void on_bind_render_targets_and_depth_stencil(reshade::api::command_list *cmd_list, uint32_t count, const reshade::api::resource_view *rtvs, reshade::api::resource_view dsv)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		for (uint32_t i = 0; i < count; ++i)
 			assert(rtvs[i] == 0 || s_resource_views.find(rtvs[i].handle) != s_resource_views.end());
 		assert(dsv == 0 || s_resource_views.find(dsv.handle) != s_resource_views.end());
 	}
+#endif
 
-	std::stringstream s; s << "bind_render_targets_and_depth_stencil(" << count << ", { ";
-	for (uint32_t i = 0; i < count; ++i)
-		s << (void *)rtvs[i].handle << ", ";
-	s << " }, " << (void *)dsv.handle << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	static_assert(sizeof(reshade::api::resource_view) == sizeof(uint64_t));
+
+	push_record(api_trace::record_type::bind_render_targets_and_depth_stencil, cmd_list, { dsv.handle }, static_cast<uint16_t>(count), rtvs, count * sizeof(uint64_t));
 }
 
-static void on_bind_pipeline(reshade::api::command_list *, reshade::api::pipeline_stage type, reshade::api::pipeline pipeline)
+static void on_bind_pipeline(reshade::api::command_list *cmd_list, reshade::api::pipeline_stage type, reshade::api::pipeline pipeline)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(pipeline.handle == 0 || s_pipelines.find(pipeline.handle) != s_pipelines.end());
 	}
+#endif
 
-	std::stringstream s; s << "bind_pipeline(" << to_string(type) << ", " << (void *)pipeline.handle << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::bind_pipeline, cmd_list, { static_cast<uint64_t>(type), pipeline.handle });
 }
-static void on_bind_pipeline_states(reshade::api::command_list *, uint32_t count, const reshade::api::dynamic_state *states, const uint32_t *values)
+static void on_bind_pipeline_states(reshade::api::command_list *cmd_list, uint32_t count, const reshade::api::dynamic_state *states, const uint32_t *values)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
-	std::stringstream s;
 	for (uint32_t i = 0; i < count; ++i)
-		s << "bind_pipeline_state(" << to_string(states[i]) << ", " << values[i] << ")" << std::endl;
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+		push_record(api_trace::record_type::bind_pipeline_state, cmd_list, { static_cast<uint64_t>(states[i]), values[i] });
 }
-static void on_bind_viewports(reshade::api::command_list *, uint32_t first, uint32_t count, const reshade::api::viewport *viewports)
+static void on_bind_viewports(reshade::api::command_list *cmd_list, uint32_t first, uint32_t count, const reshade::api::viewport *viewports)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
-	std::stringstream s; s << "bind_viewports(" << first << ", " << count << ", { ... })";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::bind_viewports, cmd_list, { first, count });
 }
-static void on_bind_scissor_rects(reshade::api::command_list *, uint32_t first, uint32_t count, const reshade::api::rect *rects)
+static void on_bind_scissor_rects(reshade::api::command_list *cmd_list, uint32_t first, uint32_t count, const reshade::api::rect *rects)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
-	std::stringstream s; s << "bind_scissor_rects(" << first << ", " << count << ", { ... })";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::bind_scissor_rects, cmd_list, { first, count });
 }
-static void on_push_constants(reshade::api::command_list *, reshade::api::shader_stage stages, reshade::api::pipeline_layout layout, uint32_t param_index, uint32_t first, uint32_t count, const uint32_t *values)
+static void on_push_constants(reshade::api::command_list *cmd_list, reshade::api::shader_stage stages, reshade::api::pipeline_layout layout, uint32_t param_index, uint32_t first, uint32_t count, const uint32_t *values)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
-	std::stringstream s; s << "push_constants(" << to_string(stages) << ", " << (void *)layout.handle << ", " << param_index << ", " << first << ", " << count << ", { ";
-	for (uint32_t i = 0; i < count; ++i)
-		s << std::hex << values[i] << std::dec << ", ";
-	s << " })";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::push_constants, cmd_list, { static_cast<uint64_t>(stages), layout.handle, param_index, first }, static_cast<uint16_t>(count), values, count * sizeof(uint32_t));
 }
-static void on_push_descriptors(reshade::api::command_list *, reshade::api::shader_stage stages, reshade::api::pipeline_layout layout, uint32_t param_index, const reshade::api::descriptor_set_update &update)
+static void on_push_descriptors(reshade::api::command_list *cmd_list, reshade::api::shader_stage stages, reshade::api::pipeline_layout layout, uint32_t param_index, const reshade::api::descriptor_set_update &update)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		switch (update.type)
@@ -459,311 +420,312 @@ static void on_push_descriptors(reshade::api::command_list *, reshade::api::shad
 			break;
 		}
 	}
+#endif
 
-	std::stringstream s; s << "push_descriptors(" << to_string(stages) << ", " << (void *)layout.handle << ", " << param_index << ", { " << to_string(update.type) << ", " << update.binding << ", " << update.count << " })";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::push_descriptors, cmd_list, { static_cast<uint64_t>(stages), layout.handle, param_index, static_cast<uint64_t>(update.type), api_trace::pack(update.binding, update.count) });
 }
-static void on_bind_descriptor_sets(reshade::api::command_list *, reshade::api::shader_stage stages, reshade::api::pipeline_layout layout, uint32_t first, uint32_t count, const reshade::api::descriptor_set *sets)
+static void on_bind_descriptor_sets(reshade::api::command_list *cmd_list, reshade::api::shader_stage stages, reshade::api::pipeline_layout layout, uint32_t first, uint32_t count, const reshade::api::descriptor_set *sets)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
-	std::stringstream s;
 	for (uint32_t i = 0; i < count; ++i)
-		s << "bind_descriptor_set(" << to_string(stages) << ", " << (void *)layout.handle << ", " << (first + i) << ", " << (void *)sets[i].handle << ")" << std::endl;
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+		push_record(api_trace::record_type::bind_descriptor_set, cmd_list, { static_cast<uint64_t>(stages), layout.handle, first + i, sets[i].handle });
 }
-static void on_bind_index_buffer(reshade::api::command_list *, reshade::api::resource buffer, uint64_t offset, uint32_t index_size)
+static void on_bind_index_buffer(reshade::api::command_list *cmd_list, reshade::api::resource buffer, uint64_t offset, uint32_t index_size)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(buffer.handle == 0 || s_resources.find(buffer.handle) != s_resources.end());
 	}
+#endif
 
-	std::stringstream s; s << "bind_index_buffer(" << (void *)buffer.handle << ", " << offset << ", " << index_size << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::bind_index_buffer, cmd_list, { buffer.handle, offset, index_size });
 }
-static void on_bind_vertex_buffers(reshade::api::command_list *, uint32_t first, uint32_t count, const reshade::api::resource *buffers, const uint64_t *offsets, const uint32_t *strides)
+static void on_bind_vertex_buffers(reshade::api::command_list *cmd_list, uint32_t first, uint32_t count, const reshade::api::resource *buffers, const uint64_t *offsets, const uint32_t *strides)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		for (uint32_t i = 0; i < count; ++i)
 			assert(buffers[i].handle == 0 || s_resources.find(buffers[i].handle) != s_resources.end());
 	}
+#endif
 
-	std::stringstream s;
 	for (uint32_t i = 0; i < count; ++i)
-		s << "bind_vertex_buffer(" << (first + i) << ", " << (void *)buffers[i].handle << ", " << (offsets != nullptr ? offsets[i] : 0) << ", " << (strides != nullptr ? strides[i] : 0) << ")" << std::endl;
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+		push_record(api_trace::record_type::bind_vertex_buffer, cmd_list, { first + i, buffers[i].handle, offsets != nullptr ? offsets[i] : 0, strides != nullptr ? strides[i] : 0u });
 }
 
-static bool on_draw(reshade::api::command_list *, uint32_t vertices, uint32_t instances, uint32_t first_vertex, uint32_t first_instance)
+static bool on_draw(reshade::api::command_list *cmd_list, uint32_t vertices, uint32_t instances, uint32_t first_vertex, uint32_t first_instance)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
-	std::stringstream s; s << "draw(" << vertices << ", " << instances << ", " << first_vertex << ", " << first_instance << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::draw, cmd_list, { vertices, instances, first_vertex, first_instance });
 
 	return false;
 }
-static bool on_draw_indexed(reshade::api::command_list *, uint32_t indices, uint32_t instances, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
+static bool on_draw_indexed(reshade::api::command_list *cmd_list, uint32_t indices, uint32_t instances, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
-	std::stringstream s; s << "draw_indexed(" << indices << ", " << instances << ", " << first_index << ", " << vertex_offset << ", " << first_instance << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::draw_indexed, cmd_list, { indices, instances, first_index, static_cast<uint32_t>(vertex_offset), first_instance });
 
 	return false;
 }
-static bool on_dispatch(reshade::api::command_list *, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+static bool on_dispatch(reshade::api::command_list *cmd_list, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
-	std::stringstream s; s << "dispatch(" << group_count_x << ", " << group_count_y << ", " << group_count_z << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::dispatch, cmd_list, { group_count_x, group_count_y, group_count_z });
 
 	return false;
 }
-static bool on_draw_or_dispatch_indirect(reshade::api::command_list *, reshade::api::indirect_command type, reshade::api::resource buffer, uint64_t offset, uint32_t draw_count, uint32_t stride)
+static bool on_draw_or_dispatch_indirect(reshade::api::command_list *cmd_list, reshade::api::indirect_command type, reshade::api::resource buffer, uint64_t offset, uint32_t draw_count, uint32_t stride)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
-	std::stringstream s;
-	switch (type)
-	{
-	case reshade::api::indirect_command::unknown:
-		s << "draw_or_dispatch_indirect(" << (void *)buffer.handle << ", " << offset << ", " << draw_count << ", " << stride << ")";
-		break;
-	case reshade::api::indirect_command::draw:
-		s << "draw_indirect(" << (void *)buffer.handle << ", " << offset << ", " << draw_count << ", " << stride << ")";
-		break;
-	case reshade::api::indirect_command::draw_indexed:
-		s << "draw_indexed_indirect(" << (void *)buffer.handle << ", " << offset << ", " << draw_count << ", " << stride << ")";
-		break;
-	case reshade::api::indirect_command::dispatch:
-		s << "dispatch_indirect(" << (void *)buffer.handle << ", " << offset << ", " << draw_count << ", " << stride << ")";
-		break;
-	}
-
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::draw_or_dispatch_indirect, cmd_list, { static_cast<uint64_t>(type), buffer.handle, offset, draw_count, stride });
 
 	return false;
 }
 
-static bool on_copy_resource(reshade::api::command_list *, reshade::api::resource src, reshade::api::resource dst)
+static bool on_copy_resource(reshade::api::command_list *cmd_list, reshade::api::resource src, reshade::api::resource dst)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resources.find(src.handle) != s_resources.end());
 		assert(s_resources.find(dst.handle) != s_resources.end());
 	}
+#endif
 
-	std::stringstream s; s << "copy_resource(" << (void *)src.handle << ", " << (void *)dst.handle << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::copy_resource, cmd_list, { src.handle, dst.handle });
 
 	return false;
 }
-static bool on_copy_buffer_region(reshade::api::command_list *, reshade::api::resource src, uint64_t src_offset, reshade::api::resource dst, uint64_t dst_offset, uint64_t size)
+static bool on_copy_buffer_region(reshade::api::command_list *cmd_list, reshade::api::resource src, uint64_t src_offset, reshade::api::resource dst, uint64_t dst_offset, uint64_t size)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resources.find(src.handle) != s_resources.end());
 		assert(s_resources.find(dst.handle) != s_resources.end());
 	}
+#endif
 
-	std::stringstream s; s << "copy_buffer_region(" << (void *)src.handle << ", " << src_offset << ", " << (void *)dst.handle << ", " << dst_offset << ", " << size << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::copy_buffer_region, cmd_list, { src.handle, src_offset, dst.handle, dst_offset, size });
 
 	return false;
 }
-static bool on_copy_buffer_to_texture(reshade::api::command_list *, reshade::api::resource src, uint64_t src_offset, uint32_t row_length, uint32_t slice_height, reshade::api::resource dst, uint32_t dst_subresource, const reshade::api::subresource_box *)
+static bool on_copy_buffer_to_texture(reshade::api::command_list *cmd_list, reshade::api::resource src, uint64_t src_offset, uint32_t row_length, uint32_t slice_height, reshade::api::resource dst, uint32_t dst_subresource, const reshade::api::subresource_box *)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resources.find(src.handle) != s_resources.end());
 		assert(s_resources.find(dst.handle) != s_resources.end());
 	}
+#endif
 
-	std::stringstream s; s << "copy_buffer_to_texture(" << (void *)src.handle << ", " << src_offset << ", " << row_length << ", " << slice_height << ", " << (void *)dst.handle << ", " << dst_subresource << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::copy_buffer_to_texture, cmd_list, { src.handle, src_offset, api_trace::pack(row_length, slice_height), dst.handle, dst_subresource });
 
 	return false;
 }
-static bool on_copy_texture_region(reshade::api::command_list *, reshade::api::resource src, uint32_t src_subresource, const reshade::api::subresource_box *, reshade::api::resource dst, uint32_t dst_subresource, const reshade::api::subresource_box *, reshade::api::filter_mode filter)
+static bool on_copy_texture_region(reshade::api::command_list *cmd_list, reshade::api::resource src, uint32_t src_subresource, const reshade::api::subresource_box *, reshade::api::resource dst, uint32_t dst_subresource, const reshade::api::subresource_box *, reshade::api::filter_mode filter)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resources.find(src.handle) != s_resources.end());
 		assert(s_resources.find(dst.handle) != s_resources.end());
 	}
+#endif
 
-	std::stringstream s; s << "copy_texture_region(" << (void *)src.handle << ", " << src_subresource << ", " << (void *)dst.handle << ", " << dst_subresource << ", " << (uint32_t)filter << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::copy_texture_region, cmd_list, { src.handle, src_subresource, dst.handle, dst_subresource, static_cast<uint64_t>(filter) });
 
 	return false;
 }
-static bool on_copy_texture_to_buffer(reshade::api::command_list *, reshade::api::resource src, uint32_t src_subresource, const reshade::api::subresource_box *, reshade::api::resource dst, uint64_t dst_offset, uint32_t row_length, uint32_t slice_height)
+static bool on_copy_texture_to_buffer(reshade::api::command_list *cmd_list, reshade::api::resource src, uint32_t src_subresource, const reshade::api::subresource_box *, reshade::api::resource dst, uint64_t dst_offset, uint32_t row_length, uint32_t slice_height)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resources.find(src.handle) != s_resources.end());
 		assert(s_resources.find(dst.handle) != s_resources.end());
 	}
+#endif
 
-	std::stringstream s; s << "copy_texture_to_buffer(" << (void *)src.handle << ", " << src_subresource << ", " << (void *)dst.handle << ", " << dst_offset << ", " << row_length << ", " << slice_height << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::copy_texture_to_buffer, cmd_list, { src.handle, src_subresource, dst.handle, dst_offset, api_trace::pack(row_length, slice_height) });
 
 	return false;
 }
-static bool on_resolve_texture_region(reshade::api::command_list *, reshade::api::resource src, uint32_t src_subresource, const reshade::api::subresource_box *, reshade::api::resource dst, uint32_t dst_subresource, int32_t dst_x, int32_t dst_y, int32_t dst_z, reshade::api::format format)
+static bool on_resolve_texture_region(reshade::api::command_list *cmd_list, reshade::api::resource src, uint32_t src_subresource, const reshade::api::subresource_box *, reshade::api::resource dst, uint32_t dst_subresource, int32_t dst_x, int32_t dst_y, int32_t dst_z, reshade::api::format format)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resources.find(src.handle) != s_resources.end());
 		assert(s_resources.find(dst.handle) != s_resources.end());
 	}
+#endif
 
-	std::stringstream s; s << "resolve_texture_region(" << (void *)src.handle << ", " << src_subresource << ", { ... }, " << (void *)dst.handle << ", " << dst_subresource << ", " << dst_x << ", " << dst_y << ", " << dst_z << ", " << (uint32_t)format << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::resolve_texture_region, cmd_list, { src.handle, api_trace::pack(src_subresource, dst_subresource), dst.handle, api_trace::pack(static_cast<uint32_t>(dst_x), static_cast<uint32_t>(dst_y)), api_trace::pack(static_cast<uint32_t>(dst_z), static_cast<uint32_t>(format)) });
 
 	return false;
 }
 
-static bool on_clear_depth_stencil_view(reshade::api::command_list *, reshade::api::resource_view dsv, const float *depth, const uint8_t *stencil, uint32_t, const reshade::api::rect *)
+static bool on_clear_depth_stencil_view(reshade::api::command_list *cmd_list, reshade::api::resource_view dsv, const float *depth, const uint8_t *stencil, uint32_t, const reshade::api::rect *)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resource_views.find(dsv.handle) != s_resource_views.end());
 	}
+#endif
 
-	std::stringstream s; s << "clear_depth_stencil_view(" << (void *)dsv.handle << ", " << (depth != nullptr ? *depth : 0.0f) << ", " << (stencil != nullptr ? *stencil : 0) << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::clear_depth_stencil_view, cmd_list, { dsv.handle, api_trace::pack(depth != nullptr ? *depth : 0.0f, 0.0f), stencil != nullptr ? *stencil : 0u });
 
 	return false;
 }
-static bool on_clear_render_target_view(reshade::api::command_list *, reshade::api::resource_view rtv, const float color[4], uint32_t, const reshade::api::rect *)
+static bool on_clear_render_target_view(reshade::api::command_list *cmd_list, reshade::api::resource_view rtv, const float color[4], uint32_t, const reshade::api::rect *)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resource_views.find(rtv.handle) != s_resource_views.end());
 	}
+#endif
 
-	std::stringstream s; s << "clear_render_target_view(" << (void *)rtv.handle << ", { " << color[0] << ", " << color[1] << ", " << color[2] << ", " << color[3] << " })";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::clear_render_target_view, cmd_list, { rtv.handle, api_trace::pack(color[0], color[1]), api_trace::pack(color[2], color[3]) });
 
 	return false;
 }
-static bool on_clear_unordered_access_view_uint(reshade::api::command_list *, reshade::api::resource_view uav, const uint32_t values[4], uint32_t, const reshade::api::rect *)
+static bool on_clear_unordered_access_view_uint(reshade::api::command_list *cmd_list, reshade::api::resource_view uav, const uint32_t values[4], uint32_t, const reshade::api::rect *)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resource_views.find(uav.handle) != s_resource_views.end());
 	}
+#endif
 
-	std::stringstream s; s << "clear_unordered_access_view_uint(" << (void *)uav.handle << ", { " << values[0] << ", " << values[1] << ", " << values[2] << ", " << values[3] << " })";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::clear_unordered_access_view_uint, cmd_list, { uav.handle, api_trace::pack(values[0], values[1]), api_trace::pack(values[2], values[3]) });
 
 	return false;
 }
-static bool on_clear_unordered_access_view_float(reshade::api::command_list *, reshade::api::resource_view uav, const float values[4], uint32_t, const reshade::api::rect *)
+static bool on_clear_unordered_access_view_float(reshade::api::command_list *cmd_list, reshade::api::resource_view uav, const float values[4], uint32_t, const reshade::api::rect *)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resource_views.find(uav.handle) != s_resource_views.end());
 	}
+#endif
 
-	std::stringstream s; s << "clear_unordered_access_view_float(" << (void *)uav.handle << ", { " << values[0] << ", " << values[1] << ", " << values[2] << ", " << values[3] << " })";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::clear_unordered_access_view_float, cmd_list, { uav.handle, api_trace::pack(values[0], values[1]), api_trace::pack(values[2], values[3]) });
 
 	return false;
 }
 
-static bool on_generate_mipmaps(reshade::api::command_list *, reshade::api::resource_view srv)
+static bool on_generate_mipmaps(reshade::api::command_list *cmd_list, reshade::api::resource_view srv)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return false;
 
+#ifndef NDEBUG
 	{	const std::lock_guard<std::mutex> lock(s_mutex);
 
 		assert(s_resource_views.find(srv.handle) != s_resource_views.end());
 	}
+#endif
 
-	std::stringstream s; s << "generate_mipmaps(" << (void *)srv.handle << ")";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::generate_mipmaps, cmd_list, { srv.handle });
 
 	return false;
 }
 
 static void on_present(reshade::api::command_queue *, reshade::api::swapchain *, const reshade::api::rect *, const reshade::api::rect *, uint32_t, const reshade::api::rect *)
 {
-	if (!s_do_capture)
+	if (!s_do_capture.load(std::memory_order_relaxed))
 		return;
 
-	std::stringstream s; s << "present()";
-	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+	push_record(api_trace::record_type::present, nullptr, {});
 
-	s_do_capture = false;
+	s_do_capture.store(false, std::memory_order_release);
 }
 
 static void draw_overlay(reshade::api::effect_runtime *)
 {
-	if (!s_do_capture)
+	if (s_capture_thread.joinable())
 	{
-		if (ImGui::Button("Capture Frame"))
-		{
-			s_capture_log.clear();
-			s_do_capture = true;
-		}
-		else
+		if (!s_capture_finished.load(std::memory_order_acquire))
+			return;
+
+		finish_capture();
+	}
+
+	if (ImGui::Button("Capture Frame"))
+	{
+		start_capture();
+	}
+	else
+	{
+		ImGui::SameLine(0.0f, -1.0f);
+		ImGui::Text("%zu records (%llu dropped)", s_capture_records.size(), s_capture_header.dropped_records);
+
+		if (ImGui::BeginChild("log", ImVec2(0, 0), true, ImGuiWindowFlags_AlwaysHorizontalScrollbar))
 		{
-			if (ImGui::BeginChild("log", ImVec2(0, 0), true, ImGuiWindowFlags_AlwaysHorizontalScrollbar))
+			ImGuiListClipper clipper;
+			clipper.Begin(static_cast<int>(s_capture_log.size()), -1.0f);
+			while (clipper.Step())
 			{
-				for (size_t i = 0; i < s_capture_log.size(); ++i)
+				for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
 				{
 					ImGui::TextUnformatted(s_capture_log[i].c_str(), s_capture_log[i].c_str() + s_capture_log[i].size());
 				}
-			} ImGui::EndChild();
-		}
+			}
+		} ImGui::EndChild();
 	}
 }
 
@@ -782,6 +744,8 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 
 		reshade::register_event<reshade::addon_event::init_swapchain>(on_init_swapchain);
 		reshade::register_event<reshade::addon_event::destroy_swapchain>(on_destroy_swapchain);
+		reshade::register_event<reshade::addon_event::destroy_device>(on_destroy_device);
+		reshade::register_event<reshade::addon_event::destroy_effect_runtime>(on_destroy_effect_runtime);
 		reshade::register_event<reshade::addon_event::init_sampler>(on_init_sampler);
 		reshade::register_event<reshade::addon_event::destroy_sampler>(on_destroy_sampler);
 		reshade::register_event<reshade::addon_event::init_resource>(on_init_resource);
@@ -823,6 +787,12 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 		reshade::register_event<reshade::addon_event::present>(on_present);
 		break;
 	case DLL_PROCESS_DETACH:
+		// The capture thread is usually stopped when the effect runtime or device is destroyed already, but if not, tell it to stop
+		// Cannot wait for it while holding the loader lock though, so let it go (it exits after its next drain of the buffers)
+		s_do_capture.store(false, std::memory_order_release);
+		if (s_capture_thread.joinable())
+			s_capture_thread.detach();
+
 		reshade::unregister_addon(hModule);
 		break;
 	}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include "api_trace_records.hpp"
+#include <atomic>
+#include <algorithm>
+#include <initializer_list>
+
+namespace api_trace
+{
+	/// <summary>
+	/// Ring buffer of trace records written by a single application thread and read by the capture thread.
+	/// </summary>
+	struct thread_buffer
+	{
+		static constexpr uint32_t capacity = 4096; // Has to be a power of two
+
+		uint32_t thread_id = 0;
+		std::atomic<bool> in_use = true;
+		std::atomic<uint32_t> read_index = 0;
+		std::atomic<uint32_t> write_index = 0;
+		std::atomic<uint32_t> dropped_records = 0;
+		record records[capacity];
+	};
+
+	/// <summary>
+	/// Writes a command to the specified buffer, followed by data records holding the specified additional data.
+	/// This may only be called by the thread owning the buffer. It never blocks: If the reader cannot keep up and the buffer is full, the command is dropped.
+	/// </summary>
+	inline void write_records(thread_buffer &buffer, uint64_t timestamp, record_type type, uint64_t cmd_list, std::initializer_list<uint64_t> args, uint16_t count = 0, const void *data = nullptr, size_t data_size = 0)
+	{
+		constexpr size_t data_size_per_record = sizeof(record::args);
+		const uint32_t num_records = 1 + static_cast<uint32_t>((data_size + data_size_per_record - 1) / data_size_per_record);
+
+		const uint32_t write_index = buffer.write_index.load(std::memory_order_relaxed);
+		if (write_index - buffer.read_index.load(std::memory_order_acquire) + num_records > thread_buffer::capacity)
+		{
+			buffer.dropped_records.fetch_add(num_records, std::memory_order_relaxed);
+			return;
+		}
+
+		for (uint32_t i = 0; i < num_records; ++i)
+		{
+			record &record = buffer.records[(write_index + i) & (thread_buffer::capacity - 1)];
+			record.timestamp = timestamp;
+			record.cmd_list = cmd_list;
+			record.thread_id = buffer.thread_id;
+			std::memset(record.args, 0, sizeof(record.args));
+
+			if (i == 0)
+			{
+				record.type = type;
+				record.count = count;
+				std::copy_n(args.begin(), std::min(args.size(), std::size(record.args)), record.args);
+			}
+			else
+			{
+				const size_t offset = (i - 1) * data_size_per_record;
+				const size_t size = std::min(data_size - offset, data_size_per_record);
+
+				record.type = record_type::data;
+				record.count = static_cast<uint16_t>((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+				std::memcpy(record.args, static_cast<const uint8_t *>(data) + offset, size);
+			}
+		}
+
+		buffer.write_index.store(write_index + num_records, std::memory_order_release);
+	}
+
+	/// <summary>
+	/// Appends all records that were written to the specified buffer since the last call to <paramref name="records"/>.
+	/// This may only be called by a single reader thread at a time.
+	/// </summary>
+	/// <returns>The number of records that were appended.</returns>
+	inline size_t read_records(thread_buffer &buffer, std::vector<record> &records)
+	{
+		const uint32_t read_index = buffer.read_index.load(std::memory_order_relaxed);
+		const uint32_t write_index = buffer.write_index.load(std::memory_order_acquire);
+
+		for (uint32_t i = read_index; i != write_index; ++i)
+			records.push_back(buffer.records[i & (thread_buffer::capacity - 1)]);
+
+		buffer.read_index.store(write_index, std::memory_order_release);
+
+		return write_index - read_index;
+	}
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "api_trace_records.hpp"
+#include <cstdio>
+#include <algorithm>
+
+static void write_json_string(FILE *file, const std::string &value)
+{
+	fputc('\"', file);
+	for (const char c : value)
+	{
+		if (c == '\"' || c == '\\')
+			fputc('\\', file);
+		fputc(c, file);
+	}
+	fputc('\"', file);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *input_path = nullptr;
+	const char *output_path = nullptr;
+	bool chrome_trace = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--json") == 0)
+			chrome_trace = true;
+		else if (input_path == nullptr)
+			input_path = argv[i];
+		else if (output_path == nullptr)
+			output_path = argv[i];
+	}
+
+	if (input_path == nullptr)
+	{
+		printf("usage: api_trace_decode [--json] <capture file> [output file]\n\n"
+			"  Converts a capture file written by the API Trace add-on to text.\n"
+			"  --json  Write Chrome trace event JSON instead (can be opened with chrome://tracing or Perfetto).\n");
+		return 1;
+	}
+
+	FILE *input_file = nullptr;
+	if (fopen_s(&input_file, input_path, "rb") != 0)
+	{
+		fprintf(stderr, "error: could not open capture file \"%s\"\n", input_path);
+		return 1;
+	}
+
+	api_trace::capture_header header;
+	if (fread(&header, sizeof(header), 1, input_file) != 1 || header.magic != api_trace::capture_header().magic)
+	{
+		fclose(input_file);
+		fprintf(stderr, "error: \"%s\" is not a valid capture file\n", input_path);
+		return 1;
+	}
+	if (header.version != api_trace::capture_header().version)
+	{
+		fclose(input_file);
+		fprintf(stderr, "error: capture file version %u is not supported\n", header.version);
+		return 1;
+	}
+
+	// Number of records in the header is only updated once capture finished, so read until the end of the file instead of relying on it
+	std::vector<api_trace::record> records;
+	for (api_trace::record record; fread(&record, sizeof(record), 1, input_file) == 1;)
+		records.push_back(record);
+
+	fclose(input_file);
+
+	if (header.num_records != 0 && records.size() != header.num_records)
+		fprintf(stderr, "warning: capture file is incomplete (expected %llu records, found %zu)\n", header.num_records, records.size());
+	if (header.dropped_records != 0)
+		fprintf(stderr, "warning: %llu records were dropped during capture\n", header.dropped_records);
+
+	// Records are in order per thread, so sort them to get the order between threads (keeping data records after the command they belong to)
+	std::stable_sort(records.begin(), records.end(),
+		[](const api_trace::record &lhs, const api_trace::record &rhs) {
+			return lhs.timestamp < rhs.timestamp || (lhs.timestamp == rhs.timestamp && lhs.thread_id < rhs.thread_id);
+		});
+
+	FILE *output_file = stdout;
+	if (output_path != nullptr && fopen_s(&output_file, output_path, "w") != 0)
+	{
+		fprintf(stderr, "error: could not open output file \"%s\"\n", output_path);
+		return 1;
+	}
+
+	const uint64_t start_timestamp = records.empty() ? 0 : records.front().timestamp;
+
+	if (chrome_trace)
+		fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", output_file);
+
+	bool first_event = true;
+	for (const api_trace::record *it = records.data(), *end = it + records.size(); it != end;)
+	{
+		const api_trace::record &record = *it;
+		const std::string text = api_trace::format_record(it, end);
+
+		if (chrome_trace)
+		{
+			// Chrome trace timestamps are in microseconds
+			const double ts = static_cast<double>(record.timestamp - start_timestamp) * 1000000.0 / header.ticks_per_second;
+
+			fprintf(output_file, "%s\n{\"name\":", first_event ? "" : ",");
+			write_json_string(output_file, text.substr(0, text.find('(')));
+			fprintf(output_file, ",\"ph\":\"i\",\"s\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"cmd_list\":\"0x%llx\",\"call\":",
+				record.type == api_trace::record_type::present ? 'g' : 't', ts, record.thread_id, record.cmd_list);
+			write_json_string(output_file, text);
+			fputs("}}", output_file);
+
+			first_event = false;
+		}
+		else
+		{
+			fprintf(output_file, "%s\n", text.c_str());
+		}
+	}
+
+	if (chrome_trace)
+		fputs("\n]}\n", output_file);
+
+	if (output_file != stdout)
+		fclose(output_file);
+
+	return 0;
+}
@@ -0,0 +1,477 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <reshade_api_device.hpp>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <sstream>
+
+namespace api_trace
+{
+	/// <summary>
+	/// Identifies the command that was recorded in a trace record.
+	/// The comments list how the arguments are stored in <see cref="record::args"/>.
+	/// </summary>
+	enum class record_type : uint16_t
+	{
+		// Continuation of the previous record on the same thread, with 'count' valid arguments
+		data = 0,
+		// resource, old_state, new_state
+		barrier,
+		// dsv, followed by 'count' render target views in data records
+		begin_render_pass,
+		end_render_pass,
+		// dsv, followed by 'count' render target views in data records
+		bind_render_targets_and_depth_stencil,
+		// stage, pipeline
+		bind_pipeline,
+		// state, value
+		bind_pipeline_state,
+		// first, count
+		bind_viewports,
+		// first, count
+		bind_scissor_rects,
+		// stages, layout, param_index, first, followed by 'count' values (two per argument) in data records
+		push_constants,
+		// stages, layout, param_index, type, binding | count << 32
+		push_descriptors,
+		// stages, layout, index, set
+		bind_descriptor_set,
+		// buffer, offset, index_size
+		bind_index_buffer,
+		// index, buffer, offset, stride
+		bind_vertex_buffer,
+		// vertices, instances, first_vertex, first_instance
+		draw,
+		// indices, instances, first_index, vertex_offset, first_instance
+		draw_indexed,
+		// group_count_x, group_count_y, group_count_z
+		dispatch,
+		// type, buffer, offset, draw_count, stride
+		draw_or_dispatch_indirect,
+		// src, dst
+		copy_resource,
+		// src, src_offset, dst, dst_offset, size
+		copy_buffer_region,
+		// src, src_offset, row_length | slice_height << 32, dst, dst_subresource
+		copy_buffer_to_texture,
+		// src, src_subresource, dst, dst_subresource, filter
+		copy_texture_region,
+		// src, src_subresource, dst, dst_offset, row_length | slice_height << 32
+		copy_texture_to_buffer,
+		// src, src_subresource | dst_subresource << 32, dst, dst_x | dst_y << 32, dst_z | format << 32
+		resolve_texture_region,
+		// dsv, depth, stencil
+		clear_depth_stencil_view,
+		// rtv, color[0] | color[1] << 32, color[2] | color[3] << 32
+		clear_render_target_view,
+		// uav, values[0] | values[1] << 32, values[2] | values[3] << 32
+		clear_unordered_access_view_uint,
+		// uav, values[0] | values[1] << 32, values[2] | values[3] << 32
+		clear_unordered_access_view_float,
+		// srv
+		generate_mipmaps,
+		present,
+	};
+
+	/// <summary>
+	/// A single fixed-size trace record.
+	/// </summary>
+	struct record
+	{
+		uint64_t timestamp;
+		uint64_t cmd_list;
+		uint32_t thread_id;
+		record_type type;
+		uint16_t count;
+		uint64_t args[5];
+	};
+
+	static_assert(sizeof(record) == 64);
+
+	/// <summary>
+	/// Header at the beginning of a capture file, which is followed by the records in the order they were written (per thread, but not between threads).
+	/// </summary>
+	struct capture_header
+	{
+		uint32_t magic = 0x43525441; // "ATRC"
+		uint32_t version = 1;
+		uint64_t ticks_per_second = 0;
+		uint64_t dropped_records = 0;
+		uint64_t num_records = 0;
+	};
+
+	inline uint64_t pack(uint32_t lo, uint32_t hi) { return static_cast<uint64_t>(lo) | (static_cast<uint64_t>(hi) << 32); }
+	inline uint64_t pack(float lo, float hi) { uint32_t lo_bits, hi_bits; std::memcpy(&lo_bits, &lo, 4); std::memcpy(&hi_bits, &hi, 4); return pack(lo_bits, hi_bits); }
+	inline uint32_t lo_uint(uint64_t value) { return static_cast<uint32_t>(value); }
+	inline uint32_t hi_uint(uint64_t value) { return static_cast<uint32_t>(value >> 32); }
+	inline float lo_float(uint64_t value) { float result; const uint32_t bits = lo_uint(value); std::memcpy(&result, &bits, 4); return result; }
+	inline float hi_float(uint64_t value) { float result; const uint32_t bits = hi_uint(value); std::memcpy(&result, &bits, 4); return result; }
+
+	inline auto to_string(reshade::api::shader_stage value)
+	{
+		switch (value)
+		{
+		case reshade::api::shader_stage::vertex:
+			return "vertex";
+		case reshade::api::shader_stage::hull:
+			return "hull";
+		case reshade::api::shader_stage::domain:
+			return "domain";
+		case reshade::api::shader_stage::geometry:
+			return "geometry";
+		case reshade::api::shader_stage::pixel:
+			return "pixel";
+		case reshade::api::shader_stage::compute:
+			return "compute";
+		case reshade::api::shader_stage::all:
+			return "all";
+		case reshade::api::shader_stage::all_graphics:
+			return "all_graphics";
+		default:
+			return "unknown";
+		}
+	}
+	inline auto to_string(reshade::api::pipeline_stage value)
+	{
+		switch (value)
+		{
+		case reshade::api::pipeline_stage::vertex_shader:
+			return "vertex_shader";
+		case reshade::api::pipeline_stage::hull_shader:
+			return "hull_shader";
+		case reshade::api::pipeline_stage::domain_shader:
+			return "domain_shader";
+		case reshade::api::pipeline_stage::geometry_shader:
+			return "geometry_shader";
+		case reshade::api::pipeline_stage::pixel_shader:
+			return "pixel_shader";
+		case reshade::api::pipeline_stage::compute_shader:
+			return "compute_shader";
+		case reshade::api::pipeline_stage::input_assembler:
+			return "input_assembler";
+		case reshade::api::pipeline_stage::stream_output:
+			return "stream_output";
+		case reshade::api::pipeline_stage::rasterizer:
+			return "rasterizer";
+		case reshade::api::pipeline_stage::depth_stencil:
+			return "depth_stencil";
+		case reshade::api::pipeline_stage::output_merger:
+			return "output_merger";
+		case reshade::api::pipeline_stage::all:
+			return "all";
+		case reshade::api::pipeline_stage::all_graphics:
+			return "all_graphics";
+		case reshade::api::pipeline_stage::all_shader_stages:
+			return "all_shader_stages";
+		default:
+			return "unknown";
+		}
+	}
+	inline auto to_string(reshade::api::descriptor_type value)
+	{
+		switch (value)
+		{
+		case reshade::api::descriptor_type::sampler:
+			return "sampler";
+		case reshade::api::descriptor_type::sampler_with_resource_view:
+			return "sampler_with_resource_view";
+		case reshade::api::descriptor_type::shader_resource_view:
+			return "shader_resource_view";
+		case reshade::api::descriptor_type::unordered_access_view:
+			return "unordered_access_view";
+		case reshade::api::descriptor_type::constant_buffer:
+			return "constant_buffer";
+		default:
+			return "unknown";
+		}
+	}
+	inline auto to_string(reshade::api::dynamic_state value)
+	{
+		switch (value)
+		{
+		default:
+		case reshade::api::dynamic_state::unknown:
+			return "unknown";
+		case reshade::api::dynamic_state::alpha_test_enable:
+			return "alpha_test_enable";
+		case reshade::api::dynamic_state::alpha_reference_value:
+			return "alpha_reference_value";
+		case reshade::api::dynamic_state::alpha_func:
+			return "alpha_func";
+		case reshade::api::dynamic_state::srgb_write_enable:
+			return "srgb_write_enable";
+		case reshade::api::dynamic_state::primitive_topology:
+			return "primitive_topology";
+		case reshade::api::dynamic_state::sample_mask:
+			return "sample_mask";
+		case reshade::api::dynamic_state::alpha_to_coverage_enable:
+			return "alpha_to_coverage_enable";
+		case reshade::api::dynamic_state::blend_enable:
+			return "blend_enable";
+		case reshade::api::dynamic_state::logic_op_enable:
+			return "logic_op_enable";
+		case reshade::api::dynamic_state::color_blend_op:
+			return "color_blend_op";
+		case reshade::api::dynamic_state::source_color_blend_factor:
+			return "src_color_blend_factor";
+		case reshade::api::dynamic_state::dest_color_blend_factor:
+			return "dst_color_blend_factor";
+		case reshade::api::dynamic_state::alpha_blend_op:
+			return "alpha_blend_op";
+		case reshade::api::dynamic_state::source_alpha_blend_factor:
+			return "src_alpha_blend_factor";
+		case reshade::api::dynamic_state::dest_alpha_blend_factor:
+			return "dst_alpha_blend_factor";
+		case reshade::api::dynamic_state::logic_op:
+			return "logic_op";
+		case reshade::api::dynamic_state::blend_constant:
+			return "blend_constant";
+		case reshade::api::dynamic_state::render_target_write_mask:
+			return "render_target_write_mask";
+		case reshade::api::dynamic_state::fill_mode:
+			return "fill_mode";
+		case reshade::api::dynamic_state::cull_mode:
+			return "cull_mode";
+		case reshade::api::dynamic_state::front_counter_clockwise:
+			return "front_counter_clockwise";
+		case reshade::api::dynamic_state::depth_bias:
+			return "depth_bias";
+		case reshade::api::dynamic_state::depth_bias_clamp:
+			return "depth_bias_clamp";
+		case reshade::api::dynamic_state::depth_bias_slope_scaled:
+			return "depth_bias_slope_scaled";
+		case reshade::api::dynamic_state::depth_clip_enable:
+			return "depth_clip_enable";
+		case reshade::api::dynamic_state::scissor_enable:
+			return "scissor_enable";
+		case reshade::api::dynamic_state::multisample_enable:
+			return "multisample_enable";
+		case reshade::api::dynamic_state::antialiased_line_enable:
+			return "antialiased_line_enable";
+		case reshade::api::dynamic_state::depth_enable:
+			return "depth_enable";
+		case reshade::api::dynamic_state::depth_write_mask:
+			return "depth_write_mask";
+		case reshade::api::dynamic_state::depth_func:
+			return "depth_func";
+		case reshade::api::dynamic_state::stencil_enable:
+			return "stencil_enable";
+		case reshade::api::dynamic_state::stencil_read_mask:
+			return "stencil_read_mask";
+		case reshade::api::dynamic_state::stencil_write_mask:
+			return "stencil_write_mask";
+		case reshade::api::dynamic_state::stencil_reference_value:
+			return "stencil_reference_value";
+		case reshade::api::dynamic_state::front_stencil_func:
+			return "front_stencil_func";
+		case reshade::api::dynamic_state::front_stencil_pass_op:
+			return "front_stencil_pass_op";
+		case reshade::api::dynamic_state::front_stencil_fail_op:
+			return "front_stencil_fail_op";
+		case reshade::api::dynamic_state::front_stencil_depth_fail_op:
+			return "front_stencil_depth_fail_op";
+		case reshade::api::dynamic_state::back_stencil_func:
+			return "back_stencil_func";
+		case reshade::api::dynamic_state::back_stencil_pass_op:
+			return "back_stencil_pass_op";
+		case reshade::api::dynamic_state::back_stencil_fail_op:
+			return "back_stencil_fail_op";
+		case reshade::api::dynamic_state::back_stencil_depth_fail_op:
+			return "back_stencil_depth_fail_op";
+		}
+	}
+	inline auto to_string(reshade::api::resource_usage value)
+	{
+		switch (value)
+		{
+		default:
+		case reshade::api::resource_usage::undefined:
+			return "undefined";
+		case reshade::api::resource_usage::index_buffer:
+			return "index_buffer";
+		case reshade::api::resource_usage::vertex_buffer:
+			return "vertex_buffer";
+		case reshade::api::resource_usage::constant_buffer:
+			return "constant_buffer";
+		case reshade::api::resource_usage::stream_output:
+			return "stream_output";
+		case reshade::api::resource_usage::indirect_argument:
+			return "indirect_argument";
+		case reshade::api::resource_usage::depth_stencil:
+		case reshade::api::resource_usage::depth_stencil_read:
+		case reshade::api::resource_usage::depth_stencil_write:
+			return "depth_stencil";
+		case reshade::api::resource_usage::render_target:
+			return "render_target";
+		case reshade::api::resource_usage::shader_resource:
+		case reshade::api::resource_usage::shader_resource_pixel:
+		case reshade::api::resource_usage::shader_resource_non_pixel:
+			return "shader_resource";
+		case reshade::api::resource_usage::unordered_access:
+			return "unordered_access";
+		case reshade::api::resource_usage::copy_dest:
+			return "copy_dest";
+		case reshade::api::resource_usage::copy_source:
+			return "copy_source";
+		case reshade::api::resource_usage::resolve_dest:
+			return "resolve_dest";
+		case reshade::api::resource_usage::resolve_source:
+			return "resolve_source";
+		case reshade::api::resource_usage::general:
+			return "general";
+		case reshade::api::resource_usage::present:
+			return "present";
+		case reshade::api::resource_usage::cpu_access:
+			return "cpu_access";
+		}
+	}
+
+	struct handle { uint64_t value; };
+
+	inline std::ostream &operator<<(std::ostream &s, handle value)
+	{
+		return s << "0x" << std::hex << value.value << std::dec;
+	}
+
+	/// <summary>
+	/// Formats the command at the specified record as text and advances past it and the data records that belong to it.
+	/// </summary>
+	inline std::string format_record(const record *&it, const record *end)
+	{
+		const record &r = *it++;
+		const uint64_t *const args = r.args;
+
+		// Collect arguments that did not fit into the record itself
+		std::vector<uint64_t> data;
+		while (it != end && it->type == record_type::data && it->thread_id == r.thread_id)
+		{
+			data.insert(data.end(), it->args, it->args + (it->count < 5 ? it->count : 5));
+			++it;
+		}
+
+		std::stringstream s;
+		switch (r.type)
+		{
+		case record_type::data:
+			s << "data(" << r.count << ")";
+			break;
+		case record_type::barrier:
+			s << "barrier(" << handle { args[0] } << ", " << to_string(static_cast<reshade::api::resource_usage>(args[1])) << ", " << to_string(static_cast<reshade::api::resource_usage>(args[2])) << ")";
+			break;
+		case record_type::begin_render_pass:
+		case record_type::bind_render_targets_and_depth_stencil:
+			s << (r.type == record_type::begin_render_pass ? "begin_render_pass(" : "bind_render_targets_and_depth_stencil(") << r.count << ", { ";
+			for (size_t i = 0; i < r.count && i < data.size(); ++i)
+				s << handle { data[i] } << ", ";
+			s << " }, " << handle { args[0] } << ")";
+			break;
+		case record_type::end_render_pass:
+			s << "end_render_pass()";
+			break;
+		case record_type::bind_pipeline:
+			s << "bind_pipeline(" << to_string(static_cast<reshade::api::pipeline_stage>(args[0])) << ", " << handle { args[1] } << ")";
+			break;
+		case record_type::bind_pipeline_state:
+			s << "bind_pipeline_state(" << to_string(static_cast<reshade::api::dynamic_state>(args[0])) << ", " << args[1] << ")";
+			break;
+		case record_type::bind_viewports:
+			s << "bind_viewports(" << args[0] << ", " << args[1] << ", { ... })";
+			break;
+		case record_type::bind_scissor_rects:
+			s << "bind_scissor_rects(" << args[0] << ", " << args[1] << ", { ... })";
+			break;
+		case record_type::push_constants:
+			s << "push_constants(" << to_string(static_cast<reshade::api::shader_stage>(args[0])) << ", " << handle { args[1] } << ", " << args[2] << ", " << args[3] << ", " << r.count << ", { ";
+			for (size_t i = 0; i < r.count && i / 2 < data.size(); ++i)
+				s << std::hex << (i % 2 == 0 ? lo_uint(data[i / 2]) : hi_uint(data[i / 2])) << std::dec << ", ";
+			s << " })";
+			break;
+		case record_type::push_descriptors:
+			s << "push_descriptors(" << to_string(static_cast<reshade::api::shader_stage>(args[0])) << ", " << handle { args[1] } << ", " << args[2] << ", { " << to_string(static_cast<reshade::api::descriptor_type>(args[3])) << ", " << lo_uint(args[4]) << ", " << hi_uint(args[4]) << " })";
+			break;
+		case record_type::bind_descriptor_set:
+			s << "bind_descriptor_set(" << to_string(static_cast<reshade::api::shader_stage>(args[0])) << ", " << handle { args[1] } << ", " << args[2] << ", " << handle { args[3] } << ")";
+			break;
+		case record_type::bind_index_buffer:
+			s << "bind_index_buffer(" << handle { args[0] } << ", " << args[1] << ", " << args[2] << ")";
+			break;
+		case record_type::bind_vertex_buffer:
+			s << "bind_vertex_buffer(" << args[0] << ", " << handle { args[1] } << ", " << args[2] << ", " << args[3] << ")";
+			break;
+		case record_type::draw:
+			s << "draw(" << args[0] << ", " << args[1] << ", " << args[2] << ", " << args[3] << ")";
+			break;
+		case record_type::draw_indexed:
+			s << "draw_indexed(" << args[0] << ", " << args[1] << ", " << args[2] << ", " << static_cast<int32_t>(args[3]) << ", " << args[4] << ")";
+			break;
+		case record_type::dispatch:
+			s << "dispatch(" << args[0] << ", " << args[1] << ", " << args[2] << ")";
+			break;
+		case record_type::draw_or_dispatch_indirect:
+			switch (static_cast<reshade::api::indirect_command>(args[0]))
+			{
+			default:
+				s << "draw_or_dispatch_indirect(";
+				break;
+			case reshade::api::indirect_command::draw:
+				s << "draw_indirect(";
+				break;
+			case reshade::api::indirect_command::draw_indexed:
+				s << "draw_indexed_indirect(";
+				break;
+			case reshade::api::indirect_command::dispatch:
+				s << "dispatch_indirect(";
+				break;
+			}
+			s << handle { args[1] } << ", " << args[2] << ", " << args[3] << ", " << args[4] << ")";
+			break;
+		case record_type::copy_resource:
+			s << "copy_resource(" << handle { args[0] } << ", " << handle { args[1] } << ")";
+			break;
+		case record_type::copy_buffer_region:
+			s << "copy_buffer_region(" << handle { args[0] } << ", " << args[1] << ", " << handle { args[2] } << ", " << args[3] << ", " << args[4] << ")";
+			break;
+		case record_type::copy_buffer_to_texture:
+			s << "copy_buffer_to_texture(" << handle { args[0] } << ", " << args[1] << ", " << lo_uint(args[2]) << ", " << hi_uint(args[2]) << ", " << handle { args[3] } << ", " << args[4] << ")";
+			break;
+		case record_type::copy_texture_region:
+			s << "copy_texture_region(" << handle { args[0] } << ", " << args[1] << ", " << handle { args[2] } << ", " << args[3] << ", " << args[4] << ")";
+			break;
+		case record_type::copy_texture_to_buffer:
+			s << "copy_texture_to_buffer(" << handle { args[0] } << ", " << args[1] << ", " << handle { args[2] } << ", " << args[3] << ", " << lo_uint(args[4]) << ", " << hi_uint(args[4]) << ")";
+			break;
+		case record_type::resolve_texture_region:
+			s << "resolve_texture_region(" << handle { args[0] } << ", " << lo_uint(args[1]) << ", { ... }, " << handle { args[2] } << ", " << hi_uint(args[1]) << ", " << static_cast<int32_t>(lo_uint(args[3])) << ", " << static_cast<int32_t>(hi_uint(args[3])) << ", " << static_cast<int32_t>(lo_uint(args[4])) << ", " << hi_uint(args[4]) << ")";
+			break;
+		case record_type::clear_depth_stencil_view:
+			s << "clear_depth_stencil_view(" << handle { args[0] } << ", " << lo_float(args[1]) << ", " << args[2] << ")";
+			break;
+		case record_type::clear_render_target_view:
+			s << "clear_render_target_view(" << handle { args[0] } << ", { " << lo_float(args[1]) << ", " << hi_float(args[1]) << ", " << lo_float(args[2]) << ", " << hi_float(args[2]) << " })";
+			break;
+		case record_type::clear_unordered_access_view_uint:
+			s << "clear_unordered_access_view_uint(" << handle { args[0] } << ", { " << lo_uint(args[1]) << ", " << hi_uint(args[1]) << ", " << lo_uint(args[2]) << ", " << hi_uint(args[2]) << " })";
+			break;
+		case record_type::clear_unordered_access_view_float:
+			s << "clear_unordered_access_view_float(" << handle { args[0] } << ", { " << lo_float(args[1]) << ", " << hi_float(args[1]) << ", " << lo_float(args[2]) << ", " << hi_float(args[2]) << " })";
+			break;
+		case record_type::generate_mipmaps:
+			s << "generate_mipmaps(" << handle { args[0] } << ")";
+			break;
+		case record_type::present:
+			s << "present()";
+			break;
+		default:
+			s << "unknown(" << static_cast<uint32_t>(r.type) << ")";
+			break;
+		}
+
+		return s.str();
+	}
+}
@@ -4,7 +4,7 @@
  */
 
 #include <reshade.hpp>
-#include "crc32_hash.hpp"
+#include "../02-shader_dump/crc32_hash.hpp"
 #include <fstream>
 #include <filesystem>
 
@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+// Decoders for block-compressed texture data
+// Each decodes a single 4x4 block into 16 RGBA texels (4 bytes each, rows stored one after another)
+// Interpolated colors are computed once per block, so that texels only need a table lookup
+// See https://docs.microsoft.com/windows/win32/direct3d10/d3d10-graphics-programming-guide-resources-block-compression
+
+namespace bc_decode
+{
+	inline uint32_t pack_rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+	{
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	inline uint64_t read_uint48(const uint8_t *src)
+	{
+		uint64_t value = 0;
+		std::memcpy(&value, src, 6);
+		return value;
+	}
+
+	inline void unpack_r5g6b5(uint16_t data, uint32_t rgb[3])
+	{
+		uint32_t temp;
+		temp =  (data           >> 11) * 255 + 16;
+		rgb[0] = (temp / 32 + temp) / 32;
+		temp = ((data & 0x07E0) >>  5) * 255 + 32;
+		rgb[1] = (temp / 64 + temp) / 64;
+		temp =  (data & 0x001F)        * 255 + 16;
+		rgb[2] = (temp / 32 + temp) / 32;
+	}
+
+	// Computes the four colors of a BC1 color block, the fourth one being transparent black in three color mode
+	inline void compute_bc1_palette(const uint8_t *src, uint32_t palette[4], bool allow_three_color_mode)
+	{
+		uint16_t color_0, color_1;
+		std::memcpy(&color_0, src, 2);
+		std::memcpy(&color_1, src + 2, 2);
+
+		uint32_t c0[3], c1[3];
+		unpack_r5g6b5(color_0, c0);
+		unpack_r5g6b5(color_1, c1);
+
+		palette[0] = pack_rgba(c0[0], c0[1], c0[2], 255);
+		palette[1] = pack_rgba(c1[0], c1[1], c1[2], 255);
+
+		if (color_0 > color_1 || !allow_three_color_mode)
+		{
+			palette[2] = pack_rgba((2 * c0[0] + c1[0]) / 3, (2 * c0[1] + c1[1]) / 3, (2 * c0[2] + c1[2]) / 3, 255);
+			palette[3] = pack_rgba((c0[0] + 2 * c1[0]) / 3, (c0[1] + 2 * c1[1]) / 3, (c0[2] + 2 * c1[2]) / 3, 255);
+		}
+		else
+		{
+			palette[2] = pack_rgba((c0[0] + c1[0]) / 2, (c0[1] + c1[1]) / 2, (c0[2] + c1[2]) / 2, 255);
+			palette[3] = 0;
+		}
+	}
+
+	// Computes the eight values of a BC4 channel block
+	inline void compute_bc4_palette(const uint8_t *src, uint32_t palette[8])
+	{
+		const uint32_t a0 = src[0];
+		const uint32_t a1 = src[1];
+
+		palette[0] = a0;
+		palette[1] = a1;
+
+		if (a0 > a1)
+		{
+			palette[2] = (6 * a0 + 1 * a1) / 7;
+			palette[3] = (5 * a0 + 2 * a1) / 7;
+			palette[4] = (4 * a0 + 3 * a1) / 7;
+			palette[5] = (3 * a0 + 4 * a1) / 7;
+			palette[6] = (2 * a0 + 5 * a1) / 7;
+			palette[7] = (1 * a0 + 6 * a1) / 7;
+		}
+		else
+		{
+			palette[2] = (4 * a0 + 1 * a1) / 5;
+			palette[3] = (3 * a0 + 2 * a1) / 5;
+			palette[4] = (2 * a0 + 3 * a1) / 5;
+			palette[5] = (1 * a0 + 4 * a1) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	// Writes the palette entries selected by 2-bit indices to the texels of a block
+	inline void expand_indices_2bit(uint32_t indices, const uint32_t palette[4], uint32_t texels[16])
+	{
+		for (int i = 0; i < 16; ++i, indices >>= 2)
+			texels[i] = palette[indices & 0x3];
+	}
+
+	// Combines the palette entries selected by 3-bit indices with the texels of a block
+	inline void expand_indices_3bit_or(uint64_t indices, const uint32_t palette[8], uint32_t texels[16])
+	{
+		for (int i = 0; i < 16; ++i, indices >>= 3)
+			texels[i] |= palette[indices & 0x7];
+	}
+
+	inline void decode_bc1_block(const uint8_t *src, uint32_t texels[16])
+	{
+		uint32_t palette[4];
+		compute_bc1_palette(src, palette, true);
+
+		uint32_t indices;
+		std::memcpy(&indices, src + 4, 4);
+
+		expand_indices_2bit(indices, palette, texels);
+	}
+
+	inline void decode_bc3_block(const uint8_t *src, uint32_t texels[16])
+	{
+		// Color block always uses four color mode in BC3
+		uint32_t color_palette[4];
+		compute_bc1_palette(src + 8, color_palette, false);
+		for (uint32_t &color : color_palette)
+			color &= 0x00FFFFFF;
+
+		uint32_t color_indices;
+		std::memcpy(&color_indices, src + 12, 4);
+
+		expand_indices_2bit(color_indices, color_palette, texels);
+
+		uint32_t alpha_palette[8];
+		compute_bc4_palette(src, alpha_palette);
+		for (uint32_t &alpha : alpha_palette)
+			alpha <<= 24;
+
+		expand_indices_3bit_or(read_uint48(src + 2), alpha_palette, texels);
+	}
+
+	inline void decode_bc4_block(const uint8_t *src, uint32_t texels[16])
+	{
+		uint32_t palette[8];
+		compute_bc4_palette(src, palette);
+		for (uint32_t &value : palette)
+			value = pack_rgba(value, value, value, 255);
+
+		std::memset(texels, 0, 16 * sizeof(uint32_t));
+		expand_indices_3bit_or(read_uint48(src + 2), palette, texels);
+	}
+
+	inline void decode_bc5_block(const uint8_t *src, uint32_t texels[16])
+	{
+		uint32_t red_palette[8];
+		compute_bc4_palette(src, red_palette);
+
+		uint32_t green_palette[8];
+		compute_bc4_palette(src + 8, green_palette);
+		for (uint32_t &value : green_palette)
+			value <<= 8;
+
+		for (int i = 0; i < 16; ++i)
+			texels[i] = 0xFF000000;
+		expand_indices_3bit_or(read_uint48(src + 2), red_palette, texels);
+		expand_indices_3bit_or(read_uint48(src + 10), green_palette, texels);
+	}
+
+	// Partition of texels into subsets for two subset modes (bit N set if texel N belongs to the second subset)
+	inline constexpr uint16_t bc7_partitions_2[64] = {
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+	};
+	// Partition of texels into subsets for three subset modes (bits 2N to 2N+1 contain the subset of texel N)
+	inline constexpr uint32_t bc7_partitions_3[64] = {
+		0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+		0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+		0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+		0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+		0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+		0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+		0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+		0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+	};
+
+	// Texel index of the anchor of the second subset in two subset modes
+	inline constexpr uint8_t bc7_anchors_2_1[64] = {
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+		15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+		 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+	};
+	// Texel index of the anchor of the second subset in three subset modes
+	inline constexpr uint8_t bc7_anchors_3_1[64] = {
+		 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+		 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+		 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+		 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+	};
+	// Texel index of the anchor of the third subset in three subset modes
+	inline constexpr uint8_t bc7_anchors_3_2[64] = {
+		15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+		15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+		15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+		15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+	};
+
+	inline constexpr uint8_t bc7_weights_2[4] = { 0, 21, 43, 64 };
+	inline constexpr uint8_t bc7_weights_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	inline constexpr uint8_t bc7_weights_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct bc7_mode_info
+	{
+		uint8_t num_subsets;
+		uint8_t partition_bits;
+		uint8_t rotation_bits;
+		uint8_t index_selection_bits;
+		uint8_t color_bits;
+		uint8_t alpha_bits;
+		uint8_t endpoint_p_bits;
+		uint8_t shared_p_bits;
+		uint8_t index_bits;
+		uint8_t index_bits_2;
+	};
+
+	inline constexpr bc7_mode_info bc7_modes[8] = {
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+	};
+
+	class bc7_bit_reader
+	{
+	public:
+		explicit bc7_bit_reader(const uint8_t *src)
+		{
+			std::memcpy(&_lo, src, 8);
+			std::memcpy(&_hi, src + 8, 8);
+		}
+
+		uint32_t read(uint32_t count)
+		{
+			uint64_t value;
+			if (_pos >= 64)
+				value = _hi >> (_pos - 64);
+			else if (_pos + count <= 64)
+				value = _lo >> _pos;
+			else
+				value = (_lo >> _pos) | (_hi << (64 - _pos));
+
+			_pos += count;
+			return static_cast<uint32_t>(value) & ((1u << count) - 1);
+		}
+
+	private:
+		uint64_t _lo, _hi;
+		uint32_t _pos = 0;
+	};
+
+	inline void decode_bc7_block(const uint8_t *src, uint32_t texels[16])
+	{
+		uint32_t mode = 0;
+		while (mode < 8 && (src[0] & (1 << mode)) == 0)
+			++mode;
+
+		// Reserved mode decodes to transparent black
+		if (mode == 8)
+		{
+			std::memset(texels, 0, 16 * sizeof(uint32_t));
+			return;
+		}
+
+		const bc7_mode_info &info = bc7_modes[mode];
+
+		bc7_bit_reader bits(src);
+		bits.read(mode + 1);
+
+		const uint32_t partition = bits.read(info.partition_bits);
+		const uint32_t rotation = bits.read(info.rotation_bits);
+		const uint32_t index_selection = bits.read(info.index_selection_bits);
+
+		const uint32_t num_endpoints = info.num_subsets * 2;
+		uint32_t endpoints[6][4];
+
+		for (uint32_t c = 0; c < 3; ++c)
+			for (uint32_t e = 0; e < num_endpoints; ++e)
+				endpoints[e][c] = bits.read(info.color_bits);
+		for (uint32_t e = 0; e < num_endpoints; ++e)
+			endpoints[e][3] = bits.read(info.alpha_bits);
+
+		uint32_t color_bits = info.color_bits;
+		uint32_t alpha_bits = info.alpha_bits;
+
+		if (info.endpoint_p_bits != 0 || info.shared_p_bits != 0)
+		{
+			uint32_t p = 0;
+			for (uint32_t e = 0; e < num_endpoints; ++e)
+			{
+				// Shared P-bits are stored once per subset, unique P-bits once per endpoint
+				if (info.endpoint_p_bits != 0 || (e % 2) == 0)
+					p = bits.read(1);
+
+				for (uint32_t c = 0; c < 4; ++c)
+					endpoints[e][c] = (endpoints[e][c] << 1) | p;
+			}
+
+			color_bits += 1;
+			if (alpha_bits != 0)
+				alpha_bits += 1;
+		}
+
+		// Expand endpoints to 8 bits by replicating the most significant bits
+		for (uint32_t e = 0; e < num_endpoints; ++e)
+		{
+			for (uint32_t c = 0; c < 3; ++c)
+				endpoints[e][c] = (endpoints[e][c] << (8 - color_bits)) | (endpoints[e][c] >> (2 * color_bits - 8));
+
+			if (alpha_bits != 0)
+				endpoints[e][3] = (endpoints[e][3] << (8 - alpha_bits)) | (endpoints[e][3] >> (2 * alpha_bits - 8));
+			else
+				endpoints[e][3] = 255;
+		}
+
+		uint32_t subsets[16] = {};
+		uint32_t anchor_1 = 0, anchor_2 = 0;
+		if (info.num_subsets == 2)
+		{
+			for (uint32_t i = 0; i < 16; ++i)
+				subsets[i] = (bc7_partitions_2[partition] >> i) & 0x1;
+			anchor_1 = bc7_anchors_2_1[partition];
+		}
+		else if (info.num_subsets == 3)
+		{
+			for (uint32_t i = 0; i < 16; ++i)
+				subsets[i] = (bc7_partitions_3[partition] >> (2 * i)) & 0x3;
+			anchor_1 = bc7_anchors_3_1[partition];
+			anchor_2 = bc7_anchors_3_2[partition];
+		}
+
+		// Anchor texels store their index with one bit less (the most significant bit is implicitly zero)
+		uint32_t indices[16];
+		for (uint32_t i = 0; i < 16; ++i)
+			indices[i] = bits.read(info.index_bits - ((i == 0 || (info.num_subsets > 1 && i == anchor_1) || (info.num_subsets > 2 && i == anchor_2)) ? 1 : 0));
+
+		uint32_t indices_2[16] = {};
+		if (info.index_bits_2 != 0)
+			for (uint32_t i = 0; i < 16; ++i)
+				indices_2[i] = bits.read(info.index_bits_2 - (i == 0 ? 1 : 0));
+
+		const uint8_t *const weights = info.index_bits == 2 ? bc7_weights_2 : info.index_bits == 3 ? bc7_weights_3 : bc7_weights_4;
+		const uint8_t *const weights_2 = info.index_bits_2 == 3 ? bc7_weights_3 : bc7_weights_2;
+
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			const uint32_t *const e0 = endpoints[2 * subsets[i] + 0];
+			const uint32_t *const e1 = endpoints[2 * subsets[i] + 1];
+
+			uint32_t color_weight = weights[indices[i]];
+			uint32_t alpha_weight = color_weight;
+			if (info.index_bits_2 != 0)
+			{
+				alpha_weight = weights_2[indices_2[i]];
+				if (index_selection != 0)
+					std::swap(color_weight, alpha_weight);
+			}
+
+			uint32_t rgba[4];
+			for (uint32_t c = 0; c < 3; ++c)
+				rgba[c] = ((64 - color_weight) * e0[c] + color_weight * e1[c] + 32) >> 6;
+			rgba[3] = ((64 - alpha_weight) * e0[3] + alpha_weight * e1[3] + 32) >> 6;
+
+			// Rotation swaps alpha with one of the color channels
+			if (rotation != 0)
+				std::swap(rgba[3], rgba[rotation - 1]);
+
+			texels[i] = pack_rgba(rgba[0], rgba[1], rgba[2], rgba[3]);
+		}
+	}
+}
@@ -4,6 +4,7 @@
 // You shouldn't need to modify these if you're just editing options
 #define DUMP_HASH_FULL 0
 #define DUMP_HASH_TEXMOD 1
+#define DUMP_HASH_FULL64 2
 
 #define DUMP_FMT_BMP 0
 #define DUMP_FMT_PNG 1
@@ -12,7 +13,7 @@
 /// OPTIONS
 
 // Which hash method to use
-// Only supports FULL and TEXMOD
+// Only supports FULL, TEXMOD and FULL64 (a faster 64-bit hash for new texture packs, which is not compatible with file names from the other methods)
 #define DUMP_HASH DUMP_HASH_TEXMOD
 
 // The subdirectory to place textures in
@@ -28,3 +29,10 @@
 // Comment out the line below to disable
 #define DUMP_ENABLE_HASH_SET
 
+// Number of threads that convert and write textures in the background, so that dumping does not stall texture creation in the application
+// Comment out the line below to dump textures on the thread that created them instead
+#define DUMP_WORKER_THREADS 2
+
+// Maximum number of textures waiting to be written by the worker threads (each holds a copy of the texture data)
+// Once reached, further textures are skipped until the worker threads caught up (and dumped the next time they are uploaded instead), which caps memory usage without stalling the application
+#define DUMP_MAX_QUEUED_TEXTURES 16
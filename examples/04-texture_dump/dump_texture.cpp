@@ -7,408 +7,237 @@
 
 #include <reshade.hpp>
 #include "dump_options.hpp"
-#include "crc32_hash.hpp"
+#include "bc_decode.hpp"
+#include "../02-shader_dump/crc32_hash.hpp"
 #include <vector>
+#include <algorithm>
 #include <filesystem>
 #include <stb_image_write.h>
 
 #ifdef DUMP_ENABLE_HASH_SET
 #include <set>
+#include <mutex>
+#endif
+#ifdef DUMP_WORKER_THREADS
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 #endif
 
 using namespace reshade::api;
 
-static void unpack_r5g6b5(uint16_t data, uint8_t rgb[3])
+#if DUMP_HASH == DUMP_HASH_FULL64
+using hash_type = uint64_t;
+#else
+using hash_type = uint32_t;
+#endif
+
+// Converts texture data of a specific format to RGBA
+using convert_func = void(*)(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, uint8_t *rgba_pixel_data);
+
+static void convert_l8(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, uint8_t *rgba_pixel_data)
 {
-	uint32_t temp;
-	temp =  (data           >> 11) * 255 + 16;
-	rgb[0] = static_cast<uint8_t>((temp / 32 + temp) / 32);
-	temp = ((data & 0x07E0) >>  5) * 255 + 32;
-	rgb[1] = static_cast<uint8_t>((temp / 64 + temp) / 64);
-	temp =  (data & 0x001F)        * 255 + 16;
-	rgb[2] = static_cast<uint8_t>((temp / 32 + temp) / 32);
+	for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += row_pitch)
+	{
+		for (uint32_t x = 0; x < desc.texture.width; ++x)
+		{
+			const uint8_t *const src = data_p + x;
+			uint8_t *const dst = rgba_pixel_data + (y * desc.texture.width + x) * 4;
+
+			dst[0] = src[0];
+			dst[1] = src[0];
+			dst[2] = src[0];
+			dst[3] = 255;
+		}
+	}
 }
-static void unpack_bc1_value(const uint8_t color_0[3], const uint8_t color_1[3], uint32_t color_index, uint8_t result[4], bool not_degenerate = true)
+static void convert_a8(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, uint8_t *rgba_pixel_data)
 {
-	switch (color_index)
+	for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += row_pitch)
 	{
-	case 0:
-		for (int c = 0; c < 3; ++c)
-			result[c] = color_0[c];
-		result[3] = 255;
-		break;
-	case 1:
-		for (int c = 0; c < 3; ++c)
-			result[c] = color_1[c];
-		result[3] = 255;
-		break;
-	case 2:
-		for (int c = 0; c < 3; ++c)
-			result[c] = not_degenerate ? (2 * color_0[c] + color_1[c]) / 3 : (color_0[c] + color_1[c]) / 2;
-		result[3] = 255;
-		break;
-	case 3:
-		for (int c = 0; c < 3; ++c)
-			result[c] = not_degenerate ? (color_0[c] + 2 * color_1[c]) / 3 : 0;
-		result[3] = not_degenerate ? 255 : 0;
-		break;
+		for (uint32_t x = 0; x < desc.texture.width; ++x)
+		{
+			const uint8_t *const src = data_p + x;
+			uint8_t *const dst = rgba_pixel_data + (y * desc.texture.width + x) * 4;
+
+			dst[0] = 0;
+			dst[1] = 0;
+			dst[2] = 0;
+			dst[3] = src[0];
+		}
 	}
 }
-static void unpack_bc4_value(uint8_t alpha_0, uint8_t alpha_1, uint32_t alpha_index, uint8_t *result)
+static void convert_r8(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, uint8_t *rgba_pixel_data)
 {
-	const bool interpolation_type = alpha_0 > alpha_1;
-
-	switch (alpha_index)
+	for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += row_pitch)
 	{
-	case 0:
-		*result = alpha_0;
-		break;
-	case 1:
-		*result = alpha_1;
-		break;
-	case 2:
-		*result = interpolation_type ? (6 * alpha_0 + 1 * alpha_1) / 7 : (4 * alpha_0 + 1 * alpha_1) / 5;
-		break;
-	case 3:
-		*result = interpolation_type ? (5 * alpha_0 + 2 * alpha_1) / 7 : (3 * alpha_0 + 2 * alpha_1) / 5;
-		break;
-	case 4:
-		*result = interpolation_type ? (4 * alpha_0 + 3 * alpha_1) / 7 : (2 * alpha_0 + 3 * alpha_1) / 5;
-		break;
-	case 5:
-		*result = interpolation_type ? (3 * alpha_0 + 4 * alpha_1) / 7 : (1 * alpha_0 + 4 * alpha_1) / 5;
-		break;
-	case 6:
-		*result = interpolation_type ? (2 * alpha_0 + 5 * alpha_1) / 7 : 0;
-		break;
-	case 7:
-		*result = interpolation_type ? (1 * alpha_0 + 6 * alpha_1) / 7 : 255;
-		break;
+		for (uint32_t x = 0; x < desc.texture.width; ++x)
+		{
+			const uint8_t *const src = data_p + x;
+			uint8_t *const dst = rgba_pixel_data + (y * desc.texture.width + x) * 4;
+
+			dst[0] = src[0];
+			dst[1] = 0;
+			dst[2] = 0;
+			dst[3] = 255;
+		}
 	}
 }
-
-bool dump_texture(const resource_desc &desc, const subresource_data &data)
+static void convert_l8a8(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, uint8_t *rgba_pixel_data)
 {
-#ifdef DUMP_ENABLE_HASH_SET
-	static std::set<uint32_t> hash_set;
-#endif
-
-	uint8_t *data_p = static_cast<uint8_t *>(data.data);
-	std::vector<uint8_t> rgba_pixel_data(desc.texture.width * desc.texture.height * 4);
+	for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += row_pitch)
+	{
+		for (uint32_t x = 0; x < desc.texture.width; ++x)
+		{
+			const uint8_t *const src = data_p + x * 2;
+			uint8_t *const dst = rgba_pixel_data + (y * desc.texture.width + x) * 4;
 
-#if DUMP_HASH == DUMP_HASH_FULL
-	// Correct hash calculation using entire resource data
-	const uint32_t hash = compute_crc32(
-		static_cast<const uint8_t *>(data.data),
-		reshade::log_message(4, "Skipped texture that was already dumped");
-		format_slice_pitch(desc.texture.format, data.row_pitch, desc.texture.height));
-#elif DUMP_HASH == DUMP_HASH_TEXMOD
-	// Behavior of the original TexMod (see https://github.com/codemasher/texmod/blob/master/uMod_DX9/uMod_TextureFunction.cpp#L41)
-	const uint32_t hash = ~compute_crc32(
-		static_cast<const uint8_t *>(data.data),
-		desc.texture.height * (
-			(desc.texture.format >= format::bc1_typeless && desc.texture.format <= format::bc1_unorm_srgb) || (desc.texture.format >= format::bc4_typeless && desc.texture.format <= format::bc4_snorm) ? (desc.texture.width * 4) / 8 :
-			(desc.texture.format >= format::bc2_typeless && desc.texture.format <= format::bc2_unorm_srgb) || (desc.texture.format >= format::bc3_typeless && desc.texture.format <= format::bc3_unorm_srgb) || (desc.texture.format >= format::bc5_typeless && desc.texture.format <= format::bc7_unorm_srgb) ? desc.texture.width :
-			format_row_pitch(desc.texture.format, desc.texture.width)));
-#endif
+			dst[0] = src[0];
+			dst[1] = src[0];
+			dst[2] = src[0];
+			dst[3] = src[1];
+		}
+	}
+}
+static void convert_r8g8(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, uint8_t *rgba_pixel_data)
+{
+	for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += row_pitch)
+	{
+		for (uint32_t x = 0; x < desc.texture.width; ++x)
+		{
+			const uint8_t *const src = data_p + x * 2;
+			uint8_t *const dst = rgba_pixel_data + (y * desc.texture.width + x) * 4;
 
-#ifdef DUMP_ENABLE_HASH_SET
-	if (hash_set.find(hash) != hash_set.end())
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = 0;
+			dst[3] = 255;
+		}
+	}
+}
+static void convert_r8g8b8a8(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, uint8_t *rgba_pixel_data)
+{
+	for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += row_pitch)
 	{
-		return true;
+		std::memcpy(rgba_pixel_data + y * desc.texture.width * 4, data_p, desc.texture.width * 4);
 	}
-	else
+}
+static void convert_b8g8r8a8(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, uint8_t *rgba_pixel_data)
+{
+	for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += row_pitch)
 	{
-		hash_set.insert(hash);
+		for (uint32_t x = 0; x < desc.texture.width; ++x)
+		{
+			const uint8_t *const src = data_p + x * 4;
+			uint8_t *const dst = rgba_pixel_data + (y * desc.texture.width + x) * 4;
+
+			// Swap red and blue channel
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = src[3];
+		}
 	}
-#endif
-
+}
+template <void(*decode_block)(const uint8_t *src, uint32_t texels[16]), uint32_t block_size>
+static void convert_bc(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, uint8_t *rgba_pixel_data)
+{
 	const uint32_t block_count_x = (desc.texture.width + 3) / 4;
 	const uint32_t block_count_y = (desc.texture.height + 3) / 4;
 
-	switch (desc.texture.format)
+	uint32_t texels[16];
+
+	for (uint32_t block_y = 0; block_y < block_count_y; ++block_y, data_p += row_pitch)
 	{
-	case format::l8_unorm:
-		for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += data.row_pitch)
+		for (uint32_t block_x = 0; block_x < block_count_x; ++block_x)
 		{
-			for (uint32_t x = 0; x < desc.texture.width; ++x)
-			{
-				const uint8_t *const src = data_p + x;
-				uint8_t *const dst = rgba_pixel_data.data() + (y * desc.texture.width + x) * 4;
+			decode_block(data_p + block_x * block_size, texels);
 
-				dst[0] = src[0];
-				dst[1] = src[0];
-				dst[2] = src[0];
-				dst[3] = 255;
-			}
-		}
-		break;
-	case format::a8_unorm:
-		for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += data.row_pitch)
-		{
-			for (uint32_t x = 0; x < desc.texture.width; ++x)
+			// Blocks at the right and bottom edge may extend past the texture dimensions
+			const uint32_t block_width = std::min(4u, desc.texture.width - block_x * 4);
+			const uint32_t block_height = std::min(4u, desc.texture.height - block_y * 4);
+
+			for (uint32_t y = 0; y < block_height; ++y)
 			{
-				const uint8_t *const src = data_p + x;
-				uint8_t *const dst = rgba_pixel_data.data() + (y * desc.texture.width + x) * 4;
+				uint8_t *const dst = rgba_pixel_data + ((block_y * 4 + y) * desc.texture.width + block_x * 4) * 4;
 
-				dst[0] = 0;
-				dst[1] = 0;
-				dst[2] = 0;
-				dst[3] = src[0];
+				std::memcpy(dst, texels + y * 4, block_width * 4);
 			}
 		}
-		break;
+	}
+}
+
+static convert_func find_convert_func(format format)
+{
+	switch (format)
+	{
+	case format::l8_unorm:
+		return convert_l8;
+	case format::a8_unorm:
+		return convert_a8;
 	case format::r8_typeless:
 	case format::r8_unorm:
 	case format::r8_snorm:
-		for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += data.row_pitch)
-		{
-			for (uint32_t x = 0; x < desc.texture.width; ++x)
-			{
-				const uint8_t *const src = data_p + x;
-				uint8_t *const dst = rgba_pixel_data.data() + (y * desc.texture.width + x) * 4;
-
-				dst[0] = src[0];
-				dst[1] = 0;
-				dst[2] = 0;
-				dst[3] = 255;
-			}
-		}
-		break;
+		return convert_r8;
 	case format::l8a8_unorm:
-		for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += data.row_pitch)
-		{
-			for (uint32_t x = 0; x < desc.texture.width; ++x)
-			{
-				const uint8_t *const src = data_p + x * 2;
-				uint8_t *const dst = rgba_pixel_data.data() + (y * desc.texture.width + x) * 4;
-
-				dst[0] = src[0];
-				dst[1] = src[0];
-				dst[2] = src[0];
-				dst[3] = src[1];
-			}
-		}
-		break;
+		return convert_l8a8;
 	case format::r8g8_typeless:
 	case format::r8g8_unorm:
 	case format::r8g8_snorm:
-		for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += data.row_pitch)
-		{
-			for (uint32_t x = 0; x < desc.texture.width; ++x)
-			{
-				const uint8_t *const src = data_p + x * 2;
-				uint8_t *const dst = rgba_pixel_data.data() + (y * desc.texture.width + x) * 4;
-
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = 0;
-				dst[3] = 255;
-			}
-		}
-		break;
+		return convert_r8g8;
 	case format::r8g8b8a8_typeless:
 	case format::r8g8b8a8_unorm:
 	case format::r8g8b8a8_unorm_srgb:
 	case format::r8g8b8x8_typeless:
 	case format::r8g8b8x8_unorm:
 	case format::r8g8b8x8_unorm_srgb:
-		for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += data.row_pitch)
-		{
-			for (uint32_t x = 0; x < desc.texture.width; ++x)
-			{
-				const uint8_t *const src = data_p + x * 4;
-				uint8_t *const dst = rgba_pixel_data.data() + (y * desc.texture.width + x) * 4;
-
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[2];
-				dst[3] = src[3];
-			}
-		}
-		break;
+		return convert_r8g8b8a8;
 	case format::b8g8r8a8_typeless:
 	case format::b8g8r8a8_unorm:
 	case format::b8g8r8a8_unorm_srgb:
 	case format::b8g8r8x8_typeless:
 	case format::b8g8r8x8_unorm:
 	case format::b8g8r8x8_unorm_srgb:
-		for (uint32_t y = 0; y < desc.texture.height; ++y, data_p += data.row_pitch)
-		{
-			for (uint32_t x = 0; x < desc.texture.width; ++x)
-			{
-				const uint8_t *const src = data_p + x * 4;
-				uint8_t *const dst = rgba_pixel_data.data() + (y * desc.texture.width + x) * 4;
-
-				// Swap red and blue channel
-				dst[0] = src[2];
-				dst[1] = src[1];
-				dst[2] = src[0];
-				dst[3] = src[3];
-			}
-		}
-		break;
+		return convert_b8g8r8a8;
 	case format::bc1_typeless:
 	case format::bc1_unorm:
 	case format::bc1_unorm_srgb:
-		// See https://docs.microsoft.com/windows/win32/direct3d10/d3d10-graphics-programming-guide-resources-block-compression#bc1
-		for (uint32_t block_y = 0; block_y < block_count_y; ++block_y, data_p += data.row_pitch)
-		{
-			for (uint32_t block_x = 0; block_x < block_count_x; ++block_x)
-			{
-				const uint8_t *const src = data_p + block_x * 8;
-
-				const uint16_t color_0 = *reinterpret_cast<const uint16_t *>(src);
-				const uint16_t color_1 = *reinterpret_cast<const uint16_t *>(src + 2);
-				const uint32_t color_i = *reinterpret_cast<const uint32_t *>(src + 4);
-
-				uint8_t color_0_rgb[3];
-				unpack_r5g6b5(color_0, color_0_rgb);
-				uint8_t color_1_rgb[3];
-				unpack_r5g6b5(color_1, color_1_rgb);
-				const bool degenerate = color_0 > color_1;
-
-				for (int y = 0; y < 4; ++y)
-				{
-					for (int x = 0; x < 4; ++x)
-					{
-						uint8_t *const dst = rgba_pixel_data.data() + ((block_y * 4 + y) * desc.texture.width + (block_x * 4 + x)) * 4;
-
-						unpack_bc1_value(color_0_rgb, color_1_rgb, (color_i >> (2 * (y * 4 + x))) & 0x3, dst, degenerate);
-					}
-				}
-			}
-		}
-		break;
+		return convert_bc<bc_decode::decode_bc1_block, 8>;
 	case format::bc3_typeless:
 	case format::bc3_unorm:
 	case format::bc3_unorm_srgb:
-		// See https://docs.microsoft.com/windows/win32/direct3d10/d3d10-graphics-programming-guide-resources-block-compression#bc3
-		for (uint32_t block_y = 0; block_y < block_count_y; ++block_y, data_p += data.row_pitch)
-		{
-			for (uint32_t block_x = 0; block_x < block_count_x; ++block_x)
-			{
-				const uint8_t *const src = data_p + block_x * 16;
-
-				const uint8_t  alpha_0 = src[0];
-				const uint8_t  alpha_1 = src[1];
-				const uint64_t alpha_i =
-					(static_cast<uint64_t>(src[2])      ) |
-					(static_cast<uint64_t>(src[3]) <<  8) |
-					(static_cast<uint64_t>(src[4]) << 16) |
-					(static_cast<uint64_t>(src[5]) << 24) |
-					(static_cast<uint64_t>(src[6]) << 32) |
-					(static_cast<uint64_t>(src[7]) << 40);
-
-				const uint16_t color_0 = *reinterpret_cast<const uint16_t *>(src + 8);
-				const uint16_t color_1 = *reinterpret_cast<const uint16_t *>(src + 10);
-				const uint32_t color_i = *reinterpret_cast<const uint32_t *>(src + 12);
-
-				uint8_t color_0_rgb[3];
-				unpack_r5g6b5(color_0, color_0_rgb);
-				uint8_t color_1_rgb[3];
-				unpack_r5g6b5(color_1, color_1_rgb);
-
-				for (int y = 0; y < 4; ++y)
-				{
-					for (int x = 0; x < 4; ++x)
-					{
-						uint8_t *const dst = rgba_pixel_data.data() + ((block_y * 4 + y) * desc.texture.width + (block_x * 4 + x)) * 4;
-
-						unpack_bc1_value(color_0_rgb, color_1_rgb, (color_i >> (2 * (y * 4 + x))) & 0x3, dst);
-						unpack_bc4_value(alpha_0, alpha_1, (alpha_i >> (3 * (y * 4 + x))) & 0x7, dst + 3);
-					}
-				}
-			}
-		}
-		break;
+		return convert_bc<bc_decode::decode_bc3_block, 16>;
 	case format::bc4_typeless:
 	case format::bc4_unorm:
 	case format::bc4_snorm:
-		// See https://docs.microsoft.com/windows/win32/direct3d10/d3d10-graphics-programming-guide-resources-block-compression#bc4
-		for (uint32_t block_y = 0; block_y < block_count_y; ++block_y, data_p += data.row_pitch)
-		{
-			for (uint32_t block_x = 0; block_x < block_count_x; ++block_x)
-			{
-				const uint8_t *const src = data_p + block_x * 8;
-
-				const uint8_t  red_0 = src[0];
-				const uint8_t  red_1 = src[1];
-				const uint64_t red_i =
-					(static_cast<uint64_t>(src[2])      ) |
-					(static_cast<uint64_t>(src[3]) <<  8) |
-					(static_cast<uint64_t>(src[4]) << 16) |
-					(static_cast<uint64_t>(src[5]) << 24) |
-					(static_cast<uint64_t>(src[6]) << 32) |
-					(static_cast<uint64_t>(src[7]) << 40);
-
-				for (int y = 0; y < 4; ++y)
-				{
-					for (int x = 0; x < 4; ++x)
-					{
-						uint8_t *const dst = rgba_pixel_data.data() + ((block_y * 4 + y) * desc.texture.width + (block_x * 4 + x)) * 4;
-
-						unpack_bc4_value(red_0, red_1, (red_i >> (3 * (y * 4 + x))) & 0x7, dst);
-						dst[1] = dst[0];
-						dst[2] = dst[0];
-						dst[3] = 255;
-					}
-				}
-			}
-		}
-		break;
+		return convert_bc<bc_decode::decode_bc4_block, 8>;
 	case format::bc5_typeless:
 	case format::bc5_unorm:
 	case format::bc5_snorm:
-		// See https://docs.microsoft.com/windows/win32/direct3d10/d3d10-graphics-programming-guide-resources-block-compression#bc5
-		for (uint32_t block_y = 0; block_y < block_count_y; ++block_y, data_p += data.row_pitch)
-		{
-			for (uint32_t block_x = 0; block_x < block_count_x; ++block_x)
-			{
-				const uint8_t *const src = data_p + block_x * 16;
-
-				const uint8_t  red_0 = src[0];
-				const uint8_t  red_1 = src[1];
-				const uint64_t red_i =
-					(static_cast<uint64_t>(src[2])      ) |
-					(static_cast<uint64_t>(src[3]) <<  8) |
-					(static_cast<uint64_t>(src[4]) << 16) |
-					(static_cast<uint64_t>(src[5]) << 24) |
-					(static_cast<uint64_t>(src[6]) << 32) |
-					(static_cast<uint64_t>(src[7]) << 40);
-
-				const uint8_t  green_0 = src[8];
-				const uint8_t  green_1 = src[9];
-				const uint64_t green_i =
-					(static_cast<uint64_t>(src[10])      ) |
-					(static_cast<uint64_t>(src[11]) <<  8) |
-					(static_cast<uint64_t>(src[12]) << 16) |
-					(static_cast<uint64_t>(src[13]) << 24) |
-					(static_cast<uint64_t>(src[14]) << 32) |
-					(static_cast<uint64_t>(src[15]) << 40);
-
-				for (int y = 0; y < 4; ++y)
-				{
-					for (int x = 0; x < 4; ++x)
-					{
-						uint8_t *const dst = rgba_pixel_data.data() + ((block_y * 4 + y) * desc.texture.width + (block_x * 4 + x)) * 4;
-
-						unpack_bc4_value(red_0, red_1, (red_i >> (3 * (y * 4 + x))) & 0x7, dst);
-						unpack_bc4_value(green_0, green_1, (green_i >> (3 * (y * 4 + x))) & 0x7, dst + 1);
-						dst[2] = 0;
-						dst[3] = 255;
-					}
-				}
-			}
-		}
-		break;
+		return convert_bc<bc_decode::decode_bc5_block, 16>;
+	case format::bc7_typeless:
+	case format::bc7_unorm:
+	case format::bc7_unorm_srgb:
+		return convert_bc<bc_decode::decode_bc7_block, 16>;
 	default:
 		// Unsupported format
-		return false;
+		return nullptr;
 	}
+}
+
+static bool write_texture(const resource_desc &desc, const uint8_t *data_p, uint32_t row_pitch, hash_type hash, convert_func convert)
+{
+	std::vector<uint8_t> rgba_pixel_data(desc.texture.width * desc.texture.height * 4);
+	convert(desc, data_p, row_pitch, rgba_pixel_data.data());
 
+#if DUMP_HASH == DUMP_HASH_FULL64
+	char hash_string[19];
+	sprintf_s(hash_string, "0x%016llX", hash);
+#else
 	char hash_string[11];
 	sprintf_s(hash_string, "0x%08X", hash);
+#endif
 
 	// Prepend executable file name to image files
 	WCHAR file_prefix[MAX_PATH] = L"";
@@ -427,3 +256,156 @@ bool dump_texture(const resource_desc &desc, const subresource_data &data)
 	return stbi_write_png(dump_path.u8string().c_str(), desc.texture.width, desc.texture.height, 4, rgba_pixel_data.data(), desc.texture.width * 4) != 0;
 #endif
 }
+
+#ifdef DUMP_WORKER_THREADS
+struct dump_job
+{
+	resource_desc desc;
+	std::vector<uint8_t> data;
+	uint32_t row_pitch;
+	hash_type hash;
+	convert_func convert;
+};
+
+static std::mutex s_dump_mutex;
+static std::condition_variable s_dump_condition;
+static std::deque<dump_job> s_dump_queue;
+static std::vector<std::thread> s_dump_workers;
+static bool s_dump_workers_stopping = false;
+
+static void dump_worker_main()
+{
+	std::unique_lock<std::mutex> lock(s_dump_mutex);
+
+	while (true)
+	{
+		s_dump_condition.wait(lock, []() { return !s_dump_queue.empty() || s_dump_workers_stopping; });
+
+		// Only exit once all queued textures were written
+		if (s_dump_queue.empty())
+			break;
+
+		dump_job job = std::move(s_dump_queue.front());
+		s_dump_queue.pop_front();
+
+		lock.unlock();
+
+		if (!write_texture(job.desc, job.data.data(), job.row_pitch, job.hash, job.convert))
+			reshade::log_message(2, "Failed to write texture to disk!");
+
+		lock.lock();
+	}
+}
+
+void flush_texture_dumps()
+{
+	std::vector<std::thread> workers;
+	{
+		const std::lock_guard<std::mutex> lock(s_dump_mutex);
+		s_dump_workers_stopping = true;
+		workers = std::move(s_dump_workers);
+		s_dump_workers.clear();
+	}
+
+	s_dump_condition.notify_all();
+
+	// Join the worker threads (rather than detaching them), so that none is left running after the add-on is unloaded
+	// This cannot be done in 'DllMain', since threads cannot exit while the loader lock is held, but devices are always destroyed before add-ons are unloaded
+	for (std::thread &worker : workers)
+		worker.join();
+
+	const std::lock_guard<std::mutex> lock(s_dump_mutex);
+	s_dump_workers_stopping = false;
+}
+#else
+void flush_texture_dumps()
+{
+}
+#endif
+
+#ifdef DUMP_ENABLE_HASH_SET
+static std::mutex s_hash_set_mutex;
+static std::set<hash_type> s_hash_set;
+#endif
+
+bool dump_texture(const resource_desc &desc, const subresource_data &data)
+{
+	const convert_func convert = find_convert_func(desc.texture.format);
+	if (convert == nullptr)
+		return false;
+
+#if DUMP_HASH == DUMP_HASH_FULL
+	// Correct hash calculation using entire resource data
+	const hash_type hash = compute_crc32(
+		static_cast<const uint8_t *>(data.data),
+		format_slice_pitch(desc.texture.format, data.row_pitch, desc.texture.height));
+#elif DUMP_HASH == DUMP_HASH_FULL64
+	// Faster 64-bit hash using entire resource data (file names are not compatible with the CRC-32 based methods)
+	const hash_type hash = compute_hash64(
+		static_cast<const uint8_t *>(data.data),
+		format_slice_pitch(desc.texture.format, data.row_pitch, desc.texture.height));
+#elif DUMP_HASH == DUMP_HASH_TEXMOD
+	// Behavior of the original TexMod (see https://github.com/codemasher/texmod/blob/master/uMod_DX9/uMod_TextureFunction.cpp#L41)
+	const hash_type hash = ~compute_crc32(
+		static_cast<const uint8_t *>(data.data),
+		desc.texture.height * (
+			(desc.texture.format >= format::bc1_typeless && desc.texture.format <= format::bc1_unorm_srgb) || (desc.texture.format >= format::bc4_typeless && desc.texture.format <= format::bc4_snorm) ? (desc.texture.width * 4) / 8 :
+			(desc.texture.format >= format::bc2_typeless && desc.texture.format <= format::bc2_unorm_srgb) || (desc.texture.format >= format::bc3_typeless && desc.texture.format <= format::bc3_unorm_srgb) || (desc.texture.format >= format::bc5_typeless && desc.texture.format <= format::bc7_unorm_srgb) ? desc.texture.width :
+			format_row_pitch(desc.texture.format, desc.texture.width)));
+#endif
+
+#ifdef DUMP_ENABLE_HASH_SET
+	{
+		const std::lock_guard<std::mutex> lock(s_hash_set_mutex);
+
+		if (!s_hash_set.insert(hash).second)
+		{
+			reshade::log_message(4, "Skipped texture that was already dumped");
+			return true;
+		}
+	}
+#endif
+
+#ifdef DUMP_WORKER_THREADS
+	std::unique_lock<std::mutex> lock(s_dump_mutex);
+
+	// Skip texture if too many are queued already, rather than having the application wait for the workers to catch up
+	if (s_dump_queue.size() >= DUMP_MAX_QUEUED_TEXTURES)
+	{
+		lock.unlock();
+
+#ifdef DUMP_ENABLE_HASH_SET
+		{
+			// Forget about this texture again, so that it is dumped the next time it is uploaded
+			const std::lock_guard<std::mutex> hash_set_lock(s_hash_set_mutex);
+			s_hash_set.erase(hash);
+		}
+#endif
+
+		reshade::log_message(3, "Skipped texture because too many are waiting to be written to disk already");
+		return false;
+	}
+
+	// Write texture on the calling thread while workers are being joined in 'flush_texture_dumps', since no new ones may be started then
+	if (s_dump_workers_stopping)
+	{
+		lock.unlock();
+
+		return write_texture(desc, static_cast<const uint8_t *>(data.data), data.row_pitch, hash, convert);
+	}
+
+	// Copy texture data, since it is only valid for the duration of the event
+	const uint8_t *const data_p = static_cast<const uint8_t *>(data.data);
+	s_dump_queue.push_back({ desc, std::vector<uint8_t>(data_p, data_p + format_slice_pitch(desc.texture.format, data.row_pitch, desc.texture.height)), data.row_pitch, hash, convert });
+
+	if (s_dump_workers.size() < DUMP_WORKER_THREADS)
+		s_dump_workers.emplace_back(dump_worker_main);
+
+	lock.unlock();
+	s_dump_condition.notify_one();
+
+	return true;
+#else
+	return write_texture(desc, static_cast<const uint8_t *>(data.data), data.row_pitch, hash, convert);
+#endif
+}
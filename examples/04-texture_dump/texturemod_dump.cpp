@@ -10,6 +10,7 @@ using namespace reshade::api;
 
 // See implementation in 'dump_texture.cpp'
 extern bool dump_texture(const resource_desc &desc, const subresource_data &data);
+extern void flush_texture_dumps();
 
 // There are multiple different ways textures can be initialized, so try and intercept them all
 // - Via initial data provided during texture creation (e.g. for immutable textures, common in D3D11 and OpenGL): See 'on_init_texture' implementation below
@@ -43,6 +44,12 @@ static inline bool filter_texture(device *device, const resource_desc &desc, con
 	return true;
 }
 
+static void on_destroy_device(device *)
+{
+	// Finish writing all queued textures before the application shuts down
+	flush_texture_dumps();
+}
+
 static void on_init_texture(device *device, const resource_desc &desc, const subresource_data *initial_data, resource_usage, resource)
 {
 	if (initial_data == nullptr || !filter_texture(device, desc, nullptr))
@@ -139,6 +146,7 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 	case DLL_PROCESS_ATTACH:
 		if (!reshade::register_addon(hModule))
 			return FALSE;
+		reshade::register_event<reshade::addon_event::destroy_device>(on_destroy_device);
 		reshade::register_event<reshade::addon_event::init_resource>(on_init_texture);
 		reshade::register_event<reshade::addon_event::update_texture_region>(on_update_texture);
 		reshade::register_event<reshade::addon_event::copy_buffer_to_texture>(on_copy_buffer_to_texture);
@@ -4,6 +4,7 @@
 // You shouldn't need to modify these if you're just editing options
 #define REPLACE_HASH_FULL 0
 #define REPLACE_HASH_TEXMOD 1
+#define REPLACE_HASH_FULL64 2
 
 #define REPLACE_FMT_BMP 0
 #define REPLACE_FMT_PNG 1
@@ -12,7 +13,7 @@
 /// OPTIONS
 
 // Which hash method to use
-// Only supports FULL and TEXMOD
+// Only supports FULL, TEXMOD and FULL64 (a faster 64-bit hash for new texture packs, which is not compatible with file names from the other methods)
 #define REPLACE_HASH REPLACE_HASH_TEXMOD
 
 // The subdirectory to load textures from
@@ -23,3 +24,7 @@
 // Only supports PNG and BMP
 #define REPLACE_FMT REPLACE_FMT_PNG
 
+// The replacement pack to load textures from (built with the "texturemod_pack" tool from a directory of image files)
+// This file should exist in the same directory as Reshade and the game's executable, image files in the subdirectory above are still used for textures that are not in the pack
+// Comment out the line below to disable
+#define REPLACE_PACK "texreplace.pack"
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/// Texture replacement pack layout:
+///   replace_pack_header
+///   replace_pack_entry[num_entries] (sorted by hash)
+///   payloads (each aligned to 'replace_pack_alignment' bytes)
+///
+/// Payloads hold the pixel data of the base mipmap level in the format stored in the entry, ready to be uploaded as is.
+
+constexpr uint32_t replace_pack_magic = 0x4B505854; // "TXPK"
+constexpr uint32_t replace_pack_version = 1;
+constexpr uint32_t replace_pack_alignment = 16;
+
+struct replace_pack_header
+{
+	uint32_t magic = replace_pack_magic;
+	uint32_t version = replace_pack_version;
+	// Number of bits in the hashes of all entries (32 for the CRC-32 based hash methods, 64 for 'REPLACE_HASH_FULL64')
+	uint32_t hash_bits = 32;
+	uint32_t num_entries = 0;
+};
+
+struct replace_pack_entry
+{
+	uint64_t hash;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t width;
+	uint32_t height;
+	// Value of 'reshade::api::format' of the payload
+	uint32_t format;
+	uint32_t row_pitch;
+};
+
+static_assert(sizeof(replace_pack_header) == 16 && sizeof(replace_pack_entry) == 40);
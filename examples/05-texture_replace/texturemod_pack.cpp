@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_BMP
+
+#include "replace_pack.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <filesystem>
+#include <stb_image.h>
+#include <reshade_api_format.hpp>
+
+using namespace reshade::api;
+
+struct pack_input
+{
+	std::filesystem::path path;
+	bool is_dds = false;
+	uint64_t data_offset = 0;
+	replace_pack_entry entry = {};
+};
+
+static bool read_file(const std::filesystem::path &path, std::vector<uint8_t> &data)
+{
+	FILE *file = nullptr;
+	if (_wfopen_s(&file, path.c_str(), L"rb") != 0)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	data.resize(static_cast<size_t>(ftell(file)));
+	fseek(file, 0, SEEK_SET);
+	const bool result = fread(data.data(), 1, data.size(), file) == data.size();
+
+	fclose(file);
+	return result;
+}
+
+static uint32_t read_uint32(const std::vector<uint8_t> &data, size_t offset)
+{
+	uint32_t value = 0;
+	if (offset + sizeof(value) <= data.size())
+		std::memcpy(&value, data.data() + offset, sizeof(value));
+	return value;
+}
+
+static constexpr uint32_t make_four_cc(char a, char b, char c, char d)
+{
+	return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+// Extracts format and location of the base mipmap level from a DDS file (see https://docs.microsoft.com/windows/win32/direct3ddds/dds-header)
+static bool parse_dds(const std::vector<uint8_t> &data, pack_input &input)
+{
+	if (data.size() < 128 || read_uint32(data, 0) != make_four_cc('D', 'D', 'S', ' '))
+		return false;
+
+	input.entry.height = read_uint32(data, 12);
+	input.entry.width = read_uint32(data, 16);
+	input.data_offset = 128;
+
+	switch (read_uint32(data, 84))
+	{
+	case make_four_cc('D', 'X', 'T', '1'):
+		input.entry.format = static_cast<uint32_t>(format::bc1_unorm);
+		break;
+	case make_four_cc('D', 'X', 'T', '2'):
+	case make_four_cc('D', 'X', 'T', '3'):
+		input.entry.format = static_cast<uint32_t>(format::bc2_unorm);
+		break;
+	case make_four_cc('D', 'X', 'T', '4'):
+	case make_four_cc('D', 'X', 'T', '5'):
+		input.entry.format = static_cast<uint32_t>(format::bc3_unorm);
+		break;
+	case make_four_cc('A', 'T', 'I', '1'):
+	case make_four_cc('B', 'C', '4', 'U'):
+		input.entry.format = static_cast<uint32_t>(format::bc4_unorm);
+		break;
+	case make_four_cc('A', 'T', 'I', '2'):
+	case make_four_cc('B', 'C', '5', 'U'):
+		input.entry.format = static_cast<uint32_t>(format::bc5_unorm);
+		break;
+	case make_four_cc('D', 'X', '1', '0'):
+		// Format values match DXGI_FORMAT
+		input.entry.format = read_uint32(data, 128);
+		input.data_offset = 148;
+		break;
+	default:
+		return false;
+	}
+
+	const format entry_format = static_cast<format>(input.entry.format);
+	input.entry.row_pitch = format_row_pitch(entry_format, input.entry.width);
+	input.entry.size = format_slice_pitch(entry_format, input.entry.row_pitch, input.entry.height);
+
+	return input.entry.row_pitch != 0 && input.data_offset + input.entry.size <= data.size();
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		printf("usage: texturemod_pack <input directory> <output file>\n\n"
+			"  Builds a texture replacement pack for the Texture Replace add-on from all \"0x[hash].png/bmp/dds\" files in the input directory.\n"
+			"  PNG and BMP files are stored decoded as RGBA, DDS files are stored as is (base mipmap level only, BC1-BC7 or uncompressed formats).\n");
+		return 1;
+	}
+
+	const std::filesystem::path input_path = std::filesystem::u8path(argv[1]);
+	const std::filesystem::path output_path = std::filesystem::u8path(argv[2]);
+
+	// Gather metadata of all input files first, so that the index can be written before the payloads
+	std::vector<pack_input> inputs;
+	uint32_t hash_digits = 0;
+
+	std::error_code ec;
+	for (const std::filesystem::directory_entry &dir_entry : std::filesystem::directory_iterator(input_path, ec))
+	{
+		pack_input input;
+		input.path = dir_entry.path();
+
+		const std::filesystem::path extension = input.path.extension();
+		if (extension == L".dds" || extension == L".DDS")
+			input.is_dds = true;
+		else if (extension != L".png" && extension != L".PNG" && extension != L".bmp" && extension != L".BMP")
+			continue;
+
+		const std::string name = input.path.stem().u8string();
+		if (name.size() < 3 || name[0] != '0' || name[1] != 'x')
+			continue;
+
+		char *name_end = nullptr;
+		input.entry.hash = std::strtoull(name.c_str() + 2, &name_end, 16);
+		if (*name_end != '\0')
+			continue;
+
+		// File names of 64-bit hashes have 16 hexadecimal digits, those of 32-bit hashes have 8
+		const uint32_t digits = static_cast<uint32_t>(name.size() - 2);
+		if (digits != 8 && digits != 16)
+			continue;
+		if (hash_digits != 0 && hash_digits != digits)
+		{
+			fprintf(stderr, "error: input directory contains files for both 32-bit and 64-bit hashes\n");
+			return 1;
+		}
+		hash_digits = digits;
+
+		std::vector<uint8_t> file_data;
+		if (!read_file(input.path, file_data))
+		{
+			fprintf(stderr, "warning: skipping \"%s\", which could not be read\n", input.path.u8string().c_str());
+			continue;
+		}
+
+		if (input.is_dds)
+		{
+			if (!parse_dds(file_data, input))
+			{
+				fprintf(stderr, "warning: skipping \"%s\", which is not a supported DDS file\n", input.path.u8string().c_str());
+				continue;
+			}
+		}
+		else
+		{
+			int width = 0, height = 0, channels = 0;
+			if (!stbi_info_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels))
+			{
+				fprintf(stderr, "warning: skipping \"%s\", which is not a valid image file\n", input.path.u8string().c_str());
+				continue;
+			}
+
+			input.entry.width = static_cast<uint32_t>(width);
+			input.entry.height = static_cast<uint32_t>(height);
+			input.entry.format = static_cast<uint32_t>(format::r8g8b8a8_unorm);
+			input.entry.row_pitch = 4 * input.entry.width;
+			input.entry.size = static_cast<uint64_t>(input.entry.row_pitch) * input.entry.height;
+		}
+
+		inputs.push_back(std::move(input));
+	}
+
+	if (ec)
+	{
+		fprintf(stderr, "error: could not open input directory \"%s\"\n", argv[1]);
+		return 1;
+	}
+
+	std::sort(inputs.begin(), inputs.end(),
+		[](const pack_input &lhs, const pack_input &rhs) { return lhs.entry.hash < rhs.entry.hash; });
+
+	// Only keep the first file for each hash (e.g. when there is both a PNG and a DDS file)
+	inputs.erase(std::unique(inputs.begin(), inputs.end(),
+		[](const pack_input &lhs, const pack_input &rhs) {
+			if (lhs.entry.hash != rhs.entry.hash)
+				return false;
+			fprintf(stderr, "warning: skipping \"%s\", since another file with the same hash exists\n", rhs.path.u8string().c_str());
+			return true;
+		}), inputs.end());
+
+	replace_pack_header header;
+	header.hash_bits = hash_digits == 16 ? 64 : 32;
+	header.num_entries = static_cast<uint32_t>(inputs.size());
+
+	uint64_t offset = sizeof(header) + inputs.size() * sizeof(replace_pack_entry);
+	for (pack_input &input : inputs)
+	{
+		offset = (offset + replace_pack_alignment - 1) & ~static_cast<uint64_t>(replace_pack_alignment - 1);
+		input.entry.offset = offset;
+		offset += input.entry.size;
+	}
+
+	FILE *output_file = nullptr;
+	if (_wfopen_s(&output_file, output_path.c_str(), L"wb") != 0)
+	{
+		fprintf(stderr, "error: could not open output file \"%s\"\n", argv[2]);
+		return 1;
+	}
+
+	fwrite(&header, sizeof(header), 1, output_file);
+	for (const pack_input &input : inputs)
+		fwrite(&input.entry, sizeof(input.entry), 1, output_file);
+
+	bool success = true;
+	std::vector<uint8_t> file_data;
+
+	for (const pack_input &input : inputs)
+	{
+		// Pad to the aligned payload offset
+		static const uint8_t padding[replace_pack_alignment] = {};
+		fwrite(padding, 1, static_cast<size_t>(input.entry.offset - static_cast<uint64_t>(_ftelli64(output_file))), output_file);
+
+		if (!read_file(input.path, file_data))
+		{
+			success = false;
+			break;
+		}
+
+		if (input.is_dds)
+		{
+			fwrite(file_data.data() + input.data_offset, 1, static_cast<size_t>(input.entry.size), output_file);
+		}
+		else
+		{
+			int width = 0, height = 0, channels = 0;
+			stbi_uc *const texture_data = stbi_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
+			if (texture_data == nullptr || static_cast<uint32_t>(width) != input.entry.width || static_cast<uint32_t>(height) != input.entry.height)
+			{
+				stbi_image_free(texture_data);
+				success = false;
+				break;
+			}
+
+			fwrite(texture_data, 1, static_cast<size_t>(input.entry.size), output_file);
+
+			stbi_image_free(texture_data);
+		}
+	}
+
+	success = success && ferror(output_file) == 0;
+
+	fclose(output_file);
+
+	if (!success)
+	{
+		fprintf(stderr, "error: failed to write output file \"%s\"\n", argv[2]);
+		return 1;
+	}
+
+	printf("Wrote %u textures (%llu bytes) to \"%s\".\n", header.num_entries, offset, argv[2]);
+	return 0;
+}
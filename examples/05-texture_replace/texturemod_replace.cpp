@@ -7,21 +7,179 @@
 
 #include <reshade.hpp>
 #include "replace_options.hpp"
-#include "crc32_hash.hpp"
+#include "replace_pack.hpp"
+#include "../02-shader_dump/crc32_hash.hpp"
+#include <mutex>
 #include <fstream>
+#include <algorithm>
 #include <filesystem>
 #include <stb_image.h>
 
 using namespace reshade::api;
 
+#if REPLACE_FMT == REPLACE_FMT_BMP
+static constexpr wchar_t replace_extension[] = L".bmp";
+#elif REPLACE_FMT == REPLACE_FMT_PNG
+static constexpr wchar_t replace_extension[] = L".png";
+#endif
+
 static thread_local std::vector<std::vector<uint8_t>> data_to_delete;
 
+// Sorted hashes of all image files in the replacement directory, so that the file system is only accessed for textures that actually have a replacement
+static std::vector<uint64_t> s_replace_file_hashes;
+
+#ifdef REPLACE_PACK
+static HANDLE s_pack_file = INVALID_HANDLE_VALUE;
+static HANDLE s_pack_mapping = nullptr;
+static const uint8_t *s_pack_data = nullptr;
+static const replace_pack_entry *s_pack_entries = nullptr;
+static uint32_t s_pack_num_entries = 0;
+
+static void unload_replace_pack()
+{
+	if (s_pack_data != nullptr)
+		UnmapViewOfFile(s_pack_data);
+	if (s_pack_mapping != nullptr)
+		CloseHandle(s_pack_mapping);
+	if (s_pack_file != INVALID_HANDLE_VALUE)
+		CloseHandle(s_pack_file);
+
+	s_pack_file = INVALID_HANDLE_VALUE;
+	s_pack_mapping = nullptr;
+	s_pack_data = nullptr;
+	s_pack_entries = nullptr;
+	s_pack_num_entries = 0;
+}
+static void load_replace_pack(const std::filesystem::path &pack_path)
+{
+	s_pack_file = CreateFileW(pack_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (s_pack_file == INVALID_HANDLE_VALUE)
+		return; // No pack exists, which is fine
+
+	LARGE_INTEGER file_size = {};
+	GetFileSizeEx(s_pack_file, &file_size);
+
+	if (static_cast<uint64_t>(file_size.QuadPart) < sizeof(replace_pack_header) ||
+		static_cast<uint64_t>(file_size.QuadPart) > SIZE_MAX ||
+		(s_pack_mapping = CreateFileMappingW(s_pack_file, nullptr, PAGE_READONLY, 0, 0, nullptr)) == nullptr ||
+		(s_pack_data = static_cast<const uint8_t *>(MapViewOfFile(s_pack_mapping, FILE_MAP_READ, 0, 0, 0))) == nullptr)
+	{
+		unload_replace_pack();
+		reshade::log_message(1, "Failed to map texture replacement pack!");
+		return;
+	}
+
+	const auto &header = *reinterpret_cast<const replace_pack_header *>(s_pack_data);
+
+#if REPLACE_HASH == REPLACE_HASH_FULL64
+	constexpr uint32_t hash_bits = 64;
+#else
+	constexpr uint32_t hash_bits = 32;
+#endif
+
+	if (header.magic != replace_pack_magic || header.version != replace_pack_version || header.hash_bits != hash_bits ||
+		sizeof(replace_pack_header) + static_cast<uint64_t>(header.num_entries) * sizeof(replace_pack_entry) > static_cast<uint64_t>(file_size.QuadPart))
+	{
+		unload_replace_pack();
+		reshade::log_message(1, "Texture replacement pack is invalid or was built for a different hash method!");
+		return;
+	}
+
+	s_pack_entries = reinterpret_cast<const replace_pack_entry *>(s_pack_data + sizeof(replace_pack_header));
+	s_pack_num_entries = header.num_entries;
+
+	// Validate index once here, so that lookups can use entries without further checks
+	for (uint32_t i = 0; i < s_pack_num_entries; ++i)
+	{
+		const replace_pack_entry &entry = s_pack_entries[i];
+
+		if ((i != 0 && s_pack_entries[i - 1].hash >= entry.hash) ||
+			entry.offset > static_cast<uint64_t>(file_size.QuadPart) || entry.size > static_cast<uint64_t>(file_size.QuadPart) - entry.offset ||
+			entry.size < format_slice_pitch(static_cast<format>(entry.format), entry.row_pitch, entry.height))
+		{
+			unload_replace_pack();
+			reshade::log_message(1, "Texture replacement pack index is corrupted!");
+			return;
+		}
+	}
+
+	char message[64];
+	sprintf_s(message, "Loaded texture replacement pack with %u entries.", s_pack_num_entries);
+	reshade::log_message(3, message);
+}
+
+static bool replace_texture_from_pack(const resource_desc &desc, subresource_data &data, uint64_t hash, bool is_rgba8)
+{
+	const replace_pack_entry *const end = s_pack_entries + s_pack_num_entries;
+	const replace_pack_entry *const entry = std::lower_bound(s_pack_entries, end, hash,
+		[](const replace_pack_entry &entry, uint64_t hash) { return entry.hash < hash; });
+	if (entry == end || entry->hash != hash)
+		return false;
+
+	// Only support changing pixel data, but not texture dimensions
+	if (desc.texture.width != entry->width ||
+		desc.texture.height != entry->height)
+		return false;
+
+	// Payload has to be compatible with the texture format, except that decoded image data may be used for all 8-bit RGBA formats (same as with image files)
+	const format entry_format = static_cast<format>(entry->format);
+	if (format_to_typeless(entry_format) != format_to_typeless(desc.texture.format) && !(is_rgba8 && entry_format == format::r8g8b8a8_unorm))
+		return false;
+
+	// Upload directly from the mapped file, so no copy is needed
+	data.data = const_cast<uint8_t *>(s_pack_data + entry->offset);
+	data.row_pitch = entry->row_pitch;
+	data.slice_pitch = format_slice_pitch(entry_format, entry->row_pitch, entry->height);
+	return true;
+}
+#endif
+
+static void load_replacements()
+{
+	WCHAR file_prefix[MAX_PATH] = L"";
+	GetModuleFileNameW(nullptr, file_prefix, ARRAYSIZE(file_prefix));
+
+	const std::filesystem::path base_path = std::filesystem::path(file_prefix).parent_path();
+
+	// Index image files once, instead of checking whether a file exists on every texture upload
+	std::error_code ec;
+	for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(base_path / REPLACE_DIR, ec))
+	{
+		const std::filesystem::path &path = entry.path();
+		if (path.extension() != replace_extension)
+			continue;
+
+		const std::string name = path.stem().u8string();
+		if (name.size() < 3 || name[0] != '0' || name[1] != 'x')
+			continue;
+
+		char *name_end = nullptr;
+		const uint64_t hash = std::strtoull(name.c_str() + 2, &name_end, 16);
+		if (*name_end == '\0')
+			s_replace_file_hashes.push_back(hash);
+	}
+
+	std::sort(s_replace_file_hashes.begin(), s_replace_file_hashes.end());
+
+#ifdef REPLACE_PACK
+	load_replace_pack(base_path / REPLACE_PACK);
+#endif
+}
+
 static bool replace_texture(const resource_desc &desc, subresource_data &data)
 {
-	if (desc.texture.format != format::r8g8b8a8_typeless && desc.texture.format != format::r8g8b8a8_unorm && desc.texture.format != format::r8g8b8a8_unorm_srgb &&
-		desc.texture.format != format::b8g8r8a8_typeless && desc.texture.format != format::b8g8r8a8_unorm && desc.texture.format != format::b8g8r8a8_unorm_srgb &&
-		desc.texture.format != format::r8g8b8x8_typeless && desc.texture.format != format::r8g8b8x8_unorm && desc.texture.format != format::r8g8b8x8_unorm_srgb &&
-		desc.texture.format != format::b8g8r8x8_typeless && desc.texture.format != format::b8g8r8x8_unorm && desc.texture.format != format::b8g8r8x8_unorm_srgb)
+	const bool is_rgba8 =
+		desc.texture.format == format::r8g8b8a8_typeless || desc.texture.format == format::r8g8b8a8_unorm || desc.texture.format == format::r8g8b8a8_unorm_srgb ||
+		desc.texture.format == format::b8g8r8a8_typeless || desc.texture.format == format::b8g8r8a8_unorm || desc.texture.format == format::b8g8r8a8_unorm_srgb ||
+		desc.texture.format == format::r8g8b8x8_typeless || desc.texture.format == format::r8g8b8x8_unorm || desc.texture.format == format::r8g8b8x8_unorm_srgb ||
+		desc.texture.format == format::b8g8r8x8_typeless || desc.texture.format == format::b8g8r8x8_unorm || desc.texture.format == format::b8g8r8x8_unorm_srgb;
+
+	// Image files only support 8-bit RGBA formats, but a pack may also contain data in other formats (e.g. block-compressed)
+#ifdef REPLACE_PACK
+	if (!is_rgba8 && s_pack_entries == nullptr)
+#else
+	if (!is_rgba8)
+#endif
 		return false;
 
 #if REPLACE_HASH == REPLACE_HASH_FULL
@@ -29,6 +187,11 @@ static bool replace_texture(const resource_desc &desc, subresource_data &data)
 	const uint32_t hash = compute_crc32(
 		static_cast<const uint8_t *>(data.data),
 		format_slice_pitch(desc.texture.format, data.row_pitch, desc.texture.height));
+#elif REPLACE_HASH == REPLACE_HASH_FULL64
+	// Faster 64-bit hash using entire resource data (file names are not compatible with the CRC-32 based methods)
+	const uint64_t hash = compute_hash64(
+		static_cast<const uint8_t *>(data.data),
+		format_slice_pitch(desc.texture.format, data.row_pitch, desc.texture.height));
 #elif REPLACE_HASH == REPLACE_HASH_TEXMOD
 	// Behavior of the original TexMod (see https://github.com/codemasher/texmod/blob/master/uMod_DX9/uMod_TextureFunction.cpp#L41)
 	const uint32_t hash = ~compute_crc32(
@@ -39,8 +202,21 @@ static bool replace_texture(const resource_desc &desc, subresource_data &data)
 			format_row_pitch(desc.texture.format, desc.texture.width)));
 #endif
 
+#ifdef REPLACE_PACK
+	if (s_pack_entries != nullptr && replace_texture_from_pack(desc, data, hash, is_rgba8))
+		return true;
+#endif
+
+	if (!is_rgba8 || !std::binary_search(s_replace_file_hashes.begin(), s_replace_file_hashes.end(), static_cast<uint64_t>(hash)))
+		return false;
+
+#if REPLACE_HASH == REPLACE_HASH_FULL64
+	char hash_string[19];
+	sprintf_s(hash_string, "0x%016llX", hash);
+#else
 	char hash_string[11];
 	sprintf_s(hash_string, "0x%08X", hash);
+#endif
 
 	// Prepend executable file name to image files
 	WCHAR file_prefix[MAX_PATH] = L"";
@@ -50,12 +226,7 @@ static bool replace_texture(const resource_desc &desc, subresource_data &data)
 	std::filesystem::path replace_path = game_file_path.parent_path();
 	replace_path /= REPLACE_DIR;
 	replace_path /= hash_string;
-
-#if REPLACE_FMT == REPLACE_FMT_BMP
-	replace_path += L".bmp";
-#elif REPLACE_FMT == REPLACE_FMT_PNG
-	replace_path += L".png";
-#endif
+	replace_path += replace_extension;
 
 	// Check if a replacement file for this texture hash exists and if so, overwrite the texture data with its contents
 	if (std::filesystem::exists(replace_path))
@@ -111,6 +282,14 @@ static inline bool filter_texture(device *device, const resource_desc &desc, con
 	return true;
 }
 
+static void on_init_device(device *)
+{
+	// Index replacements when the first device is created, rather than in 'DllMain', where file system access is not safe while holding the loader lock
+	// Devices are initialized before the application can create any textures on them, so the index is complete before it is first used
+	static std::once_flag replacements_loaded;
+	std::call_once(replacements_loaded, load_replacements);
+}
+
 static bool on_create_texture(device *device, resource_desc &desc, subresource_data *initial_data, resource_usage)
 {
 	if (!filter_texture(device, desc, nullptr))
@@ -234,6 +413,7 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 	case DLL_PROCESS_ATTACH:
 		if (!reshade::register_addon(hModule))
 			return FALSE;
+		reshade::register_event<reshade::addon_event::init_device>(on_init_device);
 		reshade::register_event<reshade::addon_event::create_resource>(on_create_texture);
 		reshade::register_event<reshade::addon_event::init_resource>(on_after_create_texture);
 		reshade::register_event<reshade::addon_event::copy_texture_region>(on_copy_texture);
@@ -243,6 +423,10 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 		break;
 	case DLL_PROCESS_DETACH:
 		reshade::unregister_addon(hModule);
+
+#ifdef REPLACE_PACK
+		unload_replace_pack();
+#endif
 		break;
 	}
 
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <reshade_api_pipeline.hpp>
+#include <vector>
+#include <utility>
+
+struct draw_stats
+{
+	uint32_t vertices = 0;
+	uint32_t drawcalls = 0;
+	uint32_t drawcalls_indirect = 0;
+	reshade::api::viewport last_viewport = {};
+};
+struct clear_stats : public draw_stats
+{
+	bool rect = false;
+};
+
+struct depth_stencil_info
+{
+	draw_stats total_stats;
+	draw_stats current_stats; // Stats since last clear operation
+	std::vector<clear_stats> clears;
+	bool copied_during_frame = false;
+
+	void reset()
+	{
+		total_stats = {};
+		current_stats = {};
+		clears.clear(); // Keeps capacity, so that no allocation is necessary when reused
+		copied_during_frame = false;
+	}
+
+	void merge(const depth_stencil_info &source)
+	{
+		total_stats.vertices += source.total_stats.vertices;
+		total_stats.drawcalls += source.total_stats.drawcalls;
+		total_stats.drawcalls_indirect += source.total_stats.drawcalls_indirect;
+		current_stats.vertices += source.current_stats.vertices;
+		current_stats.drawcalls += source.current_stats.drawcalls;
+		current_stats.drawcalls_indirect += source.current_stats.drawcalls_indirect;
+
+		clears.insert(clears.end(), source.clears.begin(), source.clears.end());
+
+		copied_during_frame |= source.copied_during_frame;
+	}
+};
+
+// Flat map of the depth-stencils used during a frame, which are usually only a handful, so a linear search is faster than hashing
+// Entries are kept after 'clear' for reuse, so that no allocations are necessary once the number of depth-stencils and clears per frame settled
+class depth_stencil_map
+{
+public:
+	using value_type = std::pair<reshade::api::resource, depth_stencil_info>;
+
+	value_type *begin() { return _entries.data(); }
+	value_type *end() { return _entries.data() + _size; }
+	const value_type *begin() const { return _entries.data(); }
+	const value_type *end() const { return _entries.data() + _size; }
+
+	bool empty() const { return _size == 0; }
+	size_t size() const { return _size; }
+
+	void reserve(size_t capacity)
+	{
+		_entries.reserve(capacity);
+	}
+
+	void clear()
+	{
+		_size = 0;
+		_last_index = 0;
+	}
+
+	depth_stencil_info &operator[](reshade::api::resource depth_stencil)
+	{
+		// Consecutive lookups are usually for the same depth-stencil (e.g. all draw calls between two bind calls), so check the last used entry first
+		if (_last_index < _size && _entries[_last_index].first == depth_stencil)
+			return _entries[_last_index].second;
+
+		for (size_t i = 0; i < _size; ++i)
+		{
+			if (_entries[i].first == depth_stencil)
+			{
+				_last_index = i;
+				return _entries[i].second;
+			}
+		}
+
+		if (_size == _entries.size())
+			_entries.emplace_back();
+
+		value_type &entry = _entries[_size];
+		entry.first = depth_stencil;
+		entry.second.reset();
+
+		_last_index = _size++;
+		return entry.second;
+	}
+
+private:
+	std::vector<value_type> _entries;
+	size_t _size = 0;
+	size_t _last_index = 0;
+};
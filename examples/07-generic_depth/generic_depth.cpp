@@ -7,6 +7,7 @@
 
 #include <imgui.h>
 #include <reshade.hpp>
+#include "depth_stencil_map.hpp"
 #include <cmath>
 #include <cstring>
 #include <algorithm>
@@ -24,26 +25,6 @@ static unsigned int s_use_aspect_ratio_heuristics = 1;
 
 using namespace reshade::api;
 
-struct draw_stats
-{
-	uint32_t vertices = 0;
-	uint32_t drawcalls = 0;
-	uint32_t drawcalls_indirect = 0;
-	viewport last_viewport = {};
-};
-struct clear_stats : public draw_stats
-{
-	bool rect = false;
-};
-
-struct depth_stencil_info
-{
-	draw_stats total_stats;
-	draw_stats current_stats; // Stats since last clear operation
-	std::vector<clear_stats> clears;
-	bool copied_during_frame = false;
-};
-
 struct depth_stencil_hash
 {
 	inline size_t operator()(resource value) const
@@ -59,11 +40,11 @@ struct __declspec(uuid("43319e83-387c-448e-881c-7e68fc2e52c4")) state_tracking
 	bool first_empty_stats = true;
 	viewport current_viewport = {};
 	resource current_depth_stencil = { 0 };
-	std::unordered_map<resource, depth_stencil_info, depth_stencil_hash> counters_per_used_depth_stencil;
+	depth_stencil_map counters_per_used_depth_stencil;
 
 	state_tracking()
 	{
-		// Reserve some space upfront to avoid rehashing during command recording
+		// Reserve some space upfront to avoid reallocating during command recording
 		counters_per_used_depth_stencil.reserve(32);
 	}
 
@@ -93,21 +74,8 @@ struct __declspec(uuid("43319e83-387c-448e-881c-7e68fc2e52c4")) state_tracking
 		if (source.counters_per_used_depth_stencil.empty())
 			return;
 
-		counters_per_used_depth_stencil.reserve(source.counters_per_used_depth_stencil.size());
 		for (const auto &[depth_stencil_handle, snapshot] : source.counters_per_used_depth_stencil)
-		{
-			depth_stencil_info &target_snapshot = counters_per_used_depth_stencil[depth_stencil_handle];
-			target_snapshot.total_stats.vertices += snapshot.total_stats.vertices;
-			target_snapshot.total_stats.drawcalls += snapshot.total_stats.drawcalls;
-			target_snapshot.total_stats.drawcalls_indirect += snapshot.total_stats.drawcalls_indirect;
-			target_snapshot.current_stats.vertices += snapshot.current_stats.vertices;
-			target_snapshot.current_stats.drawcalls += snapshot.current_stats.drawcalls;
-			target_snapshot.current_stats.drawcalls_indirect += snapshot.current_stats.drawcalls_indirect;
-
-			target_snapshot.clears.insert(target_snapshot.clears.end(), snapshot.clears.begin(), snapshot.clears.end());
-
-			target_snapshot.copied_during_frame |= snapshot.copied_during_frame;
-		}
+			counters_per_used_depth_stencil[depth_stencil_handle].merge(snapshot);
 	}
 };
 
@@ -152,7 +120,7 @@ struct __declspec(uuid("e006e162-33ac-4b9f-b10f-0e15335c7bdb")) state_tracking_c
 	std::vector<resource> destroyed_resources;
 
 	// List of all encountered depth-stencils of the last frame
-	std::vector<std::pair<resource, depth_stencil_info>> current_depth_stencil_list;
+	depth_stencil_map current_depth_stencil_list;
 
 	// List of depth-stencils that should be tracked throughout each frame and potentially be backed up during clear operations
 	std::vector<depth_stencil_backup> depth_stencil_backups;
@@ -536,7 +504,6 @@ static void on_present(command_queue *queue, swapchain *swapchain, const rect *,
 	const std::unique_lock<std::shared_mutex> lock(s_mutex);
 
 	device_state.current_depth_stencil_list.clear();
-	device_state.current_depth_stencil_list.reserve(queue_state.counters_per_used_depth_stencil.size());
 
 	for (const auto &[resource, snapshot] : queue_state.counters_per_used_depth_stencil)
 	{
@@ -547,7 +514,7 @@ static void on_present(command_queue *queue, swapchain *swapchain, const rect *,
 			continue; // Skip resources that were destroyed by the application
 
 		// Save to current list of depth-stencils on the device, so that it can be displayed in the GUI
-		device_state.current_depth_stencil_list.emplace_back(resource, snapshot);
+		device_state.current_depth_stencil_list[resource] = snapshot;
 	}
 
 	queue_state.reset_on_present();
@@ -565,7 +532,10 @@ static void on_begin_render_effects(effect_runtime *runtime, command_list *cmd_l
 
 	resource best_match = { 0 };
 	resource_desc best_match_desc;
-	depth_stencil_info best_snapshot;
+	// Only copy the stats that are needed below, not the list of clears
+	draw_stats best_total_stats;
+	draw_stats best_current_stats;
+	bool best_copied_during_frame = false;
 
 	uint32_t frame_width, frame_height;
 	runtime->get_screenshot_width_and_height(&frame_width, &frame_height);
@@ -586,13 +556,15 @@ static void on_begin_render_effects(effect_runtime *runtime, command_list *cmd_l
 
 		if (snapshot.total_stats.drawcalls_indirect < (snapshot.total_stats.drawcalls / 3) ?
 				// Choose snapshot with the most vertices, since that is likely to contain the main scene
-				snapshot.total_stats.vertices > best_snapshot.total_stats.vertices :
+				snapshot.total_stats.vertices > best_total_stats.vertices :
 				// Or check draw calls, since vertices may not be accurate if application is using indirect draw calls
-				snapshot.total_stats.drawcalls > best_snapshot.total_stats.drawcalls)
+				snapshot.total_stats.drawcalls > best_total_stats.drawcalls)
 		{
 			best_match = resource;
 			best_match_desc = desc;
-			best_snapshot = snapshot;
+			best_total_stats = snapshot.total_stats;
+			best_current_stats = snapshot.current_stats;
+			best_copied_during_frame = snapshot.copied_during_frame;
 		}
 	}
 
@@ -603,7 +575,9 @@ static void on_begin_render_effects(effect_runtime *runtime, command_list *cmd_l
 		{
 			best_match = it->first;
 			best_match_desc = device->get_resource_desc(it->first);
-			best_snapshot = it->second;
+			best_total_stats = it->second.total_stats;
+			best_current_stats = it->second.current_stats;
+			best_copied_during_frame = it->second.copied_during_frame;
 		}
 	}
 
@@ -669,12 +643,12 @@ static void on_begin_render_effects(effect_runtime *runtime, command_list *cmd_l
 
 			if (s_preserve_depth_buffers)
 			{
-				depth_stencil_backup->previous_stats = best_snapshot.current_stats;
+				depth_stencil_backup->previous_stats = best_current_stats;
 			}
 			else
 			{
 				// Copy to backup texture unless already copied during the current frame
-				if (!best_snapshot.copied_during_frame && (best_match_desc.usage & resource_usage::copy_source) != 0)
+				if (!best_copied_during_frame && (best_match_desc.usage & resource_usage::copy_source) != 0)
 				{
 					cmd_list->barrier(best_match, resource_usage::depth_stencil | resource_usage::shader_resource, resource_usage::copy_source);
 					cmd_list->copy_resource(best_match, backup_texture);
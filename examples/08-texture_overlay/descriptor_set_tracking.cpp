@@ -10,50 +10,43 @@ using namespace reshade::api;
 
 resource_view descriptor_set_tracking::get_shader_resource_view(descriptor_pool pool, uint32_t offset) const
 {
-	const std::shared_lock<std::shared_mutex> lock(mutex);
-
-	const descriptor_pool_data &pool_data = pools.at(pool);
-
-	if (offset < pool_data.descriptors.size() && pool_data.descriptors[offset].first == descriptor_type::shader_resource_view)
-		return { pool_data.descriptors[offset].second };
+	if (const descriptor_pool_data *const pool_data = pools.find(pool.handle))
+		return { pool_data->get(offset) };
 	else
 		return { 0 };
 }
 
 pipeline_layout_param descriptor_set_tracking::get_pipeline_layout_param(pipeline_layout layout, uint32_t param) const
 {
-	const std::shared_lock<std::shared_mutex> lock(mutex);
+	pipeline_layout_param result;
 
-	const pipeline_layout_data &layout_data = layouts.at(layout);
+	layouts.read(layout.handle, [&](const pipeline_layout_data &layout_data) {
+		if (param < layout_data.params.size())
+			result = layout_data.params[param];
+	});
 
-	if (param < layout_data.params.size())
-		return layout_data.params[param];
-	else
-		return pipeline_layout_param();
+	return result;
 }
 
 void descriptor_set_tracking::register_pipeline_layout(pipeline_layout layout, uint32_t count, const pipeline_layout_param *params)
 {
-	const std::unique_lock<std::shared_mutex> lock(mutex);
+	layouts.write(layout.handle, [&](pipeline_layout_data &layout_data) {
+		layout_data.params.assign(params, params + count);
+		layout_data.ranges.resize(count);
 
-	pipeline_layout_data &layout_data = layouts[layout];
-	layout_data.params.assign(params, params + count);
-	layout_data.ranges.resize(count);
-
-	for (uint32_t i = 0; i < count; ++i)
-	{
-		if (params[i].type == pipeline_layout_param_type::descriptor_set)
+		for (uint32_t i = 0; i < count; ++i)
 		{
-			layout_data.ranges[i].assign(params[i].descriptor_set.ranges, params[i].descriptor_set.ranges + params[i].descriptor_set.count);
-			layout_data.params[i].descriptor_set.ranges = layout_data.ranges[i].data();
+			if (params[i].type == pipeline_layout_param_type::descriptor_set)
+			{
+				layout_data.ranges[i].assign(params[i].descriptor_set.ranges, params[i].descriptor_set.ranges + params[i].descriptor_set.count);
+				layout_data.params[i].descriptor_set.ranges = layout_data.ranges[i].data();
+			}
 		}
-	}
+	});
 }
 void descriptor_set_tracking::unregister_pipeline_layout(pipeline_layout layout)
 {
-	const std::unique_lock<std::shared_mutex> lock(mutex);
-
-	layouts.erase(layout);
+	layouts.erase(layout.handle);
 }
 
 static void on_init_device(device *device)
@@ -76,11 +69,36 @@ static void on_destroy_pipeline_layout(device *device, pipeline_layout layout)
 	ctx.unregister_pipeline_layout(layout);
 }
 
+/// <summary>
+/// Remembers the last few descriptor pools used in a batch of copies or updates, so that each pool is only looked up once per batch.
+/// </summary>
+class descriptor_pool_cache
+{
+public:
+	explicit descriptor_pool_cache(descriptor_set_tracking &ctx) : _ctx(ctx) {}
+
+	descriptor_pool_data &get(descriptor_pool pool)
+	{
+		for (const std::pair<descriptor_pool, descriptor_pool_data *> &entry : _entries)
+			if (entry.second != nullptr && entry.first == pool)
+				return *entry.second;
+
+		descriptor_pool_data &pool_data = _ctx.pools.find_or_create(pool.handle);
+		_entries[_next_entry++ % std::size(_entries)] = { pool, &pool_data };
+		return pool_data;
+	}
+
+private:
+	descriptor_set_tracking &_ctx;
+	std::pair<descriptor_pool, descriptor_pool_data *> _entries[4] = {};
+	uint32_t _next_entry = 0;
+};
+
 static bool on_copy_descriptor_sets(device *device, uint32_t count, const descriptor_set_copy *copies)
 {
 	descriptor_set_tracking &ctx = device->get_private_data<descriptor_set_tracking>();
 
-	const std::unique_lock<std::shared_mutex> lock(ctx.mutex);
+	descriptor_pool_cache pool_cache(ctx);
 
 	for (uint32_t i = 0; i < count; ++i)
 	{
@@ -94,15 +112,12 @@ static bool on_copy_descriptor_sets(device *device, uint32_t count, const descri
 		descriptor_pool dst_pool = { 0 };
 		device->get_descriptor_pool_offset(copy.dest_set, copy.dest_binding, copy.dest_array_offset, &dst_pool, &dst_offset);
 
-		descriptor_set_tracking::descriptor_pool_data &src_pool_data = ctx.pools[src_pool];
-		descriptor_set_tracking::descriptor_pool_data &dst_pool_data = ctx.pools[dst_pool];
-
-		if (dst_offset + copy.count > dst_pool_data.descriptors.size())
-			dst_pool_data.descriptors.resize(dst_offset + copy.count);
+		const descriptor_pool_data &src_pool_data = pool_cache.get(src_pool);
+		descriptor_pool_data &dst_pool_data = pool_cache.get(dst_pool);
 
 		for (uint32_t k = 0; k < copy.count; ++k)
 		{
-			dst_pool_data.descriptors[dst_offset + k] = src_pool_data.descriptors[src_offset + k];
+			dst_pool_data.set(dst_offset + k, src_pool_data.get(src_offset + k));
 		}
 	}
 
@@ -113,7 +128,7 @@ static bool on_update_descriptor_sets(device *device, uint32_t count, const desc
 {
 	descriptor_set_tracking &ctx = device->get_private_data<descriptor_set_tracking>();
 
-	const std::unique_lock<std::shared_mutex> lock(ctx.mutex);
+	descriptor_pool_cache pool_cache(ctx);
 
 	for (uint32_t i = 0; i < count; ++i)
 	{
@@ -123,19 +138,18 @@ static bool on_update_descriptor_sets(device *device, uint32_t count, const desc
 		descriptor_pool pool = { 0 };
 		device->get_descriptor_pool_offset(update.set, update.binding, update.array_offset, &pool, &offset);
 
-		descriptor_set_tracking::descriptor_pool_data &pool_data = ctx.pools[pool];
-
-		if (offset + update.count > pool_data.descriptors.size())
-			pool_data.descriptors.resize(offset + update.count);
+		descriptor_pool_data &pool_data = pool_cache.get(pool);
 
-		for (uint32_t k = 0; k < update.count; ++k)
+		// Only shader resource views are queried, so any other descriptor type just clears the entry
+		if (update.type == descriptor_type::shader_resource_view)
 		{
-			pool_data.descriptors[offset + k].first = update.type;
-
-			if (update.type == descriptor_type::sampler)
-				pool_data.descriptors[offset + k].second = static_cast<const sampler *>(update.descriptors)[k].handle;
-			else if (update.type == descriptor_type::shader_resource_view || update.type == descriptor_type::unordered_access_view)
-				pool_data.descriptors[offset + k].second = static_cast<const resource_view *>(update.descriptors)[k].handle;
+			for (uint32_t k = 0; k < update.count; ++k)
+				pool_data.set(offset + k, static_cast<const resource_view *>(update.descriptors)[k].handle);
+		}
+		else
+		{
+			for (uint32_t k = 0; k < update.count; ++k)
+				pool_data.set(offset + k, 0);
 		}
 	}
 
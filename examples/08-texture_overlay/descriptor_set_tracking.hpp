@@ -5,9 +5,186 @@
 
 #pragma once
 
-#include <map>
+#include <mutex>
+#include <memory>
 #include <vector>
+#include <atomic>
+#include <algorithm>
 #include <shared_mutex>
+#include <unordered_map>
+
+/// <summary>
+/// Hash map from API object handles to values, split into shards with their own lock, so that accesses to different objects rarely contend.
+/// Values are heap allocated, so pointers to them stay valid until they are erased.
+/// </summary>
+template <typename T>
+class sharded_handle_map
+{
+public:
+	template <typename F>
+	bool read(uint64_t handle, F &&func) const
+	{
+		const shard &s = get_shard(handle);
+		const std::shared_lock<std::shared_mutex> lock(s.mutex);
+
+		if (const auto it = s.map.find(handle); it != s.map.end())
+		{
+			func(static_cast<const T &>(*it->second));
+			return true;
+		}
+		return false;
+	}
+
+	T *find(uint64_t handle) const
+	{
+		const shard &s = get_shard(handle);
+		const std::shared_lock<std::shared_mutex> lock(s.mutex);
+
+		if (const auto it = s.map.find(handle); it != s.map.end())
+			return it->second.get();
+		return nullptr;
+	}
+	T &find_or_create(uint64_t handle)
+	{
+		if (T *const existing = find(handle))
+			return *existing;
+
+		shard &s = get_shard(handle);
+		const std::unique_lock<std::shared_mutex> lock(s.mutex);
+
+		std::unique_ptr<T> &value = s.map[handle];
+		if (value == nullptr)
+			value = std::make_unique<T>();
+		return *value;
+	}
+
+	template <typename F>
+	void write(uint64_t handle, F &&func)
+	{
+		shard &s = get_shard(handle);
+		const std::unique_lock<std::shared_mutex> lock(s.mutex);
+
+		std::unique_ptr<T> &value = s.map[handle];
+		if (value == nullptr)
+			value = std::make_unique<T>();
+		func(*value);
+	}
+
+	void erase(uint64_t handle)
+	{
+		shard &s = get_shard(handle);
+		const std::unique_lock<std::shared_mutex> lock(s.mutex);
+
+		s.map.erase(handle);
+	}
+
+private:
+	struct shard
+	{
+		mutable std::shared_mutex mutex;
+		std::unordered_map<uint64_t, std::unique_ptr<T>> map;
+	};
+
+	static constexpr size_t num_shards = 16;
+
+	const shard &get_shard(uint64_t handle) const
+	{
+		// Handles are usually pointers, so mix all bits into the shard index (top 4 bits of the product select one of the 16 shards)
+		return _shards[(handle * 0x9E3779B97F4A7C15ull) >> 60];
+	}
+	shard &get_shard(uint64_t handle)
+	{
+		return const_cast<shard &>(static_cast<const sharded_handle_map *>(this)->get_shard(handle));
+	}
+
+	shard _shards[num_shards];
+};
+
+/// <summary>
+/// Shadow copy of the shader resource views in a descriptor pool, indexed by offset.
+/// Descriptors are stored in fixed-size pages that never move, so reads and writes to existing pages are lock-free. Only adding pages takes a lock.
+/// </summary>
+class descriptor_pool_data
+{
+public:
+	static constexpr uint32_t page_size = 256;
+
+	descriptor_pool_data() = default;
+	descriptor_pool_data(const descriptor_pool_data &) = delete;
+	descriptor_pool_data &operator=(const descriptor_pool_data &) = delete;
+
+	uint64_t get(uint32_t offset) const
+	{
+		if (const page *const p = find_page(offset / page_size))
+			return p->descriptors[offset % page_size].load(std::memory_order_relaxed);
+		return 0;
+	}
+
+	void set(uint32_t offset, uint64_t value)
+	{
+		page *p = find_page(offset / page_size);
+		if (p == nullptr)
+		{
+			// Do not allocate pages just to store empty descriptors
+			if (value == 0)
+				return;
+			p = create_page(offset / page_size);
+		}
+
+		p->descriptors[offset % page_size].store(value, std::memory_order_relaxed);
+	}
+
+private:
+	struct page
+	{
+		std::atomic<uint64_t> descriptors[page_size] = {};
+	};
+	struct page_table
+	{
+		uint32_t num_pages;
+		std::unique_ptr<std::atomic<page *>[]> pages;
+	};
+
+	page *find_page(uint32_t page_index) const
+	{
+		const page_table *const table = _table.load(std::memory_order_acquire);
+		if (table == nullptr || page_index >= table->num_pages)
+			return nullptr;
+		return table->pages[page_index].load(std::memory_order_acquire);
+	}
+	page *create_page(uint32_t page_index)
+	{
+		const std::unique_lock<std::mutex> lock(_mutex);
+
+		page_table *table = _table.load(std::memory_order_relaxed);
+		if (table == nullptr || page_index >= table->num_pages)
+		{
+			// Grow page table, but keep the old one around, since other threads may still be reading from it
+			auto &new_table = _tables.emplace_back(std::make_unique<page_table>());
+			new_table->num_pages = std::max(page_index + 1, table != nullptr ? table->num_pages * 2 : 4u);
+			new_table->pages = std::make_unique<std::atomic<page *>[]>(new_table->num_pages);
+			for (uint32_t i = 0; i < new_table->num_pages; ++i)
+				new_table->pages[i].store(table != nullptr && i < table->num_pages ? table->pages[i].load(std::memory_order_relaxed) : nullptr, std::memory_order_relaxed);
+
+			table = new_table.get();
+			_table.store(table, std::memory_order_release);
+		}
+
+		page *p = table->pages[page_index].load(std::memory_order_relaxed);
+		if (p == nullptr)
+		{
+			p = _pages.emplace_back(std::make_unique<page>()).get();
+			table->pages[page_index].store(p, std::memory_order_release);
+		}
+
+		return p;
+	}
+
+	std::mutex _mutex;
+	std::atomic<page_table *> _table = nullptr;
+	std::vector<std::unique_ptr<page_table>> _tables;
+	std::vector<std::unique_ptr<page>> _pages;
+};
 
 struct __declspec(uuid("33319e83-387c-448e-881c-7e68fc2e52c4")) descriptor_set_tracking
 {
@@ -23,16 +200,12 @@ struct __declspec(uuid("33319e83-387c-448e-881c-7e68fc2e52c4")) descriptor_set_t
 		std::vector<reshade::api::pipeline_layout_param> params;
 		std::vector<std::vector<reshade::api::descriptor_range>> ranges;
 	};
-	struct descriptor_pool_data
-	{
-		std::vector<std::pair<reshade::api::descriptor_type, uint64_t>> descriptors;
-	};
 
-	mutable std::shared_mutex mutex;
-	std::map<reshade::api::descriptor_pool, descriptor_pool_data> pools;
+	// Shader resource view handles per descriptor pool (zero for any other descriptor type)
+	sharded_handle_map<descriptor_pool_data> pools;
 
 private:
-	std::map<reshade::api::pipeline_layout, pipeline_layout_data> layouts;
+	sharded_handle_map<pipeline_layout_data> layouts;
 };
 
 extern void register_descriptor_set_tracking();
@@ -16,6 +16,10 @@
 
 using namespace reshade::api;
 
+// See implementation in 'dump_texture.cpp'
+extern bool dump_texture(const resource_desc &desc, const subresource_data &data);
+extern void flush_texture_dumps();
+
 struct tex_data
 {
 	resource_desc desc;
@@ -80,6 +84,9 @@ static void on_destroy_device(device *device)
 	device->destroy_resource_view(data.green_texture_srv);
 
 	device->destroy_private_data<device_data>();
+
+	// Finish writing all queued textures before the application shuts down
+	flush_texture_dumps();
 }
 static void on_init_cmd_list(command_list *cmd_list)
 {
@@ -220,9 +227,13 @@ static void on_bind_descriptor_sets(command_list *cmd_list, shader_stage stages,
 			descriptor_pool pool = { 0 };
 			device->get_descriptor_pool_offset(sets[i], range.binding, 0, &pool, &base_offset);
 
+			const descriptor_pool_data *const pool_data = descriptor_data.pools.find(pool.handle);
+			if (pool_data == nullptr)
+				continue;
+
 			for (uint32_t j = 0; j < std::min(10u, range.count); ++j)
 			{
-				resource_view descriptor = descriptor_data.get_shader_resource_view(pool, base_offset + j);
+				const resource_view descriptor = { pool_data->get(base_offset + j) };
 				if (descriptor.handle == 0)
 					continue;
 
@@ -274,9 +285,6 @@ static void on_present(command_queue *queue, swapchain *swapchain, const rect *,
 	data.destroyed_views.clear();
 }
 
-// See implementation in 'dump_texture.cpp'
-extern bool dump_texture(const resource_desc &desc, const subresource_data &data);
-
 static bool dump_texture(command_queue *queue, resource tex, const resource_desc &desc)
 {
 	device *const device = queue->get_device();
@@ -453,7 +461,8 @@ void register_addon_texmod_overlay()
 	reshade::register_event<reshade::addon_event::destroy_resource_view>(on_destroy_texture_view);
 
 	reshade::register_event<reshade::addon_event::push_descriptors>(on_push_descriptors);
-	reshade::register_event<reshade::addon_event::bind_descriptor_sets>(on_bind_descriptor_sets);
+	// Only interested in descriptors bound to the pixel shader stage, so skip all other calls
+	reshade::register_event<reshade::addon_event::bind_descriptor_sets>(on_bind_descriptor_sets, static_cast<uint32_t>(shader_stage::pixel));
 
 	reshade::register_event<reshade::addon_event::execute_command_list>(on_execute);
 	reshade::register_event<reshade::addon_event::present>(on_present);
@@ -4,6 +4,15 @@
  */
 
 #include <chrono>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <condition_variable>
+#include <emmintrin.h>
 #include <reshade.hpp>
 
 extern "C" {
@@ -12,13 +21,42 @@ extern "C" {
 #include <libavformat/avformat.h>
 }
 
+// Number of host resources the back buffer is copied into in a round-robin fashion, so that only the oldest one is mapped, which the GPU should have finished copying to by then
+constexpr size_t NUM_HOST_RESOURCES = 3;
+// Maximum number of frames that may wait for the encoder thread, before new frames are dropped instead of stalling the application
+constexpr size_t MAX_QUEUED_FRAMES = 8;
+
+struct captured_frame
+{
+	// Tightly packed 32-bit pixels in the format of the back buffer
+	std::vector<uint8_t> pixels;
+	int64_t timestamp_ms = 0;
+};
+
 struct __declspec(uuid("0D7525F9-C4E1-426E-BC99-15BBD5FD51F2")) video_capture
 {
 	AVCodecContext *codec_ctx = nullptr;
 	AVFormatContext *output_ctx = nullptr;
 	AVFrame *frame = nullptr;
-
-	reshade::api::resource host_resource;
+	// Raw YUV4MPEG2 output file, which is written instead of using FFmpeg when enabled in the configuration
+	FILE *raw_file = nullptr;
+
+	int width = 0;
+	int height = 0;
+	bool bgra = false;
+	bool recording = false;
+
+	reshade::api::resource host_resources[NUM_HOST_RESOURCES] = {};
+	bool host_resource_ready[NUM_HOST_RESOURCES] = {};
+	int64_t host_resource_timestamps[NUM_HOST_RESOURCES] = {};
+	size_t current_host_resource = 0;
+
+	std::thread encoder_thread;
+	std::mutex queue_mutex;
+	std::condition_variable queue_condition;
+	std::deque<captured_frame> queued_frames;
+	std::vector<std::vector<uint8_t>> free_buffers;
+	bool stop_encoder = false;
 
 	std::chrono::system_clock::time_point last_time;
 	std::chrono::system_clock::time_point start_time;
@@ -27,8 +65,112 @@ struct __declspec(uuid("0D7525F9-C4E1-426E-BC99-15BBD5FD51F2")) video_capture
 	void destroy_codec_ctx();
 	bool init_format_ctx(const char *filename);
 	void destroy_format_ctx();
+	bool init_raw_file(const char *filename);
+	void destroy_raw_file();
+
+	bool init_host_resources(reshade::api::device *device, reshade::api::resource_desc desc);
+	void destroy_host_resources(reshade::api::device *device);
+	void read_host_resource(reshade::api::device *device, size_t index);
+
+	void start_encoder_thread();
+	void stop_encoder_thread();
+	void encoder_thread_main();
 };
 
+// Converts 8-bit RGBA or BGRA pixels to full range BT.601 YUV 4:2:0 planes (as used by 'C420jpeg' in YUV4MPEG2)
+static void convert_rgba_to_yuv420(const uint8_t *pixels, int width, int height, bool bgra, uint8_t *y_plane, uint8_t *u_plane, uint8_t *v_plane)
+{
+	// Coefficients in 8.8 fixed point, ordered by byte position in a pixel
+	const int16_t r_index = bgra ? 2 : 0, b_index = bgra ? 0 : 2;
+	int16_t y_coeffs[4] = {}, u_coeffs[4] = {}, v_coeffs[4] = {};
+	y_coeffs[r_index] =  77; y_coeffs[1] =  150; y_coeffs[b_index] =  29;
+	u_coeffs[r_index] = -43; u_coeffs[1] =  -85; u_coeffs[b_index] = 128;
+	v_coeffs[r_index] = 128; v_coeffs[1] = -107; v_coeffs[b_index] = -21;
+
+	const __m128i y_coeffs_sse = _mm_setr_epi16(y_coeffs[0], y_coeffs[1], y_coeffs[2], 0, y_coeffs[0], y_coeffs[1], y_coeffs[2], 0);
+	const __m128i u_coeffs_sse = _mm_setr_epi16(u_coeffs[0], u_coeffs[1], u_coeffs[2], 0, u_coeffs[0], u_coeffs[1], u_coeffs[2], 0);
+	const __m128i v_coeffs_sse = _mm_setr_epi16(v_coeffs[0], v_coeffs[1], v_coeffs[2], 0, v_coeffs[0], v_coeffs[1], v_coeffs[2], 0);
+	const __m128i zero = _mm_setzero_si128();
+
+	// Computes the dot product of 4 pixels with the specified coefficients and returns the four 32-bit results
+	const auto dot4 = [zero](__m128i pixels, __m128i coeffs) {
+		const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coeffs);
+		const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coeffs);
+		const __m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+		const __m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+		return _mm_add_epi32(even, odd);
+	};
+	const auto to_bytes = [](__m128i values, int bias) {
+		values = _mm_srai_epi32(_mm_add_epi32(values, _mm_set1_epi32(bias)), 8);
+		values = _mm_packs_epi32(values, values);
+		return _mm_packus_epi16(values, values);
+	};
+
+	const int chroma_width = (width + 1) / 2;
+	const int simd_width = width & ~3;
+
+	for (int y = 0; y < height; y += 2)
+	{
+		const uint8_t *const row0 = pixels + static_cast<size_t>(y) * width * 4;
+		// Duplicate last row for odd heights
+		const uint8_t *const row1 = (y + 1 < height) ? row0 + static_cast<size_t>(width) * 4 : row0;
+
+		uint8_t *const y_row0 = y_plane + static_cast<size_t>(y) * width;
+		uint8_t *const y_row1 = (y + 1 < height) ? y_row0 + width : nullptr;
+		uint8_t *const u_row = u_plane + static_cast<size_t>(y / 2) * chroma_width;
+		uint8_t *const v_row = v_plane + static_cast<size_t>(y / 2) * chroma_width;
+
+		int x = 0;
+		for (; x < simd_width; x += 4)
+		{
+			const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 4));
+			const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 4));
+
+			*reinterpret_cast<int *>(y_row0 + x) = _mm_cvtsi128_si32(to_bytes(dot4(p0, y_coeffs_sse), 128));
+			if (y_row1 != nullptr)
+				*reinterpret_cast<int *>(y_row1 + x) = _mm_cvtsi128_si32(to_bytes(dot4(p1, y_coeffs_sse), 128));
+
+			// Average 2x2 blocks, the results end up in pixel 0 and 2
+			__m128i average = _mm_avg_epu8(p0, p1);
+			average = _mm_avg_epu8(average, _mm_srli_si128(average, 4));
+
+			const int u = _mm_cvtsi128_si32(to_bytes(dot4(average, u_coeffs_sse), 128 << 8 | 128));
+			const int v = _mm_cvtsi128_si32(to_bytes(dot4(average, v_coeffs_sse), 128 << 8 | 128));
+			u_row[x / 2 + 0] = static_cast<uint8_t>(u);
+			u_row[x / 2 + 1] = static_cast<uint8_t>(u >> 16);
+			v_row[x / 2 + 0] = static_cast<uint8_t>(v);
+			v_row[x / 2 + 1] = static_cast<uint8_t>(v >> 16);
+		}
+
+		// Handle remaining pixels that do not fill a full SIMD register
+		for (; x < width; x += 2)
+		{
+			const int x1 = (x + 1 < width) ? x + 1 : x;
+			const uint8_t *const block[4] = { row0 + x * 4, row0 + x1 * 4, row1 + x * 4, row1 + x1 * 4 };
+
+			int average[3] = {};
+			for (int i = 0; i < 4; ++i)
+			{
+				const uint8_t *const p = block[i];
+				const int luma = (y_coeffs[0] * p[0] + y_coeffs[1] * p[1] + y_coeffs[2] * p[2] + 128) >> 8;
+				if (i == 0 || (i == 1 && x1 != x))
+					y_row0[x + i] = static_cast<uint8_t>(luma);
+				else if (y_row1 != nullptr && (i == 2 || (i == 3 && x1 != x)))
+					y_row1[x + i - 2] = static_cast<uint8_t>(luma);
+
+				for (int c = 0; c < 3; ++c)
+					average[c] += p[c];
+			}
+
+			for (int c = 0; c < 3; ++c)
+				average[c] = (average[c] + 2) / 4;
+
+			u_row[x / 2] = static_cast<uint8_t>(std::min(std::max(((u_coeffs[0] * average[0] + u_coeffs[1] * average[1] + u_coeffs[2] * average[2] + 128) >> 8) + 128, 0), 255));
+			v_row[x / 2] = static_cast<uint8_t>(std::min(std::max(((v_coeffs[0] * average[0] + v_coeffs[1] * average[1] + v_coeffs[2] * average[2] + 128) >> 8) + 128, 0), 255));
+		}
+	}
+}
+
 bool video_capture::init_codec_ctx(const reshade::api::resource_desc &buffer_desc)
 {
 	const AVCodec *codec = nullptr;
@@ -63,25 +205,7 @@ bool video_capture::init_codec_ctx(const reshade::api::resource_desc &buffer_des
 	codec_ctx->gop_size = 250;
 	codec_ctx->max_b_frames = 2;
 
-	switch (buffer_desc.texture.format)
-	{
-	case reshade::api::format::r8g8b8a8_unorm:
-	case reshade::api::format::r8g8b8a8_unorm_srgb:
-	case reshade::api::format::r8g8b8x8_unorm:
-	case reshade::api::format::r8g8b8x8_unorm_srgb:
-		codec_ctx->pix_fmt = AV_PIX_FMT_0BGR32;
-		break;
-	case reshade::api::format::b8g8r8a8_unorm:
-	case reshade::api::format::b8g8r8a8_unorm_srgb:
-	case reshade::api::format::b8g8r8x8_unorm:
-	case reshade::api::format::b8g8r8x8_unorm_srgb:
-		codec_ctx->pix_fmt = AV_PIX_FMT_0RGB32;
-		break;
-	default:
-		destroy_codec_ctx();
-		reshade::log_message(1, "Unsupported texture format!");
-		return false;
-	}
+	codec_ctx->pix_fmt = bgra ? AV_PIX_FMT_0RGB32 : AV_PIX_FMT_0BGR32;
 
 	if (int err = avcodec_open2(codec_ctx, codec, nullptr); err < 0)
 	{
@@ -174,6 +298,125 @@ void video_capture::destroy_format_ctx()
 	}
 }
 
+bool video_capture::init_raw_file(const char *filename)
+{
+	if (fopen_s(&raw_file, filename, "wb") != 0)
+	{
+		raw_file = nullptr;
+
+		reshade::log_message(1, "Failed to open output file!");
+		return false;
+	}
+
+	// Frames are captured at a fixed rate of 30 per second (see 'on_reshade_finish_effects')
+	fprintf(raw_file, "YUV4MPEG2 W%d H%d F30:1 Ip A1:1 C420jpeg\n", width, height);
+
+	return true;
+}
+void video_capture::destroy_raw_file()
+{
+	if (raw_file != nullptr)
+	{
+		fclose(raw_file);
+		raw_file = nullptr;
+	}
+}
+
+bool video_capture::init_host_resources(reshade::api::device *device, reshade::api::resource_desc desc)
+{
+	desc.type = reshade::api::resource_type::texture_2d;
+	desc.heap = reshade::api::memory_heap::gpu_to_cpu;
+	desc.usage = reshade::api::resource_usage::copy_dest;
+
+	for (size_t i = 0; i < NUM_HOST_RESOURCES; ++i)
+	{
+		if (!device->create_resource(desc, nullptr, reshade::api::resource_usage::cpu_access, &host_resources[i]))
+		{
+			destroy_host_resources(device);
+			return false;
+		}
+
+		host_resource_ready[i] = false;
+	}
+
+	current_host_resource = 0;
+
+	return true;
+}
+void video_capture::destroy_host_resources(reshade::api::device *device)
+{
+	for (size_t i = 0; i < NUM_HOST_RESOURCES; ++i)
+	{
+		if (host_resources[i] != 0)
+			device->destroy_resource(host_resources[i]);
+
+		host_resources[i] = { 0 };
+		host_resource_ready[i] = false;
+	}
+}
+void video_capture::read_host_resource(reshade::api::device *device, size_t index)
+{
+	if (!host_resource_ready[index])
+		return;
+	host_resource_ready[index] = false;
+
+	std::unique_lock<std::mutex> lock(queue_mutex);
+
+	// Drop frame if the encoder cannot keep up, rather than stalling the application
+	if (queued_frames.size() >= MAX_QUEUED_FRAMES)
+		return;
+
+	captured_frame frame_data;
+	if (!free_buffers.empty())
+	{
+		frame_data.pixels = std::move(free_buffers.back());
+		free_buffers.pop_back();
+	}
+
+	lock.unlock();
+
+	reshade::api::subresource_data host_data;
+	if (!device->map_texture_region(host_resources[index], 0, nullptr, reshade::api::map_access::read_only, &host_data))
+		return;
+
+	// Only copy rows here to unmap again quickly, conversion to the output format is done on the encoder thread
+	const size_t row_size = static_cast<size_t>(width) * 4;
+	frame_data.pixels.resize(row_size * height);
+	for (int y = 0; y < height; ++y)
+		std::memcpy(frame_data.pixels.data() + y * row_size, static_cast<const uint8_t *>(host_data.data) + y * host_data.row_pitch, row_size);
+
+	device->unmap_texture_region(host_resources[index], 0);
+
+	frame_data.timestamp_ms = host_resource_timestamps[index];
+
+	lock.lock();
+	queued_frames.push_back(std::move(frame_data));
+	lock.unlock();
+
+	queue_condition.notify_one();
+}
+
+void video_capture::start_encoder_thread()
+{
+	stop_encoder = false;
+	encoder_thread = std::thread(&video_capture::encoder_thread_main, this);
+}
+void video_capture::stop_encoder_thread()
+{
+	if (!encoder_thread.joinable())
+		return;
+
+	{
+		const std::lock_guard<std::mutex> lock(queue_mutex);
+		stop_encoder = true;
+	}
+
+	queue_condition.notify_one();
+
+	// Encoder thread finishes all queued frames before exiting
+	encoder_thread.join();
+}
+
 static void encode_frame(AVCodecContext *enc, AVFormatContext *s, AVFrame *frame, int stream_index = 0)
 {
 	if (int err = avcodec_send_frame(enc, frame); err < 0)
@@ -195,6 +438,79 @@ static void encode_frame(AVCodecContext *enc, AVFormatContext *s, AVFrame *frame
 	}
 }
 
+void video_capture::encoder_thread_main()
+{
+	const size_t row_size = static_cast<size_t>(width) * 4;
+	const size_t luma_size = static_cast<size_t>(width) * height;
+	const size_t chroma_size = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+	std::vector<uint8_t> yuv_data(raw_file != nullptr ? luma_size + 2 * chroma_size : 0);
+
+	while (true)
+	{
+		captured_frame frame_data;
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			queue_condition.wait(lock, [this]() { return stop_encoder || !queued_frames.empty(); });
+
+			if (queued_frames.empty())
+				break; // Stop was requested and all frames were processed
+
+			frame_data = std::move(queued_frames.front());
+			queued_frames.pop_front();
+		}
+
+		if (raw_file != nullptr)
+		{
+			convert_rgba_to_yuv420(frame_data.pixels.data(), width, height, bgra, yuv_data.data(), yuv_data.data() + luma_size, yuv_data.data() + luma_size + chroma_size);
+
+			fputs("FRAME\n", raw_file);
+			fwrite(yuv_data.data(), 1, yuv_data.size(), raw_file);
+		}
+		else if (av_frame_make_writable(frame) >= 0)
+		{
+			// Back buffer layout matches the frame pixel format, so can copy whole rows
+			for (int y = 0; y < height; ++y)
+				std::memcpy(frame->data[0] + y * frame->linesize[0], frame_data.pixels.data() + y * row_size, row_size);
+
+			frame->pts = av_rescale_q(
+				frame_data.timestamp_ms,
+				AVRational { std::milli::num, std::milli::den },
+				codec_ctx->time_base);
+
+			encode_frame(codec_ctx, output_ctx, frame);
+		}
+
+		// Return buffer so it can be reused for the next captured frame
+		const std::lock_guard<std::mutex> lock(queue_mutex);
+		free_buffers.push_back(std::move(frame_data.pixels));
+	}
+
+	// Flush the encoder
+	if (output_ctx != nullptr)
+		encode_frame(codec_ctx, output_ctx, nullptr);
+}
+
+static void stop_recording(reshade::api::command_queue *queue, video_capture &data)
+{
+	reshade::api::device *const device = queue->get_device();
+
+	// Read back the frames that are still in flight, oldest first
+	queue->flush_immediate_command_list();
+	for (size_t i = 1; i <= NUM_HOST_RESOURCES; ++i)
+		data.read_host_resource(device, (data.current_host_resource + i) % NUM_HOST_RESOURCES);
+
+	data.stop_encoder_thread();
+
+	data.destroy_host_resources(device);
+
+	data.destroy_raw_file();
+	data.destroy_format_ctx(); data.destroy_codec_ctx();
+
+	data.queued_frames.clear();
+	data.free_buffers.clear();
+	data.recording = false;
+}
+
 static void on_init(reshade::api::swapchain *swapchain)
 {
 	swapchain->create_private_data<video_capture>();
@@ -203,14 +519,15 @@ static void on_destroy(reshade::api::swapchain *swapchain)
 {
 	video_capture &data = swapchain->get_private_data<video_capture>();
 
-	if (data.host_resource != 0)
-		swapchain->get_device()->destroy_resource(data.host_resource);
+	if (data.recording)
+	{
+		data.stop_encoder_thread();
 
-	// Flush the encoder
-	if (data.output_ctx != nullptr)
-		encode_frame(data.codec_ctx, data.output_ctx, nullptr);
+		data.destroy_host_resources(swapchain->get_device());
 
-	data.destroy_format_ctx(); data.destroy_codec_ctx();
+		data.destroy_raw_file();
+		data.destroy_format_ctx(); data.destroy_codec_ctx();
+	}
 
 	swapchain->destroy_private_data<video_capture>();
 }
@@ -225,96 +542,104 @@ static void on_reshade_finish_effects(reshade::api::effect_runtime *runtime, res
 
 	if (runtime->is_key_pressed(VK_F11))
 	{
-		if (data.output_ctx != nullptr)
+		if (data.recording)
 		{
 			reshade::log_message(3, "Stopping video recording ...");
 
-			device->destroy_resource(data.host_resource);
-			data.host_resource = { 0 };
-
-			// Flush the encoder
-			encode_frame(data.codec_ctx, data.output_ctx, nullptr);
-
-			data.destroy_format_ctx(); data.destroy_codec_ctx();
+			stop_recording(runtime->get_command_queue(), data);
+			return;
 		}
 		else
 		{
-			reshade::api::resource_desc desc = device->get_resource_desc(rtv_resource);
+			const reshade::api::resource_desc desc = device->get_resource_desc(rtv_resource);
 
-			if (!data.init_codec_ctx(desc))
-				return;
-			if (!data.init_format_ctx("video.mp4"))
+			switch (desc.texture.format)
+			{
+			case reshade::api::format::r8g8b8a8_unorm:
+			case reshade::api::format::r8g8b8a8_unorm_srgb:
+			case reshade::api::format::r8g8b8x8_unorm:
+			case reshade::api::format::r8g8b8x8_unorm_srgb:
+				data.bgra = false;
+				break;
+			case reshade::api::format::b8g8r8a8_unorm:
+			case reshade::api::format::b8g8r8a8_unorm_srgb:
+			case reshade::api::format::b8g8r8x8_unorm:
+			case reshade::api::format::b8g8r8x8_unorm_srgb:
+				data.bgra = true;
+				break;
+			default:
+				reshade::log_message(1, "Unsupported texture format!");
 				return;
+			}
+
+			data.width = desc.texture.width;
+			data.height = desc.texture.height;
 
-			desc.type = reshade::api::resource_type::texture_2d;
-			desc.heap = reshade::api::memory_heap::gpu_to_cpu;
-			desc.usage = reshade::api::resource_usage::copy_dest;
+			// Optionally write uncompressed YUV4MPEG2 output, which does not depend on an encoder being available
+			bool raw_output = false;
+			reshade::config_get_value(nullptr, "VIDEO_CAPTURE", "RawOutput", raw_output);
+
+			if (raw_output)
+			{
+				if (!data.init_raw_file("video.y4m"))
+					return;
+			}
+			else
+			{
+				if (!data.init_codec_ctx(desc))
+					return;
+				if (!data.init_format_ctx("video.mp4"))
+				{
+					data.destroy_codec_ctx();
+					return;
+				}
+			}
 
-			if (device->create_resource(desc, nullptr, reshade::api::resource_usage::cpu_access, &data.host_resource))
+			if (data.init_host_resources(device, desc))
 			{
 				reshade::log_message(3, "Starting video recording ...");
 
+				data.recording = true;
+				data.start_encoder_thread();
+
 				data.start_time = data.last_time = std::chrono::system_clock::now();
 			}
 			else
 			{
 				reshade::log_message(1, "Failed to create host resource!");
 
+				data.destroy_raw_file();
 				data.destroy_format_ctx(); data.destroy_codec_ctx();
 				return;
 			}
 		}
 	}
 
-	if (data.codec_ctx == nullptr || data.output_ctx == nullptr || data.host_resource == 0)
+	if (!data.recording)
 		return;
 
 	// Only encode a frame every few frames, depending on the set codec framerate
 	const auto time = std::chrono::system_clock::now();
-	if ((time - data.last_time) < (std::chrono::milliseconds(data.codec_ctx->time_base.num * std::milli::den) / data.codec_ctx->time_base.den))
+	if ((time - data.last_time) < (std::chrono::milliseconds(std::milli::den) / 30))
 		return;
 	data.last_time = time;
 
-	// TODO: This is slow/incorrect, because blocking for the frame and copy to finish.
-	// Instead multiple resources should be created and copied into in a round-robin fashion, only the oldest of which is mapped below and copies into the video frame.
-	// See also the OBS capture add-on example which does this.
+	const size_t index = data.current_host_resource;
+	data.current_host_resource = (index + 1) % NUM_HOST_RESOURCES;
+
+	// The resource that is about to be overwritten holds the oldest captured frame, which was copied a few frames ago, so mapping it should not have to wait for the GPU anymore
+	data.read_host_resource(device, index);
+
+	// Copy commands are submitted with the rest of the frame, so there is no need to flush here
 	reshade::api::command_list *const cmd_list = runtime->get_command_queue()->get_immediate_command_list();
-	cmd_list->barrier(data.host_resource, reshade::api::resource_usage::cpu_access, reshade::api::resource_usage::copy_dest);
+	cmd_list->barrier(data.host_resources[index], reshade::api::resource_usage::cpu_access, reshade::api::resource_usage::copy_dest);
 	cmd_list->barrier(rtv_resource, reshade::api::resource_usage::render_target, reshade::api::resource_usage::copy_source);
-	cmd_list->copy_resource(rtv_resource, data.host_resource);
-	cmd_list->barrier(data.host_resource, reshade::api::resource_usage::copy_dest, reshade::api::resource_usage::cpu_access);
+	cmd_list->copy_resource(rtv_resource, data.host_resources[index]);
+	cmd_list->barrier(data.host_resources[index], reshade::api::resource_usage::copy_dest, reshade::api::resource_usage::cpu_access);
 	cmd_list->barrier(rtv_resource, reshade::api::resource_usage::copy_source, reshade::api::resource_usage::render_target);
 
-	runtime->get_command_queue()->flush_immediate_command_list();
-
-	if (av_frame_make_writable(data.frame) < 0)
-		return;
-
-	reshade::api::subresource_data host_data;
-	if (!device->map_texture_region(data.host_resource, 0, nullptr, reshade::api::map_access::read_only, &host_data))
-		return;
-
-	for (int y = 0; y < data.codec_ctx->height; ++y)
-	{
-		for (int x = 0; x < data.codec_ctx->width; ++x)
-		{
-			const size_t host_data_index = y * host_data.row_pitch + x * 4;
-			const size_t frame_data_index = y * data.frame->linesize[0] + x * 4;
-
-			data.frame->data[0][frame_data_index + 0] = static_cast<const uint8_t *>(host_data.data)[host_data_index + 0];
-			data.frame->data[0][frame_data_index + 1] = static_cast<const uint8_t *>(host_data.data)[host_data_index + 1];
-			data.frame->data[0][frame_data_index + 2] = static_cast<const uint8_t *>(host_data.data)[host_data_index + 2];
-		}
-	}
-
-	device->unmap_texture_region(data.host_resource, 0);
-
-	data.frame->pts = av_rescale_q(
-		std::chrono::duration_cast<std::chrono::milliseconds>(time - data.start_time).count(),
-		AVRational { std::milli::num, std::milli::den },
-		data.codec_ctx->time_base);
-
-	encode_frame(data.codec_ctx, data.output_ctx, data.frame);
+	data.host_resource_ready[index] = true;
+	data.host_resource_timestamps[index] = std::chrono::duration_cast<std::chrono::milliseconds>(time - data.start_time).count();
 }
 
 extern "C" __declspec(dllexport) const char *NAME = "Video Capture";
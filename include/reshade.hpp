@@ -6,11 +6,12 @@
 #pragma once
 
 #include "reshade_events.hpp"
+#include "reshade_command_records.hpp"
 #include "reshade_overlay.hpp"
 #include <charconv>
 #include <Windows.h>
 
-#define RESHADE_API_VERSION 2
+#define RESHADE_API_VERSION 4
 
  // Use the kernel32 variant of module enumeration functions so it can be safely called from 'DllMain'
 extern "C" BOOL WINAPI K32EnumProcessModules(HANDLE hProcess, HMODULE *lphModule, DWORD cb, LPDWORD lpcbNeeded);
@@ -185,6 +186,29 @@ namespace reshade
 		func(ev, static_cast<void *>(callback));
 	}
 	/// <summary>
+	/// Registers a callback for the specified event (via template) with ReShade, which is only called for the subset of calls that match the specified <paramref name="filter"/> mask.
+	/// <para>The callback is skipped when the bitwise AND of <paramref name="filter"/> and the filter value of a call is zero. Filter values are:</para>
+	/// <list type="bullet">
+	/// <item><description><see cref="addon_event::init_resource"/>, <see cref="addon_event::create_resource"/>: <c>1 &lt;&lt; desc.type</c> (see <see cref="api::resource_type"/>)</description></item>
+	/// <item><description><see cref="addon_event::init_resource_view"/>, <see cref="addon_event::create_resource_view"/>: <c>usage_type</c> (see <see cref="api::resource_usage"/>), or all bits set if the usage is <see cref="api::resource_usage::undefined"/></description></item>
+	/// <item><description><see cref="addon_event::bind_pipeline"/>: <c>stages</c> (see <see cref="api::pipeline_stage"/>)</description></item>
+	/// <item><description><see cref="addon_event::push_constants"/>, <see cref="addon_event::push_descriptors"/>, <see cref="addon_event::bind_descriptor_sets"/>: <c>stages</c> (see <see cref="api::shader_stage"/>)</description></item>
+	/// <item><description><see cref="addon_event::draw_or_dispatch_indirect"/>: <c>1 &lt;&lt; type</c> (see <see cref="api::indirect_command"/>)</description></item>
+	/// </list>
+	/// <para>Calls of all other events always match. Falls back to registering an unfiltered callback when ReShade does not support filters.</para>
+	/// </summary>
+	/// <param name="callback">Pointer to the callback function.</param>
+	/// <param name="filter">Mask of filter values the callback should be called for.</param>
+	template <reshade::addon_event ev>
+	inline void register_event(typename reshade::addon_event_traits<ev>::decl callback, uint32_t filter)
+	{
+		static const auto func = reinterpret_cast<void(*)(reshade::addon_event, void *, uint32_t)>(
+			GetProcAddress(internal::get_reshade_module_handle(), "ReShadeRegisterEventWithFilter"));
+		if (func == nullptr)
+			return register_event<ev>(callback);
+		func(ev, static_cast<void *>(callback), filter);
+	}
+	/// <summary>
 	/// Unregisters a callback for the specified event (via template) that was previously registered via <see cref="register_event"/>.
 	/// </summary>
 	/// <param name="callback">Pointer to the callback function.</param>
@@ -196,6 +220,35 @@ namespace reshade
 		func(ev, static_cast<void *>(callback));
 	}
 
+	/// <summary>
+	/// Registers a command observer for the specified events (via template) with ReShade.
+	/// <para>Instead of calling a callback for every command, ReShade then appends a compact record (see <see cref="command_record"/>) for each of these events to a buffer per command list and passes that whole buffer to the <paramref name="callback"/> function when the command list is executed.</para>
+	/// <para>This is much cheaper than registering event callbacks for add-ons that only need to observe commands, but cannot be used to modify or skip them.</para>
+	/// </summary>
+	/// <param name="callback">Pointer to the callback function.</param>
+	/// <returns><see langword="true"/> if the observer was registered, or <see langword="false"/> if this version of ReShade does not support command observers (in which case <see cref="register_event"/> has to be used instead).</returns>
+	template <reshade::addon_event... events>
+	inline bool register_command_observer(reshade::command_observer callback)
+	{
+		static_assert((reshade::command_record_traits<events>::supported && ...), "no command records exist for one of the specified events");
+
+		static const reshade::addon_event event_list[] = { events... };
+		static const auto func = reinterpret_cast<bool(*)(void *, uint32_t, const reshade::addon_event *)>(
+			GetProcAddress(internal::get_reshade_module_handle(), "ReShadeRegisterCommandObserver"));
+		return func != nullptr && func(reinterpret_cast<void *>(callback), static_cast<uint32_t>(sizeof...(events)), event_list);
+	}
+	/// <summary>
+	/// Unregisters a command observer that was previously registered via <see cref="register_command_observer"/>.
+	/// </summary>
+	/// <param name="callback">Pointer to the callback function.</param>
+	inline void unregister_command_observer(reshade::command_observer callback)
+	{
+		static const auto func = reinterpret_cast<void(*)(void *)>(
+			GetProcAddress(internal::get_reshade_module_handle(), "ReShadeUnregisterCommandObserver"));
+		if (func != nullptr)
+			func(reinterpret_cast<void *>(callback));
+	}
+
 	/// <summary>
 	/// Registers an overlay with ReShade.
 	/// <para>The callback function is then called when the overlay is visible and allows adding Dear ImGui widgets for user interaction.</para>
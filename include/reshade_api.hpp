@@ -559,5 +559,38 @@ namespace reshade::api
 		/// <param name="name">Name of the definition.</param>
 		/// <param name="value">Value of the definition.</param>
 		virtual void set_preprocessor_definition(const char *name, const char *value) = 0;
+
+		/// <summary>
+		/// Finds multiple uniform variables in the loaded effects at once and returns handles to them.
+		/// </summary>
+		/// <param name="effect_name">File name of the effect file the variables are declared in, or <see langword="nullptr"/> to search in all loaded effects.</param>
+		/// <param name="count">Number of variables to find.</param>
+		/// <param name="variable_names">Pointer to an array of names of the uniform variable declarations to find.</param>
+		/// <param name="out_variables">Pointer to an array that is filled with opaque handles to the uniform variables, or zero for those that were not found.</param>
+		virtual void find_uniform_variables(const char *effect_name, uint32_t count, const char *const *variable_names, effect_uniform_variable *out_variables) const = 0;
+		/// <summary>
+		/// Finds multiple texture variables in the loaded effects at once and returns handles to them.
+		/// </summary>
+		/// <param name="effect_name">File name of the effect file the variables are declared in, or <see langword="nullptr"/> to search in all loaded effects.</param>
+		/// <param name="count">Number of variables to find.</param>
+		/// <param name="variable_names">Pointer to an array of names of the texture variable declarations to find.</param>
+		/// <param name="out_variables">Pointer to an array that is filled with opaque handles to the texture variables, or zero for those that were not found.</param>
+		virtual void find_texture_variables(const char *effect_name, uint32_t count, const char *const *variable_names, effect_texture_variable *out_variables) const = 0;
+		/// <summary>
+		/// Finds multiple techniques in the loaded effects at once and returns handles to them.
+		/// </summary>
+		/// <param name="effect_name">File name of the effect file the techniques are declared in, or <see langword="nullptr"/> to search in all loaded effects.</param>
+		/// <param name="count">Number of techniques to find.</param>
+		/// <param name="technique_names">Pointer to an array of names of the techniques to find.</param>
+		/// <param name="out_techniques">Pointer to an array that is filled with opaque handles to the techniques, or zero for those that were not found.</param>
+		virtual void find_techniques(const char *effect_name, uint32_t count, const char *const *technique_names, effect_technique *out_techniques) = 0;
+
+		/// <summary>
+		/// Writes the 50th, 95th and 99th percentile and maximum of the frame durations and the CPU and GPU durations of all enabled techniques and their passes recorded so far to a CSV file.
+		/// GPU durations are only gathered while the statistics page of the overlay is open, a timing export key is configured, or after this was called once.
+		/// </summary>
+		/// <param name="path">UTF-8 encoded path to the file to write, or <see langword="nullptr"/> to write a file with a generated name into the screenshot directory.</param>
+		/// <returns><see langword="true"/> if the file was written successfully, <see langword="false"/> otherwise.</returns>
+		virtual bool export_timing_statistics(const char *path) = 0;
 	};
 }
@@ -948,6 +948,23 @@ namespace reshade::api
 		/// <param name="label">Null-terminated string containing the label of the debug marker.</param>
 		/// <param name="color">Optional RGBA color value associated with the debug marker.</param>
 		virtual void insert_debug_marker(const char *label, const float color[4] = nullptr) = 0;
+
+		/// <summary>
+		/// Gets an increasing index identifying the submission of the immediate command list that will execute all commands recorded on it so far.
+		/// Compare this against <see cref="get_completed_submission_index"/> to find out whether those commands finished executing, e.g. before mapping a resource they copied to.
+		/// </summary>
+		virtual uint64_t get_pending_submission_index() const = 0;
+		/// <summary>
+		/// Gets the index of the last submission of the immediate command list that finished executing on the GPU.
+		/// In D3D9, D3D10, D3D11 and OpenGL this always equals <see cref="get_pending_submission_index"/>, since mapping a resource waits for pending work to finish there already.
+		/// </summary>
+		virtual uint64_t get_completed_submission_index() const = 0;
+
+		/// <summary>
+		/// Gets the number of ticks per second of timestamps written by <see cref="query_type::timestamp"/> queries executed on this command queue, which is needed to convert the results of <see cref="device::get_query_pool_results"/> to time.
+		/// In D3D9 and OpenGL timestamps are always in nanoseconds. In D3D10 and D3D11 this has to wait for the GPU to report the frequency, so should not be called every frame.
+		/// </summary>
+		virtual uint64_t get_timestamp_frequency() const = 0;
 	};
 
 	/// <summary>
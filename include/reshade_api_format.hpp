@@ -262,7 +262,7 @@ namespace reshade::api
 		case format::bc3_typeless:
 		case format::bc3_unorm:
 		case format::bc3_unorm_srgb:
-			return format::bc2_typeless;
+			return format::bc3_typeless;
 		case format::bc4_typeless:
 		case format::bc4_unorm:
 		case format::bc4_snorm:
@@ -421,7 +421,7 @@ namespace reshade::api
 			return  2 * width;
 		if (value <= format::a8_unorm || value == format::l8_unorm)
 			return  1 * width;
-		if (value <= format::g8r8_g8b8_unorm || (value >= format::b8g8r8a8_unorm && value <= format::b8g8r8x8_unorm_srgb) || (value >= format::r8g8b8x8_typeless && value <= format::r8g8b8x8_unorm_srgb))
+		if (value <= format::g8r8_g8b8_unorm || (value >= format::b8g8r8a8_unorm && value <= format::b8g8r8x8_unorm_srgb) || (value >= format::r8g8b8x8_typeless && value <= format::r8g8b8x8_unorm_srgb) || value == format::b10g10r10a2_unorm)
 			return  4 * width;
 
 		// Block compressed formats are bytes per block, rather than per pixel
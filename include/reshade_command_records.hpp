@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include "reshade_events.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// Header of a compact record of a command that was added to a command list, as passed to command observers (see <see cref="register_command_observer"/>).
+	/// Records are tightly packed one after another, with each record being followed by the event specific data of the matching <c>*_record</c> structure.
+	/// </summary>
+	struct alignas(8) command_record
+	{
+		/// <summary>
+		/// Event this record was created for.
+		/// </summary>
+		addon_event ev;
+		/// <summary>
+		/// Size of this record in bytes, including this header and any trailing arrays (always a multiple of 8).
+		/// </summary>
+		uint32_t size;
+
+		/// <summary>
+		/// Gets the record following this one.
+		/// </summary>
+		const command_record *next() const { return reinterpret_cast<const command_record *>(reinterpret_cast<const uint8_t *>(this) + size); }
+	};
+
+	/// <summary>
+	/// Record of <see cref="addon_event::barrier"/>.
+	/// </summary>
+	struct barrier_record : command_record
+	{
+		uint32_t count;
+
+		const api::resource *resources() const { return reinterpret_cast<const api::resource *>(this + 1); }
+		const api::resource_usage *old_states() const { return reinterpret_cast<const api::resource_usage *>(resources() + count); }
+		const api::resource_usage *new_states() const { return old_states() + count; }
+	};
+
+	/// <summary>
+	/// Record of <see cref="addon_event::bind_render_targets_and_depth_stencil"/>.
+	/// </summary>
+	struct bind_render_targets_and_depth_stencil_record : command_record
+	{
+		uint32_t count;
+		api::resource_view dsv;
+
+		const api::resource_view *rtvs() const { return reinterpret_cast<const api::resource_view *>(this + 1); }
+	};
+
+	/// <summary>
+	/// Record of <see cref="addon_event::bind_pipeline"/>.
+	/// </summary>
+	struct bind_pipeline_record : command_record
+	{
+		api::pipeline_stage stages;
+		api::pipeline pipeline;
+	};
+
+	/// <summary>
+	/// Record of <see cref="addon_event::draw"/>.
+	/// </summary>
+	struct draw_record : command_record
+	{
+		uint32_t vertex_count;
+		uint32_t instance_count;
+		uint32_t first_vertex;
+		uint32_t first_instance;
+	};
+
+	/// <summary>
+	/// Record of <see cref="addon_event::draw_indexed"/>.
+	/// </summary>
+	struct draw_indexed_record : command_record
+	{
+		uint32_t index_count;
+		uint32_t instance_count;
+		uint32_t first_index;
+		int32_t vertex_offset;
+		uint32_t first_instance;
+	};
+
+	/// <summary>
+	/// Record of <see cref="addon_event::dispatch"/>.
+	/// </summary>
+	struct dispatch_record : command_record
+	{
+		uint32_t group_count_x;
+		uint32_t group_count_y;
+		uint32_t group_count_z;
+	};
+
+	/// <summary>
+	/// Record of <see cref="addon_event::draw_or_dispatch_indirect"/>.
+	/// </summary>
+	struct draw_or_dispatch_indirect_record : command_record
+	{
+		api::indirect_command type;
+		api::resource buffer;
+		uint64_t offset;
+		uint32_t draw_count;
+		uint32_t stride;
+	};
+
+	/// <summary>
+	/// Record of <see cref="addon_event::clear_depth_stencil_view"/>.
+	/// Clear rectangles are not recorded.
+	/// </summary>
+	struct clear_depth_stencil_view_record : command_record
+	{
+		api::resource_view dsv;
+		bool clear_depth;
+		bool clear_stencil;
+		uint8_t stencil;
+		float depth;
+	};
+
+	template <addon_event ev>
+	struct command_record_traits
+	{
+		static constexpr bool supported = false;
+	};
+
+#define RESHADE_DEFINE_COMMAND_RECORD_TRAITS(ev, record_type) \
+	template <> \
+	struct command_record_traits<ev> { \
+		static constexpr bool supported = true; \
+		using type = record_type; \
+	}
+
+	RESHADE_DEFINE_COMMAND_RECORD_TRAITS(addon_event::barrier, barrier_record);
+	RESHADE_DEFINE_COMMAND_RECORD_TRAITS(addon_event::bind_render_targets_and_depth_stencil, bind_render_targets_and_depth_stencil_record);
+	RESHADE_DEFINE_COMMAND_RECORD_TRAITS(addon_event::bind_pipeline, bind_pipeline_record);
+	RESHADE_DEFINE_COMMAND_RECORD_TRAITS(addon_event::draw, draw_record);
+	RESHADE_DEFINE_COMMAND_RECORD_TRAITS(addon_event::draw_indexed, draw_indexed_record);
+	RESHADE_DEFINE_COMMAND_RECORD_TRAITS(addon_event::dispatch, dispatch_record);
+	RESHADE_DEFINE_COMMAND_RECORD_TRAITS(addon_event::draw_or_dispatch_indirect, draw_or_dispatch_indirect_record);
+	RESHADE_DEFINE_COMMAND_RECORD_TRAITS(addon_event::clear_depth_stencil_view, clear_depth_stencil_view_record);
+
+	/// <summary>
+	/// Callback function signature of command observers.
+	/// <para>Receives all records that were added to <paramref name="cmd_list"/> since it was last reset, when it is executed on <paramref name="queue"/> (or at present for immediate command lists).</para>
+	/// </summary>
+	/// <remarks>
+	/// The records may include events that other add-ons subscribed to, so observers should skip records of events they do not handle.
+	/// </remarks>
+	using command_observer = void(*)(api::command_queue *queue, api::command_list *cmd_list, const command_record *records, size_t size);
+}
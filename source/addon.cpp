@@ -46,7 +46,7 @@ extern "C" __declspec(dllexport) void ReShadeSetConfigValue(void *, reshade::api
 
 	config.set(section, key, std::string(value));
 
-	config.save();
+	config.queue_save();
 }
 
 #if RESHADE_GUI
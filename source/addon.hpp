@@ -5,9 +5,14 @@
 
 #pragma once
 
+#include <mutex>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 
 template <typename T, size_t STACK_ELEMENTS = 16>
 struct temp_mem
@@ -37,6 +42,78 @@ struct temp_mem
 
 namespace reshade::api
 {
+	/// <summary>
+	/// Process-wide registry that assigns each private data GUID a small integer slot the first time data is set with it.
+	/// Lookups hash the GUID into a fixed open-addressing table that is never shrunk, so they are lock-free. Only registration takes a lock.
+	/// </summary>
+	class private_data_slots
+	{
+	public:
+		static constexpr uint32_t max_slots = 64;
+		static constexpr uint32_t invalid_slot = 0xFFFFFFFF;
+
+		/// <summary>
+		/// Gets the slot of the specified <paramref name="guid"/>, or <see cref="invalid_slot"/> if it was not registered yet.
+		/// </summary>
+		static uint32_t find(const uint8_t guid[16])
+		{
+			for (uint32_t i = hash(guid), probe = 0; probe < table_size; ++probe, i = (i + 1) % table_size)
+			{
+				const uint32_t slot_plus_one = s_table[i].slot_plus_one.load(std::memory_order_acquire);
+				if (slot_plus_one == 0)
+					break;
+				if (std::memcmp(s_table[i].guid, guid, 16) == 0)
+					return slot_plus_one - 1;
+			}
+
+			return invalid_slot;
+		}
+		/// <summary>
+		/// Gets the slot of the specified <paramref name="guid"/>, registering it if necessary, or <see cref="invalid_slot"/> if all slots are in use.
+		/// </summary>
+		static uint32_t find_or_register(const uint8_t guid[16])
+		{
+			if (const uint32_t slot = find(guid); slot != invalid_slot)
+				return slot;
+
+			const std::unique_lock<std::mutex> lock(s_mutex);
+
+			uint32_t i = hash(guid);
+			for (uint32_t slot_plus_one; (slot_plus_one = s_table[i].slot_plus_one.load(std::memory_order_relaxed)) != 0; i = (i + 1) % table_size)
+				if (std::memcmp(s_table[i].guid, guid, 16) == 0)
+					return slot_plus_one - 1; // Another thread registered this GUID in the meantime
+
+			if (s_num_slots == max_slots)
+				return invalid_slot;
+
+			// Write the GUID before publishing the slot, so that lock-free readers never see a partially written entry
+			std::memcpy(s_table[i].guid, guid, 16);
+			s_table[i].slot_plus_one.store(++s_num_slots, std::memory_order_release);
+			return s_num_slots - 1;
+		}
+
+	private:
+		// Keep table at most half full, so that probe sequences stay short
+		static constexpr uint32_t table_size = max_slots * 2;
+
+		struct entry
+		{
+			uint8_t guid[16];
+			std::atomic<uint32_t> slot_plus_one;
+		};
+
+		static uint32_t hash(const uint8_t guid[16])
+		{
+			uint64_t key[2];
+			std::memcpy(key, guid, 16);
+			return static_cast<uint32_t>(((key[0] ^ key[1]) * 0x9E3779B97F4A7C15ull) >> 57) % table_size;
+		}
+
+		static inline entry s_table[table_size] = {};
+		static inline uint32_t s_num_slots = 0;
+		static inline std::mutex s_mutex;
+	};
+
 	template <typename T, typename... api_object_base>
 	class api_object_impl : public api_object_base...
 	{
@@ -48,6 +125,13 @@ namespace reshade::api
 
 		void get_private_data(const uint8_t guid[16], uint64_t *data) const override
 		{
+			if (const uint32_t slot = private_data_slots::find(guid); slot != private_data_slots::invalid_slot)
+			{
+				*data = slot < _private_data_slots.size() ? _private_data_slots[slot] : 0;
+				return;
+			}
+
+			// Fall back to searching the overflow list for GUIDs that did not get a slot
 			for (auto it = _private_data.begin(); it != _private_data.end(); ++it)
 			{
 				if (std::memcmp(it->guid, guid, 16) == 0)
@@ -61,6 +145,19 @@ namespace reshade::api
 		}
 		void set_private_data(const uint8_t guid[16], const uint64_t data)  override
 		{
+			if (const uint32_t slot = data != 0 ? private_data_slots::find_or_register(guid) : private_data_slots::find(guid); slot != private_data_slots::invalid_slot)
+			{
+				if (slot >= _private_data_slots.size())
+				{
+					if (data == 0)
+						return;
+					_private_data_slots.resize(slot + 1);
+				}
+
+				_private_data_slots[slot] = data;
+				return;
+			}
+
 			for (auto it = _private_data.begin(); it != _private_data.end(); ++it)
 			{
 				if (std::memcmp(it->guid, guid, 16) == 0)
@@ -92,6 +189,7 @@ namespace reshade::api
 		{
 			// All user data should ideally have been removed before destruction, to avoid leaks
 			assert(_private_data.empty());
+			assert(std::all_of(_private_data_slots.begin(), _private_data_slots.end(), [](uint64_t data) { return data == 0; }));
 		}
 
 	private:
@@ -101,6 +199,9 @@ namespace reshade::api
 			uint64_t guid[2];
 		};
 
+		// Private data indexed by the slot of its GUID (see 'private_data_slots')
+		std::vector<uint64_t> _private_data_slots;
+		// Private data with GUIDs that did not get a slot because all were in use
 		std::vector<private_data> _private_data;
 	};
 
@@ -119,6 +220,11 @@ namespace reshade
 			std::string title;
 			void(*callback)(api::effect_runtime *) = nullptr;
 		};
+		struct event_statistics
+		{
+			std::atomic<uint64_t> num_calls = 0;
+			std::atomic<uint64_t> total_time = 0; // In nanoseconds
+		};
 
 		void *handle = nullptr;
 #if !RESHADE_ADDON_LITE
@@ -131,6 +237,9 @@ namespace reshade
 		std::string version;
 
 		std::vector<std::pair<uint32_t, void *>> event_callbacks;
+		std::vector<std::pair<void *, std::vector<uint32_t>>> command_observers;
+		// Profiling statistics per event (indexed by 'addon_event'), which are only gathered while 'addon_event_profiling' is enabled
+		std::shared_ptr<event_statistics[]> event_stats;
 #if RESHADE_GUI
 		void(*settings_overlay_callback)(api::effect_runtime *) = nullptr;
 		std::vector<overlay_callback> overlay_callbacks;
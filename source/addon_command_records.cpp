@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#if RESHADE_ADDON
+
+#include "addon_manager.hpp"
+
+std::vector<reshade::command_observer> reshade::addon_command_observers;
+uint32_t reshade::addon_event_observer_count[static_cast<uint32_t>(reshade::addon_event::max)] = {};
+
+void reshade::handle_command_records_execute(api::command_queue *queue, api::command_list *cmd_list, bool clear)
+{
+	if (cmd_list == nullptr)
+		return;
+
+	uint64_t data = 0;
+	cmd_list->get_private_data(reinterpret_cast<const uint8_t *>(&__uuidof(command_record_buffer)), &data);
+	command_record_buffer *const buffer = reinterpret_cast<command_record_buffer *>(static_cast<uintptr_t>(data));
+	if (buffer == nullptr || buffer->size == 0)
+		return;
+
+	for (const command_observer observer : addon_command_observers)
+		observer(queue, cmd_list, reinterpret_cast<const command_record *>(buffer->data.data()), buffer->size);
+
+	if (clear)
+		buffer->size = 0;
+}
+void reshade::handle_command_records_execute_secondary(api::command_list *cmd_list, api::command_list *secondary_cmd_list)
+{
+	uint64_t data = 0;
+	secondary_cmd_list->get_private_data(reinterpret_cast<const uint8_t *>(&__uuidof(command_record_buffer)), &data);
+	const command_record_buffer *const secondary_buffer = reinterpret_cast<const command_record_buffer *>(static_cast<uintptr_t>(data));
+	if (secondary_buffer == nullptr || secondary_buffer->size == 0)
+		return;
+
+	// Commands of the secondary command list are executed as part of this command list, so append its records
+	command_record_buffer &buffer = get_command_record_buffer(cmd_list);
+	if (buffer.size + secondary_buffer->size > buffer.data.size())
+		buffer.data.resize(std::max(buffer.size + secondary_buffer->size, buffer.data.size() * 2));
+	std::memcpy(buffer.data.data() + buffer.size, secondary_buffer->data.data(), secondary_buffer->size);
+	buffer.size += secondary_buffer->size;
+}
+void reshade::handle_command_records_reset(api::command_list *cmd_list)
+{
+	uint64_t data = 0;
+	cmd_list->get_private_data(reinterpret_cast<const uint8_t *>(&__uuidof(command_record_buffer)), &data);
+	if (data != 0)
+		reinterpret_cast<command_record_buffer *>(static_cast<uintptr_t>(data))->size = 0;
+}
+void reshade::handle_command_records_destroy(api::command_list *cmd_list)
+{
+	uint64_t data = 0;
+	cmd_list->get_private_data(reinterpret_cast<const uint8_t *>(&__uuidof(command_record_buffer)), &data);
+	if (data != 0)
+		cmd_list->destroy_private_data<command_record_buffer>();
+}
+
+#endif
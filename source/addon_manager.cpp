@@ -18,10 +18,9 @@ extern HMODULE g_module_handle;
 
 extern std::filesystem::path get_module_path(HMODULE module);
 
-#if RESHADE_VERBOSE_LOG
-static const char *addon_event_to_string(reshade::addon_event ev)
+const char *reshade::addon_event_to_string(addon_event ev)
 {
-#define CASE(name) case reshade::addon_event::name: return #name
+#define CASE(name) case addon_event::name: return #name
 	switch (ev)
 	{
 		CASE(init_device);
@@ -109,12 +108,12 @@ static const char *addon_event_to_string(reshade::addon_event ev)
 #undef  CASE
 	return "unknown";
 }
-#endif
 
 #if RESHADE_ADDON_LITE
 bool reshade::addon_enabled = true;
 #endif
-std::vector<void *> reshade::addon_event_list[static_cast<uint32_t>(reshade::addon_event::max)];
+bool reshade::addon_event_profiling = false;
+std::vector<reshade::addon_event_callback> reshade::addon_event_list[static_cast<uint32_t>(reshade::addon_event::max)];
 std::vector<reshade::addon_info> reshade::addon_loaded_info;
 static unsigned long s_reference_count = 0;
 
@@ -229,6 +228,7 @@ void reshade::unload_addons()
 	// All events should have been unregistered at this point
 	for (const auto &event_info : addon_event_list)
 		assert(event_info.empty());
+	assert(addon_command_observers.empty());
 #endif
 
 	addon_loaded_info.clear();
@@ -253,8 +253,12 @@ extern "C" __declspec(dllexport) bool ReShadeRegisterAddon(HMODULE module, uint3
 extern "C" __declspec(dllexport) void ReShadeUnregisterAddon(HMODULE module);
 
 extern "C" __declspec(dllexport) void ReShadeRegisterEvent(reshade::addon_event ev, void *callback);
+extern "C" __declspec(dllexport) void ReShadeRegisterEventWithFilter(reshade::addon_event ev, void *callback, uint32_t filter);
 extern "C" __declspec(dllexport) void ReShadeUnregisterEvent(reshade::addon_event ev, void *callback);
 
+extern "C" __declspec(dllexport) bool ReShadeRegisterCommandObserver(void *callback, uint32_t count, const reshade::addon_event *events);
+extern "C" __declspec(dllexport) void ReShadeUnregisterCommandObserver(void *callback);
+
 #if RESHADE_GUI
 extern "C" __declspec(dllexport) void ReShadeRegisterOverlay(const char *title, void(*callback)(reshade::api::effect_runtime *runtime));
 extern "C" __declspec(dllexport) void ReShadeUnregisterOverlay(const char *title, void(*callback)(reshade::api::effect_runtime *runtime));
@@ -353,6 +357,12 @@ void ReShadeUnregisterAddon(HMODULE module)
 		ReShadeUnregisterEvent(static_cast<reshade::addon_event>(last_event_callback.first), last_event_callback.second);
 	}
 
+	// Unregister all command observers registered by this add-on
+	while (!info->command_observers.empty())
+	{
+		ReShadeUnregisterCommandObserver(info->command_observers.back().first);
+	}
+
 #if RESHADE_GUI
 	// Unregister all overlay callbacks associated with this add-on
 	while (!info->overlay_callbacks.empty())
@@ -368,6 +378,10 @@ void ReShadeUnregisterAddon(HMODULE module)
 }
 
 void ReShadeRegisterEvent(reshade::addon_event ev, void *callback)
+{
+	ReShadeRegisterEventWithFilter(ev, callback, 0xFFFFFFFF);
+}
+void ReShadeRegisterEventWithFilter(reshade::addon_event ev, void *callback, uint32_t filter)
 {
 	if (ev >= reshade::addon_event::max)
 		return;
@@ -388,13 +402,16 @@ void ReShadeRegisterEvent(reshade::addon_event ev, void *callback)
 	}
 #endif
 
+	if (info->event_stats == nullptr)
+		info->event_stats.reset(new reshade::addon_info::event_statistics[static_cast<uint32_t>(reshade::addon_event::max)]);
+
 	auto &event_list = reshade::addon_event_list[static_cast<uint32_t>(ev)];
-	event_list.push_back(callback);
+	event_list.push_back({ callback, filter, &info->event_stats[static_cast<uint32_t>(ev)] });
 
 	info->event_callbacks.emplace_back(static_cast<uint32_t>(ev), callback);
 
 #if RESHADE_VERBOSE_LOG
-	LOG(DEBUG) << "Registered event callback " << callback << " for event " << addon_event_to_string(ev) << '.';
+	LOG(DEBUG) << "Registered event callback " << callback << " for event " << reshade::addon_event_to_string(ev) << " with filter " << std::hex << filter << std::dec << '.';
 #endif
 }
 void ReShadeUnregisterEvent(reshade::addon_event ev, void *callback)
@@ -412,12 +429,96 @@ void ReShadeUnregisterEvent(reshade::addon_event ev, void *callback)
 #endif
 
 	auto &event_list = reshade::addon_event_list[static_cast<uint32_t>(ev)];
-	event_list.erase(std::remove(event_list.begin(), event_list.end(), callback), event_list.end());
+	event_list.erase(std::remove_if(event_list.begin(), event_list.end(),
+		[callback](const reshade::addon_event_callback &item) { return item.func == callback; }), event_list.end());
 
 	info->event_callbacks.erase(std::remove(info->event_callbacks.begin(), info->event_callbacks.end(), std::make_pair(static_cast<uint32_t>(ev), callback)), info->event_callbacks.end());
 
 #if RESHADE_VERBOSE_LOG
-	LOG(DEBUG) << "Unregistered event callback " << callback << " for event " << addon_event_to_string(ev) << '.';
+	LOG(DEBUG) << "Unregistered event callback " << callback << " for event " << reshade::addon_event_to_string(ev) << '.';
+#endif
+}
+
+// Command list events that are needed to manage and pass on the records of the observed events
+static constexpr reshade::addon_event s_command_observer_lifetime_events[] = {
+	reshade::addon_event::execute_command_list,
+	reshade::addon_event::execute_secondary_command_list,
+	reshade::addon_event::present,
+};
+
+bool ReShadeRegisterCommandObserver(void *callback, uint32_t count, const reshade::addon_event *events)
+{
+	reshade::addon_info *const info = reshade::find_addon(callback);
+	if (info == nullptr)
+	{
+		LOG(ERROR) << "Could not find associated add-on and therefore failed to register a command observer.";
+		return false;
+	}
+
+#if RESHADE_ADDON_LITE
+	if (info->handle != g_module_handle)
+	{
+		LOG(ERROR) << "Failed to register a command observer because only limited add-on functionality is available.";
+		return false;
+	}
+#endif
+
+	std::vector<uint32_t> observed_events;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		switch (events[i])
+		{
+		case reshade::addon_event::barrier:
+		case reshade::addon_event::bind_render_targets_and_depth_stencil:
+		case reshade::addon_event::bind_pipeline:
+		case reshade::addon_event::draw:
+		case reshade::addon_event::draw_indexed:
+		case reshade::addon_event::dispatch:
+		case reshade::addon_event::draw_or_dispatch_indirect:
+		case reshade::addon_event::clear_depth_stencil_view:
+			observed_events.push_back(static_cast<uint32_t>(events[i]));
+			break;
+		default:
+			LOG(ERROR) << "Failed to register a command observer because there are no command records for event " << reshade::addon_event_to_string(events[i]) << '.';
+			return false;
+		}
+	}
+
+	for (const reshade::addon_event ev : s_command_observer_lifetime_events)
+		observed_events.push_back(static_cast<uint32_t>(ev));
+
+	for (const uint32_t ev : observed_events)
+		reshade::addon_event_observer_count[ev]++;
+
+	reshade::addon_command_observers.push_back(reinterpret_cast<reshade::command_observer>(callback));
+
+	info->command_observers.emplace_back(callback, std::move(observed_events));
+
+#if RESHADE_VERBOSE_LOG
+	LOG(DEBUG) << "Registered command observer " << callback << " for " << count << " events.";
+#endif
+	return true;
+}
+void ReShadeUnregisterCommandObserver(void *callback)
+{
+	reshade::addon_info *const info = reshade::find_addon(callback);
+	if (info == nullptr)
+		return;
+
+	const auto it = std::find_if(info->command_observers.begin(), info->command_observers.end(),
+		[callback](const std::pair<void *, std::vector<uint32_t>> &item) { return item.first == callback; });
+	if (it == info->command_observers.end())
+		return;
+
+	for (const uint32_t ev : it->second)
+		reshade::addon_event_observer_count[ev]--;
+
+	reshade::addon_command_observers.erase(std::find(reshade::addon_command_observers.begin(), reshade::addon_command_observers.end(), reinterpret_cast<reshade::command_observer>(callback)));
+
+	info->command_observers.erase(it);
+
+#if RESHADE_VERBOSE_LOG
+	LOG(DEBUG) << "Unregistered command observer " << callback << '.';
 #endif
 }
 
@@ -7,6 +7,10 @@
 
 #include "addon.hpp"
 #include "reshade_events.hpp"
+#include "reshade_command_records.hpp"
+#include <chrono>
+#include <cstring>
+#include <algorithm>
 
 #if RESHADE_ADDON
 
@@ -19,10 +23,34 @@ namespace reshade
 	extern bool addon_enabled;
 #endif
 
+	/// <summary>
+	/// Global switch to enable gathering call counts and timings of all add-on event callbacks.
+	/// </summary>
+	extern bool addon_event_profiling;
+
+	/// <summary>
+	/// An add-on event callback and the filter mask it was registered with.
+	/// </summary>
+	struct addon_event_callback
+	{
+		void *func;
+		uint32_t filter;
+		addon_info::event_statistics *stats;
+	};
+
 	/// <summary>
 	/// List of add-on event callbacks.
 	/// </summary>
-	extern std::vector<void *> addon_event_list[];
+	extern std::vector<addon_event_callback> addon_event_list[];
+
+	/// <summary>
+	/// List of registered command observers.
+	/// </summary>
+	extern std::vector<command_observer> addon_command_observers;
+	/// <summary>
+	/// Number of command observers that need records of each event (or the command list lifetime events they depend on).
+	/// </summary>
+	extern uint32_t addon_event_observer_count[];
 
 	/// <summary>
 	/// List of currently loaded add-ons.
@@ -44,13 +72,186 @@ namespace reshade
 	/// </summary>
 	addon_info *find_addon(void *address);
 
+	/// <summary>
+	/// Gets the name of the specified <paramref name="ev"/>ent.
+	/// </summary>
+	const char *addon_event_to_string(addon_event ev);
+
 	/// <summary>
 	/// Checks whether any callbacks were registered for the specified <paramref name="ev"/>ent.
 	/// </summary>
 	template <addon_event ev>
 	__forceinline bool has_addon_event()
 	{
-		return !addon_event_list[static_cast<uint32_t>(ev)].empty();
+		return !addon_event_list[static_cast<uint32_t>(ev)].empty() || addon_event_observer_count[static_cast<uint32_t>(ev)] != 0;
+	}
+
+	/// <summary>
+	/// Buffer of command records for command observers, attached to each command list that records commands while observers are registered.
+	/// </summary>
+	struct __declspec(uuid("5C2E9D41-8A7F-4B36-9E0D-1F4B6A3C8E27")) command_record_buffer
+	{
+		std::vector<uint8_t> data;
+		size_t size = 0;
+
+		template <typename T>
+		__forceinline T *append(addon_event ev, size_t trailing_size = 0)
+		{
+			const size_t record_size = (sizeof(T) + trailing_size + 7) & ~static_cast<size_t>(7);
+			if (size + record_size > data.size())
+				data.resize(std::max(size + record_size, data.size() * 2));
+
+			T *const record = reinterpret_cast<T *>(data.data() + size);
+			record->ev = ev;
+			record->size = static_cast<uint32_t>(record_size);
+			size += record_size;
+			return record;
+		}
+	};
+
+	/// <summary>
+	/// Gets the command record buffer of the specified command list, creating it if it does not exist yet.
+	/// </summary>
+	inline command_record_buffer &get_command_record_buffer(api::command_list *cmd_list)
+	{
+		uint64_t data = 0;
+		cmd_list->get_private_data(reinterpret_cast<const uint8_t *>(&__uuidof(command_record_buffer)), &data);
+		if (data == 0)
+			return cmd_list->create_private_data<command_record_buffer>();
+		return *reinterpret_cast<command_record_buffer *>(static_cast<uintptr_t>(data));
+	}
+
+	/// <summary>
+	/// Appends a record of a call of the specified <typeparamref name="ev"/>ent to the command record buffer of the command list it was called on.
+	/// </summary>
+	template <addon_event ev, typename... Args>
+	inline void record_addon_command(const Args &... args)
+	{
+		using record_type = typename command_record_traits<ev>::type;
+
+		if constexpr (ev == addon_event::barrier)
+			[](api::command_list *cmd_list, uint32_t count, const api::resource *resources, const api::resource_usage *old_states, const api::resource_usage *new_states) {
+				record_type *const record = get_command_record_buffer(cmd_list).append<record_type>(ev, count * (sizeof(api::resource) + 2 * sizeof(api::resource_usage)));
+				record->count = count;
+				uint8_t *const trailing_data = reinterpret_cast<uint8_t *>(record + 1);
+				std::memcpy(trailing_data, resources, count * sizeof(api::resource));
+				std::memcpy(trailing_data + count * sizeof(api::resource), old_states, count * sizeof(api::resource_usage));
+				std::memcpy(trailing_data + count * (sizeof(api::resource) + sizeof(api::resource_usage)), new_states, count * sizeof(api::resource_usage));
+			}(args...);
+		else if constexpr (ev == addon_event::bind_render_targets_and_depth_stencil)
+			[](api::command_list *cmd_list, uint32_t count, const api::resource_view *rtvs, api::resource_view dsv) {
+				record_type *const record = get_command_record_buffer(cmd_list).append<record_type>(ev, count * sizeof(api::resource_view));
+				record->count = count;
+				record->dsv = dsv;
+				std::memcpy(record + 1, rtvs, count * sizeof(api::resource_view));
+			}(args...);
+		else if constexpr (ev == addon_event::bind_pipeline)
+			[](api::command_list *cmd_list, api::pipeline_stage stages, api::pipeline pipeline) {
+				record_type *const record = get_command_record_buffer(cmd_list).append<record_type>(ev);
+				record->stages = stages;
+				record->pipeline = pipeline;
+			}(args...);
+		else if constexpr (ev == addon_event::draw)
+			[](api::command_list *cmd_list, uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) {
+				record_type *const record = get_command_record_buffer(cmd_list).append<record_type>(ev);
+				record->vertex_count = vertex_count;
+				record->instance_count = instance_count;
+				record->first_vertex = first_vertex;
+				record->first_instance = first_instance;
+			}(args...);
+		else if constexpr (ev == addon_event::draw_indexed)
+			[](api::command_list *cmd_list, uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance) {
+				record_type *const record = get_command_record_buffer(cmd_list).append<record_type>(ev);
+				record->index_count = index_count;
+				record->instance_count = instance_count;
+				record->first_index = first_index;
+				record->vertex_offset = vertex_offset;
+				record->first_instance = first_instance;
+			}(args...);
+		else if constexpr (ev == addon_event::dispatch)
+			[](api::command_list *cmd_list, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) {
+				record_type *const record = get_command_record_buffer(cmd_list).append<record_type>(ev);
+				record->group_count_x = group_count_x;
+				record->group_count_y = group_count_y;
+				record->group_count_z = group_count_z;
+			}(args...);
+		else if constexpr (ev == addon_event::draw_or_dispatch_indirect)
+			[](api::command_list *cmd_list, api::indirect_command type, api::resource buffer, uint64_t offset, uint32_t draw_count, uint32_t stride) {
+				record_type *const record = get_command_record_buffer(cmd_list).append<record_type>(ev);
+				record->type = type;
+				record->buffer = buffer;
+				record->offset = offset;
+				record->draw_count = draw_count;
+				record->stride = stride;
+			}(args...);
+		else if constexpr (ev == addon_event::clear_depth_stencil_view)
+			[](api::command_list *cmd_list, api::resource_view dsv, const float *depth, const uint8_t *stencil, uint32_t, const api::rect *) {
+				record_type *const record = get_command_record_buffer(cmd_list).append<record_type>(ev);
+				record->dsv = dsv;
+				record->clear_depth = depth != nullptr;
+				record->clear_stencil = stencil != nullptr;
+				record->stencil = stencil != nullptr ? *stencil : 0;
+				record->depth = depth != nullptr ? *depth : 0.0f;
+			}(args...);
+	}
+
+	/// <summary>
+	/// Updates command record buffers for command list lifetime events and passes them to command observers on execution.
+	/// </summary>
+	void handle_command_records_execute(api::command_queue *queue, api::command_list *cmd_list, bool clear);
+	void handle_command_records_execute_secondary(api::command_list *cmd_list, api::command_list *secondary_cmd_list);
+	void handle_command_records_reset(api::command_list *cmd_list);
+	void handle_command_records_destroy(api::command_list *cmd_list);
+
+	/// <summary>
+	/// Gets the value that callback filter masks are compared against for a call of the specified <typeparamref name="ev"/>ent (see <see cref="register_event"/>).
+	/// </summary>
+	template <addon_event ev, typename... Args>
+	__forceinline uint32_t get_addon_event_filter_value(const Args &... args)
+	{
+		if constexpr (ev == addon_event::init_resource || ev == addon_event::create_resource)
+			return [](api::device *, const api::resource_desc &desc, auto &&...) { return 1u << static_cast<uint32_t>(desc.type); }(args...);
+		else if constexpr (ev == addon_event::init_resource_view || ev == addon_event::create_resource_view)
+			// Some back-ends do not know the usage of a view (e.g. Vulkan and OpenGL), so match all callbacks in that case
+			return [](api::device *, api::resource, api::resource_usage usage_type, auto &&...) { return usage_type != api::resource_usage::undefined ? static_cast<uint32_t>(usage_type) : 0xFFFFFFFF; }(args...);
+		else if constexpr (ev == addon_event::bind_pipeline)
+			return [](api::command_list *, api::pipeline_stage stages, auto &&...) { return static_cast<uint32_t>(stages); }(args...);
+		else if constexpr (ev == addon_event::push_constants || ev == addon_event::push_descriptors || ev == addon_event::bind_descriptor_sets)
+			return [](api::command_list *, api::shader_stage stages, auto &&...) { return static_cast<uint32_t>(stages); }(args...);
+		else if constexpr (ev == addon_event::draw_or_dispatch_indirect)
+			return [](api::command_list *, api::indirect_command type, auto &&...) { return 1u << static_cast<uint32_t>(type); }(args...);
+		else
+			return 0xFFFFFFFF;
+	}
+
+	/// <summary>
+	/// Invokes a single add-on event callback, measuring its duration if <see cref="addon_event_profiling"/> is enabled.
+	/// </summary>
+	template <addon_event ev, typename... Args>
+	__forceinline typename addon_event_traits<ev>::type invoke_addon_event_callback(const addon_event_callback &cb, Args &&... args)
+	{
+		const auto func = reinterpret_cast<typename addon_event_traits<ev>::decl>(cb.func);
+
+		if (!addon_event_profiling)
+			return func(std::forward<Args>(args)...);
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		const auto record = [&cb, start]() {
+			cb.stats->num_calls.fetch_add(1, std::memory_order_relaxed);
+			cb.stats->total_time.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count(), std::memory_order_relaxed);
+		};
+
+		if constexpr (std::is_same_v<typename addon_event_traits<ev>::type, void>)
+		{
+			func(std::forward<Args>(args)...);
+			record();
+		}
+		else
+		{
+			const auto result = func(std::forward<Args>(args)...);
+			record();
+			return result;
+		}
 	}
 
 	/// <summary>
@@ -87,9 +288,43 @@ namespace reshade
 		if (!addon_enabled)
 			return;
 #endif
-		std::vector<void *> &event_list = addon_event_list[static_cast<uint32_t>(ev)];
+		const uint32_t filter_value = get_addon_event_filter_value<ev>(args...);
+
+		std::vector<addon_event_callback> &event_list = addon_event_list[static_cast<uint32_t>(ev)];
 		for (size_t cb = 0, count = event_list.size(); cb < count; ++cb) // Generates better code than ranged-based for loop
-			reinterpret_cast<typename addon_event_traits<ev>::decl>(event_list[cb])(std::forward<Args>(args)...);
+			if ((event_list[cb].filter & filter_value) != 0)
+				invoke_addon_event_callback<ev>(event_list[cb], std::forward<Args>(args)...);
+
+		if constexpr (command_record_traits<ev>::supported)
+		{
+			if (addon_event_observer_count[static_cast<uint32_t>(ev)] != 0)
+				record_addon_command<ev>(args...);
+		}
+		else if constexpr (ev == addon_event::execute_command_list)
+		{
+			if (addon_event_observer_count[static_cast<uint32_t>(ev)] != 0)
+				[](api::command_queue *queue, api::command_list *cmd_list) { handle_command_records_execute(queue, cmd_list, false); }(args...);
+		}
+		else if constexpr (ev == addon_event::execute_secondary_command_list)
+		{
+			if (addon_event_observer_count[static_cast<uint32_t>(ev)] != 0)
+				[](api::command_list *cmd_list, api::command_list *secondary_cmd_list) { handle_command_records_execute_secondary(cmd_list, secondary_cmd_list); }(args...);
+		}
+		else if constexpr (ev == addon_event::present)
+		{
+			// Immediate command lists are never executed explicitly, so pass their records to observers once per frame
+			if (addon_event_observer_count[static_cast<uint32_t>(ev)] != 0)
+				[](api::command_queue *queue, auto &&...) { handle_command_records_execute(queue, queue->get_immediate_command_list(), true); }(args...);
+		}
+		else if constexpr (ev == addon_event::reset_command_list)
+		{
+			[](api::command_list *cmd_list) { handle_command_records_reset(cmd_list); }(args...);
+		}
+		else if constexpr (ev == addon_event::destroy_command_list)
+		{
+			// Always free the buffer, even if all observers were unregistered since it was created
+			[](api::command_list *cmd_list) { handle_command_records_destroy(cmd_list); }(args...);
+		}
 	}
 	/// <summary>
 	/// Invokes registered callbacks for the specified <typeparamref name="ev"/>ent until a callback reports back as having handled this event by returning <see langword="true"/>.
@@ -101,10 +336,20 @@ namespace reshade
 		if (!addon_enabled)
 			return false;
 #endif
-		std::vector<void *> &event_list = addon_event_list[static_cast<uint32_t>(ev)];
+		const uint32_t filter_value = get_addon_event_filter_value<ev>(args...);
+
+		std::vector<addon_event_callback> &event_list = addon_event_list[static_cast<uint32_t>(ev)];
 		for (size_t cb = 0, count = event_list.size(); cb < count; ++cb)
-			if (reinterpret_cast<typename addon_event_traits<ev>::decl>(event_list[cb])(std::forward<Args>(args)...))
+			if ((event_list[cb].filter & filter_value) != 0 && invoke_addon_event_callback<ev>(event_list[cb], std::forward<Args>(args)...))
 				return true;
+
+		// Only record commands that were not skipped by a callback
+		if constexpr (command_record_traits<ev>::supported)
+		{
+			if (addon_event_observer_count[static_cast<uint32_t>(ev)] != 0)
+				record_addon_command<ev>(args...);
+		}
+
 		return false;
 	}
 }
@@ -9,3 +9,33 @@ void reshade::d3d10::device_impl::flush_immediate_command_list() const
 {
 	_orig->Flush();
 }
+
+uint64_t reshade::d3d10::device_impl::get_timestamp_frequency() const
+{
+	if (_timestamp_frequency_queried)
+		return _timestamp_frequency;
+	_timestamp_frequency_queried = true;
+
+	// The frequency can only be queried with a disjoint query, so submit one and wait for its result (which does not change for the lifetime of the device)
+	const D3D10_QUERY_DESC internal_desc = { D3D10_QUERY_TIMESTAMP_DISJOINT };
+
+	com_ptr<ID3D10Query> query;
+	if (FAILED(_orig->CreateQuery(&internal_desc, &query)))
+		return 0;
+
+	query->Begin();
+	query->End();
+
+	D3D10_QUERY_DATA_TIMESTAMP_DISJOINT data = {};
+	for (int attempt = 0; attempt < 1000; ++attempt)
+	{
+		const HRESULT hr = query->GetData(&data, sizeof(data), 0);
+		if (hr == S_OK)
+			return _timestamp_frequency = data.Frequency;
+		if (FAILED(hr))
+			break;
+		Sleep(1);
+	}
+
+	return 0;
+}
@@ -1161,6 +1161,9 @@ HRESULT STDMETHODCALLTYPE D3D11DeviceContext::FinishCommandList(BOOL RestoreDefe
 	}
 
 #if RESHADE_ADDON
+	// Records were copied to the command list object above, so start with an empty buffer for the next command list, regardless of whether state is restored
+	reshade::handle_command_records_reset(this);
+
 	if (!RestoreDeferredContextState)
 	{
 		reshade::invoke_addon_event<reshade::addon_event::reset_command_list>(this);
@@ -85,6 +85,11 @@ namespace reshade::d3d11
 
 		api::command_list *get_immediate_command_list() final;
 
+		uint64_t get_pending_submission_index() const final { return 0; }
+		uint64_t get_completed_submission_index() const final { return 0; }
+
+		uint64_t get_timestamp_frequency() const final;
+
 		void barrier(uint32_t count, const api::resource *resources, const api::resource_usage *old_states, const api::resource_usage *new_states) final;
 
 		void begin_render_pass(uint32_t count, const api::render_pass_render_target_desc *rts, const api::render_pass_depth_stencil_desc *ds) final;
@@ -142,5 +147,9 @@ namespace reshade::d3d11
 
 		UINT _push_constants_size = 0;
 		com_ptr<ID3D11Buffer> _push_constants;
+
+		mutable uint64_t _timestamp_frequency = 0;
+		// Set after the first query, so that a failure is not retried (and waited on) again
+		mutable bool _timestamp_frequency_queried = false;
 	};
 }
@@ -148,6 +148,10 @@ HRESULT STDMETHODCALLTYPE D3D12GraphicsCommandList::Reset(ID3D12CommandAllocator
 	_current_descriptor_heaps[0] = nullptr;
 	_current_descriptor_heaps[1] = nullptr;
 
+	// Previously recorded commands can no longer be executed after a reset, so transient descriptors only have to stay alive until the last submission completed
+	release_transient_descriptors();
+	_executed_bundles.clear();
+
 	const HRESULT hr = _orig->Reset(pAllocator, pInitialState);
 #if RESHADE_ADDON && !RESHADE_ADDON_LITE
 	if (SUCCEEDED(hr))
@@ -413,6 +417,10 @@ void STDMETHODCALLTYPE D3D12GraphicsCommandList::ExecuteBundle(ID3D12GraphicsCom
 	reshade::invoke_addon_event<reshade::addon_event::execute_secondary_command_list>(this, command_list_proxy);
 #endif
 
+	// Keep the bundle alive until this command list was submitted, so that its transient descriptors can be tagged with the fence value of that submission
+	if (command_list_proxy->has_transient_descriptors())
+		_executed_bundles.emplace_back(command_list_proxy);
+
 	_orig->ExecuteBundle(command_list_proxy->_orig);
 }
 void STDMETHODCALLTYPE D3D12GraphicsCommandList::SetDescriptorHeaps(UINT NumDescriptorHeaps, ID3D12DescriptorHeap *const *ppDescriptorHeaps)
@@ -118,6 +118,10 @@ struct DECLSPEC_UUID("479B29E3-9A2C-11D0-B696-00A0C903487A") D3D12GraphicsComman
 
 	bool check_and_upgrade_interface(REFIID riid);
 
+	// Bundles with transient descriptors that were executed by this command list since it was last reset
+	// Bundles are never submitted to a queue themselves, so their transient descriptors are tagged with the fence value of the submissions of this command list instead
+	std::vector<com_ptr<D3D12GraphicsCommandList>> _executed_bundles;
+
 	ULONG _ref = 1;
 	unsigned int _interface_version = 0;
 	D3D12Device *const _device;
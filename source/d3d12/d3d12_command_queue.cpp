@@ -153,6 +153,8 @@ void    STDMETHODCALLTYPE D3D12CommandQueue::ExecuteCommandLists(UINT NumCommand
 	std::unique_lock<std::shared_mutex> lock(_mutex);
 
 	temp_mem<ID3D12CommandList *> command_lists(NumCommandLists);
+	temp_mem<D3D12GraphicsCommandList *> command_lists_with_transient_descriptors(NumCommandLists);
+	UINT num_command_lists_with_transient_descriptors = 0;
 	for (UINT i = 0; i < NumCommandLists; i++)
 	{
 		assert(ppCommandLists[i] != nullptr);
@@ -166,6 +168,9 @@ void    STDMETHODCALLTYPE D3D12CommandQueue::ExecuteCommandLists(UINT NumCommand
 
 			// Get original command list pointer from proxy object
 			command_lists[i] = command_list_proxy->_orig;
+
+			if (command_list_proxy->has_transient_descriptors() || !command_list_proxy->_executed_bundles.empty())
+				command_lists_with_transient_descriptors[num_command_lists_with_transient_descriptors++] = command_list_proxy.get();
 		}
 		else
 		{
@@ -179,6 +184,19 @@ void    STDMETHODCALLTYPE D3D12CommandQueue::ExecuteCommandLists(UINT NumCommand
 	lock.unlock();
 
 	_orig->ExecuteCommandLists(NumCommandLists, command_lists.p);
+
+	// Signal after execution, so that transient descriptors of these command lists are not reused before they finished executing
+	if (num_command_lists_with_transient_descriptors != 0)
+	{
+		const UINT64 fence_value = _submission_fence->signal(_orig);
+		for (UINT i = 0; i < num_command_lists_with_transient_descriptors; i++)
+		{
+			command_lists_with_transient_descriptors[i]->submit_transient_descriptors(_submission_fence, fence_value);
+
+			for (const com_ptr<D3D12GraphicsCommandList> &bundle : command_lists_with_transient_descriptors[i]->_executed_bundles)
+				bundle->submit_transient_descriptors(_submission_fence, fence_value);
+		}
+	}
 }
 void    STDMETHODCALLTYPE D3D12CommandQueue::SetMarker(UINT Metadata, const void *pData, UINT Size)
 {
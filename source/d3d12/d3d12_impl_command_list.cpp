@@ -33,6 +33,8 @@ reshade::d3d12::command_list_impl::~command_list_impl()
 	if (_orig != nullptr)
 		invoke_addon_event<addon_event::destroy_command_list>(this);
 #endif
+
+	release_transient_descriptors();
 }
 
 reshade::api::device *reshade::d3d12::command_list_impl::get_device()
@@ -40,6 +42,17 @@ reshade::api::device *reshade::d3d12::command_list_impl::get_device()
 	return _device_impl;
 }
 
+void reshade::d3d12::command_list_impl::submit_transient_descriptors(submission_fence *fence, UINT64 fence_value)
+{
+	_device_impl->_gpu_sampler_heap.submit_transient(_transient_descriptors[0], fence, fence_value);
+	_device_impl->_gpu_view_heap.submit_transient(_transient_descriptors[1], fence, fence_value);
+}
+void reshade::d3d12::command_list_impl::release_transient_descriptors()
+{
+	_device_impl->_gpu_sampler_heap.release_transient(_transient_descriptors[0]);
+	_device_impl->_gpu_view_heap.release_transient(_transient_descriptors[1]);
+}
+
 void reshade::d3d12::command_list_impl::barrier(uint32_t count, const api::resource *resources, const api::resource_usage *old_states, const api::resource_usage *new_states)
 {
 	if (count == 0)
@@ -259,8 +272,8 @@ void reshade::d3d12::command_list_impl::push_descriptors(api::shader_stage stage
 	D3D12_CPU_DESCRIPTOR_HANDLE base_handle;
 	D3D12_GPU_DESCRIPTOR_HANDLE base_handle_gpu;
 	if (update.type != api::descriptor_type::sampler ?
-		!_device_impl->_gpu_view_heap.allocate_transient(update.binding + update.count, base_handle, base_handle_gpu) :
-		!_device_impl->_gpu_sampler_heap.allocate_transient(update.binding + update.count, base_handle, base_handle_gpu))
+		!_device_impl->_gpu_view_heap.allocate_transient(_transient_descriptors[1], update.binding + update.count, base_handle, base_handle_gpu) :
+		!_device_impl->_gpu_sampler_heap.allocate_transient(_transient_descriptors[0], update.binding + update.count, base_handle, base_handle_gpu))
 		return;
 
 	const D3D12_DESCRIPTOR_HEAP_TYPE heap_type = convert_descriptor_type_to_heap_type(update.type);
@@ -663,7 +676,7 @@ void reshade::d3d12::command_list_impl::clear_unordered_access_view_uint(api::re
 
 	D3D12_CPU_DESCRIPTOR_HANDLE table_base;
 	D3D12_GPU_DESCRIPTOR_HANDLE table_base_gpu;
-	if (!_device_impl->_gpu_view_heap.allocate_transient(1, table_base, table_base_gpu))
+	if (!_device_impl->_gpu_view_heap.allocate_transient(_transient_descriptors[1], 1, table_base, table_base_gpu))
 		return;
 
 	const auto view_heap = _device_impl->_gpu_view_heap.get();
@@ -687,7 +700,7 @@ void reshade::d3d12::command_list_impl::clear_unordered_access_view_float(api::r
 
 	D3D12_CPU_DESCRIPTOR_HANDLE table_base;
 	D3D12_GPU_DESCRIPTOR_HANDLE table_base_gpu;
-	if (!_device_impl->_gpu_view_heap.allocate_transient(1, table_base, table_base_gpu))
+	if (!_device_impl->_gpu_view_heap.allocate_transient(_transient_descriptors[1], 1, table_base, table_base_gpu))
 		return;
 
 	const auto view_heap = _device_impl->_gpu_view_heap.get();
@@ -714,7 +727,7 @@ void reshade::d3d12::command_list_impl::generate_mipmaps(api::resource_view srv)
 
 	D3D12_CPU_DESCRIPTOR_HANDLE base_handle;
 	D3D12_GPU_DESCRIPTOR_HANDLE base_handle_gpu;
-	if (!_device_impl->_gpu_view_heap.allocate_transient(desc.MipLevels * 2, base_handle, base_handle_gpu))
+	if (!_device_impl->_gpu_view_heap.allocate_transient(_transient_descriptors[1], desc.MipLevels * 2, base_handle, base_handle_gpu))
 		return;
 
 	for (uint32_t level = 0; level < desc.MipLevels; ++level, base_handle = _device_impl->offset_descriptor_handle(base_handle, 1, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV))
@@ -7,6 +7,7 @@
 
 #include <d3d12.h>
 #include "addon_manager.hpp"
+#include "descriptor_heap.hpp"
 
 namespace reshade::d3d12
 {
@@ -66,6 +67,17 @@ namespace reshade::d3d12
 		void end_debug_event() final;
 		void insert_debug_marker(const char *label, const float color[4]) final;
 
+		bool has_transient_descriptors() const { return !_transient_descriptors[0].ranges.empty() || !_transient_descriptors[1].ranges.empty(); }
+
+		/// <summary>
+		/// Tags the transient descriptors used by this command list with the fence value that is signaled after it was executed.
+		/// </summary>
+		void submit_transient_descriptors(submission_fence *fence, UINT64 fence_value);
+		/// <summary>
+		/// Returns the transient descriptors used by this command list to the ring, after it was reset.
+		/// </summary>
+		void release_transient_descriptors();
+
 	protected:
 		device_impl *const _device_impl;
 		bool _has_commands = false;
@@ -74,5 +86,7 @@ namespace reshade::d3d12
 		ID3D12RootSignature *_current_root_signature[2] = {};
 		// Currently bound descriptor heaps (there can only be one of each shader visible type, so a maximum of two)
 		ID3D12DescriptorHeap *_current_descriptor_heaps[2] = {};
+		// Blocks of transient descriptors this command list allocated from since it was last reset (sampler blocks at index 0, view blocks at index 1)
+		transient_descriptor_blocks _transient_descriptors[2];
 	};
 }
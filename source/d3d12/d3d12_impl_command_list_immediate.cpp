@@ -7,8 +7,8 @@
 #include "d3d12_impl_command_list_immediate.hpp"
 #include "dll_log.hpp" // Include late to get HRESULT log overloads
 
-reshade::d3d12::command_list_immediate_impl::command_list_immediate_impl(device_impl *device) :
-	command_list_impl(device, nullptr)
+reshade::d3d12::command_list_immediate_impl::command_list_immediate_impl(device_impl *device, submission_fence *fence) :
+	command_list_impl(device, nullptr), _submission_fence(fence)
 {
 	// Create multiple command allocators to buffer for multiple frames
 	for (uint32_t i = 0; i < NUM_COMMAND_FRAMES; ++i)
@@ -56,6 +56,9 @@ bool reshade::d3d12::command_list_immediate_impl::flush(ID3D12CommandQueue *queu
 	{
 		LOG(ERROR) << "Failed to close immediate command list!" << " HRESULT is " << hr << '.';
 
+		// Commands were never submitted, so transient descriptors can be reused right away
+		release_transient_descriptors();
+
 		// A command list that failed to close can never be reset, so destroy it and create a new one
 		_orig->Release(); _orig = nullptr;
 		if (SUCCEEDED(_device_impl->_orig->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, _cmd_alloc[_cmd_index].get(), nullptr, IID_PPV_ARGS(&_orig))))
@@ -66,6 +69,13 @@ bool reshade::d3d12::command_list_immediate_impl::flush(ID3D12CommandQueue *queu
 	ID3D12CommandList *const cmd_lists[] = { _orig };
 	queue->ExecuteCommandLists(ARRAYSIZE(cmd_lists), cmd_lists);
 
+	_cmd_submission_index[_cmd_index] = ++_submission_index;
+
+	// The command list is reset below, so transient descriptors can be returned right after tagging them with the fence value of this submission
+	if (has_transient_descriptors())
+		submit_transient_descriptors(_submission_fence, _submission_fence->signal(queue));
+	release_transient_descriptors();
+
 	if (const UINT64 sync_value = _fence_value[_cmd_index] + NUM_COMMAND_FRAMES;
 		SUCCEEDED(queue->Signal(_fence[_cmd_index].get(), sync_value)))
 		_fence_value[_cmd_index] = sync_value;
@@ -101,3 +111,13 @@ bool reshade::d3d12::command_list_immediate_impl::flush_and_wait(ID3D12CommandQu
 		return false;
 	return WaitForSingleObject(_fence_event, INFINITE) == WAIT_OBJECT_0;
 }
+
+UINT64 reshade::d3d12::command_list_immediate_impl::completed_submission_index() const
+{
+	// Take the oldest submission that has not finished yet, all submissions before it have finished as well
+	UINT64 completed_index = _submission_index;
+	for (uint32_t i = 0; i < NUM_COMMAND_FRAMES; ++i)
+		if (_fence[i]->GetCompletedValue() < _fence_value[i])
+			completed_index = std::min(completed_index, _cmd_submission_index[i] - 1);
+	return completed_index;
+}
@@ -14,14 +14,20 @@ namespace reshade::d3d12
 		static constexpr uint32_t NUM_COMMAND_FRAMES = 4; // Use power of two so that modulo can be replaced with bitwise operation
 
 	public:
-		command_list_immediate_impl(device_impl *device);
+		command_list_immediate_impl(device_impl *device, submission_fence *fence);
 		~command_list_immediate_impl();
 
 		bool flush(ID3D12CommandQueue *queue);
 		bool flush_and_wait(ID3D12CommandQueue *queue);
 
+		UINT64 pending_submission_index() const { return _submission_index + (_has_commands ? 1 : 0); }
+		UINT64 completed_submission_index() const;
+
 	private:
 		UINT32 _cmd_index = 0;
+		UINT64 _submission_index = 0;
+		UINT64 _cmd_submission_index[NUM_COMMAND_FRAMES] = {};
+		submission_fence *const _submission_fence;
 		HANDLE _fence_event = nullptr;
 		UINT64 _fence_value[NUM_COMMAND_FRAMES] = {};
 		com_ptr<ID3D12Fence> _fence[NUM_COMMAND_FRAMES];
@@ -16,10 +16,16 @@ reshade::d3d12::command_queue_impl::command_queue_impl(device_impl *device, ID3D
 	// Technically need to lock here, since queues may be created on multiple threads simultaneously via 'ID3D12Device::CreateCommandQueue', but it is unlikely an application actually does that
 	_device_impl->_queues.push_back(this);
 
+	// Create fence that tracks when command lists using transient descriptors finished executing on this queue (owned by the device, see 'device_impl::_submission_fences')
+	{
+		const std::unique_lock<std::shared_mutex> lock(_device_impl->_mutex);
+		_submission_fence = _device_impl->_submission_fences.emplace_back(std::make_unique<submission_fence>(device->_orig)).get();
+	}
+
 	// Only create an immediate command list for graphics queues (since the implemented commands do not work on other queue types)
 	if (queue->GetDesc().Type == D3D12_COMMAND_LIST_TYPE_DIRECT)
 	{
-		_immediate_cmd_list = new command_list_immediate_impl(device);
+		_immediate_cmd_list = new command_list_immediate_impl(device, _submission_fence);
 		// Ensure the immediate command list was initialized successfully, otherwise disable it
 		if (_immediate_cmd_list->_orig == nullptr)
 		{
@@ -101,6 +107,15 @@ void reshade::d3d12::command_queue_impl::flush_immediate_command_list() const
 		_immediate_cmd_list->flush(_orig);
 }
 
+uint64_t reshade::d3d12::command_queue_impl::get_timestamp_frequency() const
+{
+	UINT64 frequency = 0;
+	if (FAILED(_orig->GetTimestampFrequency(&frequency)))
+		return 0;
+
+	return frequency;
+}
+
 void reshade::d3d12::command_queue_impl::begin_debug_event(const char *label, const float color[4])
 {
 #if 0
@@ -30,8 +30,16 @@ namespace reshade::d3d12
 		void end_debug_event() final;
 		void insert_debug_marker(const char *label, const float color[4]) final;
 
+		uint64_t get_pending_submission_index() const final { return _immediate_cmd_list != nullptr ? _immediate_cmd_list->pending_submission_index() : 0; }
+		uint64_t get_completed_submission_index() const final { return _immediate_cmd_list != nullptr ? _immediate_cmd_list->completed_submission_index() : 0; }
+
+		uint64_t get_timestamp_frequency() const final;
+
 		mutable std::shared_mutex _mutex; // 'ID3D12CommandQueue' is thread-safe, so need to lock when accessed from multiple threads
 
+	protected:
+		submission_fence *_submission_fence = nullptr;
+
 	private:
 		device_impl *const _device_impl;
 		command_list_immediate_impl *_immediate_cmd_list = nullptr;
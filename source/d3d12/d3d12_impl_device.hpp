@@ -122,8 +122,11 @@ namespace reshade::d3d12
 		UINT _descriptor_handle_size[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 
 		descriptor_heap_cpu _view_heaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
-		descriptor_heap_gpu<D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 128, 128> _gpu_sampler_heap;
-		descriptor_heap_gpu<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 50000, 2048> _gpu_view_heap;
+		// Every command list that pushes descriptors owns at least one transient block until it is reset, so keep blocks small and plentiful (shader visible sampler heaps are limited to 2048 descriptors)
+		descriptor_heap_gpu<D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 128, 1920, 8> _gpu_sampler_heap;
+		descriptor_heap_gpu<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 50000, 65536, 64> _gpu_view_heap;
+		// Fences of all queues, which are kept alive with the device, since transient descriptor blocks may still reference them after a queue was destroyed
+		std::vector<std::unique_ptr<submission_fence>> _submission_fences;
 
 #if RESHADE_ADDON && !RESHADE_ADDON_LITE
 		std::vector<D3D12DescriptorHeap *> _descriptor_heaps;
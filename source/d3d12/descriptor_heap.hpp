@@ -5,117 +5,127 @@
 
 #pragma once
 
+#include <mutex>
 #include <vector>
 #include <shared_mutex>
 #include <d3d12.h>
 #include "com_ptr.hpp"
+#include "descriptor_slot_allocator.hpp"
+#include "transient_descriptor_ring.hpp"
 
 namespace reshade::d3d12
 {
 	class descriptor_heap_cpu
 	{
-		struct heap_info
+		struct heap_backend
 		{
-			com_ptr<ID3D12DescriptorHeap> heap;
-			std::vector<bool> state;
-			SIZE_T heap_base = 0;
-		};
+			using heap_type = com_ptr<ID3D12DescriptorHeap>;
+
+			bool create_heap(uint32_t num_descriptors, heap_type &heap, uint64_t &base_address)
+			{
+				D3D12_DESCRIPTOR_HEAP_DESC desc;
+				desc.Type = type;
+				desc.NumDescriptors = num_descriptors;
+				desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+				desc.NodeMask = 0;
+
+				if (FAILED(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap))))
+					return false;
 
-		const UINT pool_size = 1024;
+				base_address = heap->GetCPUDescriptorHandleForHeapStart().ptr;
+				return true;
+			}
+
+			ID3D12Device *device;
+			D3D12_DESCRIPTOR_HEAP_TYPE type;
+		};
 
 	public:
 		descriptor_heap_cpu(ID3D12Device *device, D3D12_DESCRIPTOR_HEAP_TYPE type) :
-			_device(device), _type(type)
-		{
-			_increment_size = device->GetDescriptorHandleIncrementSize(type);
-		}
+			_allocator(heap_backend { device, type }, device->GetDescriptorHandleIncrementSize(type)) {}
 
 		bool allocate(D3D12_CPU_DESCRIPTOR_HANDLE &handle)
 		{
-			const std::unique_lock<std::shared_mutex> lock(_mutex);
-
-			for (int attempt = 0; attempt < 2; ++attempt)
-			{
-				for (heap_info &heap_info : _heap_infos)
-				{
-					// Find free empty in the heap
-					if (const auto it = std::find(heap_info.state.begin(), heap_info.state.end(), false);
-						it != heap_info.state.end())
-					{
-						const size_t index = it - heap_info.state.begin();
-						heap_info.state[index] = true; // Mark this entry as being in use
-
-						handle.ptr = heap_info.heap_base + index * _increment_size;
-						return true;
-					}
-				}
-
-				// No more space available in the existing heaps, so create a new one and try again
-				if (!allocate_heap())
-					break;
-			}
+			uint64_t address = 0;
+			if (!_allocator.allocate(address))
+				return false;
 
-			return false;
+			handle.ptr = static_cast<SIZE_T>(address);
+			return true;
 		}
 
 		void free(D3D12_CPU_DESCRIPTOR_HANDLE handle)
 		{
-			const std::unique_lock<std::shared_mutex> lock(_mutex);
-
-			for (heap_info &heap_info : _heap_infos)
-			{
-				const SIZE_T heap_beg = heap_info.heap_base;
-				const SIZE_T heap_end = heap_info.heap_base + pool_size * _increment_size;
+			// Handles that were not allocated from this heap are ignored
+			_allocator.free(handle.ptr);
+		}
 
-				if (handle.ptr >= heap_beg && handle.ptr < heap_end)
-				{
-					const SIZE_T index = (handle.ptr - heap_beg) / _increment_size;
+	private:
+		descriptor_slot_allocator<heap_backend> _allocator;
+	};
 
-					// Mark free slot in the descriptor heap
-					heap_info.state[index] = false;
-					break;
-				}
-			}
+	/// <summary>
+	/// Fence that is signaled on a command queue after command lists that used transient descriptors were executed on it.
+	/// </summary>
+	class submission_fence
+	{
+	public:
+		explicit submission_fence(ID3D12Device *device)
+		{
+			device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&_fence));
 		}
 
-	private:
-		bool allocate_heap()
+		/// <summary>
+		/// Signals the next fence value on the specified <paramref name="queue"/>.
+		/// </summary>
+		/// <returns>The signaled value, or zero if signaling failed.</returns>
+		UINT64 signal(ID3D12CommandQueue *queue)
 		{
-			heap_info &heap_info = _heap_infos.emplace_back();
+			if (_fence == nullptr)
+				return 0;
 
-			D3D12_DESCRIPTOR_HEAP_DESC desc;
-			desc.Type = _type;
-			desc.NumDescriptors = pool_size;
-			desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-			desc.NodeMask = 0;
+			// Signal while holding the lock, so that values are always signaled in increasing order, even if the queue is accessed from multiple threads
+			const std::unique_lock<std::mutex> lock(_mutex);
 
-			if (FAILED(_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap_info.heap))))
-			{
-				_heap_infos.pop_back();
-				return false;
-			}
+			if (FAILED(queue->Signal(_fence.get(), _last_signaled_value + 1)))
+				return 0;
 
-			heap_info.heap_base = heap_info.heap->GetCPUDescriptorHandleForHeapStart().ptr;
-			heap_info.state.resize(pool_size);
+			return ++_last_signaled_value;
+		}
 
-			return true;
+		uint64_t completed_value() const
+		{
+			// Treat everything as completed when the fence could not be created, which matches the behavior without fence tracking
+			return _fence != nullptr ? _fence->GetCompletedValue() : UINT64_MAX;
 		}
 
-		ID3D12Device *const _device;
-		std::vector<heap_info> _heap_infos;
-		SIZE_T _increment_size;
-		D3D12_DESCRIPTOR_HEAP_TYPE _type;
-		std::shared_mutex _mutex;
+		void wait(uint64_t value) const
+		{
+			// Passing no event blocks until the fence reached the value
+			if (_fence != nullptr && _fence->GetCompletedValue() < value)
+				_fence->SetEventOnCompletion(value, nullptr);
+		}
+
+	private:
+		com_ptr<ID3D12Fence> _fence;
+		UINT64 _last_signaled_value = 0;
+		std::mutex _mutex;
 	};
 
-	template <D3D12_DESCRIPTOR_HEAP_TYPE type, UINT static_size, UINT transient_size>
+	using transient_descriptor_blocks = transient_descriptor_block_list<submission_fence>;
+
+	template <D3D12_DESCRIPTOR_HEAP_TYPE type, UINT static_size, UINT transient_size, UINT transient_block_size>
 	class descriptor_heap_gpu
 	{
+		// The end of the transient portion is not tracked by fences, and only used when all blocks of the ring are owned by command lists that were not submitted yet
+		static constexpr UINT overflow_size = transient_size / 8;
+
 	public:
-		explicit descriptor_heap_gpu(ID3D12Device *device, UINT node_mask = 0)
+		explicit descriptor_heap_gpu(ID3D12Device *device, UINT node_mask = 0) :
+			_transient_ring(transient_size - overflow_size)
 		{
 			// Manage all descriptors in a single heap, to avoid costly descriptor heap switches during rendering
-			// The lower portion of the heap is reserved for static bindings, the upper portion for transient bindings (which change frequently and are managed like a ring buffer)
+			// The lower portion of the heap is reserved for static bindings, the upper portion for transient bindings (which change frequently and are managed like a ring buffer, see 'transient_descriptor_ring')
 			D3D12_DESCRIPTOR_HEAP_DESC desc;
 			desc.Type = type;
 			desc.NumDescriptors = static_size + transient_size;
@@ -168,27 +178,46 @@ namespace reshade::d3d12
 
 			return true;
 		}
-		bool allocate_transient(UINT count, D3D12_CPU_DESCRIPTOR_HANDLE &base_handle, D3D12_GPU_DESCRIPTOR_HANDLE &base_handle_gpu)
+		bool allocate_transient(transient_descriptor_blocks &blocks, UINT count, D3D12_CPU_DESCRIPTOR_HANDLE &base_handle, D3D12_GPU_DESCRIPTOR_HANDLE &base_handle_gpu)
 		{
 			if (_heap == nullptr)
 				return false;
 
-			const std::unique_lock<std::shared_mutex> lock(_mutex);
+			// This does not need to lock, since the ring hands out blocks with atomic operations and the blocks themselves are only used by a single command list
+			uint32_t index = 0;
+			if (!_transient_ring.allocate(blocks, count, index))
+			{
+				// Rather than dropping the descriptors, fall back to a simple ring buffer that wraps around without waiting for the GPU, which may overwrite descriptors still in use by earlier submissions
+				if (count > overflow_size)
+					return false;
+
+				const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+				index = static_cast<uint32_t>(_current_overflow_tail % overflow_size);
 
-			SIZE_T index = static_cast<SIZE_T>(_current_transient_tail % transient_size);
+				// Allocations need to be contiguous
+				if (index + count > overflow_size)
+					_current_overflow_tail += overflow_size - index, index = 0;
 
-			// Allocations need to be contiguous
-			if (index + count > transient_size)
-				_current_transient_tail += transient_size - index, index = 0;
+				_current_overflow_tail += count;
+
+				index += transient_size - overflow_size;
+			}
 
 			const SIZE_T offset = index * _increment_size;
 			base_handle.ptr = _transient_heap_base + offset;
 			base_handle_gpu.ptr = _transient_heap_base_gpu + offset;
 
-			_current_transient_tail += count;
-
 			return true;
 		}
+		void submit_transient(transient_descriptor_blocks &blocks, submission_fence *fence, UINT64 fence_value)
+		{
+			_transient_ring.submit(blocks, fence, fence_value);
+		}
+		void release_transient(transient_descriptor_blocks &blocks)
+		{
+			_transient_ring.release(blocks);
+		}
 
 		void free(D3D12_GPU_DESCRIPTOR_HANDLE handle, UINT count = 1)
 		{
@@ -268,7 +297,8 @@ namespace reshade::d3d12
 		SIZE_T _transient_heap_base;
 		UINT64 _transient_heap_base_gpu;
 		SIZE_T _current_static_index = 0;
-		UINT64 _current_transient_tail = 0;
+		UINT64 _current_overflow_tail = 0;
+		transient_descriptor_ring<submission_fence, transient_block_size> _transient_ring;
 		std::vector<std::pair<UINT64, UINT64>> _free_list;
 		std::shared_mutex _mutex;
 	};
@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// <summary>
+/// Allocates single descriptor slots from a growing list of fixed-size descriptor heaps, independent of the graphics API.
+/// Free slots are tracked in 64-bit bitmaps per heap. Recently freed slots are cached in a few small magazines that threads pick based on their ID, so that most allocations and frees do not touch the shared state.
+/// </summary>
+/// <remarks>
+/// The <typeparamref name="backend_type"/> has to define a <c>heap_type</c> type that keeps a heap alive and a <c>bool create_heap(uint32_t num_descriptors, heap_type &amp;heap, uint64_t &amp;base_address)</c> method.
+/// Up to <c>num_magazines * magazine_size</c> free slots may be cached in magazines, which other threads cannot allocate until those are flushed.
+/// </remarks>
+template <typename backend_type, uint32_t heap_size = 1024, uint32_t magazine_size = 32, uint32_t num_magazines = 8>
+class descriptor_slot_allocator
+{
+	static_assert(heap_size != 0 && heap_size % 64 == 0, "Heap size has to be a multiple of 64.");
+	static_assert(magazine_size >= 2);
+
+	using heap_type = typename backend_type::heap_type;
+
+public:
+	descriptor_slot_allocator(backend_type backend, uint64_t increment_size) :
+		_backend(std::move(backend)), _increment_size(increment_size) {}
+
+	descriptor_slot_allocator(const descriptor_slot_allocator &) = delete;
+	descriptor_slot_allocator &operator=(const descriptor_slot_allocator &) = delete;
+
+	/// <summary>
+	/// Allocates a single descriptor slot, creating a new heap if all existing ones are full.
+	/// </summary>
+	/// <param name="address">Receives the address of the allocated slot.</param>
+	/// <returns><c>true</c> if a slot was allocated, <c>false</c> if creating a new heap failed.</returns>
+	bool allocate(uint64_t &address)
+	{
+		magazine &m = get_magazine();
+		const magazine_lock lock(m);
+
+		if (m.count == 0 && !refill(m))
+			return false;
+
+		address = m.slots[--m.count];
+		return true;
+	}
+
+	/// <summary>
+	/// Frees a descriptor slot that was previously allocated via <see cref="allocate"/>.
+	/// </summary>
+	/// <param name="address">The address of the slot to free.</param>
+	/// <returns><c>true</c> if the slot belongs to this allocator and was freed, <c>false</c> otherwise.</returns>
+	bool free(uint64_t address)
+	{
+		// This is called with slots from other allocators too, so check ownership before caching the slot
+		if (!contains(address))
+			return false;
+
+		magazine &m = get_magazine();
+		const magazine_lock lock(m);
+
+		// Return the older half of a full magazine to the heaps, so that it is available to all threads again
+		if (m.count == magazine_size)
+			flush(m, magazine_size / 2);
+
+		m.slots[m.count++] = address;
+		return true;
+	}
+
+	/// <summary>
+	/// Checks whether the specified <paramref name="address"/> falls into any of the heaps of this allocator.
+	/// This does not take a lock.
+	/// </summary>
+	bool contains(uint64_t address) const
+	{
+		const heap_ranges *const ranges = _ranges.load(std::memory_order_acquire);
+		return ranges != nullptr && find_heap(*ranges, address) != nullptr;
+	}
+
+private:
+	struct heap_info
+	{
+		heap_type heap;
+		uint64_t base_address = 0;
+		uint32_t num_free = heap_size;
+		// Bit is set if the slot is free, so that a free slot is found by counting trailing zeros
+		uint64_t free_mask[heap_size / 64];
+	};
+
+	// Immutable list of heaps sorted by base address, which is replaced as a whole when a heap is added, so that it can be searched without a lock
+	using heap_ranges = std::vector<heap_info *>;
+
+	struct alignas(64) magazine
+	{
+		std::atomic<bool> locked = false;
+		uint32_t count = 0;
+		uint64_t slots[magazine_size];
+	};
+
+	struct magazine_lock
+	{
+		explicit magazine_lock(magazine &m) : m(m)
+		{
+			// Magazines are usually only used by a single thread, so this rarely has to wait
+			while (m.locked.exchange(true, std::memory_order_acquire))
+				std::this_thread::yield();
+		}
+		~magazine_lock()
+		{
+			m.locked.store(false, std::memory_order_release);
+		}
+
+		magazine &m;
+	};
+
+	magazine &get_magazine()
+	{
+		static thread_local const size_t thread_hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+		return _magazines[thread_hash % num_magazines];
+	}
+
+	heap_info *find_heap(const heap_ranges &ranges, uint64_t address) const
+	{
+		// Find the last heap that starts at or before the address
+		const auto it = std::upper_bound(ranges.begin(), ranges.end(), address,
+			[](uint64_t address, const heap_info *heap) { return address < heap->base_address; });
+		if (it == ranges.begin())
+			return nullptr;
+
+		heap_info *const heap = *(it - 1);
+		if (address >= heap->base_address + heap_size * _increment_size)
+			return nullptr;
+		return heap;
+	}
+
+	bool refill(magazine &m)
+	{
+		const std::unique_lock<std::mutex> lock(_mutex);
+
+		// Only fill half the magazine, so that frees that follow do not immediately have to flush it again
+		const uint32_t target_count = magazine_size / 2;
+
+		// Start with the heap that was last allocated from, since the ones before it are likely full
+		for (size_t i = 0; i < _heaps.size() && m.count < target_count; ++i)
+		{
+			const size_t heap_index = (_next_heap + i) % _heaps.size();
+			if (_heaps[heap_index]->num_free == 0)
+				continue;
+
+			take_free_slots(*_heaps[heap_index], m, target_count);
+			_next_heap = heap_index;
+		}
+
+		// Only create a new heap if there are no free slots left at all
+		if (m.count == 0 && create_heap())
+		{
+			_next_heap = _heaps.size() - 1;
+			take_free_slots(*_heaps.back(), m, target_count);
+		}
+
+		return m.count != 0;
+	}
+
+	void take_free_slots(heap_info &heap, magazine &m, uint32_t target_count)
+	{
+		for (uint32_t word = 0; word < heap_size / 64 && m.count < target_count; ++word)
+		{
+			for (uint64_t &mask = heap.free_mask[word]; mask != 0 && m.count < target_count; mask &= mask - 1) // Clear lowest set bit
+			{
+				m.slots[m.count++] = heap.base_address + (word * 64 + count_trailing_zeros(mask)) * _increment_size;
+				heap.num_free--;
+			}
+		}
+	}
+
+	void flush(magazine &m, uint32_t count)
+	{
+		assert(count <= m.count);
+
+		const std::unique_lock<std::mutex> lock(_mutex);
+
+		const heap_ranges &ranges = *_ranges.load(std::memory_order_relaxed);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			heap_info *const heap = find_heap(ranges, m.slots[i]);
+			assert(heap != nullptr);
+
+			const uint64_t index = (m.slots[i] - heap->base_address) / _increment_size;
+			assert((heap->free_mask[index / 64] & (1ull << (index % 64))) == 0); // Slot should not have been freed twice
+
+			heap->free_mask[index / 64] |= 1ull << (index % 64);
+			heap->num_free++;
+		}
+
+		std::copy(m.slots + count, m.slots + m.count, m.slots);
+		m.count -= count;
+	}
+
+	bool create_heap()
+	{
+		auto heap = std::make_unique<heap_info>();
+		if (!_backend.create_heap(heap_size, heap->heap, heap->base_address))
+			return false;
+		std::fill_n(heap->free_mask, heap_size / 64, ~0ull);
+
+		// Publish a new sorted list of heaps, but keep the previous one alive, since other threads may still be searching it
+		auto ranges = std::make_unique<heap_ranges>(_ranges_history.empty() ? heap_ranges() : *_ranges_history.back());
+		ranges->insert(std::upper_bound(ranges->begin(), ranges->end(), heap->base_address,
+			[](uint64_t address, const heap_info *heap) { return address < heap->base_address; }), heap.get());
+		_ranges.store(ranges.get(), std::memory_order_release);
+		_ranges_history.push_back(std::move(ranges));
+
+		_heaps.push_back(std::move(heap));
+		return true;
+	}
+
+	static uint32_t count_trailing_zeros(uint64_t mask)
+	{
+		assert(mask != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, static_cast<unsigned long>(mask)))
+			return index;
+		_BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+		return 32 + index;
+#else
+		return __builtin_ctzll(mask);
+#endif
+	}
+
+	backend_type _backend;
+	const uint64_t _increment_size;
+	std::mutex _mutex;
+	size_t _next_heap = 0;
+	std::vector<std::unique_ptr<heap_info>> _heaps;
+	std::atomic<const heap_ranges *> _ranges = nullptr;
+	std::vector<std::unique_ptr<heap_ranges>> _ranges_history;
+	magazine _magazines[num_magazines];
+};
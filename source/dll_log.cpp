@@ -4,27 +4,112 @@
  */
 
 #include "dll_log.hpp"
-#include <shared_mutex>
-#include <Windows.h>
+#include "log_staging.hpp"
 
-struct scoped_file_handle
+/// <summary>
+/// Stream buffer that appends to a string, which keeps its capacity between messages, so that formatting does not allocate after the first few messages.
+/// </summary>
+class line_buffer : public std::streambuf
 {
-	~scoped_file_handle()
+public:
+	std::string data;
+
+protected:
+	int_type overflow(int_type c) override
+	{
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+			data.push_back(traits_type::to_char_type(c));
+		return traits_type::not_eof(c);
+	}
+	std::streamsize xsputn(const char *s, std::streamsize n) override
 	{
-		if (handle != INVALID_HANDLE_VALUE)
-			CloseHandle(handle);
+		data.append(s, static_cast<size_t>(n));
+		return n;
 	}
+};
 
-	inline operator HANDLE() const { return handle; }
-	inline void operator=(HANDLE new_handle) { handle = new_handle; }
+static thread_local line_buffer s_line_buffer;
+static thread_local bool s_line_is_error = false;
+thread_local std::ostream reshade::log::line_stream(&s_line_buffer);
+
+// Flush in the background once a thread staged this many bytes, instead of waiting for the next regular wake up
+static constexpr size_t s_flush_threshold = 32 * 1024;
+
+static reshade::log::line_stager s_stager;
+static std::mutex s_flush_mutex;
+static reshade::log::file_sink s_file;
+static HANDLE s_flush_event = nullptr;
+static HANDLE s_flush_thread = nullptr;
+static std::atomic<bool> s_flush_thread_running = false;
+static std::atomic<bool> s_process_terminating = false;
+static PVOID s_crash_handler_handle = nullptr;
+
+/// <summary>
+/// Writes all staged lines to the log file. This has to be called with the flush lock held, except when the process is terminating.
+/// </summary>
+static void write_staged_lines()
+{
+	// Once the process is terminating all other threads were killed, possibly while staging a line, so cannot wait for them
+	const bool terminating = s_process_terminating.load(std::memory_order_relaxed);
 
-private:
-	HANDLE handle = INVALID_HANDLE_VALUE;
-};
+	static thread_local std::string buffer;
+	buffer.clear();
+
+	s_stager.collect(buffer, !terminating);
+
+	if (buffer.empty())
+		return;
+
+	// Write all lines to the log file at once
+	if (s_file.is_open())
+	{
+		const bool written = s_file.write(buffer.data(), buffer.size());
+		assert(written);
+		(void)written;
+	}
+
+#ifndef NDEBUG
+	// Write lines to the debug output
+	OutputDebugStringA(buffer.c_str());
+#endif
+}
+
+static DWORD WINAPI flush_thread_main(LPVOID)
+{
+	// Wake up regularly, or earlier when the queue is filling up
+	while (WaitForSingleObject(s_flush_event, 50) != WAIT_FAILED && s_flush_thread_running)
+		reshade::log::flush();
+
+	// Fall back to writing messages immediately in case waiting failed
+	s_flush_thread_running = false;
+
+	return 0;
+}
+
+static LONG WINAPI crash_handler(PEXCEPTION_POINTERS ex)
+{
+	// Make sure all queued log messages are written before the application potentially crashes
+	// Only do so for exceptions that usually terminate the process, since others may be raised and handled frequently (e.g. C++ exceptions)
+	// Stack overflows are excluded too, since there is not enough stack left to write the queued messages safely
+	switch (ex->ExceptionRecord->ExceptionCode)
+	{
+	case EXCEPTION_ACCESS_VIOLATION:
+	case EXCEPTION_IN_PAGE_ERROR:
+	case EXCEPTION_ILLEGAL_INSTRUCTION:
+	case EXCEPTION_PRIV_INSTRUCTION:
+	case EXCEPTION_INT_DIVIDE_BY_ZERO:
+	case EXCEPTION_NONCONTINUABLE_EXCEPTION:
+	case 0xC0000374: // STATUS_HEAP_CORRUPTION
+		reshade::log::try_flush();
+		break;
+	default:
+		if ((ex->ExceptionRecord->ExceptionFlags & EXCEPTION_NONCONTINUABLE) != 0 && ex->ExceptionRecord->ExceptionCode != EXCEPTION_STACK_OVERFLOW)
+			reshade::log::try_flush();
+		break;
+	}
 
-static std::shared_mutex s_message_mutex;
-static scoped_file_handle s_file_handle;
-std::ostringstream reshade::log::line_stream;
+	return EXCEPTION_CONTINUE_SEARCH;
+}
 
 reshade::log::message::message(level level)
 {
@@ -38,12 +123,12 @@ reshade::log::message::message(level level)
 	SYSTEMTIME time;
 	GetLocalTime(&time);
 
-	// Lock the stream until the message is complete
-	s_message_mutex.lock();
+	// Start a new line (every thread has its own stream, so no need to lock anything here)
+	s_line_buffer.data.clear();
+	s_line_is_error = (level == level::error);
 
-	// Start a new line
-	line_stream.str(std::string());
 	line_stream.clear();
+	line_stream.setf(std::ios::showbase);
 
 	line_stream << std::right << std::setfill('0')
 #if RESHADE_VERBOSE_LOG
@@ -60,42 +145,85 @@ reshade::log::message::message(level level)
 }
 reshade::log::message::~message()
 {
-	std::string line_string = line_stream.str();
-	line_string += '\n'; // Terminate line with line feed
+	const size_t staged_size = s_stager.stage(s_line_buffer.data);
 
-	// Replace all LF with CRLF
-	for (size_t offset = 0; (offset = line_string.find('\n', offset)) != std::string::npos; offset += 2)
-		line_string.replace(offset, 1, "\r\n", 2);
+	// Write errors immediately, so that they make it to disk even if the application crashes right after
+	if (s_line_is_error || !s_flush_thread_running)
+		flush();
+	else if (staged_size > s_flush_threshold)
+		SetEvent(s_flush_event);
+}
+
+bool reshade::log::open_log_file(const std::filesystem::path &path)
+{
+	// Write any queued lines to the previous file before replacing it
+	flush();
 
-	// Write line to the log file
-	if (s_file_handle != INVALID_HANDLE_VALUE)
 	{
-		DWORD written = 0;
-		WriteFile(s_file_handle, line_string.data(), static_cast<DWORD>(line_string.size()), &written, nullptr);
-		assert(written == line_string.size());
+		const std::lock_guard<std::mutex> lock(s_flush_mutex);
+
+		// Open the log file for writing (and flush on each write) and clear previous contents, which closes the previous file first
+		s_file.open(path);
 	}
 
-#ifndef NDEBUG
-	// Write line to the debug output
-	OutputDebugStringA(line_string.c_str());
-#endif
+	// Start background thread that writes queued lines to the file (this may be called from 'DllMain', so cannot use 'std::thread', which waits for the thread to start)
+	if (s_flush_thread == nullptr)
+	{
+		s_flush_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+		s_flush_thread_running = true;
+		s_flush_thread = CreateThread(nullptr, 0, &flush_thread_main, nullptr, 0, nullptr);
+		if (s_flush_thread == nullptr)
+			s_flush_thread_running = false;
+
+		// Messages are no longer written immediately, so have to write them when the application crashes (in all builds, not just with the debug exception handler in 'dll_main.cpp')
+		if (s_flush_thread_running && s_crash_handler_handle == nullptr)
+			s_crash_handler_handle = AddVectoredExceptionHandler(0, &crash_handler);
+	}
 
-	// The message is finished, we can unlock the stream
-	s_message_mutex.unlock();
+	return s_file.is_open();
 }
 
-bool reshade::log::open_log_file(const std::filesystem::path &path)
+void reshade::log::flush()
+{
+	std::unique_lock<std::mutex> lock(s_flush_mutex, std::defer_lock);
+	// All other threads were killed when the process is terminating, possibly while holding the lock, in which case it would never be released
+	// They cannot be writing to the file anymore at that point, so it is safe to continue without the lock then
+	if (s_process_terminating.load(std::memory_order_relaxed))
+		lock.try_lock();
+	else
+		lock.lock();
+
+	write_staged_lines();
+}
+bool reshade::log::try_flush()
 {
-	// Close the previous file first
-	if (s_file_handle != INVALID_HANDLE_VALUE)
-		CloseHandle(s_file_handle);
+	std::unique_lock<std::mutex> lock(s_flush_mutex, std::try_to_lock);
+	if (!lock.owns_lock() && !s_process_terminating.load(std::memory_order_relaxed))
+		return false;
 
-	// Set default line stream settings
-	line_stream.setf(std::ios::left);
-	line_stream.setf(std::ios::showbase);
+	write_staged_lines();
+	return true;
+}
+void reshade::log::stop_flush_thread(bool process_terminating)
+{
+	if (process_terminating)
+		s_process_terminating.store(true, std::memory_order_relaxed);
 
-	// Open the log file for writing (and flush on each write) and clear previous contents
-	s_file_handle = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, NULL);
+	if (s_flush_thread == nullptr)
+		return;
+
+	s_flush_thread_running = false;
+	SetEvent(s_flush_event);
+
+	CloseHandle(s_flush_thread);
+	s_flush_thread = nullptr;
+
+	if (s_crash_handler_handle != nullptr)
+	{
+		RemoveVectoredExceptionHandler(s_crash_handler_handle);
+		s_crash_handler_handle = nullptr;
+	}
 
-	return s_file_handle != INVALID_HANDLE_VALUE;
+	// Write anything that was still queued, since from now on messages are written immediately
+	flush();
 }
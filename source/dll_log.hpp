@@ -34,14 +34,31 @@ namespace reshade::log
 
 	/// <summary>
 	/// Open a log file for writing.
+	/// Messages are queued and written to it from a background thread, except for errors, which are written immediately.
 	/// </summary>
 	/// <param name="path">The path to the log file.</param>
 	bool open_log_file(const std::filesystem::path &path);
 
 	/// <summary>
-	/// The current log line stream.
+	/// Writes all queued messages to the open log file on the calling thread, waiting for any other thread that is writing at the same time.
 	/// </summary>
-	extern std::ostringstream line_stream;
+	void flush();
+	/// <summary>
+	/// Writes all queued messages to the open log file on the calling thread, unless another thread is writing at the same time.
+	/// Use this in exception handlers, where the thread that raised the exception may already hold the lock.
+	/// </summary>
+	/// <returns><see langword="true"/> if the messages were written, <see langword="false"/> if another thread was writing.</returns>
+	bool try_flush();
+	/// <summary>
+	/// Stops the background thread writing queued messages, after which each message is written immediately again.
+	/// </summary>
+	/// <param name="process_terminating">Set to <see langword="true"/> when the process is terminating, in which case all other threads were killed already and writing no longer waits for the locks they may have held.</param>
+	void stop_flush_thread(bool process_terminating = false);
+
+	/// <summary>
+	/// The current log line stream of the calling thread.
+	/// </summary>
+	extern thread_local std::ostream line_stream;
 
 	/// <summary>
 	/// Constructs a single log message including current time and level and writes it to the open log file.
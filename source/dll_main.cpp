@@ -824,7 +824,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int nCmdShow
 static PVOID s_exception_handler_handle = nullptr;
 #  endif
 
-BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
+BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 {
 	switch (fdwReason)
 	{
@@ -871,6 +871,9 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 					code == 0xE06D7363 /* Visual C++ exception */)
 					goto continue_search;
 
+				// Make sure all queued log messages are written before the application potentially crashes (without waiting, in case this thread is the one writing them)
+				reshade::log::try_flush();
+
 				// Create dump with exception information for the first 100 occurrences
 				if (static unsigned int dump_index = 0; dump_index < 100)
 				{
@@ -977,6 +980,11 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 	case DLL_PROCESS_DETACH:
 		LOG(INFO) << "Exiting ...";
 
+		// Stop writing INI files and log messages from background threads, so that they have left the module by the time it is unloaded (see wait below)
+		ini_file::stop_flush_thread();
+		// Reserved parameter is not null when the process is terminating, rather than the module being unloaded via 'FreeLibrary'
+		reshade::log::stop_flush_thread(lpReserved != nullptr);
+
 		reshade::hooks::uninstall();
 
 		// Module is now invalid, so break out of any message loops that may still have it in the call stack (see 'HookGetMessage' implementation in input.cpp)
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+namespace reshade
+{
+	/// <summary>
+	/// Records durations in nanoseconds into logarithmic buckets, so that percentiles can be queried with a bounded relative error and without storing every sample.
+	/// </summary>
+	class duration_histogram
+	{
+		// Each power of two range is divided into 64 buckets, so a bucket spans less than 1/64 of its values (~1.6%)
+		static constexpr uint32_t SUB_BUCKET_BITS = 7;
+		static constexpr uint32_t SUB_BUCKET_HALF_COUNT = 1u << (SUB_BUCKET_BITS - 1);
+		// Durations are clamped to 2^36 ns (~68 seconds)
+		static constexpr uint32_t MAX_VALUE_BITS = 36;
+		static constexpr uint32_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 2) * SUB_BUCKET_HALF_COUNT;
+
+	public:
+		void clear()
+		{
+			std::fill_n(_buckets, BUCKET_COUNT, 0u);
+			_count = 0;
+			_sum = 0;
+			_max = 0;
+		}
+		void append(uint64_t value)
+		{
+			value = std::min(value, (uint64_t(1) << MAX_VALUE_BITS) - 1);
+
+			_buckets[bucket_index(value)]++;
+			_count++;
+			_sum += value;
+			_max = std::max(_max, value);
+		}
+
+		uint64_t count() const { return _count; }
+		uint64_t max() const { return _max; }
+		uint64_t mean() const { return _count != 0 ? _sum / _count : 0; }
+
+		/// <summary>
+		/// Gets the duration that <paramref name="percent"/> percent of all recorded durations are less than or equal to.
+		/// This returns the center of the bucket that duration falls into, which is off by less than 1/128 (~0.8%) of the exact value.
+		/// </summary>
+		uint64_t percentile(double percent) const
+		{
+			if (_count == 0)
+				return 0;
+
+			// Rank of the sample to find, starting at one
+			const uint64_t rank = std::clamp(static_cast<uint64_t>(percent / 100.0 * _count + 0.999999), uint64_t(1), _count);
+
+			uint64_t count = 0;
+			for (uint32_t index = 0; index < BUCKET_COUNT; ++index)
+			{
+				count += _buckets[index];
+				if (count >= rank)
+					return std::min(bucket_center(index), _max);
+			}
+
+			return _max;
+		}
+
+	private:
+		static uint32_t bucket_index(uint64_t value)
+		{
+			// Find index of the most significant bit
+			uint32_t msb = 0;
+			for (uint32_t shift = 32; shift != 0; shift /= 2)
+				if (value >> (msb + shift))
+					msb += shift;
+
+			// Values below 2^SUB_BUCKET_BITS have a bucket each, larger ones drop their low bits so that only the top SUB_BUCKET_BITS bits remain
+			const uint32_t exponent = msb >= SUB_BUCKET_BITS ? msb - SUB_BUCKET_BITS + 1 : 0;
+			return exponent * SUB_BUCKET_HALF_COUNT + static_cast<uint32_t>(value >> exponent);
+		}
+		static uint64_t bucket_center(uint32_t index)
+		{
+			const uint32_t exponent = index < 2 * SUB_BUCKET_HALF_COUNT ? 0 : index / SUB_BUCKET_HALF_COUNT - 1;
+			const uint64_t mantissa = index - exponent * SUB_BUCKET_HALF_COUNT;
+			return (mantissa << exponent) + (((uint64_t(1) << exponent) - 1) / 2);
+		}
+
+		uint32_t _buckets[BUCKET_COUNT] = {};
+		uint64_t _count = 0;
+		uint64_t _sum = 0;
+		uint64_t _max = 0;
+	};
+}
@@ -0,0 +1,1480 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "image_utils.hpp"
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#define RESHADE_IMAGE_UTILS_SSE2 1
+#define RESHADE_IMAGE_UTILS_SSSE3 1
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define RESHADE_IMAGE_UTILS_SSE2 1
+#define RESHADE_IMAGE_UTILS_SSSE3 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RESHADE_IMAGE_UTILS_SSE2 1
+#define RESHADE_IMAGE_UTILS_SSSE3 0
+#else
+#define RESHADE_IMAGE_UTILS_SSE2 0
+#define RESHADE_IMAGE_UTILS_SSSE3 0
+#endif
+
+#if RESHADE_IMAGE_UTILS_SSSE3
+static bool has_ssse3()
+{
+#if defined(_M_IX86) || defined(_M_X64)
+	static const bool result = []() {
+		int cpu_info[4] = {};
+		__cpuid(cpu_info, 1);
+		return (cpu_info[2] & (1 << 9)) != 0;
+	}();
+	return result;
+#else
+	return true;
+#endif
+}
+#endif
+
+void reshade::convert_bgra_to_rgba(const uint8_t *src, uint8_t *dst, size_t num_pixels, bool force_opaque)
+{
+	size_t i = 0;
+
+#if RESHADE_IMAGE_UTILS_SSSE3
+	if (has_ssse3())
+	{
+		const __m128i shuffle_mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		const __m128i alpha_mask = _mm_set1_epi32(force_opaque ? 0xFF000000 : 0);
+
+		for (; i + 4 <= num_pixels; i += 4)
+		{
+			const __m128i bgra = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(bgra, shuffle_mask), alpha_mask));
+		}
+	}
+#endif
+
+	for (; i < num_pixels; ++i)
+	{
+		const uint8_t b = src[i * 4 + 0];
+		dst[i * 4 + 0] = src[i * 4 + 2];
+		dst[i * 4 + 1] = src[i * 4 + 1];
+		dst[i * 4 + 2] = b;
+		dst[i * 4 + 3] = force_opaque ? 0xFF : src[i * 4 + 3];
+	}
+}
+
+void reshade::convert_rgba_to_rgb(const uint8_t *src, uint8_t *dst, size_t num_pixels)
+{
+	size_t i = 0;
+
+#if RESHADE_IMAGE_UTILS_SSSE3
+	if (has_ssse3())
+	{
+		const __m128i shuffle_mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+		// Each iteration stores 16 bytes, but only advances the destination by 12, so stop early enough to not write past its end
+		// This also works in place, since the destination never overtakes the source
+		for (; i + 6 <= num_pixels; i += 4)
+		{
+			const __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 3), _mm_shuffle_epi8(rgba, shuffle_mask));
+		}
+	}
+#endif
+
+	for (; i < num_pixels; ++i)
+	{
+		dst[i * 3 + 0] = src[i * 4 + 0];
+		dst[i * 3 + 1] = src[i * 4 + 1];
+		dst[i * 3 + 2] = src[i * 4 + 2];
+	}
+}
+
+void reshade::convert_rgba_to_rgb(const uint16_t *src, uint16_t *dst, size_t num_pixels)
+{
+	for (size_t i = 0; i < num_pixels; ++i)
+	{
+		dst[i * 3 + 0] = src[i * 4 + 0];
+		dst[i * 3 + 1] = src[i * 4 + 1];
+		dst[i * 3 + 2] = src[i * 4 + 2];
+	}
+}
+
+namespace
+{
+	float half_to_float(uint16_t value)
+	{
+		const uint32_t sign = (value & 0x8000u) << 16;
+		uint32_t exponent = (value >> 10) & 0x1F;
+		uint32_t mantissa = value & 0x3FF;
+
+		uint32_t bits = sign;
+		if (exponent == 0x1F)
+		{
+			bits |= 0x7F800000 | (mantissa << 13); // Infinity or NaN
+		}
+		else if (exponent != 0)
+		{
+			bits |= ((exponent + (127 - 15)) << 23) | (mantissa << 13);
+		}
+		else if (mantissa != 0)
+		{
+			// Normalize denormalized value
+			for (exponent = 127 - 14; (mantissa & 0x400) == 0; --exponent)
+				mantissa <<= 1;
+			bits |= (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+	uint16_t float_to_half(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const uint16_t sign = (bits >> 16) & 0x8000;
+		bits &= 0x7FFFFFFF;
+
+		if (bits >= 0x7F800000) // Infinity or NaN
+			return sign | 0x7C00 | (bits != 0x7F800000 ? 0x200 : 0);
+		if (bits >= 0x477FF000) // Values from 65520 upwards round to infinity
+			return sign | 0x7C00;
+
+		// Round to nearest even in both the normalized and denormalized case
+		uint32_t result, remainder, halfway;
+		if (bits >= 0x38800000)
+		{
+			result = (bits - ((127 - 15) << 23)) >> 13;
+			remainder = bits & 0x1FFF;
+			halfway = 0x1000;
+		}
+		else
+		{
+			if (bits < 0x33000000) // Values up to half the smallest denormalized value round to zero
+				return sign;
+
+			const uint32_t shift = (127 - 1) - (bits >> 23);
+			const uint32_t mantissa = (bits & 0x7FFFFF) | 0x800000;
+			result = mantissa >> shift;
+			remainder = mantissa & ((1u << shift) - 1);
+			halfway = 1u << (shift - 1);
+		}
+
+		if (remainder > halfway || (remainder == halfway && (result & 1) != 0))
+			result++;
+		return sign | static_cast<uint16_t>(result);
+	}
+
+	float srgb_to_linear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+	float linear_to_srgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// Values up to this are kept as is, only brighter ones are compressed, so that SDR content does not change
+	constexpr float tonemap_shoulder_start = 0.8f;
+	// Value that is mapped to 1.0, which corresponds to 1000 nits in scRGB (where 1.0 is 80 nits)
+	constexpr float tonemap_white_point = 12.5f;
+
+	float tonemap(float value)
+	{
+		if (value <= tonemap_shoulder_start)
+			return value;
+
+		// Extended Reinhard curve over the range above the shoulder
+		constexpr float range = 1.0f - tonemap_shoulder_start;
+		constexpr float white = (tonemap_white_point - tonemap_shoulder_start) / range;
+		const float x = (value - tonemap_shoulder_start) / range;
+		return tonemap_shoulder_start + range * std::min(x * (1.0f + x / (white * white)) / (1.0f + x), 1.0f);
+	}
+
+	enum class half_conversion
+	{
+		alpha,
+		color,
+		color_tonemap
+	};
+
+	/// <summary>
+	/// Gets a table that converts the raw bits of a half-float value to an unsigned normalized value, so that each channel only takes a single lookup.
+	/// </summary>
+	template <typename T, half_conversion conversion>
+	const T *get_half_lookup_table()
+	{
+		static const std::unique_ptr<T[]> table = []() {
+			std::unique_ptr<T[]> table(new T[65536]);
+			for (uint32_t i = 0; i < 65536; ++i)
+			{
+				float value = half_to_float(static_cast<uint16_t>(i));
+				if (!(value > 0.0f)) // Also catches NaN
+					value = 0.0f;
+				if constexpr (conversion == half_conversion::color_tonemap)
+					value = tonemap(value);
+				value = std::min(value, 1.0f);
+				if constexpr (conversion != half_conversion::alpha)
+					value = linear_to_srgb(value);
+				table[i] = static_cast<T>(value * std::numeric_limits<T>::max() + 0.5f);
+			}
+			return table;
+		}();
+		return table.get();
+	}
+
+	/// <summary>
+	/// Gets a table that converts an unsigned normalized value with the specified number of bits to a linear half-float value.
+	/// </summary>
+	template <uint32_t bits, bool srgb>
+	const uint16_t *get_unorm_to_half_lookup_table()
+	{
+		static const std::unique_ptr<uint16_t[]> table = []() {
+			constexpr uint32_t max_value = (1u << bits) - 1;
+			std::unique_ptr<uint16_t[]> table(new uint16_t[max_value + 1]);
+			for (uint32_t i = 0; i <= max_value; ++i)
+				table[i] = float_to_half(srgb ? srgb_to_linear(i / static_cast<float>(max_value)) : i / static_cast<float>(max_value));
+			return table;
+		}();
+		return table.get();
+	}
+
+	// Equal to 'round(value * 255 / 1023)', but without a division, since 'x / 1023' is 'x / 1024 * (1 + 1 / 1024 + ...)'
+	inline uint32_t unorm10_to_unorm8(uint32_t value)
+	{
+		const uint32_t x = value * 255 + 511;
+		return (x + (x >> 10)) >> 10;
+	}
+	// Replicate the high bits into the low bits, so that 0x3FF becomes 0xFFFF and the conversion can be reversed by a shift
+	inline uint32_t unorm10_to_unorm16(uint32_t value)
+	{
+		return (value << 6) | (value >> 4);
+	}
+
+	void convert_r10g10b10a2_to_rgba8(const uint8_t *src, uint8_t *dst, size_t num_pixels, bool swap_red_blue)
+	{
+		size_t i = 0;
+
+#if RESHADE_IMAGE_UTILS_SSE2
+		const __m128i mask = _mm_set1_epi32(0x3FF);
+		const __m128i bias = _mm_set1_epi32(511);
+
+		const auto scale = [bias](__m128i value) {
+			const __m128i x = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(value, 8), value), bias);
+			return _mm_srli_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 10)), 10);
+		};
+
+		for (; i + 4 <= num_pixels; i += 4)
+		{
+			const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+
+			__m128i r = scale(_mm_and_si128(packed, mask));
+			const __m128i g = scale(_mm_and_si128(_mm_srli_epi32(packed, 10), mask));
+			__m128i b = scale(_mm_and_si128(_mm_srli_epi32(packed, 20), mask));
+			const __m128i a = _mm_mullo_epi16(_mm_srli_epi32(packed, 30), _mm_set1_epi32(85));
+			if (swap_red_blue)
+				std::swap(r, b);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24))));
+		}
+#endif
+
+		for (; i < num_pixels; ++i)
+		{
+			uint32_t packed;
+			std::memcpy(&packed, src + i * 4, 4);
+
+			dst[i * 4 + (swap_red_blue ? 2 : 0)] = static_cast<uint8_t>(unorm10_to_unorm8(packed & 0x3FF));
+			dst[i * 4 + 1] = static_cast<uint8_t>(unorm10_to_unorm8((packed >> 10) & 0x3FF));
+			dst[i * 4 + (swap_red_blue ? 0 : 2)] = static_cast<uint8_t>(unorm10_to_unorm8((packed >> 20) & 0x3FF));
+			dst[i * 4 + 3] = static_cast<uint8_t>((packed >> 30) * 85);
+		}
+	}
+	void convert_r10g10b10a2_to_rgba16(const uint8_t *src, uint16_t *dst, size_t num_pixels, bool swap_red_blue)
+	{
+		size_t i = 0;
+
+#if RESHADE_IMAGE_UTILS_SSE2
+		const __m128i mask = _mm_set1_epi32(0x3FF);
+
+		const auto scale = [](__m128i value) {
+			return _mm_or_si128(_mm_slli_epi32(value, 6), _mm_srli_epi32(value, 4));
+		};
+
+		for (; i + 4 <= num_pixels; i += 4)
+		{
+			const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+
+			__m128i r = scale(_mm_and_si128(packed, mask));
+			const __m128i g = scale(_mm_and_si128(_mm_srli_epi32(packed, 10), mask));
+			__m128i b = scale(_mm_and_si128(_mm_srli_epi32(packed, 20), mask));
+			const __m128i a = _mm_mullo_epi16(_mm_srli_epi32(packed, 30), _mm_set1_epi32(0x5555));
+			if (swap_red_blue)
+				std::swap(r, b);
+
+			// Combine into pairs of 16-bit channels and then interleave those to get two pixels per register
+			const __m128i rg = _mm_or_si128(r, _mm_slli_epi32(g, 16));
+			const __m128i ba = _mm_or_si128(b, _mm_slli_epi32(a, 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4 + 0), _mm_unpacklo_epi32(rg, ba));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4 + 8), _mm_unpackhi_epi32(rg, ba));
+		}
+#endif
+
+		for (; i < num_pixels; ++i)
+		{
+			uint32_t packed;
+			std::memcpy(&packed, src + i * 4, 4);
+
+			dst[i * 4 + (swap_red_blue ? 2 : 0)] = static_cast<uint16_t>(unorm10_to_unorm16(packed & 0x3FF));
+			dst[i * 4 + 1] = static_cast<uint16_t>(unorm10_to_unorm16((packed >> 10) & 0x3FF));
+			dst[i * 4 + (swap_red_blue ? 0 : 2)] = static_cast<uint16_t>(unorm10_to_unorm16((packed >> 20) & 0x3FF));
+			dst[i * 4 + 3] = static_cast<uint16_t>((packed >> 30) * 0x5555);
+		}
+	}
+}
+
+bool reshade::is_convertible_format(api::format format)
+{
+	switch (format)
+	{
+	case api::format::r8_unorm:
+	case api::format::r8g8_unorm:
+	case api::format::r8g8b8a8_unorm:
+	case api::format::r8g8b8x8_unorm:
+	case api::format::b8g8r8a8_unorm:
+	case api::format::b8g8r8x8_unorm:
+	case api::format::r10g10b10a2_unorm:
+	case api::format::b10g10r10a2_unorm:
+	case api::format::r16g16b16a16_unorm:
+	case api::format::r16g16b16a16_float:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool reshade::convert_pixels_to_rgba8(api::format format, uint32_t width, uint32_t height, const uint8_t *data, uint32_t row_pitch, uint8_t *pixels, bool tonemap)
+{
+	if (!is_convertible_format(format))
+		return false;
+
+	const uint32_t pixels_row_pitch = width * 4;
+
+	for (uint32_t y = 0; y < height; ++y, pixels += pixels_row_pitch, data += row_pitch)
+	{
+		switch (format)
+		{
+		case api::format::r8_unorm:
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				pixels[x * 4 + 0] = data[x];
+				pixels[x * 4 + 1] = 0;
+				pixels[x * 4 + 2] = 0;
+				pixels[x * 4 + 3] = 0xFF;
+			}
+			break;
+		case api::format::r8g8_unorm:
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				pixels[x * 4 + 0] = data[x * 2 + 0];
+				pixels[x * 4 + 1] = data[x * 2 + 1];
+				pixels[x * 4 + 2] = 0;
+				pixels[x * 4 + 3] = 0xFF;
+			}
+			break;
+		case api::format::r8g8b8a8_unorm:
+		case api::format::r8g8b8x8_unorm:
+			std::memcpy(pixels, data, pixels_row_pitch);
+			if (format == api::format::r8g8b8x8_unorm)
+				for (uint32_t x = 0; x < pixels_row_pitch; x += 4)
+					pixels[x + 3] = 0xFF;
+			break;
+		case api::format::b8g8r8a8_unorm:
+		case api::format::b8g8r8x8_unorm:
+			// Format is BGRA, but output should be RGBA, so flip channels
+			convert_bgra_to_rgba(data, pixels, width, format == api::format::b8g8r8x8_unorm);
+			break;
+		case api::format::r10g10b10a2_unorm:
+		case api::format::b10g10r10a2_unorm:
+			convert_r10g10b10a2_to_rgba8(data, pixels, width, format == api::format::b10g10r10a2_unorm);
+			break;
+		case api::format::r16g16b16a16_unorm:
+			for (uint32_t x = 0; x < pixels_row_pitch; ++x)
+			{
+				uint16_t value;
+				std::memcpy(&value, data + x * 2, 2);
+				pixels[x] = static_cast<uint8_t>((value * 255u + 32767u) / 65535u);
+			}
+			break;
+		case api::format::r16g16b16a16_float:
+		{
+			const uint8_t *const color_table = tonemap ? get_half_lookup_table<uint8_t, half_conversion::color_tonemap>() : get_half_lookup_table<uint8_t, half_conversion::color>();
+			const uint8_t *const alpha_table = get_half_lookup_table<uint8_t, half_conversion::alpha>();
+
+			for (uint32_t x = 0; x < pixels_row_pitch; x += 4)
+			{
+				uint16_t rgba[4];
+				std::memcpy(rgba, data + x * 2, 8);
+				pixels[x + 0] = color_table[rgba[0]];
+				pixels[x + 1] = color_table[rgba[1]];
+				pixels[x + 2] = color_table[rgba[2]];
+				pixels[x + 3] = alpha_table[rgba[3]];
+			}
+			break;
+		}
+		}
+	}
+
+	return true;
+}
+
+bool reshade::convert_pixels_to_rgba16(api::format format, uint32_t width, uint32_t height, const uint8_t *data, uint32_t row_pitch, uint16_t *pixels, bool tonemap)
+{
+	if (!is_convertible_format(format))
+		return false;
+
+	const uint32_t num_channels = width * 4;
+
+	for (uint32_t y = 0; y < height; ++y, pixels += num_channels, data += row_pitch)
+	{
+		switch (format)
+		{
+		case api::format::r8_unorm:
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				pixels[x * 4 + 0] = data[x] * 257;
+				pixels[x * 4 + 1] = 0;
+				pixels[x * 4 + 2] = 0;
+				pixels[x * 4 + 3] = 0xFFFF;
+			}
+			break;
+		case api::format::r8g8_unorm:
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				pixels[x * 4 + 0] = data[x * 2 + 0] * 257;
+				pixels[x * 4 + 1] = data[x * 2 + 1] * 257;
+				pixels[x * 4 + 2] = 0;
+				pixels[x * 4 + 3] = 0xFFFF;
+			}
+			break;
+		case api::format::r8g8b8a8_unorm:
+		case api::format::r8g8b8x8_unorm:
+		case api::format::b8g8r8a8_unorm:
+		case api::format::b8g8r8x8_unorm:
+		{
+			const bool swap_red_blue = format == api::format::b8g8r8a8_unorm || format == api::format::b8g8r8x8_unorm;
+			const bool force_opaque = format == api::format::r8g8b8x8_unorm || format == api::format::b8g8r8x8_unorm;
+
+			for (uint32_t x = 0; x < num_channels; x += 4)
+			{
+				pixels[x + 0] = data[x + (swap_red_blue ? 2 : 0)] * 257;
+				pixels[x + 1] = data[x + 1] * 257;
+				pixels[x + 2] = data[x + (swap_red_blue ? 0 : 2)] * 257;
+				pixels[x + 3] = force_opaque ? 0xFFFF : data[x + 3] * 257;
+			}
+			break;
+		}
+		case api::format::r10g10b10a2_unorm:
+		case api::format::b10g10r10a2_unorm:
+			convert_r10g10b10a2_to_rgba16(data, pixels, width, format == api::format::b10g10r10a2_unorm);
+			break;
+		case api::format::r16g16b16a16_unorm:
+			std::memcpy(pixels, data, num_channels * 2);
+			break;
+		case api::format::r16g16b16a16_float:
+		{
+			const uint16_t *const color_table = tonemap ? get_half_lookup_table<uint16_t, half_conversion::color_tonemap>() : get_half_lookup_table<uint16_t, half_conversion::color>();
+			const uint16_t *const alpha_table = get_half_lookup_table<uint16_t, half_conversion::alpha>();
+
+			for (uint32_t x = 0; x < num_channels; x += 4)
+			{
+				uint16_t rgba[4];
+				std::memcpy(rgba, data + x * 2, 8);
+				pixels[x + 0] = color_table[rgba[0]];
+				pixels[x + 1] = color_table[rgba[1]];
+				pixels[x + 2] = color_table[rgba[2]];
+				pixels[x + 3] = alpha_table[rgba[3]];
+			}
+			break;
+		}
+		}
+	}
+
+	return true;
+}
+
+bool reshade::convert_pixels_to_rgba16f(api::format format, uint32_t width, uint32_t height, const uint8_t *data, uint32_t row_pitch, uint16_t *pixels)
+{
+	if (!is_convertible_format(format))
+		return false;
+
+	constexpr uint16_t half_one = 0x3C00;
+	const uint32_t num_channels = width * 4;
+
+	for (uint32_t y = 0; y < height; ++y, pixels += num_channels, data += row_pitch)
+	{
+		switch (format)
+		{
+		case api::format::r8_unorm:
+		case api::format::r8g8_unorm:
+		{
+			const uint16_t *const color_table = get_unorm_to_half_lookup_table<8, true>();
+			const uint32_t stride = format == api::format::r8g8_unorm ? 2 : 1;
+
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				pixels[x * 4 + 0] = color_table[data[x * stride]];
+				pixels[x * 4 + 1] = stride == 2 ? color_table[data[x * stride + 1]] : 0;
+				pixels[x * 4 + 2] = 0;
+				pixels[x * 4 + 3] = half_one;
+			}
+			break;
+		}
+		case api::format::r8g8b8a8_unorm:
+		case api::format::r8g8b8x8_unorm:
+		case api::format::b8g8r8a8_unorm:
+		case api::format::b8g8r8x8_unorm:
+		{
+			const uint16_t *const color_table = get_unorm_to_half_lookup_table<8, true>();
+			const uint16_t *const alpha_table = get_unorm_to_half_lookup_table<8, false>();
+			const bool swap_red_blue = format == api::format::b8g8r8a8_unorm || format == api::format::b8g8r8x8_unorm;
+			const bool force_opaque = format == api::format::r8g8b8x8_unorm || format == api::format::b8g8r8x8_unorm;
+
+			for (uint32_t x = 0; x < num_channels; x += 4)
+			{
+				pixels[x + 0] = color_table[data[x + (swap_red_blue ? 2 : 0)]];
+				pixels[x + 1] = color_table[data[x + 1]];
+				pixels[x + 2] = color_table[data[x + (swap_red_blue ? 0 : 2)]];
+				pixels[x + 3] = force_opaque ? half_one : alpha_table[data[x + 3]];
+			}
+			break;
+		}
+		case api::format::r10g10b10a2_unorm:
+		case api::format::b10g10r10a2_unorm:
+		{
+			const uint16_t *const color_table = get_unorm_to_half_lookup_table<10, true>();
+			const uint16_t *const alpha_table = get_unorm_to_half_lookup_table<2, false>();
+			const bool swap_red_blue = format == api::format::b10g10r10a2_unorm;
+
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				uint32_t packed;
+				std::memcpy(&packed, data + x * 4, 4);
+				pixels[x * 4 + (swap_red_blue ? 2 : 0)] = color_table[packed & 0x3FF];
+				pixels[x * 4 + 1] = color_table[(packed >> 10) & 0x3FF];
+				pixels[x * 4 + (swap_red_blue ? 0 : 2)] = color_table[(packed >> 20) & 0x3FF];
+				pixels[x * 4 + 3] = alpha_table[packed >> 30];
+			}
+			break;
+		}
+		case api::format::r16g16b16a16_unorm:
+		{
+			const uint16_t *const color_table = get_unorm_to_half_lookup_table<16, true>();
+			const uint16_t *const alpha_table = get_unorm_to_half_lookup_table<16, false>();
+
+			for (uint32_t x = 0; x < num_channels; x += 4)
+			{
+				uint16_t rgba[4];
+				std::memcpy(rgba, data + x * 2, 8);
+				pixels[x + 0] = color_table[rgba[0]];
+				pixels[x + 1] = color_table[rgba[1]];
+				pixels[x + 2] = color_table[rgba[2]];
+				pixels[x + 3] = alpha_table[rgba[3]];
+			}
+			break;
+		}
+		case api::format::r16g16b16a16_float:
+			std::memcpy(pixels, data, num_channels * 2);
+			break;
+		}
+	}
+
+	return true;
+}
+
+namespace
+{
+	// Deflate stream constants (see RFC 1951)
+	const uint16_t s_length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t  s_length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t s_distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t  s_distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	const uint8_t  s_code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	constexpr uint32_t window_size = 32768;
+	constexpr uint32_t min_match_length = 4;
+	constexpr uint32_t max_match_length = 258;
+	constexpr uint32_t hash_bits = 15;
+	// Number of symbols after which a new block with its own Huffman codes is started
+	constexpr size_t max_block_symbols = 1 << 16;
+
+	struct lookup_tables
+	{
+		lookup_tables()
+		{
+			for (uint8_t code = 0; code < 29; ++code)
+				for (uint32_t length = s_length_base[code]; length < s_length_base[code] + (1u << s_length_extra[code]) && length <= max_match_length; ++length)
+					length_code[length - 3] = code;
+			// Length 258 has its own code, even though it also falls into the range of the one before it
+			length_code[max_match_length - 3] = 28;
+
+			// Distances up to 256 are looked up directly, larger ones in steps of 128 (as done in zlib)
+			for (uint8_t code = 0; code < 30; ++code)
+			{
+				for (uint32_t distance = s_distance_base[code]; distance < s_distance_base[code] + (1u << s_distance_extra[code]); ++distance)
+				{
+					if (distance <= 256)
+						distance_code[distance - 1] = code;
+					else
+						distance_code[256 + ((distance - 1) >> 7)] = code;
+				}
+			}
+
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; ++k)
+					c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+				crc[0][i] = c;
+			}
+			for (uint32_t i = 0; i < 256; ++i)
+				for (int k = 1; k < 8; ++k)
+					crc[k][i] = (crc[k - 1][i] >> 8) ^ crc[0][crc[k - 1][i] & 0xFF];
+		}
+
+		uint8_t length_code[256];
+		uint8_t distance_code[512];
+		uint32_t crc[8][256];
+	};
+
+	const lookup_tables &get_lookup_tables()
+	{
+		static const lookup_tables tables;
+		return tables;
+	}
+
+	uint32_t update_crc32(uint32_t crc, const uint8_t *data, size_t size)
+	{
+		const lookup_tables &tables = get_lookup_tables();
+
+		crc = ~crc;
+		// Process eight bytes at a time ("slicing-by-8")
+		for (; size >= 8; size -= 8, data += 8)
+		{
+			uint32_t lo, hi;
+			std::memcpy(&lo, data, 4);
+			std::memcpy(&hi, data + 4, 4);
+			lo ^= crc;
+			crc =
+				tables.crc[7][lo & 0xFF] ^ tables.crc[6][(lo >> 8) & 0xFF] ^ tables.crc[5][(lo >> 16) & 0xFF] ^ tables.crc[4][lo >> 24] ^
+				tables.crc[3][hi & 0xFF] ^ tables.crc[2][(hi >> 8) & 0xFF] ^ tables.crc[1][(hi >> 16) & 0xFF] ^ tables.crc[0][hi >> 24];
+		}
+		for (; size != 0; --size, ++data)
+			crc = tables.crc[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	uint32_t update_adler32(uint32_t adler, const uint8_t *data, size_t size)
+	{
+		uint32_t a = adler & 0xFFFF, b = adler >> 16;
+		while (size != 0)
+		{
+			// Largest number of bytes that can be summed up before the sums may overflow 32 bits
+			const size_t chunk_size = std::min<size_t>(size, 5552);
+			for (size_t i = 0; i < chunk_size; ++i)
+				a += data[i], b += a;
+			a %= 65521;
+			b %= 65521;
+			data += chunk_size;
+			size -= chunk_size;
+		}
+		return (b << 16) | a;
+	}
+	uint32_t combine_adler32(uint32_t adler1, uint32_t adler2, size_t size2)
+	{
+		// See 'adler32_combine' in zlib
+		const uint32_t rem = static_cast<uint32_t>(size2 % 65521);
+		uint32_t a = adler1 & 0xFFFF;
+		uint32_t b = static_cast<uint32_t>((static_cast<uint64_t>(rem) * a) % 65521);
+		a += (adler2 & 0xFFFF) + 65521 - 1;
+		b += (adler1 >> 16) + (adler2 >> 16) + 65521 - rem;
+		if (a >= 65521) a -= 65521;
+		if (a >= 65521) a -= 65521;
+		if (b >= (65521 << 1)) b -= (65521 << 1);
+		if (b >= 65521) b -= 65521;
+		return (b << 16) | a;
+	}
+
+	struct bit_writer
+	{
+		explicit bit_writer(std::vector<uint8_t> &out) : out(out), size(out.size()) {}
+		~bit_writer()
+		{
+			out.resize(size);
+		}
+
+		/// <summary>
+		/// Makes room for at least the specified number of bytes, so that <see cref="write"/> does not have to check for that.
+		/// </summary>
+		void reserve(size_t num_bytes)
+		{
+			if (size + num_bytes + 8 > out.size())
+				out.resize(std::max(out.size() * 2, size + num_bytes + 8));
+		}
+
+		void write(uint32_t value, uint32_t num_bits)
+		{
+			bits |= static_cast<uint64_t>(value) << count;
+			count += num_bits;
+			if (count >= 32)
+			{
+				uint8_t *const dst = out.data() + size;
+				dst[0] = static_cast<uint8_t>(bits);
+				dst[1] = static_cast<uint8_t>(bits >> 8);
+				dst[2] = static_cast<uint8_t>(bits >> 16);
+				dst[3] = static_cast<uint8_t>(bits >> 24);
+				size += 4;
+				bits >>= 32;
+				count -= 32;
+			}
+		}
+
+		void write_bytes(const uint8_t *data, size_t num_bytes)
+		{
+			flush_to_byte_boundary();
+			reserve(num_bytes);
+			std::memcpy(out.data() + size, data, num_bytes);
+			size += num_bytes;
+		}
+
+		void flush_to_byte_boundary()
+		{
+			reserve(8);
+			for (; count > 0; count = count > 8 ? count - 8 : 0, bits >>= 8)
+				out[size++] = static_cast<uint8_t>(bits);
+			bits = 0;
+		}
+
+		std::vector<uint8_t> &out;
+		size_t size;
+		uint64_t bits = 0;
+		uint32_t count = 0;
+	};
+
+	struct huffman_code
+	{
+		void build(const uint32_t *freqs, uint32_t num_symbols, uint32_t max_length)
+		{
+			std::vector<uint32_t> adjusted_freqs(freqs, freqs + num_symbols);
+
+			// Some decoders reject codes with a single symbol, so always have at least two
+			uint32_t num_used = 0;
+			for (uint32_t i = 0; i < num_symbols; ++i)
+				num_used += adjusted_freqs[i] != 0;
+			for (uint32_t i = 0; i < num_symbols && num_used < 2; ++i)
+				if (adjusted_freqs[i] == 0)
+					adjusted_freqs[i] = 1, num_used++;
+
+			// Flatten the distribution until the tree is no deeper than allowed
+			while (!build_lengths(adjusted_freqs.data(), num_symbols, max_length))
+				for (uint32_t &freq : adjusted_freqs)
+					if (freq != 0)
+						freq = (freq + 1) / 2;
+
+			// Assign canonical codes, which are written starting with the most significant bit, so reverse them
+			uint32_t length_count[16] = {}, next_code[16] = {};
+			for (uint32_t i = 0; i < num_symbols; ++i)
+				length_count[lengths[i]]++;
+			length_count[0] = 0;
+			for (uint32_t length = 1, code = 0; length < 16; ++length)
+				next_code[length] = code = (code + length_count[length - 1]) << 1;
+
+			for (uint32_t i = 0; i < num_symbols; ++i)
+			{
+				if (lengths[i] == 0)
+					continue;
+
+				uint32_t code = next_code[lengths[i]]++, reversed = 0;
+				for (uint32_t k = 0; k < lengths[i]; ++k, code >>= 1)
+					reversed = (reversed << 1) | (code & 1);
+				codes[i] = static_cast<uint16_t>(reversed);
+			}
+		}
+
+		bool build_lengths(const uint32_t *freqs, uint32_t num_symbols, uint32_t max_length)
+		{
+			struct node
+			{
+				uint32_t freq;
+				uint32_t index;
+				bool operator<(const node &other) const { return freq > other.freq || (freq == other.freq && index > other.index); }
+			};
+
+			std::priority_queue<node> queue;
+			// Leaves come first, followed by the internal nodes
+			std::vector<uint32_t> parents(num_symbols * 2, 0);
+
+			for (uint32_t i = 0; i < num_symbols; ++i)
+				if (freqs[i] != 0)
+					queue.push({ freqs[i], i });
+
+			uint32_t next_index = num_symbols;
+			while (queue.size() > 1)
+			{
+				const node a = queue.top(); queue.pop();
+				const node b = queue.top(); queue.pop();
+				parents[a.index] = parents[b.index] = next_index;
+				queue.push({ a.freq + b.freq, next_index++ });
+			}
+
+			// Depth of each node is one more than that of its parent, which always has a higher index
+			std::vector<uint8_t> depths(num_symbols * 2, 0);
+			for (uint32_t i = next_index - 1; i >= num_symbols; --i)
+				if (i != next_index - 1)
+					depths[i] = depths[parents[i]] + 1;
+
+			for (uint32_t i = 0; i < num_symbols; ++i)
+			{
+				lengths[i] = freqs[i] != 0 ? depths[parents[i]] + 1 : 0;
+				if (lengths[i] > max_length)
+					return false;
+			}
+
+			return true;
+		}
+
+		uint8_t lengths[288] = {};
+		uint16_t codes[288] = {};
+	};
+
+	struct symbol
+	{
+		uint16_t literal_or_length; // Literal if distance is zero, match length otherwise
+		uint16_t distance;
+	};
+
+	void write_dynamic_block(bit_writer &writer, const std::vector<symbol> &symbols)
+	{
+		const lookup_tables &tables = get_lookup_tables();
+
+		uint32_t literal_freqs[286] = {}, distance_freqs[30] = {};
+		for (const symbol &s : symbols)
+		{
+			if (s.distance == 0)
+			{
+				literal_freqs[s.literal_or_length]++;
+			}
+			else
+			{
+				literal_freqs[257 + tables.length_code[s.literal_or_length - 3]]++;
+				distance_freqs[s.distance <= 256 ? tables.distance_code[s.distance - 1] : tables.distance_code[256 + ((s.distance - 1) >> 7)]]++;
+			}
+		}
+		literal_freqs[256] = 1; // End of block
+
+		huffman_code literal_code, distance_code;
+		literal_code.build(literal_freqs, 286, 15);
+		distance_code.build(distance_freqs, 30, 15);
+
+		uint32_t num_literal_codes = 286, num_distance_codes = 30;
+		while (num_literal_codes > 257 && literal_code.lengths[num_literal_codes - 1] == 0)
+			num_literal_codes--;
+		while (num_distance_codes > 1 && distance_code.lengths[num_distance_codes - 1] == 0)
+			num_distance_codes--;
+
+		// Run-length encode the code lengths of both codes as a single sequence
+		uint8_t all_lengths[286 + 30];
+		std::memcpy(all_lengths, literal_code.lengths, num_literal_codes);
+		std::memcpy(all_lengths + num_literal_codes, distance_code.lengths, num_distance_codes);
+		const uint32_t num_lengths = num_literal_codes + num_distance_codes;
+
+		std::vector<std::pair<uint8_t, uint8_t>> length_symbols; // Pairs of code length symbol and value of its extra bits
+		uint32_t length_freqs[19] = {};
+		for (uint32_t i = 0; i < num_lengths;)
+		{
+			const uint8_t length = all_lengths[i];
+			uint32_t run = 1;
+			while (i + run < num_lengths && all_lengths[i + run] == length)
+				run++;
+			i += run;
+
+			if (length == 0)
+			{
+				for (uint32_t n; run >= 11; run -= n)
+					n = std::min(run, 138u), length_symbols.emplace_back(18, static_cast<uint8_t>(n - 11));
+				if (run >= 3)
+					length_symbols.emplace_back(17, static_cast<uint8_t>(run - 3)), run = 0;
+			}
+			else
+			{
+				length_symbols.emplace_back(length, 0), run--;
+				for (uint32_t n; run >= 3; run -= n)
+					n = std::min(run, 6u), length_symbols.emplace_back(16, static_cast<uint8_t>(n - 3));
+			}
+
+			for (; run != 0; --run)
+				length_symbols.emplace_back(length, 0);
+		}
+		for (const std::pair<uint8_t, uint8_t> &s : length_symbols)
+			length_freqs[s.first]++;
+
+		huffman_code length_code;
+		length_code.build(length_freqs, 19, 7);
+
+		uint32_t num_length_codes = 19;
+		while (num_length_codes > 4 && length_code.lengths[s_code_length_order[num_length_codes - 1]] == 0)
+			num_length_codes--;
+
+		// Each symbol takes at most 15 + 5 bits for the length and 15 + 13 bits for the distance, plus the code length codes in the header
+		writer.reserve(symbols.size() * 6 + length_symbols.size() * 2 + 64);
+
+		writer.write(0, 1); // Not the final block
+		writer.write(2, 2); // Compressed with dynamic Huffman codes
+		writer.write(num_literal_codes - 257, 5);
+		writer.write(num_distance_codes - 1, 5);
+		writer.write(num_length_codes - 4, 4);
+		for (uint32_t i = 0; i < num_length_codes; ++i)
+			writer.write(length_code.lengths[s_code_length_order[i]], 3);
+
+		for (const std::pair<uint8_t, uint8_t> &s : length_symbols)
+		{
+			writer.write(length_code.codes[s.first], length_code.lengths[s.first]);
+			if (s.first == 16)
+				writer.write(s.second, 2);
+			else if (s.first == 17)
+				writer.write(s.second, 3);
+			else if (s.first == 18)
+				writer.write(s.second, 7);
+		}
+
+		for (const symbol &s : symbols)
+		{
+			if (s.distance == 0)
+			{
+				writer.write(literal_code.codes[s.literal_or_length], literal_code.lengths[s.literal_or_length]);
+				continue;
+			}
+
+			const uint32_t lcode = tables.length_code[s.literal_or_length - 3];
+			writer.write(literal_code.codes[257 + lcode], literal_code.lengths[257 + lcode]);
+			writer.write(s.literal_or_length - s_length_base[lcode], s_length_extra[lcode]);
+
+			const uint32_t dcode = s.distance <= 256 ? tables.distance_code[s.distance - 1] : tables.distance_code[256 + ((s.distance - 1) >> 7)];
+			writer.write(distance_code.codes[dcode], distance_code.lengths[dcode]);
+			writer.write(s.distance - s_distance_base[dcode], s_distance_extra[dcode]);
+		}
+
+		writer.write(literal_code.codes[256], literal_code.lengths[256]);
+	}
+
+	size_t extend_match(const uint8_t *a, const uint8_t *b, size_t max_length)
+	{
+		size_t length = min_match_length;
+		// Compare eight bytes at a time and find the first differing byte from the lowest set bit of the difference
+		for (uint64_t x, y; length + 8 <= max_length; length += 8)
+		{
+			std::memcpy(&x, a + length, 8);
+			std::memcpy(&y, b + length, 8);
+			if (x != y)
+			{
+#if defined(_MSC_VER) && defined(_WIN64)
+				unsigned long index;
+				_BitScanForward64(&index, x ^ y);
+				return length + index / 8;
+#elif defined(_MSC_VER)
+				unsigned long index;
+				if (!_BitScanForward(&index, static_cast<unsigned long>(x ^ y)))
+					_BitScanForward(&index, static_cast<unsigned long>((x ^ y) >> 32)), index += 32;
+				return length + index / 8;
+#else
+				return length + __builtin_ctzll(x ^ y) / 8;
+#endif
+			}
+		}
+		while (length < max_length && a[length] == b[length])
+			length++;
+		return length;
+	}
+
+	/// <summary>
+	/// Compresses the data starting at <paramref name="data"/> + <paramref name="dictionary_size"/> into a sequence of non-final deflate blocks, which may reference the preceding dictionary bytes.
+	/// </summary>
+	void deflate(const uint8_t *data, size_t dictionary_size, size_t size, bool last, std::vector<uint8_t> &out)
+	{
+		const auto read32 = [data](size_t pos) { uint32_t v; std::memcpy(&v, data + pos, 4); return v; };
+		const auto hash = [](uint32_t v) { return (v * 2654435761u) >> (32 - hash_bits); };
+
+		// Positions are stored plus one, so that zero means empty
+		std::vector<uint32_t> head(1 << hash_bits, 0);
+
+		const size_t end = dictionary_size + size;
+		for (size_t pos = dictionary_size > window_size ? dictionary_size - window_size : 0; pos < dictionary_size && pos + min_match_length <= end; ++pos)
+			head[hash(read32(pos))] = static_cast<uint32_t>(pos + 1);
+
+		bit_writer writer(out);
+
+		std::vector<symbol> symbols;
+		symbols.reserve(max_block_symbols);
+
+		for (size_t pos = dictionary_size; pos < end;)
+		{
+			size_t match_length = 0;
+			size_t match_pos = 0;
+
+			if (pos + min_match_length <= end)
+			{
+				// Only check the most recent position with the same hash, which is enough for the long runs typical in screenshots
+				const uint32_t value = read32(pos);
+				uint32_t &entry = head[hash(value)];
+				const size_t candidate = entry;
+				entry = static_cast<uint32_t>(pos + 1);
+
+				if (candidate != 0 && pos - (candidate - 1) <= window_size && read32(candidate - 1) == value)
+				{
+					match_pos = candidate - 1;
+					match_length = min_match_length;
+
+					match_length = extend_match(data + match_pos, data + pos, std::min<size_t>(max_match_length, end - pos));
+				}
+			}
+
+			if (match_length != 0)
+			{
+				symbols.push_back({ static_cast<uint16_t>(match_length), static_cast<uint16_t>(pos - match_pos) });
+
+				// Make the positions covered by the match available to later matches too
+				for (size_t k = pos + 1; k < pos + match_length && k + min_match_length <= end; ++k)
+					head[hash(read32(k))] = static_cast<uint32_t>(k + 1);
+
+				pos += match_length;
+			}
+			else
+			{
+				symbols.push_back({ data[pos], 0 });
+				pos++;
+			}
+
+			if (symbols.size() >= max_block_symbols)
+			{
+				write_dynamic_block(writer, symbols);
+				symbols.clear();
+			}
+		}
+
+		if (!symbols.empty())
+			write_dynamic_block(writer, symbols);
+
+		writer.reserve(8);
+
+		if (last)
+		{
+			// Empty final block with fixed Huffman codes, consisting only of the end of block code (which is seven zero bits)
+			writer.write(1, 1);
+			writer.write(1, 2);
+			writer.write(0, 7);
+			writer.flush_to_byte_boundary();
+		}
+		else
+		{
+			// Empty stored block, which aligns the stream to a byte boundary, so that the next strip can simply be appended (same as a 'Z_SYNC_FLUSH' in zlib)
+			writer.write(0, 1);
+			writer.write(0, 2);
+			const uint8_t empty_stored_block[4] = { 0x00, 0x00, 0xFF, 0xFF };
+			writer.write_bytes(empty_stored_block, 4);
+		}
+	}
+
+	void filter_rows(const uint8_t *pixels, size_t row_size, uint32_t first_row, uint32_t last_row, bool swap_bytes, uint8_t *out)
+	{
+		// PNG stores 16-bit samples in big-endian byte order, so swap the bytes of each sample while filtering (which does not change the result of the byte-wise subtraction)
+		const size_t swap_mask = swap_bytes ? 1 : 0;
+
+		for (uint32_t y = first_row; y < last_row; ++y, out += row_size + 1)
+		{
+			const uint8_t *const row = pixels + y * row_size;
+
+			// Use the "None" filter on the first row and the "Up" filter on all others, which works well for screenshots and is cheap to compute
+			if (y == 0)
+			{
+				out[0] = 0;
+				for (size_t x = 0; x < row_size; ++x)
+					out[1 + x] = row[x ^ swap_mask];
+				continue;
+			}
+
+			const uint8_t *const prev_row = row - row_size;
+
+			out[0] = 2;
+			size_t x = 0;
+#if RESHADE_IMAGE_UTILS_SSE2
+			for (; x + 16 <= row_size; x += 16)
+			{
+				__m128i difference = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(prev_row + x)));
+				if (swap_bytes)
+					difference = _mm_or_si128(_mm_slli_epi16(difference, 8), _mm_srli_epi16(difference, 8));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 1 + x), difference);
+			}
+#endif
+			for (; x < row_size; ++x)
+				out[1 + x] = row[x ^ swap_mask] - prev_row[x ^ swap_mask];
+		}
+	}
+
+	void compress_zlib(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+	{
+		out.push_back(0x78); // Deflate with 32K window
+		out.push_back(0x01); // Fastest compression level, no preset dictionary, header checksum
+		deflate(data, 0, size, true, out);
+
+		const uint32_t adler = update_adler32(1, data, size);
+		const uint8_t adler_bytes[4] = { static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16), static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler) };
+		out.insert(out.end(), adler_bytes, adler_bytes + 4);
+	}
+
+	void write_chunk(std::vector<uint8_t> &out, const char type[4], const uint8_t *data, size_t size)
+	{
+		const uint8_t length[4] = { static_cast<uint8_t>(size >> 24), static_cast<uint8_t>(size >> 16), static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size) };
+		out.insert(out.end(), length, length + 4);
+		const size_t offset = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data, data + size);
+
+		const uint32_t crc = update_crc32(0, out.data() + offset, size + 4);
+		const uint8_t crc_bytes[4] = { static_cast<uint8_t>(crc >> 24), static_cast<uint8_t>(crc >> 16), static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc) };
+		out.insert(out.end(), crc_bytes, crc_bytes + 4);
+	}
+}
+
+bool reshade::encode_png(const void *pixels, uint32_t width, uint32_t height, uint32_t channels, uint32_t bits_per_channel, std::vector<uint8_t> &out, uint32_t num_threads)
+{
+	if (width == 0 || height == 0 || (channels != 3 && channels != 4) || (bits_per_channel != 8 && bits_per_channel != 16))
+		return false;
+
+	const size_t row_size = static_cast<size_t>(width) * channels * (bits_per_channel / 8);
+	const size_t filtered_row_size = row_size + 1;
+	// Zlib stream length is limited to what fits into a single chunk
+	if (filtered_row_size * height > 0x7FFFFFFF / 2)
+		return false;
+
+	if (num_threads == 0)
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// Strips need to be large enough for compression to not suffer from the restarted Huffman codes and hash table
+	constexpr size_t min_strip_size = 256 * 1024;
+	const uint32_t num_strips = static_cast<uint32_t>(std::clamp<size_t>(filtered_row_size * height / min_strip_size, 1, std::min(num_threads, height)));
+	// Number of preceding rows each strip uses as dictionary to be able to reference data of the previous strip
+	const uint32_t dictionary_rows = static_cast<uint32_t>((window_size + filtered_row_size - 1) / filtered_row_size);
+
+	struct strip
+	{
+		uint32_t first_row, last_row;
+		uint32_t adler;
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<strip> strips(num_strips);
+	for (uint32_t i = 0; i < num_strips; ++i)
+	{
+		strips[i].first_row = static_cast<uint32_t>(static_cast<uint64_t>(height) * i / num_strips);
+		strips[i].last_row = static_cast<uint32_t>(static_cast<uint64_t>(height) * (i + 1) / num_strips);
+	}
+
+	const auto encode_strip = [&](strip &s, bool last) {
+		const uint32_t first_row = s.first_row > dictionary_rows ? s.first_row - dictionary_rows : 0;
+
+		// Filter dictionary rows again rather than waiting on the previous strip, since filtering is cheap compared to compression
+		std::vector<uint8_t> filtered(filtered_row_size * (s.last_row - first_row));
+		filter_rows(static_cast<const uint8_t *>(pixels), row_size, first_row, s.last_row, bits_per_channel == 16, filtered.data());
+
+		const size_t dictionary_size = filtered_row_size * (s.first_row - first_row);
+		const size_t size = filtered.size() - dictionary_size;
+
+		s.adler = update_adler32(1, filtered.data() + dictionary_size, size);
+		s.data.reserve(size / 2);
+		deflate(filtered.data(), dictionary_size, size, last, s.data);
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(num_strips - 1);
+	for (uint32_t i = 1; i < num_strips; ++i)
+		threads.emplace_back(encode_strip, std::ref(strips[i]), i == num_strips - 1);
+	encode_strip(strips[0], num_strips == 1);
+	for (std::thread &thread : threads)
+		thread.join();
+
+	// Join the deflate streams of all strips into a single zlib stream
+	uint32_t adler = strips[0].adler;
+	size_t idat_size = 2 + 4;
+	for (uint32_t i = 0; i < num_strips; ++i)
+	{
+		if (i != 0)
+			adler = combine_adler32(adler, strips[i].adler, filtered_row_size * (strips[i].last_row - strips[i].first_row));
+		idat_size += strips[i].data.size();
+	}
+
+	std::vector<uint8_t> idat;
+	idat.reserve(idat_size);
+	idat.push_back(0x78); // Deflate with 32K window
+	idat.push_back(0x01); // Fastest compression level, no preset dictionary, header checksum
+	for (strip &s : strips)
+	{
+		idat.insert(idat.end(), s.data.begin(), s.data.end());
+		s.data.clear();
+		s.data.shrink_to_fit();
+	}
+	const uint8_t adler_bytes[4] = { static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16), static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler) };
+	idat.insert(idat.end(), adler_bytes, adler_bytes + 4);
+
+	const uint8_t ihdr[13] = {
+		static_cast<uint8_t>(width >> 24), static_cast<uint8_t>(width >> 16), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width),
+		static_cast<uint8_t>(height >> 24), static_cast<uint8_t>(height >> 16), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+		static_cast<uint8_t>(bits_per_channel),
+		static_cast<uint8_t>(channels == 4 ? 6 : 2), // Color type (RGBA or RGB)
+		0, // Compression method
+		0, // Filter method
+		0, // Interlace method
+	};
+
+	const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	out.clear();
+	out.reserve(sizeof(signature) + (12 + sizeof(ihdr)) + (12 + idat.size()) + 12);
+	out.insert(out.end(), signature, signature + sizeof(signature));
+	write_chunk(out, "IHDR", ihdr, sizeof(ihdr));
+	write_chunk(out, "IDAT", idat.data(), idat.size());
+	write_chunk(out, "IEND", nullptr, 0);
+
+	return true;
+}
+
+bool reshade::encode_exr(const uint16_t *pixels, uint32_t width, uint32_t height, uint32_t channels, std::vector<uint8_t> &out, uint32_t num_threads)
+{
+	if (width == 0 || height == 0 || width > 0x7FFFFFFF || height > 0x7FFFFFFF || (channels != 3 && channels != 4))
+		return false;
+
+	if (num_threads == 0)
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// ZIP compression always works on blocks of 16 scanlines
+	constexpr uint32_t lines_per_block = 16;
+	const uint32_t num_blocks = (height + lines_per_block - 1) / lines_per_block;
+
+	const auto append_uint32 = [](std::vector<uint8_t> &data, uint32_t value) {
+		const uint8_t bytes[4] = { static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24) };
+		data.insert(data.end(), bytes, bytes + 4);
+	};
+	const auto append_attribute = [&append_uint32](std::vector<uint8_t> &data, const char *name, const char *type, const std::vector<uint8_t> &value) {
+		data.insert(data.end(), name, name + std::strlen(name) + 1);
+		data.insert(data.end(), type, type + std::strlen(type) + 1);
+		append_uint32(data, static_cast<uint32_t>(value.size()));
+		data.insert(data.end(), value.begin(), value.end());
+	};
+
+	// Channels have to be sorted by name, so they are stored in the reverse order of the input pixels
+	const char *const channel_names = channels == 4 ? "ABGR" : "BGR";
+
+	std::vector<uint8_t> channel_list;
+	for (uint32_t c = 0; c < channels; ++c)
+	{
+		channel_list.push_back(channel_names[c]);
+		channel_list.push_back('\0');
+		append_uint32(channel_list, 1); // Half pixel type
+		append_uint32(channel_list, 0); // Not perceptually linear, followed by three reserved bytes
+		append_uint32(channel_list, 1); // Horizontal sampling
+		append_uint32(channel_list, 1); // Vertical sampling
+	}
+	channel_list.push_back('\0');
+
+	std::vector<uint8_t> window;
+	append_uint32(window, 0);
+	append_uint32(window, 0);
+	append_uint32(window, width - 1);
+	append_uint32(window, height - 1);
+
+	std::vector<uint8_t> one, center;
+	append_uint32(one, 0x3F800000); // 1.0f
+	append_uint32(center, 0);
+	append_uint32(center, 0);
+
+	std::vector<uint8_t> header = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 }; // Magic number and version 2 with single-part scanline flags
+	append_attribute(header, "channels", "chlist", channel_list);
+	append_attribute(header, "compression", "compression", { 3 }); // ZIP_COMPRESSION
+	append_attribute(header, "dataWindow", "box2i", window);
+	append_attribute(header, "displayWindow", "box2i", window);
+	append_attribute(header, "lineOrder", "lineOrder", { 0 }); // INCREASING_Y
+	append_attribute(header, "pixelAspectRatio", "float", one);
+	append_attribute(header, "screenWindowCenter", "v2f", center);
+	append_attribute(header, "screenWindowWidth", "float", one);
+	header.push_back('\0');
+
+	std::vector<std::vector<uint8_t>> blocks(num_blocks);
+
+	const auto encode_blocks = [&](uint32_t first_block, uint32_t last_block) {
+		std::vector<uint8_t> raw, reordered;
+
+		for (uint32_t block = first_block; block < last_block; ++block)
+		{
+			const uint32_t first_line = block * lines_per_block;
+			const uint32_t last_line = std::min(first_line + lines_per_block, height);
+
+			// Scanlines store all values of one channel after another
+			raw.resize(static_cast<size_t>(last_line - first_line) * width * channels * 2);
+			uint8_t *dst = raw.data();
+			for (uint32_t y = first_line; y < last_line; ++y)
+			{
+				const uint16_t *const row = pixels + static_cast<size_t>(y) * width * channels;
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					for (uint32_t x = 0, channel = channels - 1 - c; x < width; ++x, dst += 2)
+					{
+						const uint16_t value = row[x * channels + channel];
+						dst[0] = static_cast<uint8_t>(value);
+						dst[1] = static_cast<uint8_t>(value >> 8);
+					}
+				}
+			}
+
+			// Split the low and high bytes of all values into two halves and store the differences between consecutive bytes, as the ZIP compression in OpenEXR expects
+			reordered.resize(raw.size());
+			const size_t half_size = (raw.size() + 1) / 2;
+			for (size_t i = 0; i < raw.size(); ++i)
+				reordered[(i % 2 == 0) ? i / 2 : half_size + i / 2] = raw[i];
+			for (size_t i = reordered.size() - 1; i > 0; --i)
+				reordered[i] = static_cast<uint8_t>(reordered[i] - reordered[i - 1] + 128);
+
+			std::vector<uint8_t> &data = blocks[block];
+			compress_zlib(reordered.data(), reordered.size(), data);
+
+			// Readers detect uncompressed blocks by their size, so store those as is if compression did not help
+			if (data.size() >= raw.size())
+				data = raw;
+		}
+	};
+
+	const uint32_t num_ranges = std::min(num_threads, num_blocks);
+
+	std::vector<std::thread> threads;
+	threads.reserve(num_ranges - 1);
+	for (uint32_t i = 1; i < num_ranges; ++i)
+		threads.emplace_back(encode_blocks, num_blocks * i / num_ranges, num_blocks * (i + 1) / num_ranges);
+	encode_blocks(0, num_blocks / num_ranges);
+	for (std::thread &thread : threads)
+		thread.join();
+
+	out = std::move(header);
+
+	// Offset table with the absolute file position of each block follows the header
+	uint64_t offset = out.size() + num_blocks * sizeof(uint64_t);
+	for (const std::vector<uint8_t> &data : blocks)
+	{
+		append_uint32(out, static_cast<uint32_t>(offset));
+		append_uint32(out, static_cast<uint32_t>(offset >> 32));
+		offset += 8 + data.size();
+	}
+
+	for (uint32_t block = 0; block < num_blocks; ++block)
+	{
+		append_uint32(out, block * lines_per_block);
+		append_uint32(out, static_cast<uint32_t>(blocks[block].size()));
+		out.insert(out.end(), blocks[block].begin(), blocks[block].end());
+		blocks[block].clear();
+		blocks[block].shrink_to_fit();
+	}
+
+	return true;
+}
+
+bool reshade::parse_dds_compressed(const uint8_t *data, size_t size, dds_compressed_desc &desc)
+{
+	const auto read_uint32 = [data](size_t offset) {
+		uint32_t value;
+		std::memcpy(&value, data + offset, sizeof(value));
+		return value;
+	};
+	const auto make_four_cc = [](char a, char b, char c, char d) {
+		return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+	};
+
+	// Magic number followed by a 124 byte 'DDS_HEADER' structure
+	if (size < 128 || read_uint32(0) != make_four_cc('D', 'D', 'S', ' ') || read_uint32(4) != 124)
+		return false;
+	// Uncompressed pixel formats do not have a FourCC code ('DDPF_FOURCC')
+	if ((read_uint32(80) & 0x4) == 0)
+		return false;
+	// Cube maps and volume textures are not supported ('DDSCAPS2_CUBEMAP' and 'DDSCAPS2_VOLUME')
+	if ((read_uint32(112) & (0x200 | 0x200000)) != 0)
+		return false;
+
+	desc.height = read_uint32(12);
+	desc.width = read_uint32(16);
+	// Mipmap count is only valid with the 'DDSD_MIPMAPCOUNT' flag set
+	desc.levels = (read_uint32(8) & 0x20000) != 0 ? std::max(read_uint32(28), 1u) : 1u;
+	desc.data_offset = 128;
+
+	const uint32_t four_cc = read_uint32(84);
+	if (four_cc == make_four_cc('D', 'X', 'T', '1'))
+		desc.format = api::format::bc1_unorm;
+	else if (four_cc == make_four_cc('D', 'X', 'T', '2') || four_cc == make_four_cc('D', 'X', 'T', '3'))
+		desc.format = api::format::bc2_unorm;
+	else if (four_cc == make_four_cc('D', 'X', 'T', '4') || four_cc == make_four_cc('D', 'X', 'T', '5'))
+		desc.format = api::format::bc3_unorm;
+	else if (four_cc == make_four_cc('A', 'T', 'I', '1') || four_cc == make_four_cc('B', 'C', '4', 'U'))
+		desc.format = api::format::bc4_unorm;
+	else if (four_cc == make_four_cc('A', 'T', 'I', '2') || four_cc == make_four_cc('B', 'C', '5', 'U'))
+		desc.format = api::format::bc5_unorm;
+	else if (four_cc == make_four_cc('D', 'X', '1', '0'))
+	{
+		// Followed by a 20 byte 'DDS_HEADER_DXT10' structure, which has to describe a single 2D texture ('D3D10_RESOURCE_DIMENSION_TEXTURE2D' and no 'D3D11_RESOURCE_MISC_TEXTURECUBE')
+		if (size < 148 || read_uint32(132) != 3 || (read_uint32(136) & 0x4) != 0 || read_uint32(140) != 1)
+			return false;
+
+		desc.data_offset = 148;
+
+		// DXGI format values match the format enumeration
+		switch (desc.format = static_cast<api::format>(read_uint32(128)))
+		{
+		case api::format::bc1_unorm:
+		case api::format::bc1_unorm_srgb:
+		case api::format::bc2_unorm:
+		case api::format::bc2_unorm_srgb:
+		case api::format::bc3_unorm:
+		case api::format::bc3_unorm_srgb:
+		case api::format::bc4_unorm:
+		case api::format::bc5_unorm:
+		case api::format::bc7_unorm:
+		case api::format::bc7_unorm_srgb:
+			break;
+		default:
+			return false;
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	if (desc.width == 0 || desc.height == 0 || desc.levels > 32 || (std::max(desc.width, desc.height) >> (desc.levels - 1)) == 0)
+		return false;
+
+	desc.data_size = 0;
+	for (uint32_t level = 0; level < desc.levels; ++level)
+	{
+		const uint32_t width = std::max(desc.width >> level, 1u);
+		const uint32_t height = std::max(desc.height >> level, 1u);
+
+		desc.data_size += api::format_slice_pitch(desc.format, api::format_row_pitch(desc.format, width), height);
+	}
+
+	return true;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "reshade_api_format.hpp"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace reshade
+{
+	/// <summary>
+	/// Checks whether the functions below can convert pixels of the specified <paramref name="format"/>.
+	/// </summary>
+	bool is_convertible_format(api::format format);
+
+	/// <summary>
+	/// Converts pixels of the specified <paramref name="format"/> to 8-bit RGBA.
+	/// Floating-point formats are assumed to contain linear scRGB values, which are encoded to sRGB.
+	/// </summary>
+	/// <param name="row_pitch">Number of bytes between rows in <paramref name="data"/>.</param>
+	/// <param name="pixels">Receives the tightly packed converted pixels.</param>
+	/// <param name="tonemap">Set to <c>true</c> to compress values of floating-point formats above 1.0 into the 8-bit range, instead of clipping them.</param>
+	/// <returns><c>true</c> if the format is supported, <c>false</c> otherwise.</returns>
+	bool convert_pixels_to_rgba8(api::format format, uint32_t width, uint32_t height, const uint8_t *data, uint32_t row_pitch, uint8_t *pixels, bool tonemap = false);
+	/// <summary>
+	/// Converts pixels of the specified <paramref name="format"/> to 16-bit RGBA, which is lossless for all supported integer formats.
+	/// Floating-point formats are encoded to sRGB like in <see cref="convert_pixels_to_rgba8"/>.
+	/// </summary>
+	bool convert_pixels_to_rgba16(api::format format, uint32_t width, uint32_t height, const uint8_t *data, uint32_t row_pitch, uint16_t *pixels, bool tonemap = false);
+	/// <summary>
+	/// Converts pixels of the specified <paramref name="format"/> to linear 16-bit floating-point RGBA.
+	/// Integer formats are assumed to be sRGB encoded, floating-point formats are copied as is.
+	/// </summary>
+	bool convert_pixels_to_rgba16f(api::format format, uint32_t width, uint32_t height, const uint8_t *data, uint32_t row_pitch, uint16_t *pixels);
+
+	/// <summary>
+	/// Converts pixels from BGRA to RGBA channel order (or the other way around).
+	/// </summary>
+	/// <param name="force_opaque">Set to <c>true</c> to set the alpha channel of all pixels to 0xFF.</param>
+	void convert_bgra_to_rgba(const uint8_t *src, uint8_t *dst, size_t num_pixels, bool force_opaque = false);
+
+	/// <summary>
+	/// Removes the alpha channel from RGBA pixels. The source and destination may be the same buffer.
+	/// </summary>
+	void convert_rgba_to_rgb(const uint8_t *src, uint8_t *dst, size_t num_pixels);
+	void convert_rgba_to_rgb(const uint16_t *src, uint16_t *dst, size_t num_pixels);
+
+	/// <summary>
+	/// Encodes an RGB or RGBA image as a PNG file.
+	/// The image is split into horizontal strips that are filtered and compressed on separate threads, with the resulting deflate streams joined into a single one.
+	/// </summary>
+	/// <param name="pixels">Tightly packed pixel data. Channels with 16 bits are expected in native byte order.</param>
+	/// <param name="channels">Number of channels per pixel, either 3 or 4.</param>
+	/// <param name="bits_per_channel">Number of bits per channel, either 8 or 16.</param>
+	/// <param name="out">Receives the encoded PNG file data.</param>
+	/// <param name="num_threads">Number of threads to use, or zero to use all hardware threads.</param>
+	bool encode_png(const void *pixels, uint32_t width, uint32_t height, uint32_t channels, uint32_t bits_per_channel, std::vector<uint8_t> &out, uint32_t num_threads = 0);
+
+	/// <summary>
+	/// Encodes a 16-bit floating-point RGB or RGBA image as an OpenEXR file with ZIP compression.
+	/// </summary>
+	/// <param name="pixels">Tightly packed pixel data.</param>
+	/// <param name="channels">Number of channels per pixel, either 3 or 4.</param>
+	/// <param name="out">Receives the encoded EXR file data.</param>
+	/// <param name="num_threads">Number of threads to use, or zero to use all hardware threads.</param>
+	bool encode_exr(const uint16_t *pixels, uint32_t width, uint32_t height, uint32_t channels, std::vector<uint8_t> &out, uint32_t num_threads = 0);
+
+	/// <summary>
+	/// Describes the layout of the block-compressed pixel data in a DDS file.
+	/// </summary>
+	struct dds_compressed_desc
+	{
+		api::format format = api::format::unknown;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t levels = 0;
+		// Offset of the first mipmap level from the start of the file, with all levels following each other tightly packed
+		size_t data_offset = 0;
+		size_t data_size = 0;
+	};
+
+	/// <summary>
+	/// Parses the header of a DDS file containing a 2D texture in one of the BC1, BC2, BC3, BC4, BC5 or BC7 formats.
+	/// </summary>
+	/// <param name="data">File data, which only has to contain the header (the first 148 bytes).</param>
+	/// <returns><c>true</c> if the file contains a supported block-compressed texture, <c>false</c> otherwise.</returns>
+	bool parse_dds_compressed(const uint8_t *data, size_t size, dds_compressed_desc &desc);
+}
@@ -6,11 +6,127 @@
 #include "ini_file.hpp"
 #include <cassert>
 #include <fstream>
-#include <sstream>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
 
 // TODO: This is unsafe if there are multiple threads accessing the cache simultaneously
 static std::unordered_map<std::wstring, ini_file> s_ini_cache;
 
+// State of the background writer used by 'flush_cache', which is safe to access from any thread
+struct pending_write
+{
+	std::string data;
+	std::filesystem::file_time_type modified_at;
+};
+static std::mutex s_writer_mutex;
+static std::condition_variable s_writer_idle;
+static std::thread s_writer_thread;
+static bool s_writer_active = false;
+static bool s_writer_failed = false;
+// Set by 'stop_flush_thread', after which files are written on the calling thread
+static bool s_writer_stopped = false;
+// Writes are coalesced per file, so only the most recent data is written if a file is modified again before the writer got to it
+static std::unordered_map<std::wstring, pending_write> s_pending_writes;
+static std::unordered_map<std::wstring, std::filesystem::file_time_type> s_written_at;
+static std::vector<std::pair<std::wstring, std::filesystem::file_time_type>> s_completed_writes;
+// Number of writes started per file, which is used to name temporary files and to find writes that were overtaken by a newer one
+static std::unordered_map<std::wstring, uint64_t> s_write_generation;
+
+static bool write_file_atomic(std::unique_lock<std::mutex> &lock, const std::filesystem::path &path, const std::string &data, std::filesystem::file_time_type &modified_at)
+{
+	assert(lock.owns_lock());
+
+	const uint64_t generation = ++s_write_generation[path.wstring()];
+
+	// Write to a temporary file first and then replace the target with it, so that the target is never left partially written
+	// Each write uses its own temporary file, since the writer thread may still be writing to this file when it is saved on another thread (e.g. after 'stop_flush_thread' gave up waiting for it)
+	std::filesystem::path temp_path = path;
+	temp_path += L'.' + std::to_wstring(generation) + L".tmp";
+
+	lock.unlock();
+
+	bool success = false;
+	{
+		std::ofstream file(temp_path);
+		if (file)
+		{
+			file.write(data.data(), data.size());
+
+			// Flush stream to disk before replacing the target
+			file.close();
+			success = !file.fail();
+		}
+	}
+
+	lock.lock();
+
+	std::error_code ec;
+
+	// Replace the target while holding the lock, so that a write that finished late cannot replace data of a newer write
+	if (success && s_write_generation[path.wstring()] != generation)
+	{
+		std::filesystem::remove(temp_path, ec);
+		return true;
+	}
+
+	if (success)
+		std::filesystem::rename(temp_path, path, ec);
+	if (!success || ec)
+	{
+		std::filesystem::remove(temp_path, ec);
+		return false;
+	}
+
+	modified_at = std::filesystem::last_write_time(path, ec);
+
+	assert(std::filesystem::file_size(path, ec) > 0);
+
+	return true;
+}
+
+static void write_pending_files(std::unique_lock<std::mutex> &lock)
+{
+	while (!s_pending_writes.empty())
+	{
+		auto node = s_pending_writes.extract(s_pending_writes.begin());
+		const std::wstring &path = node.key();
+		const pending_write &write = node.mapped();
+
+		// Take into account writes done by this thread, which the cache entry may not have picked up yet
+		std::filesystem::file_time_type expected_modified_at = write.modified_at;
+		if (const auto it = s_written_at.find(path); it != s_written_at.end())
+			expected_modified_at = std::max(expected_modified_at, it->second);
+
+		bool success = false;
+		std::error_code ec;
+		std::filesystem::file_time_type modified_at = std::filesystem::last_write_time(path, ec);
+		// File exists and was modified on disk and therefore may have different data, so cannot save
+		if (ec || modified_at <= expected_modified_at)
+			success = write_file_atomic(lock, path, write.data, modified_at);
+
+		if (success)
+		{
+			s_written_at[path] = modified_at;
+			s_completed_writes.emplace_back(path, modified_at);
+		}
+		else
+		{
+			s_writer_failed = true;
+		}
+	}
+}
+
+static void writer_thread_main()
+{
+	std::unique_lock<std::mutex> lock(s_writer_mutex);
+
+	write_pending_files(lock);
+
+	s_writer_active = false;
+	s_writer_idle.notify_all();
+}
+
 ini_file &reshade::global_config()
 {
 	return ini_file::load_cache(g_target_executable_path.parent_path() / L"ReShade.ini");
@@ -31,22 +147,51 @@ void ini_file::load()
 	// Clear when file does not exist too
 	_sections.clear();
 
-	std::ifstream file;
-	if (file.open(_path); !file)
+	// Read the entire file in one go and tokenize it in place, rather than going line by line
+	std::string data;
+	if (std::ifstream file(_path, std::ios::binary); file)
+	{
+		file.seekg(0, std::ios::end);
+		data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0, std::ios::beg);
+		file.read(data.data(), data.size());
+		data.resize(static_cast<size_t>(file.gcount()));
+	}
+	else
+	{
 		return;
+	}
 
 	_modified = false;
 	_modified_at = modified_at;
 
-	file.imbue(std::locale("en-us.UTF-8"));
+	std::string_view remaining = data;
 	// Remove BOM (0xefbbbf means 0xfeff)
-	if (file.get() != 0xef || file.get() != 0xbb || file.get() != 0xbf)
-		file.seekg(0, std::ios::beg);
+	if (remaining.size() >= 3 && remaining.compare(0, 3, "\xef\xbb\xbf") == 0)
+		remaining.remove_prefix(3);
 
-	std::string line, section;
-	while (std::getline(file, line))
+	const auto trim_view = [](std::string_view str, const char chars[] = " \t") {
+		const size_t first = str.find_first_not_of(chars);
+		if (first == std::string_view::npos)
+			return std::string_view();
+		return str.substr(first, str.find_last_not_of(chars) - first + 1);
+	};
+
+	// Section is only created once the first key in it is encountered
+	std::string_view section_name;
+	ini_file::section *section = nullptr;
+
+	while (!remaining.empty())
 	{
-		trim(line);
+		const size_t line_end = remaining.find('\n');
+		std::string_view line = remaining.substr(0, line_end);
+		remaining.remove_prefix(line_end != std::string_view::npos ? line_end + 1 : remaining.size());
+
+		// Treat CRLF line endings the same as LF
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+
+		line = trim_view(line);
 
 		if (line.empty() || line[0] == ';' || line[0] == '/' || line[0] == '#')
 			continue;
@@ -54,25 +199,29 @@ void ini_file::load()
 		// Read section name
 		if (line[0] == '[')
 		{
-			section = trim(line.substr(0, line.find(']')), " \t[]");
+			section_name = trim_view(line.substr(0, line.find(']')), " \t[]");
+			section = nullptr;
 			continue;
 		}
 
+		if (section == nullptr)
+			section = &_sections[std::string(section_name)];
+
 		// Read section content
-		const auto assign_index = line.find('=');
-		if (assign_index != std::string::npos)
+		const size_t assign_index = line.find('=');
+		if (assign_index != std::string_view::npos)
 		{
-			const std::string key = trim(line.substr(0, assign_index));
-			const std::string value = trim(line.substr(assign_index + 1));
+			const std::string_view key = trim_view(line.substr(0, assign_index));
+			const std::string_view value = trim_view(line.substr(assign_index + 1));
 
 			if (value.empty())
 			{
-				_sections[section].insert({ key, {} });
+				section->emplace(key, ini_file::value());
 				continue;
 			}
 
 			// Append to key if it already exists
-			ini_file::value &elements = _sections[section][key];
+			ini_file::value &elements = (*section)[std::string(key)];
 			for (size_t offset = 0, base = 0, len = value.size(); offset <= len;)
 			{
 				// Treat ",," as an escaped comma and only split on single ","
@@ -101,10 +250,39 @@ void ini_file::load()
 		}
 		else
 		{
-			_sections[section].insert({ line, {} });
+			section->emplace(line, ini_file::value());
 		}
 	}
 }
+void ini_file::queue_save()
+{
+	if (!_modified)
+		return;
+
+	_modified = false;
+
+	// Serialize on the calling thread, so that the writer thread never has to access the cache
+	pending_write write = { serialize(), _modified_at };
+
+	std::unique_lock<std::mutex> lock(s_writer_mutex);
+
+	// Replace any write to this file that is still pending, instead of writing it twice
+	s_pending_writes.insert_or_assign(_path.wstring(), std::move(write));
+
+	if (s_writer_stopped)
+	{
+		write_pending_files(lock);
+	}
+	else if (!s_writer_active)
+	{
+		// Previous writer thread already finished all its work, so this does not block
+		if (s_writer_thread.joinable())
+			s_writer_thread.join();
+
+		s_writer_active = true;
+		s_writer_thread = std::thread(writer_thread_main);
+	}
+}
 bool ini_file::save()
 {
 	if (!_modified)
@@ -113,113 +291,144 @@ bool ini_file::save()
 	// Reset state even on failure to avoid 'flush_cache' repeatedly trying and failing to save
 	_modified = false;
 
+	const std::string data = serialize();
+
+	std::unique_lock<std::mutex> lock(s_writer_mutex);
+
+	// Take into account writes done by the writer thread, which this entry may not have picked up yet
+	if (const auto it = s_written_at.find(_path.wstring()); it != s_written_at.end())
+		_modified_at = std::max(_modified_at, it->second);
+
 	std::error_code ec;
 	const std::filesystem::file_time_type modified_at = std::filesystem::last_write_time(_path, ec);
 	if (!ec && modified_at > _modified_at)
 		return false; // File exists and was modified on disk and therefore may have different data, so cannot save
 
-	std::stringstream data;
-	std::vector<std::string> section_names, key_names;
+	// Drop any queued write to this file, since it would contain older data than what is written now
+	s_pending_writes.erase(_path.wstring());
 
-	section_names.reserve(_sections.size());
-	for (const auto &section : _sections)
-		section_names.push_back(section.first);
-
-	// Sort sections to generate consistent files
-	std::sort(section_names.begin(), section_names.end(),
-		[](std::string a, std::string b) {
-			std::transform(a.begin(), a.end(), a.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
-			std::transform(b.begin(), b.end(), b.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
-			return a < b;
-		});
+	return write_file_atomic(lock, _path, data, _modified_at);
+}
+std::string ini_file::serialize() const
+{
+	std::string data;
 
-	for (const std::string &section_name : section_names)
+	// Sections and keys are already stored in the order they should be written in (case-insensitive), so can just iterate them
+	// Empty section is sorted to the top, so do not need to append it before keys
+	for (const auto &[section_name, keys] : _sections)
 	{
-		const auto &keys = _sections.at(section_name);
-
-		key_names.clear();
-		key_names.reserve(keys.size());
-		for (const auto &key : keys)
-			key_names.push_back(key.first);
-
-		std::sort(key_names.begin(), key_names.end(),
-			[](std::string a, std::string b) {
-				std::transform(a.begin(), a.end(), a.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
-				std::transform(b.begin(), b.end(), b.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
-				return a < b;
-			});
-
-		// Empty section should have been sorted to the top, so do not need to append it before keys
 		if (!section_name.empty())
-			data << '[' << section_name << ']' << '\n';
+		{
+			data += '[';
+			data += section_name;
+			data += ']';
+			data += '\n';
+		}
 
-		for (const std::string &key_name : key_names)
+		for (const auto &[key_name, elements] : keys)
 		{
-			data << key_name << '=';
+			data += key_name;
+			data += '=';
 
-			if (const ini_file::value &elements = keys.at(key_name); !elements.empty())
+			if (!elements.empty())
 			{
-				std::string value;
 				for (const std::string &element : elements)
 				{
-					value.reserve(value.size() + element.size() + 1);
 					for (const char c : element)
-						value.append(c == ',' ? 2 : 1, c);
-					value += ','; // Separate multiple values with a comma
+						data.append(c == ',' ? 2 : 1, c);
+					data += ','; // Separate multiple values with a comma
 				}
 
 				// Remove the last comma
-				value.pop_back();
-
-				data << value;
+				data.pop_back();
 			}
 
-			data << '\n';
+			data += '\n';
 		}
 
-		data << '\n';
+		data += '\n';
 	}
 
-	std::ofstream file(_path);
-	if (!file)
-		return false;
-
-	const std::string str = data.str();
-	file.imbue(std::locale("en-us.UTF-8"));
-	file.write(str.data(), str.size());
-
-	// Flush stream to disk before updating last write time
-	file.close();
-	_modified_at = std::filesystem::last_write_time(_path, ec);
-
-	assert(std::filesystem::file_size(_path, ec) > 0);
-
-	return true;
+	return data;
 }
 
 bool ini_file::flush_cache()
 {
-	bool success = true;
+	std::unique_lock<std::mutex> lock(s_writer_mutex);
+
+	// Pick up the file times of writes the background writer finished, so that they are not mistaken for external modifications
+	for (const auto &[path, modified_at] : s_completed_writes)
+		if (const auto it = s_ini_cache.find(path); it != s_ini_cache.end())
+			it->second._modified_at = std::max(it->second._modified_at, modified_at);
+	s_completed_writes.clear();
+
+	const bool success = !s_writer_failed;
+	s_writer_failed = false;
+
+	lock.unlock();
 
 	// Save all files that were modified in one second intervals
 	for (std::pair<const std::wstring, ini_file> &file : s_ini_cache)
 	{
 		// Check modified status before requesting file time, since the latter is costly and therefore should be avoided when not necessary
 		if (file.second._modified && (std::filesystem::file_time_type::clock::now() - file.second._modified_at) > std::chrono::seconds(1))
-			success &= file.second.save();
+			file.second.queue_save();
 	}
 
 	return success;
 }
 bool ini_file::flush_cache(const std::filesystem::path &path)
 {
-	const auto it = s_ini_cache.find(path);
-	return it != s_ini_cache.end() && it->second.save();
+	const auto it = s_ini_cache.find(path.wstring());
+	if (it == s_ini_cache.end())
+		return false;
+
+	it->second.queue_save();
+	return true;
+}
+void ini_file::wait_for_flush()
+{
+	std::unique_lock<std::mutex> lock(s_writer_mutex);
+	s_writer_idle.wait(lock, []() { return !s_writer_active; });
+}
+void ini_file::flush_cache_and_wait()
+{
+	// Save all modified files right away, rather than waiting for modifications to settle
+	for (std::pair<const std::wstring, ini_file> &file : s_ini_cache)
+		file.second.queue_save();
+
+	std::unique_lock<std::mutex> lock(s_writer_mutex);
+	s_writer_idle.wait(lock, []() { return !s_writer_active; });
+
+	if (s_writer_thread.joinable())
+		s_writer_thread.join();
+}
+void ini_file::stop_flush_thread()
+{
+	std::unique_lock<std::mutex> lock(s_writer_mutex);
+
+	s_writer_stopped = true;
+
+	// Write anything that is still queued on the calling thread, since the writer thread may not get to run anymore
+	write_pending_files(lock);
+
+	// Cannot join here, since a thread cannot exit while the loader lock is held, so give the writer some time to finish the file it is currently writing and then let it go (it is about to exit anyway)
+	// Do not wait indefinitely, in case the writer thread was terminated (which happens to all other threads during process exit)
+	s_writer_idle.wait_for(lock, std::chrono::seconds(1), []() { return !s_writer_active; });
+
+	if (s_writer_thread.joinable())
+		s_writer_thread.detach();
+
+	lock.unlock();
+
+	// Write remaining modifications too, which now happens on the calling thread
+	for (std::pair<const std::wstring, ini_file> &file : s_ini_cache)
+		file.second.queue_save();
 }
 
 ini_file &ini_file::load_cache(const std::filesystem::path &path)
 {
-	const auto it = s_ini_cache.try_emplace(path, path);
+	const auto it = s_ini_cache.try_emplace(path.wstring(), path);
 	std::pair<const std::wstring, ini_file> &file = *it.first;
 
 	// Don't reload file when it was just loaded or there are still modifications pending
@@ -228,3 +437,12 @@ ini_file &ini_file::load_cache(const std::filesystem::path &path)
 
 	return file.second;
 }
+void ini_file::insert_cache(ini_file &&file)
+{
+	const std::wstring path = file._path.wstring();
+	const auto it = s_ini_cache.try_emplace(path, std::move(file)); // This does not move from 'file' if the path is cached already
+
+	// Replace existing entry if it was parsed from an older version of the file, unless it has modifications that were not yet written to disk
+	if (!it.second && !it.first->second._modified && it.first->second._modified_at < file._modified_at)
+		it.first->second = std::move(file);
+}
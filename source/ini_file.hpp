@@ -5,10 +5,11 @@
 
 #pragma once
 
+#include <cctype>
 #include <string>
 #include <vector>
 #include <filesystem>
-#include <unordered_map>
+#include <map>
 
 extern std::filesystem::path g_reshade_dll_path;
 extern std::filesystem::path g_reshade_base_path;
@@ -103,11 +104,7 @@ public:
 	/// Returns <c>true</c> only if the specified <paramref name="section"/> and <paramref name="key"/> exists and is not zero.
 	/// </summary>
 	/// <returns><c>true</c> if the key exists and is not zero, <c>false</c>otherwise.</returns>
-	bool get(const std::string &section, const std::string &key) const
-	{
-		bool value = false;
-		return get<bool>(section, key, value) && value;
-	}
+	bool get(const std::string &section, const std::string &key) const;
 
 	/// <summary>
 	/// Sets the value of the specified <paramref name="section"/> and <paramref name="key"/> to a new <paramref name="value"/>.
@@ -118,19 +115,6 @@ public:
 	{
 		set(section, key, std::to_string(value));
 	}
-	template <>
-	void set(const std::string &section, const std::string &key, const bool &value)
-	{
-		set<std::string>(section, key, value ? "1" : "0");
-	}
-	template <>
-	void set(const std::string &section, const std::string &key, const std::string &value)
-	{
-		auto &v = _sections[section][key];
-		v.assign(1, value);
-		_modified = true;
-		_modified_at = std::filesystem::file_time_type::clock::now();
-	}
 	void set(const std::string &section, const std::string &key, std::string &&value)
 	{
 		auto &v = _sections[section][key];
@@ -139,11 +123,6 @@ public:
 		_modified = true;
 		_modified_at = std::filesystem::file_time_type::clock::now();
 	}
-	template <>
-	void set(const std::string &section, const std::string &key, const std::filesystem::path &value)
-	{
-		set(section, key, value.u8string());
-	}
 	template <typename T, size_t SIZE>
 	void set(const std::string &section, const std::string &key, const T(&values)[SIZE], const size_t size = SIZE)
 	{
@@ -154,14 +133,6 @@ public:
 		_modified = true;
 		_modified_at = std::filesystem::file_time_type::clock::now();
 	}
-	template <>
-	void set(const std::string &section, const std::string &key, const std::vector<std::string> &values)
-	{
-		auto &v = _sections[section][key];
-		v = values;
-		_modified = true;
-		_modified_at = std::filesystem::file_time_type::clock::now();
-	}
 	void set(const std::string &section, const std::string &key, std::vector<std::string> &&values)
 	{
 		auto &v = _sections[section][key];
@@ -169,16 +140,6 @@ public:
 		_modified = true;
 		_modified_at = std::filesystem::file_time_type::clock::now();
 	}
-	template <>
-	void set(const std::string &section, const std::string &key, const std::vector<std::filesystem::path> &values)
-	{
-		auto &v = _sections[section][key];
-		v.resize(values.size());
-		for (size_t i = 0; i < values.size(); ++i)
-			v[i] = values[i].u8string();
-		_modified = true;
-		_modified_at = std::filesystem::file_time_type::clock::now();
-	}
 
 	/// <summary>
 	/// Removes the specified <paramref name="key"/> from the <paramref name="section"/>.
@@ -200,12 +161,31 @@ public:
 	/// Saves all changes to this INI file to disk.
 	/// </summary>
 	bool save();
+	/// <summary>
+	/// Queues all changes to this INI file to be saved to disk on the background writer thread, so that this does not block on disk access.
+	/// </summary>
+	void queue_save();
 
 	/// <summary>
 	/// Saves all changes to INI files that were loaded through <see cref="load_cache"/> to disk.
+	/// The files are written on a background thread, so this does not block on disk access. Use <see cref="wait_for_flush"/> to wait for the writes to finish.
 	/// </summary>
+	/// <returns><c>false</c> if any previously queued write failed, <c>true</c> otherwise.</returns>
 	static bool flush_cache();
 	static bool flush_cache(const std::filesystem::path &path);
+	/// <summary>
+	/// Blocks until all writes queued by <see cref="flush_cache"/> have finished. This may be called from any thread.
+	/// </summary>
+	static void wait_for_flush();
+	/// <summary>
+	/// Saves all changes to INI files that were loaded through <see cref="load_cache"/> to disk right away and waits for the background writer thread to exit.
+	/// </summary>
+	static void flush_cache_and_wait();
+	/// <summary>
+	/// Writes all changes still queued on the calling thread and stops starting background writer threads, after which each save is written immediately.
+	/// This is called when the module is unloaded, where threads cannot be joined because the loader lock is held.
+	/// </summary>
+	static void stop_flush_thread();
 
 	/// <summary>
 	/// Gets the specified INI file from cache or opens it when it was not cached yet.
@@ -214,65 +194,40 @@ public:
 	/// <param name="path">The path to the INI file to access.</param>
 	/// <returns>A reference to the cached data. This reference is valid until the next call to <see cref="load_cache"/>.</returns>
 	static ini_file &load_cache(const std::filesystem::path &path);
+	/// <summary>
+	/// Adds an INI file that was already opened elsewhere (e.g. on a background thread) to the cache.
+	/// If that path is cached already, the cached entry is only replaced if the file was modified on disk since and the entry has no pending modifications.
+	/// </summary>
+	/// <param name="file">The INI file to take ownership of.</param>
+	static void insert_cache(ini_file &&file);
 
 private:
+	std::string serialize() const;
+
 	template <typename T>
 	static const T convert(const std::vector<std::string> &values, size_t i) = delete;
-	template <>
-	static const bool convert(const std::vector<std::string> &values, size_t i)
-	{
-		return convert<int>(values, i) != 0 || i < values.size() && (values[i] == "true" || values[i] == "True" || values[i] == "TRUE");
-	}
-	template <>
-	static const int convert(const std::vector<std::string> &values, size_t i)
-	{
-		return static_cast<int>(convert<long>(values, i));
-	}
-	template <>
-	static const unsigned int convert(const std::vector<std::string> &values, size_t i)
-	{
-		return static_cast<unsigned int>(convert<unsigned long>(values, i));
-	}
-	template <>
-	static const long convert(const std::vector<std::string> &values, size_t i)
-	{
-		return i < values.size() ? std::strtol(values[i].c_str(), nullptr, 10) : 0l;
-	}
-	template <>
-	static const unsigned long convert(const std::vector<std::string> &values, size_t i)
-	{
-		return i < values.size() ? std::strtoul(values[i].c_str(), nullptr, 10) : 0ul;
-	}
-	template <>
-	static const long long convert(const std::vector<std::string> &values, size_t i)
-	{
-		return i < values.size() ? std::strtoll(values[i].c_str(), nullptr, 10) : 0ll;
-	}
-	template <>
-	static const unsigned long long convert(const std::vector<std::string> &values, size_t i)
-	{
-		return i < values.size() ? std::strtoull(values[i].c_str(), nullptr, 10) : 0ull;
-	}
-	template <>
-	static const float convert(const std::vector<std::string> &values, size_t i)
-	{
-		return static_cast<float>(convert<double>(values, i));
-	}
-	template <>
-	static const double convert(const std::vector<std::string> &values, size_t i)
-	{
-		return i < values.size() ? std::strtod(values[i].c_str(), nullptr) : 0.0;
-	}
-	template <>
-	static const std::string convert(const std::vector<std::string> &values, size_t i)
-	{
-		return i < values.size() ? values[i] : std::string();
-	}
-	template <>
-	static const std::filesystem::path convert(const std::vector<std::string> &values, size_t i)
+
+	/// <summary>
+	/// Orders names case-insensitive first (which is the order they are written to disk in), and case-sensitive only to break ties.
+	/// </summary>
+	struct less_case_insensitive
 	{
-		return i < values.size() ? std::filesystem::u8path(values[i]) : std::filesystem::path();
-	}
+		bool operator()(const std::string &lhs, const std::string &rhs) const
+		{
+			const size_t len = lhs.size() < rhs.size() ? lhs.size() : rhs.size();
+			for (size_t i = 0; i < len; ++i)
+			{
+				// Convert back to 'char' and compare like 'std::string' does, to keep the same order that files were always written in
+				const char lhs_c = static_cast<char>(toupper(lhs[i]));
+				const char rhs_c = static_cast<char>(toupper(rhs[i]));
+				if (lhs_c != rhs_c)
+					return std::char_traits<char>::lt(lhs_c, rhs_c);
+			}
+			if (lhs.size() != rhs.size())
+				return lhs.size() < rhs.size();
+			return lhs < rhs;
+		}
+	};
 
 	/// <summary>
 	/// Describes a single value in an INI file.
@@ -281,14 +236,113 @@ private:
 	/// <summary>
 	/// Describes a section of multiple key/value pairs in an INI file.
 	/// </summary>
-	using section = std::unordered_map<std::string, value>;
+	using section = std::map<std::string, value, less_case_insensitive>;
 
 	bool _modified = false;
 	std::filesystem::path _path;
-	std::filesystem::file_time_type _modified_at;
-	std::unordered_map<std::string, section> _sections;
+	// Start at the earliest time rather than the clock epoch, which is not the earliest time on every platform (and would make loading skip files)
+	std::filesystem::file_time_type _modified_at = std::filesystem::file_time_type::min();
+	std::map<std::string, section, less_case_insensitive> _sections;
 };
 
+// Explicit specializations are defined outside the class, since only MSVC accepts them in class scope
+template <>
+inline void ini_file::set<std::string>(const std::string &section, const std::string &key, const std::string &value)
+{
+	auto &v = _sections[section][key];
+	v.assign(1, value);
+	_modified = true;
+	_modified_at = std::filesystem::file_time_type::clock::now();
+}
+template <>
+inline void ini_file::set<bool>(const std::string &section, const std::string &key, const bool &value)
+{
+	set<std::string>(section, key, value ? "1" : "0");
+}
+template <>
+inline void ini_file::set<std::filesystem::path>(const std::string &section, const std::string &key, const std::filesystem::path &value)
+{
+	set(section, key, value.u8string());
+}
+template <>
+inline void ini_file::set<std::vector<std::string>>(const std::string &section, const std::string &key, const std::vector<std::string> &values)
+{
+	auto &v = _sections[section][key];
+	v = values;
+	_modified = true;
+	_modified_at = std::filesystem::file_time_type::clock::now();
+}
+template <>
+inline void ini_file::set<std::vector<std::filesystem::path>>(const std::string &section, const std::string &key, const std::vector<std::filesystem::path> &values)
+{
+	auto &v = _sections[section][key];
+	v.resize(values.size());
+	for (size_t i = 0; i < values.size(); ++i)
+		v[i] = values[i].u8string();
+	_modified = true;
+	_modified_at = std::filesystem::file_time_type::clock::now();
+}
+template <>
+inline const long ini_file::convert<long>(const std::vector<std::string> &values, size_t i)
+{
+	return i < values.size() ? std::strtol(values[i].c_str(), nullptr, 10) : 0l;
+}
+template <>
+inline const unsigned long ini_file::convert<unsigned long>(const std::vector<std::string> &values, size_t i)
+{
+	return i < values.size() ? std::strtoul(values[i].c_str(), nullptr, 10) : 0ul;
+}
+template <>
+inline const long long ini_file::convert<long long>(const std::vector<std::string> &values, size_t i)
+{
+	return i < values.size() ? std::strtoll(values[i].c_str(), nullptr, 10) : 0ll;
+}
+template <>
+inline const unsigned long long ini_file::convert<unsigned long long>(const std::vector<std::string> &values, size_t i)
+{
+	return i < values.size() ? std::strtoull(values[i].c_str(), nullptr, 10) : 0ull;
+}
+template <>
+inline const int ini_file::convert<int>(const std::vector<std::string> &values, size_t i)
+{
+	return static_cast<int>(convert<long>(values, i));
+}
+template <>
+inline const unsigned int ini_file::convert<unsigned int>(const std::vector<std::string> &values, size_t i)
+{
+	return static_cast<unsigned int>(convert<unsigned long>(values, i));
+}
+template <>
+inline const bool ini_file::convert<bool>(const std::vector<std::string> &values, size_t i)
+{
+	return convert<int>(values, i) != 0 || i < values.size() && (values[i] == "true" || values[i] == "True" || values[i] == "TRUE");
+}
+template <>
+inline const double ini_file::convert<double>(const std::vector<std::string> &values, size_t i)
+{
+	return i < values.size() ? std::strtod(values[i].c_str(), nullptr) : 0.0;
+}
+template <>
+inline const float ini_file::convert<float>(const std::vector<std::string> &values, size_t i)
+{
+	return static_cast<float>(convert<double>(values, i));
+}
+template <>
+inline const std::string ini_file::convert<std::string>(const std::vector<std::string> &values, size_t i)
+{
+	return i < values.size() ? values[i] : std::string();
+}
+template <>
+inline const std::filesystem::path ini_file::convert<std::filesystem::path>(const std::vector<std::string> &values, size_t i)
+{
+	return i < values.size() ? std::filesystem::u8path(values[i]) : std::filesystem::path();
+}
+inline bool ini_file::get(const std::string &section, const std::string &key) const
+{
+	bool value = false;
+	return get<bool>(section, key, value) && value;
+}
+
 namespace reshade
 {
 	/// <summary>
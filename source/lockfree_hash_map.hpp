@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2019 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cassert>
+#include <shared_mutex>
+
+/// <summary>
+/// A lock-free open-addressing hash table that grows on demand.
+/// Look ups never take a lock. Adding and removing entries is lock-free too, except while the table is being replaced by a larger one after it filled up.
+/// The key value "zero" and the two largest key values hold a special meaning (see <see cref="no_value"/>, <see cref="update_value"/> and <see cref="erased_value"/>), so do not use them.
+/// </summary>
+template <typename TKey, typename TValue, uint32_t INITIAL_CAPACITY>
+class lockfree_hash_map : lockfree_hash_map<TKey, TValue *, INITIAL_CAPACITY>
+{
+	using base = lockfree_hash_map<TKey, TValue *, INITIAL_CAPACITY>;
+
+public:
+	~lockfree_hash_map()
+	{
+		clear(); // Free all pointers
+	}
+
+	using base::no_value;
+	using base::update_value;
+	using base::erased_value;
+
+	using base::capacity;
+
+	/// <summary>
+	/// Gets the value associated with the specified <paramref name="key"/>.
+	/// This is a weak look up and may fail if another thread is erasing a value at the same time.
+	/// </summary>
+	/// <param name="key">The key to look up.</param>
+	/// <returns>A reference to the associated value.</returns>
+	TValue &at(TKey key) const
+	{
+		TValue *const value = base::at(key);
+		if (value != nullptr)
+			return *value;
+
+		assert(false);
+		return default_value(); // Fall back if key does not exist
+	}
+
+	/// <summary>
+	/// Adds the specified key-value pair to the table.
+	/// </summary>
+	/// <param name="key">The key to add.</param>
+	/// <param name="args">The constructor arguments to use for creation.</param>
+	/// <returns>A reference to the newly added value.</returns>
+	template <typename... Args>
+	TValue &emplace(TKey key, Args... args)
+	{
+		// Create a pointer to the new value using copy construction
+		TValue *const new_value = new TValue(std::forward<Args>(args)...);
+		base::emplace(key, new_value); // This cannot fail, since the table grows when it is full
+		return *new_value;
+	}
+
+	/// <summary>
+	/// Removes the value associated with the specified <paramref name="key"/> from the table.
+	/// </summary>
+	/// <param name="key">The key to look up.</param>
+	/// <returns><c>true</c> if the key existed and was removed, <c>false</c> otherwise.</returns>
+	bool erase(TKey key)
+	{
+		TValue *const old_value = base::erase(key);
+		if (old_value != nullptr)
+		{
+			delete old_value;
+			return true;
+		}
+		return false;
+	}
+	/// <summary>
+	/// Removes and returns the value associated with the specified <paramref name="key"/> from the table.
+	/// </summary>
+	/// <param name="key">The key to look up.</param>
+	/// <param name="value">The value associated with that key.</param>
+	/// <returns><c>true</c> if the key existed and was removed, <c>false</c> otherwise.</returns>
+	bool erase(TKey key, TValue &value)
+	{
+		TValue *const old_value = base::erase(key);
+		if (old_value != nullptr)
+		{
+			// Move value to output argument and delete its pointer (which is no longer in use now)
+			value = std::move(*old_value);
+			delete old_value;
+			return true;
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// Clears the entire table and deletes all keys.
+	/// Note that this must not run concurrently with look ups, since it resets entries to empty and deletes the values.
+	/// </summary>
+	void clear()
+	{
+		base::clear([](TValue *old_value) {
+			// Delete any value attached to the entry, but only if there was one to begin with
+			delete old_value;
+		});
+	}
+
+private:
+	static inline TValue &default_value()
+	{
+		// Make default value thread local, so no data races occur after multiple threads failed to access a value
+		static thread_local TValue _ = {}; return _;
+	}
+};
+
+/// <summary>
+/// Overload of the lock-free table for pointer value types, which avoids an extra indirection and stores the pointers directly.
+/// </summary>
+template <typename TKey, typename TValue, uint32_t INITIAL_CAPACITY>
+class lockfree_hash_map<TKey, TValue *, INITIAL_CAPACITY>
+{
+	static_assert(INITIAL_CAPACITY >= 2 && (INITIAL_CAPACITY & (INITIAL_CAPACITY - 1)) == 0, "Initial capacity has to be a power of two.");
+
+	using TValuePtr = TValue *;
+
+public:
+	lockfree_hash_map()
+	{
+		_table.store(_tables.emplace_back(std::make_unique<table>(INITIAL_CAPACITY)).get(), std::memory_order_relaxed);
+	}
+	~lockfree_hash_map()
+	{
+		clear();
+	}
+
+	lockfree_hash_map(const lockfree_hash_map &) = delete;
+	lockfree_hash_map &operator=(const lockfree_hash_map &) = delete;
+
+	/// <summary>
+	/// Special key indicating that the entry is empty.
+	/// </summary>
+	static constexpr TKey no_value = (TKey)0;
+	/// <summary>
+	/// Special key indicating that the entry is currently being updated.
+	/// Non-dispatchable Vulkan handles may be small integers on some drivers, so the special keys other than zero use values that are neither valid pointers nor handles.
+	/// </summary>
+	static constexpr TKey update_value = (TKey)~0ull;
+	/// <summary>
+	/// Special key indicating that the entry was erased and may be used again (but does not end a probe sequence like an empty entry does).
+	/// </summary>
+	static constexpr TKey erased_value = (TKey)(~0ull - 1);
+
+	/// <summary>
+	/// Gets the pointer associated with the specified <paramref name="key"/>.
+	/// This is a weak look up and may fail if another thread is erasing a value at the same time.
+	/// </summary>
+	/// <param name="key">The key to look up.</param>
+	/// <returns>The pointer associated with the key or <c>nullptr</c> if it was not found.</returns>
+	TValuePtr at(TKey key) const
+	{
+		assert(key != no_value && key != update_value && key != erased_value);
+
+		// This never takes a lock, since tables are never modified anymore after they were replaced by a larger one
+		const table *const t = _table.load(std::memory_order_acquire);
+
+		for (uint32_t i = t->home(hash_key(key)), probe = 0; probe <= t->mask; ++probe, i = (i + 1) & t->mask)
+		{
+			const TKey test_key = t->entries[i].key.load(std::memory_order_acquire);
+			if (test_key == key)
+			{
+				// The pointer is guaranteed to be value at this point, or else key would have been in update mode
+				return t->entries[i].value.load(std::memory_order_relaxed);
+			}
+			if (test_key == no_value)
+			{
+				break; // Entries only become empty again if no key is further along their probe sequence, so the key cannot exist
+			}
+		}
+
+		return nullptr;
+	}
+
+	/// <summary>
+	/// Adds the specified key-pointer pair to the table.
+	/// </summary>
+	/// <param name="key">The key to add.</param>
+	/// <param name="value">The pointer to add.</param>
+	/// <returns>Always <c>true</c>, since the table grows when it is full.</returns>
+	bool emplace(TKey key, TValuePtr value)
+	{
+		assert(key != no_value && key != update_value && key != erased_value);
+
+		const uint64_t hash = hash_key(key);
+
+		while (true)
+		{
+			{
+				// Multiple threads may add or remove entries at the same time, only growing the table is exclusive
+				const std::shared_lock<std::shared_mutex> lock(_grow_mutex);
+
+				if (_table.load(std::memory_order_relaxed)->emplace(hash, key, value))
+					return true;
+			}
+
+			grow();
+		}
+	}
+
+	/// <summary>
+	/// Removes and returns the pointer associated with the specified <paramref name="key"/> from the table.
+	/// </summary>
+	/// <param name="key">The key to look up.</param>
+	/// <returns>The removed pointer if the key existed, <c>nullptr</c> otherwise.</returns>
+	TValuePtr erase(TKey key)
+	{
+		if (key == no_value || key == update_value || key == erased_value) // Cannot remove special keys
+			return nullptr;
+
+		const std::shared_lock<std::shared_mutex> lock(_grow_mutex);
+
+		table *const t = _table.load(std::memory_order_relaxed);
+
+		for (uint32_t i = t->home(hash_key(key)), probe = 0; probe <= t->mask; ++probe, i = (i + 1) & t->mask)
+		{
+			// Load and check before doing an expensive CAS
+			if (TKey test_key = t->entries[i].key.load(std::memory_order_acquire);
+				test_key == key)
+			{
+				// Get the value before freeing the entry up for other threads to fill again
+				const TValuePtr old_value = t->entries[i].value.load(std::memory_order_relaxed);
+
+				if (t->entries[i].key.compare_exchange_strong(test_key, erased_value, std::memory_order_acq_rel))
+				{
+					return old_value;
+				}
+			}
+			else if (test_key == no_value)
+			{
+				break;
+			}
+		}
+
+		return nullptr;
+	}
+
+	/// <summary>
+	/// Clears the entire table.
+	/// Note that this must not run concurrently with look ups, since it resets entries to empty.
+	/// </summary>
+	void clear()
+	{
+		clear([](TValuePtr) {});
+	}
+
+	/// <summary>
+	/// Gets the number of entries in the current table, which is replaced by a larger one once three quarters of them are in use.
+	/// </summary>
+	uint32_t capacity() const
+	{
+		return _table.load(std::memory_order_acquire)->mask + 1;
+	}
+
+protected:
+	template <typename F>
+	void clear(F &&erased_callback)
+	{
+		const std::unique_lock<std::shared_mutex> lock(_grow_mutex);
+
+		table *const t = _table.load(std::memory_order_relaxed);
+
+		for (size_t i = 0; i <= t->mask; ++i)
+		{
+			const TValuePtr old_value = t->entries[i].value.load(std::memory_order_relaxed);
+
+			// Clear this entry so it can be used again
+			if (TKey current_key = t->entries[i].key.exchange(no_value);
+				current_key != no_value && current_key != update_value && current_key != erased_value) // If this in update mode, we can assume the thread updating will reset the key to its intended value
+			{
+				erased_callback(old_value);
+			}
+		}
+
+		t->used.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	struct entry
+	{
+		std::atomic<TKey> key = no_value;
+		std::atomic<TValuePtr> value = nullptr;
+	};
+
+	struct table
+	{
+		explicit table(uint32_t capacity) : mask(capacity - 1), shift(64), entries(new entry[capacity])
+		{
+			while (capacity >>= 1)
+				shift--;
+		}
+
+		bool emplace(uint64_t hash, TKey key, TValuePtr value)
+		{
+			// Only use empty entries while the table is less than three quarters full, to keep probe sequences short (erased entries can always be reused)
+			const bool allow_empty = used.load(std::memory_order_relaxed) < max_used();
+
+			for (uint32_t i = home(hash), probe = 0; probe <= mask; ++probe, i = (i + 1) & mask)
+			{
+				TKey test_key = entries[i].key.load(std::memory_order_relaxed);
+				if (test_key == no_value && !allow_empty)
+					return false;
+
+				if ((test_key == no_value || test_key == erased_value) &&
+					entries[i].key.compare_exchange_strong(test_key, update_value, std::memory_order_acquire))
+				{
+					if (test_key == no_value)
+						used.fetch_add(1, std::memory_order_relaxed);
+
+					entries[i].value.store(value, std::memory_order_relaxed);
+
+					entries[i].key.store(key, std::memory_order_release);
+
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		uint32_t reclaim_erased()
+		{
+			// An erased entry directly before an empty one cannot be part of the probe sequence to any key, so it can safely become empty again
+			// This must not run concurrently with other threads adding entries, but concurrent look ups are fine
+			for (uint32_t i = 0; i <= mask; ++i)
+			{
+				if (entries[i].key.load(std::memory_order_relaxed) != no_value)
+					continue;
+
+				for (uint32_t k = (i - 1) & mask; entries[k].key.load(std::memory_order_relaxed) == erased_value; k = (k - 1) & mask)
+				{
+					entries[k].key.store(no_value, std::memory_order_relaxed);
+					used.fetch_sub(1, std::memory_order_relaxed);
+				}
+			}
+
+			return used.load(std::memory_order_relaxed);
+		}
+
+		// Use the upper bits of the hash, which are mixed best by the multiplicative hashing
+		uint32_t home(uint64_t hash) const { return static_cast<uint32_t>(hash >> shift); }
+		uint32_t max_used() const { return (mask + 1) - (mask + 1) / 4; }
+
+		const uint32_t mask;
+		uint32_t shift;
+		const std::unique_ptr<entry[]> entries;
+		// Number of entries that are not empty (which includes erased entries, since those still take part in probe sequences)
+		std::atomic<uint32_t> used = 0;
+	};
+
+	void grow()
+	{
+		const std::unique_lock<std::shared_mutex> lock(_grow_mutex);
+
+		table *const old_table = _table.load(std::memory_order_relaxed);
+		// Another thread may have grown the table in the meantime
+		if (old_table->used.load(std::memory_order_relaxed) < old_table->max_used())
+			return;
+
+		uint32_t num_entries = 0;
+		for (size_t i = 0; i <= old_table->mask; ++i)
+			if (const TKey key = old_table->entries[i].key.load(std::memory_order_relaxed); key != no_value && key != erased_value)
+				num_entries++;
+
+		// If the table is mostly filled with erased entries (e.g. because objects are frequently recreated), try to reuse those before allocating a new table
+		if (num_entries < (old_table->mask + 1) / 2 && old_table->reclaim_erased() < old_table->max_used())
+			return;
+
+		// Only double the capacity if the table is actually at least half full, otherwise just get rid of erased entries
+		uint32_t new_capacity = old_table->mask + 1;
+		while (num_entries >= new_capacity / 2)
+			new_capacity *= 2;
+
+		table *const new_table = _tables.emplace_back(std::make_unique<table>(new_capacity)).get();
+		for (size_t i = 0; i <= old_table->mask; ++i)
+			if (const TKey key = old_table->entries[i].key.load(std::memory_order_relaxed); key != no_value && key != erased_value)
+				new_table->emplace(hash_key(key), key, old_table->entries[i].value.load(std::memory_order_relaxed));
+
+		// Keep the old table alive, since other threads may still be looking up keys in it
+		_table.store(new_table, std::memory_order_release);
+	}
+
+	static uint64_t hash_key(TKey key)
+	{
+		// Keys are usually pointers or handles, which have their low bits in common, so mix all bits into the upper ones (Fibonacci hashing)
+		return (uint64_t)key * 0x9E3779B97F4A7C15ull;
+	}
+
+	std::atomic<table *> _table;
+	std::vector<std::unique_ptr<table>> _tables;
+	std::shared_mutex _grow_mutex;
+};
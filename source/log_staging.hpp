@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace reshade::log
+{
+	/// <summary>
+	/// Collects finished log lines in a staging buffer per thread, so that threads writing messages only ever take their own (uncontended) lock.
+	/// The lines of all threads are merged back into the order they were staged in when collected for writing.
+	/// </summary>
+	class line_stager
+	{
+	public:
+#ifdef _WIN32
+		static constexpr char line_ending[] = "\r\n";
+#else
+		static constexpr char line_ending[] = "\n";
+#endif
+
+		/// <summary>
+		/// Appends a message to the staging buffer of the calling thread, terminating each line in it with <see cref="line_ending"/>.
+		/// </summary>
+		/// <returns>The number of bytes staged by the calling thread that were not collected yet.</returns>
+		size_t stage(const std::string &message)
+		{
+			staging_buffer &buffer = local_buffer();
+			const uint64_t sequence = _next_sequence.fetch_add(1, std::memory_order_relaxed);
+
+			const std::lock_guard<std::mutex> lock(buffer.mutex);
+
+			// Strings keep their capacity between collections, so this does not allocate once warmed up
+			for (size_t offset = 0, next; offset < message.size(); offset = next + 1)
+			{
+				if ((next = message.find('\n', offset)) == std::string::npos)
+					next = message.size();
+
+				buffer.data.append(message, offset, next - offset);
+				buffer.data.append(line_ending, sizeof(line_ending) - 1);
+			}
+
+			buffer.lines.push_back({ sequence, buffer.data.size() });
+			return buffer.data.size();
+		}
+
+		/// <summary>
+		/// Moves all staged lines of all threads to the end of <paramref name="output"/>, ordered by when they were staged.
+		/// This may not be called concurrently from multiple threads.
+		/// </summary>
+		/// <param name="output">String to append the lines to.</param>
+		/// <param name="wait">Set to <see langword="false"/> to skip the buffers of threads that are currently staging a line, instead of waiting for them.</param>
+		void collect(std::string &output, bool wait = true)
+		{
+			{
+				const std::lock_guard<std::mutex> lock(_buffers_mutex);
+				_collected_buffers = _buffers;
+			}
+
+			_collected_data.clear();
+			_collected_lines.clear();
+
+			for (const std::shared_ptr<staging_buffer> &buffer : _collected_buffers)
+			{
+				std::unique_lock<std::mutex> lock(buffer->mutex, std::defer_lock);
+				if (wait)
+					lock.lock();
+				else if (!lock.try_lock())
+					continue;
+
+				for (size_t i = 0, begin = 0; i < buffer->lines.size(); begin = buffer->lines[i++].end)
+					_collected_lines.push_back({ buffer->lines[i].sequence, _collected_data.size() + begin, _collected_data.size() + buffer->lines[i].end });
+
+				_collected_data += buffer->data;
+
+				buffer->data.clear();
+				buffer->lines.clear();
+			}
+
+			// Lines of each thread are already in order, so this only has to interleave them
+			std::sort(_collected_lines.begin(), _collected_lines.end(),
+				[](const collected_line &lhs, const collected_line &rhs) { return lhs.sequence < rhs.sequence; });
+
+			for (const collected_line &line : _collected_lines)
+				output.append(_collected_data, line.begin, line.end - line.begin);
+
+			_collected_buffers.clear();
+
+			// Remove buffers of threads that exited (which released their reference) once all their lines were collected
+			const std::lock_guard<std::mutex> lock(_buffers_mutex);
+			_buffers.erase(std::remove_if(_buffers.begin(), _buffers.end(),
+				[](const std::shared_ptr<staging_buffer> &buffer) { return buffer.use_count() == 1 && buffer->lines.empty(); }), _buffers.end());
+		}
+
+		/// <summary>
+		/// Gets the number of staging buffers that are currently registered, which is the number of threads that staged lines and did not exit yet or still have lines pending.
+		/// </summary>
+		size_t num_staging_buffers() const
+		{
+			const std::lock_guard<std::mutex> lock(_buffers_mutex);
+			return _buffers.size();
+		}
+
+	private:
+		struct line
+		{
+			uint64_t sequence;
+			size_t end;
+		};
+		struct collected_line
+		{
+			uint64_t sequence;
+			size_t begin, end;
+		};
+		struct staging_buffer
+		{
+			std::mutex mutex;
+			std::string data;
+			std::vector<line> lines;
+		};
+
+		staging_buffer &local_buffer()
+		{
+			// Each thread keeps a reference to its buffer until it exits, after which the buffer is removed on the next collection
+			thread_local struct { const line_stager *owner; std::shared_ptr<staging_buffer> buffer; } local = {};
+			if (local.owner != this || local.buffer == nullptr)
+			{
+				local.owner = this;
+				local.buffer = std::make_shared<staging_buffer>();
+
+				const std::lock_guard<std::mutex> lock(_buffers_mutex);
+				_buffers.push_back(local.buffer);
+			}
+
+			return *local.buffer;
+		}
+
+		std::atomic<uint64_t> _next_sequence = 0;
+		mutable std::mutex _buffers_mutex;
+		std::vector<std::shared_ptr<staging_buffer>> _buffers;
+		// Scratch space for 'collect', which keeps its capacity between calls
+		std::vector<std::shared_ptr<staging_buffer>> _collected_buffers;
+		std::string _collected_data;
+		std::vector<collected_line> _collected_lines;
+	};
+
+	/// <summary>
+	/// Log file that is written through to disk on every write, so that nothing is lost if the application crashes right after.
+	/// </summary>
+	class file_sink
+	{
+	public:
+		file_sink() = default;
+		~file_sink() { close(); }
+
+		file_sink(const file_sink &) = delete;
+		file_sink &operator=(const file_sink &) = delete;
+
+		bool is_open() const
+		{
+#ifdef _WIN32
+			return _handle != INVALID_HANDLE_VALUE;
+#else
+			return _fd >= 0;
+#endif
+		}
+
+		/// <summary>
+		/// Opens the file at the specified <paramref name="path"/> for writing and clears its previous contents, closing any previously open file first.
+		/// </summary>
+		bool open(const std::filesystem::path &path)
+		{
+			close();
+
+#ifdef _WIN32
+			_handle = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, NULL);
+#else
+			_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DSYNC | O_CLOEXEC, 0644);
+#endif
+			return is_open();
+		}
+
+		void close()
+		{
+#ifdef _WIN32
+			if (_handle != INVALID_HANDLE_VALUE)
+				CloseHandle(_handle);
+			_handle = INVALID_HANDLE_VALUE;
+#else
+			if (_fd >= 0)
+				::close(_fd);
+			_fd = -1;
+#endif
+		}
+
+		/// <summary>
+		/// Appends the specified data to the file.
+		/// </summary>
+		bool write(const char *data, size_t size)
+		{
+#ifdef _WIN32
+			DWORD written = 0;
+			return WriteFile(_handle, data, static_cast<DWORD>(size), &written, nullptr) && written == size;
+#else
+			while (size != 0)
+			{
+				const ssize_t written = ::write(_fd, data, size);
+				if (written < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return false;
+				}
+
+				data += written;
+				size -= static_cast<size_t>(written);
+			}
+			return true;
+#endif
+		}
+
+	private:
+#ifdef _WIN32
+		HANDLE _handle = INVALID_HANDLE_VALUE;
+#else
+		int _fd = -1;
+#endif
+	};
+}
@@ -91,6 +91,11 @@ namespace reshade::opengl
 
 		api::command_list *get_immediate_command_list() final { return this; }
 
+		uint64_t get_pending_submission_index() const final { return 0; }
+		uint64_t get_completed_submission_index() const final { return 0; }
+
+		uint64_t get_timestamp_frequency() const final { return 1000000000; }
+
 		void barrier(uint32_t, const api::resource *, const api::resource_usage *, const api::resource_usage *) final { /* no-op */ }
 
 		void begin_render_pass(uint32_t count, const api::render_pass_render_target_desc *rts, const api::render_pass_depth_stencil_desc *ds) final;
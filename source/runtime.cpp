@@ -17,6 +17,8 @@
 #include "input_freepie.hpp"
 #include "com_ptr.hpp"
 #include "process_utils.hpp"
+#include "image_utils.hpp"
+#include "trace_markers.hpp"
 #include <set>
 #include <thread>
 #include <cstring>
@@ -149,11 +151,18 @@ reshade::runtime::~runtime()
 	assert(_worker_threads.empty());
 #if RESHADE_FX
 	assert(!_is_initialized && _techniques.empty());
+	assert(_texture_loader_threads.empty());
+
+	if (_preset_index_thread.joinable())
+		_preset_index_thread.join();
 #endif
 
 	// Save configuration before shutting down to ensure the current window state is written to disk
 	save_config();
 
+	// Make sure the background writer finished, so that it does not outlive the module after the last runtime was destroyed
+	ini_file::flush_cache_and_wait();
+
 #if RESHADE_GUI
 	 deinit_gui();
 #endif
@@ -383,6 +392,9 @@ bool reshade::runtime::on_init(input::window_handle window)
 	else
 		_input = std::make_shared<input>(nullptr);
 
+	// Query the timestamp frequency here rather than when rendering, since this may have to wait for the GPU (the result is cached by the command queue, so this only waits on the first initialization)
+	_timestamp_frequency = _graphics_queue->get_timestamp_frequency();
+
 	// Reset frame count to zero so effects are loaded in 'update_effects'
 	_framecount = 0;
 
@@ -455,10 +467,16 @@ void reshade::runtime::on_reset()
 	else
 		return; // Nothing to do if the runtime was already destroyed or not successfully initialized in the first place
 
+	// Finish any screenshots that are still in flight before the back buffer goes away
+	destroy_screenshot_readbacks();
+
 #if RESHADE_FX
 	// Already performs a wait for idle, so no need to do it again before destroying resources below
 	destroy_effects();
 
+	if (_preset_index_thread.joinable())
+		_preset_index_thread.join();
+
 	_device->destroy_resource(_empty_tex);
 	_empty_tex = {};
 	_device->destroy_resource_view(_empty_srv);
@@ -519,6 +537,8 @@ void reshade::runtime::on_present()
 {
 	assert(is_initialized());
 
+	const trace::scope trace_scope("on_present");
+
 	api::command_list *const cmd_list = _graphics_queue->get_immediate_command_list();
 
 	uint32_t back_buffer_index = get_current_back_buffer_index();
@@ -569,6 +589,7 @@ void reshade::runtime::on_present()
 	_framecount++;
 	const auto current_time = std::chrono::high_resolution_clock::now();
 	_last_frame_duration = current_time - _last_present_time; _last_present_time = current_time;
+	_frame_duration_histogram.append(std::chrono::duration_cast<std::chrono::nanoseconds>(_last_frame_duration).count());
 	_effects_rendered_this_frame = false;
 
 #ifdef NDEBUG
@@ -589,6 +610,11 @@ void reshade::runtime::on_present()
 
 	// All screenshots were created at this point, so reset request
 	_should_save_screenshot = false;
+	if (_screenshot_burst_frames_remaining != 0)
+		_screenshot_burst_frames_remaining--;
+
+	// Hand screenshots of previous frames whose copy finished executing to the writer thread
+	update_screenshot_readbacks(false);
 
 	// Handle keyboard shortcuts
 	if (!_ignore_shortcuts)
@@ -598,6 +624,13 @@ void reshade::runtime::on_present()
 
 		if (_input->is_key_pressed(_screenshot_key_data, _force_shortcut_modifiers))
 			_should_save_screenshot = true; // Remember that we want to save a screenshot next frame
+		if (_input->is_key_pressed(_screenshot_burst_key_data, _force_shortcut_modifiers))
+			_screenshot_burst_frames_remaining = _screenshot_burst_frame_count;
+
+		if (_input->is_key_pressed(_timing_export_key_data, _force_shortcut_modifiers))
+			export_timing_statistics(nullptr);
+		if (_input->is_key_pressed(_trace_capture_key_data, _force_shortcut_modifiers))
+			toggle_trace_capture();
 
 #if RESHADE_FX
 		// Do not allow the following shortcuts while effects are being loaded or initialized (since they affect that state)
@@ -632,6 +665,10 @@ void reshade::runtime::on_present()
 #endif
 	}
 
+	// Keep taking screenshots every frame until the burst is complete
+	if (_screenshot_burst_frames_remaining != 0)
+		_should_save_screenshot = true;
+
 	// Stretch main render target back into MSAA back buffer if MSAA is active or copy when format conversion is required
 	if (_back_buffer_resolved != 0)
 	{
@@ -720,6 +757,9 @@ void reshade::runtime::load_config()
 
 	config.get("INPUT", "ForceShortcutModifiers", _force_shortcut_modifiers);
 	config.get("INPUT", "KeyScreenshot", _screenshot_key_data);
+	config.get("INPUT", "KeyScreenshotBurst", _screenshot_burst_key_data);
+	config.get("INPUT", "KeyTimingExport", _timing_export_key_data);
+	config.get("INPUT", "KeyTraceCapture", _trace_capture_key_data);
 #if RESHADE_FX
 	config.get("INPUT", "KeyEffects", _effects_key_data);
 	config.get("INPUT", "KeyNextPreset", _next_preset_key_data);
@@ -755,10 +795,14 @@ void reshade::runtime::load_config()
 		_current_preset_path = g_reshade_base_path / L"ReShadePreset.ini";
 #endif
 
+	config.get("SCREENSHOT", "BurstFrameCount", _screenshot_burst_frame_count);
 	config.get("SCREENSHOT", "ClearAlpha", _screenshot_clear_alpha);
 	config.get("SCREENSHOT", "FileFormat", _screenshot_format);
 	config.get("SCREENSHOT", "FileNaming", _screenshot_name);
+	config.get("SCREENSHOT", "HDRToneMapping", _screenshot_tonemap_hdr);
+	config.get("SCREENSHOT", "HighBitDepth", _screenshot_high_bit_depth);
 	config.get("SCREENSHOT", "JPEGQuality", _screenshot_jpeg_quality);
+	config.get("SCREENSHOT", "MemoryLimit", _screenshot_memory_limit);
 #if RESHADE_FX
 	config.get("SCREENSHOT", "SaveBeforeShot", _screenshot_save_before);
 #endif
@@ -784,6 +828,9 @@ void reshade::runtime::save_config() const
 
 	config.set("INPUT", "ForceShortcutModifiers", _force_shortcut_modifiers);
 	config.set("INPUT", "KeyScreenshot", _screenshot_key_data);
+	config.set("INPUT", "KeyScreenshotBurst", _screenshot_burst_key_data);
+	config.set("INPUT", "KeyTimingExport", _timing_export_key_data);
+	config.set("INPUT", "KeyTraceCapture", _trace_capture_key_data);
 #if RESHADE_FX
 	config.set("INPUT", "KeyEffects", _effects_key_data);
 	config.set("INPUT", "KeyNextPreset", _next_preset_key_data);
@@ -813,10 +860,14 @@ void reshade::runtime::save_config() const
 	config.set("GENERAL", "PresetTransitionDelay", _preset_transition_delay);
 #endif
 
+	config.set("SCREENSHOT", "BurstFrameCount", _screenshot_burst_frame_count);
 	config.set("SCREENSHOT", "ClearAlpha", _screenshot_clear_alpha);
 	config.set("SCREENSHOT", "FileFormat", _screenshot_format);
 	config.set("SCREENSHOT", "FileNaming", _screenshot_name);
+	config.set("SCREENSHOT", "HDRToneMapping", _screenshot_tonemap_hdr);
+	config.set("SCREENSHOT", "HighBitDepth", _screenshot_high_bit_depth);
 	config.set("SCREENSHOT", "JPEGQuality", _screenshot_jpeg_quality);
+	config.set("SCREENSHOT", "MemoryLimit", _screenshot_memory_limit);
 #if RESHADE_FX
 	config.set("SCREENSHOT", "SaveBeforeShot", _screenshot_save_before);
 #endif
@@ -894,6 +945,7 @@ void reshade::runtime::load_current_preset()
 				rhs_it = std::find(sorted_technique_list.begin(), sorted_technique_list.end(), rhs.name);
 			return lhs_it < rhs_it;
 		});
+	_effect_generation++;
 
 	// Compute times since the transition has started and how much is left till it should end
 	auto transition_time = std::chrono::duration_cast<std::chrono::microseconds>(_last_present_time - _last_preset_switching_time).count();
@@ -1075,15 +1127,50 @@ bool reshade::runtime::switch_to_next_preset(std::filesystem::path filter_path,
 
 	size_t current_preset_index = std::numeric_limits<size_t>::max();
 	std::vector<std::filesystem::path> preset_paths;
+	std::vector<std::filesystem::path> candidate_paths;
 
-	for (std::filesystem::path preset_path : std::filesystem::directory_iterator(filter_path, std::filesystem::directory_options::skip_permission_denied, ec))
+	// Use the results of the background indexer if it covers this folder, so that switching does not have to access the file system at all
+	bool indexed = false;
+	if (const std::unique_lock<std::mutex> lock(_preset_index_mutex, std::try_to_lock);
+		lock.owns_lock() && filter_path == _preset_index_path)
 	{
-		// Skip anything that is not a valid preset file
-		if (!resolve_preset_path(preset_path))
-			continue;
+		indexed = true;
+		candidate_paths = _preset_index_list;
+
+		// Hand over the already parsed preset files, so that loading the next preset does not need to read it from disk again
+		for (ini_file &file : _preset_index_files)
+			ini_file::insert_cache(std::move(file));
+		_preset_index_files.clear();
+	}
+
+	if (!indexed)
+	{
+		// Fall back to scanning the folder if the indexer did not get to it yet
+		for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(filter_path, std::filesystem::directory_options::skip_permission_denied, ec))
+		{
+			std::filesystem::path preset_path = entry.path();
+
+			// Skip anything that is not a valid preset file
+			if (resolve_preset_path(preset_path))
+				candidate_paths.push_back(std::move(preset_path));
+		}
+	}
+
+	// Update index in the background, so that presets that were added or modified since are picked up by the next switch
+	update_preset_index(filter_path);
+
+	// Paths in the index are built the same way as those this function selects, so only have to ask the file system when the current preset was selected some other way
+	auto current_preset_it = std::find(candidate_paths.begin(), candidate_paths.end(), _current_preset_path);
+	if (current_preset_it == candidate_paths.end())
+		current_preset_it = std::find_if(candidate_paths.begin(), candidate_paths.end(), [this, &ec](const std::filesystem::path &preset_path) {
+			return _wcsicmp(preset_path.filename().c_str(), _current_preset_path.filename().c_str()) == 0 && std::filesystem::equivalent(preset_path, _current_preset_path, ec); });
+
+	for (auto it = candidate_paths.begin(); it != candidate_paths.end(); ++it)
+	{
+		std::filesystem::path &preset_path = *it;
 
 		// Keep track of the index of the current preset in the list of found preset files that is being build
-		if (std::filesystem::equivalent(preset_path, _current_preset_path, ec))
+		if (it == current_preset_it)
 		{
 			current_preset_index = preset_paths.size();
 			preset_paths.push_back(std::move(preset_path));
@@ -1119,8 +1206,116 @@ bool reshade::runtime::switch_to_next_preset(std::filesystem::path filter_path,
 
 	return true;
 }
+void reshade::runtime::update_preset_index(std::filesystem::path preset_folder)
+{
+	if (_preset_index_pending || !resolve_path(preset_folder))
+		return; // Indexer is still busy or folder does not exist
+
+	if (_preset_index_thread.joinable())
+		_preset_index_thread.join();
+
+	// Switching to a preset with different preprocessor definitions (or any preset in performance mode) reloads effects
+	// Compile the effects such presets use into the effect cache ahead of time, so that reloading finds the preprocessed source and shader binaries there
+	std::vector<std::filesystem::path> effect_files;
+	if (!_no_effect_cache && _is_initialized && !is_loading())
+		for (const effect &effect : _effects)
+			effect_files.push_back(effect.source_file);
+
+	_preset_index_pending = true;
+	_preset_index_thread = std::thread([this, preset_folder = std::move(preset_folder), effect_files = std::move(effect_files), current_preprocessor_definitions = _preset_preprocessor_definitions]() {
+		// Start from the previous results for this folder, so that only files that were added or modified since are parsed again
+		std::unordered_map<std::wstring, preset_index_entry> previous_index;
+		{
+			const std::lock_guard<std::mutex> lock(_preset_index_mutex);
+			if (preset_folder == _preset_index_path)
+				previous_index = _preset_index;
+		}
 
-bool reshade::runtime::load_effect(const std::filesystem::path &source_file, const ini_file &preset, size_t effect_index, bool preprocess_required)
+		std::unordered_map<std::wstring, preset_index_entry> preset_index;
+		std::vector<std::filesystem::path> preset_list;
+		std::vector<ini_file> preset_files;
+		std::vector<std::vector<std::string>> compiled_variants;
+
+		std::error_code ec;
+		for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(preset_folder, std::filesystem::directory_options::skip_permission_denied, ec))
+		{
+			std::filesystem::path preset_path = entry.path();
+
+			preset_index_entry &result = preset_index[preset_path.native()];
+			result.modified_at = entry.last_write_time(ec);
+
+			if (const auto it = previous_index.find(preset_path.native());
+				it != previous_index.end() && it->second.modified_at == result.modified_at)
+			{
+				if ((result.is_preset = it->second.is_preset))
+					preset_list.push_back(std::move(preset_path));
+				continue;
+			}
+
+			// Same checks as in 'resolve_preset_path', but without going through the INI cache, since that may only be accessed from the main thread
+			if (const std::filesystem::path ext = preset_path.extension();
+				ext != L".ini" && ext != L".txt")
+				continue;
+			if (!resolve_path(preset_path))
+				continue;
+
+			ini_file preset(preset_path);
+			if (!preset.has({}, "Techniques"))
+				continue;
+
+			result.is_preset = true;
+			preset_list.push_back(preset_path);
+
+			std::vector<std::string> preprocessor_definitions;
+			preset.get({}, "PreprocessorDefinitions", preprocessor_definitions);
+
+			// Presets often share the same definitions, so only compile each variant once (in performance mode the preset values are part of the variant too)
+			if (!effect_files.empty() && (_performance_mode || (preprocessor_definitions != current_preprocessor_definitions &&
+				std::find(compiled_variants.begin(), compiled_variants.end(), preprocessor_definitions) == compiled_variants.end())))
+			{
+				precompile_preset_effects(preset, preprocessor_definitions, effect_files);
+				compiled_variants.push_back(std::move(preprocessor_definitions));
+			}
+
+			preset_files.push_back(std::move(preset));
+		}
+
+		const std::lock_guard<std::mutex> lock(_preset_index_mutex);
+		// Files parsed for a different folder are of no use anymore, but those for this one may not have been handed over yet
+		if (preset_folder != _preset_index_path)
+			_preset_index_files.clear();
+		_preset_index_path = preset_folder;
+		_preset_index = std::move(preset_index);
+		_preset_index_list = std::move(preset_list);
+		std::move(preset_files.begin(), preset_files.end(), std::back_inserter(_preset_index_files));
+		_preset_index_pending = false;
+	});
+}
+void reshade::runtime::precompile_preset_effects(const ini_file &preset, const std::vector<std::string> &preprocessor_definitions, const std::vector<std::filesystem::path> &effect_files)
+{
+	std::vector<std::string> techniques;
+	preset.get({}, "Techniques", techniques);
+
+	for (const std::filesystem::path &source_file : effect_files)
+	{
+		// Abort when effects are reloaded or the runtime is reset in the meantime, since the results would not match anymore
+		if (_preset_index_cancel || !_is_initialized || is_loading())
+			break;
+
+		const std::string effect_name = source_file.filename().u8string();
+		if (std::find_if(techniques.cbegin(), techniques.cend(), [&effect_name](const std::string &technique) {
+				const size_t at_pos = technique.find('@') + 1;
+				return at_pos == 0 || technique.find(effect_name, at_pos) == at_pos; }) == techniques.cend())
+			continue; // Effect is not used by this preset, so it is skipped when switching to it
+
+		// This writes the preprocessed source and compiled shader modules to the effect cache, the effect itself is thrown away
+		effect variant;
+		bool source_cached = false;
+		compile_effect(variant, source_file, preset, preprocessor_definitions, std::numeric_limits<size_t>::max(), false, source_cached);
+	}
+}
+
+bool reshade::runtime::compile_effect(effect &effect, const std::filesystem::path &source_file, const ini_file &preset, const std::vector<std::string> &preset_preprocessor_definitions, size_t effect_index, bool preprocess_required, bool &source_cached)
 {
 	// Generate a unique string identifying this effect
 	std::string attributes;
@@ -1161,13 +1356,12 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 
 	std::vector<std::string> preprocessor_definitions = _global_preprocessor_definitions;
 	// Insert preset preprocessor definitions before global ones, so that if there are duplicates, the preset ones are used (since 'add_macro_definition' succeeds only for the first occurance)
-	preprocessor_definitions.insert(preprocessor_definitions.begin(), _preset_preprocessor_definitions.begin(), _preset_preprocessor_definitions.end());
+	preprocessor_definitions.insert(preprocessor_definitions.begin(), preset_preprocessor_definitions.begin(), preset_preprocessor_definitions.end());
 	for (const std::string &definition : preprocessor_definitions)
 		attributes += definition + ';';
 
 	const size_t source_hash = std::hash<std::string>()(attributes);
 
-	effect &effect = _effects[effect_index];
 	const std::string effect_name = source_file.filename().u8string();
 	if (source_file != effect.source_file || source_hash != effect.source_hash)
 	{
@@ -1177,25 +1371,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		effect.source_hash = source_hash;
 	}
 
-	if (_effect_load_skipping && !_load_option_disable_skipping && !_worker_threads.empty()) // Only skip during 'load_effects'
-	{
-		if (std::vector<std::string> techniques;
-			preset.get({}, "Techniques", techniques))
-		{
-			effect.skipped = std::find_if(techniques.cbegin(), techniques.cend(), [&effect_name](const std::string &technique) {
-				const size_t at_pos = technique.find('@') + 1;
-				return at_pos == 0 || technique.find(effect_name, at_pos) == at_pos; }) == techniques.cend();
-
-			if (effect.skipped)
-			{
-				if (_reload_remaining_effects != 0 && _reload_remaining_effects != std::numeric_limits<size_t>::max())
-					_reload_remaining_effects--;
-				return false;
-			}
-		}
-	}
-
-	bool source_cached = false; std::string source;
+	source_cached = false; std::string source;
 	if (!effect.preprocessed && (preprocess_required || (source_cached = load_effect_cache(source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash), "i", source)) == false))
 	{
 		reshadefx::preprocessor pp;
@@ -1313,8 +1489,9 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 			{
 				variable.effect_index = effect_index;
 
-				// Copy initial data into uniform storage area
-				reset_uniform_value(variable);
+				// Copy initial data into uniform storage area (which is looked up through the effect list, so skip this when compiling a variant ahead of time, see 'precompile_preset_effects')
+				if (effect_index != std::numeric_limits<size_t>::max())
+					reset_uniform_value(variable);
 
 				const std::string_view special = variable.annotation_as_string("source");
 				if (special.empty()) /* Ignore if annotation is missing */
@@ -1415,7 +1592,10 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		}
 	}
 
-	if ( effect.compiled && (effect.preprocessed || source_cached))
+	// Textures and techniques of the effect module are registered even if compiling a shader module fails below, so that errors are reported for them too
+	const bool module_generated = effect.compiled && (effect.preprocessed || source_cached);
+
+	if (module_generated)
 	{
 		// Compile shader modules
 		for (const reshadefx::entry_point &entry_point : effect.module.entry_points)
@@ -1687,7 +1867,42 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				std::memcpy(cso.data(), spirv.data(), cso.size());
 			}
 		}
+	}
+
+	return module_generated;
+}
+bool reshade::runtime::load_effect(const std::filesystem::path &source_file, const ini_file &preset, size_t effect_index, bool preprocess_required)
+{
+	const std::string trace_detail = trace::capturing ? source_file.filename().u8string() : std::string();
+	const trace::scope trace_scope("load_effect", trace_detail.c_str());
+
+	effect &effect = _effects[effect_index];
+	const std::string effect_name = source_file.filename().u8string();
+
+	if (_effect_load_skipping && !_load_option_disable_skipping && !_worker_threads.empty()) // Only skip during 'load_effects'
+	{
+		if (std::vector<std::string> techniques;
+			preset.get({}, "Techniques", techniques))
+		{
+			effect.skipped = std::find_if(techniques.cbegin(), techniques.cend(), [&effect_name](const std::string &technique) {
+				const size_t at_pos = technique.find('@') + 1;
+				return at_pos == 0 || technique.find(effect_name, at_pos) == at_pos; }) == techniques.cend();
+
+			if (effect.skipped)
+			{
+				// Effects are always empty during 'load_effects', so only have to remember which file this is
+				effect.source_file = source_file;
+
+				if (_reload_remaining_effects != 0 && _reload_remaining_effects != std::numeric_limits<size_t>::max())
+					_reload_remaining_effects--;
+				return false;
+			}
+		}
+	}
 
+	bool source_cached = false;
+	if (compile_effect(effect, source_file, preset, _preset_preprocessor_definitions, effect_index, preprocess_required, source_cached))
+	{
 		const std::unique_lock<std::shared_mutex> lock(_reload_mutex);
 
 		for (texture new_texture : effect.module.textures)
@@ -1805,6 +2020,9 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		}
 	}
 
+	// Uniforms, textures and techniques may have changed, so rebuild name lookup tables on next use
+	_effect_generation++;
+
 	if (_reload_remaining_effects != 0 && _reload_remaining_effects != std::numeric_limits<size_t>::max())
 		_reload_remaining_effects--;
 	else
@@ -1833,6 +2051,9 @@ bool reshade::runtime::create_effect(size_t effect_index)
 {
 	effect &effect = _effects[effect_index];
 
+	const std::string trace_detail = trace::capturing ? effect.source_file.filename().u8string() : std::string();
+	const trace::scope trace_scope("create_effect", trace_detail.c_str());
+
 	// Create textures now, since they are referenced when building samplers below
 	for (texture &tex : _textures)
 	{
@@ -1858,8 +2079,12 @@ bool reshade::runtime::create_effect(size_t effect_index)
 		spec_constants.push_back(id);
 	}
 
-	// Create query pool for time measurements
-	if (!_device->create_query_pool(api::query_type::timestamp, static_cast<uint32_t>(effect.module.techniques.size() * 2 * 4), &effect.query_pool))
+	// Create query pool for time measurements, with a timestamp before each technique and after each of its passes for every command frame
+	size_t num_queries = 0;
+	for (const reshadefx::technique_info &info : effect.module.techniques)
+		num_queries += (info.passes.size() + 1) * 4;
+
+	if (!_device->create_query_pool(api::query_type::timestamp, static_cast<uint32_t>(num_queries), &effect.query_pool))
 	{
 		effect.compiled = false;
 		_last_reload_successfull = false;
@@ -2072,7 +2297,7 @@ bool reshade::runtime::create_effect(size_t effect_index)
 
 	// Initialize techniques and passes
 	size_t total_pass_index = 0;
-	size_t technique_index_in_effect = 0;
+	uint32_t query_base_index = 0;
 
 	for (technique &tech : _techniques)
 	{
@@ -2081,8 +2306,9 @@ bool reshade::runtime::create_effect(size_t effect_index)
 
 		tech.passes_data.resize(tech.passes.size());
 
-		// Offset index so that a query exists for each command frame and two subsequent ones are used for before/after stamps
-		tech.query_base_index = static_cast<uint32_t>(technique_index_in_effect++ * 2 * 4);
+		// Offset index so that a set of queries exists for each command frame, with one timestamp before the first pass and one after each pass
+		tech.query_base_index = query_base_index;
+		query_base_index += static_cast<uint32_t>((tech.passes.size() + 1) * 4);
 
 		for (size_t pass_index = 0; pass_index < tech.passes.size(); ++pass_index, ++total_pass_index)
 		{
@@ -2372,6 +2598,9 @@ bool reshade::runtime::create_effect(size_t effect_index)
 					else
 					{
 						srv = texture->srv[info.srgb];
+
+						if (texture->compressed_format != api::format::unknown)
+							effect.compressed_texture_to_binding.push_back({ texture->unique_name, write.set, write.binding, sampler_with_resource_view ? sampler_descriptors[info.binding].sampler : api::sampler { 0 }, !!info.srgb });
 					}
 
 					assert(srv != 0);
@@ -2477,6 +2706,7 @@ void reshade::runtime::destroy_effect(size_t effect_index)
 		effect.query_pool = {};
 
 		effect.texture_semantic_to_binding.clear();
+		effect.compressed_texture_to_binding.clear();
 	}
 
 #if RESHADE_GUI
@@ -2506,10 +2736,12 @@ void reshade::runtime::destroy_effect(size_t effect_index)
 			return tech.effect_index == effect_index;
 		}), _techniques.end());
 
+	_effect_generation++;
+
 	// Do not clear effect here, since it is common to be re-used immediately
 }
 
-bool reshade::runtime::create_texture(texture &tex)
+bool reshade::runtime::create_texture(texture &tex, bool allow_compressed)
 {
 	// Do not create resource if it is a special reference, those are set in 'render_technique' and 'update_texture_bindings'
 	if (!tex.semantic.empty())
@@ -2564,6 +2796,15 @@ bool reshade::runtime::create_texture(texture &tex)
 	if (view_format == api::format::unknown)
 		view_format_srgb = view_format = format;
 
+	// Textures that are only sampled from can use the block-compressed data of their image file directly, which is smaller than the uncompressed format declared in the effect
+	tex.compressed_format = allow_compressed ? find_compressed_texture_format(tex) : api::format::unknown;
+	if (tex.compressed_format != api::format::unknown)
+	{
+		format = tex.compressed_format;
+		view_format = api::format_to_default_typed(format, 0);
+		view_format_srgb = api::format_to_default_typed(format, 1);
+	}
+
 	api::resource_usage usage = api::resource_usage::shader_resource;
 	usage |= api::resource_usage::copy_source; // For texture data download
 	if (tex.semantic.empty())
@@ -2574,7 +2815,7 @@ bool reshade::runtime::create_texture(texture &tex)
 		usage |= api::resource_usage::unordered_access;
 
 	api::resource_flags flags = api::resource_flags::none;
-	if (tex.levels > 1)
+	if (tex.levels > 1 && tex.compressed_format == api::format::unknown) // Mipmaps of block-compressed textures are uploaded from the image file instead
 		flags |= api::resource_flags::generate_mipmaps;
 
 	// Clear texture to zero since by default its contents are undefined
@@ -2583,7 +2824,7 @@ bool reshade::runtime::create_texture(texture &tex)
 	for (uint32_t level = 0, width = tex.width; level < tex.levels; ++level, width /= 2)
 	{
 		initial_data[level].data = zero_data.data();
-		initial_data[level].row_pitch = width * 16;
+		initial_data[level].row_pitch = tex.compressed_format != api::format::unknown ? api::format_row_pitch(format, std::max(width, 1u)) : width * 16;
 	}
 
 	if (!_device->create_resource(api::resource_desc(tex.width, tex.height, 1, tex.levels, format, 1, api::memory_heap::gpu_only, usage, flags), initial_data.data(), api::resource_usage::shader_resource, &tex.resource))
@@ -2720,6 +2961,10 @@ void reshade::runtime::disable_technique(technique &tech)
 	tech.time_left = 0;
 	tech.average_cpu_duration.clear();
 	tech.average_gpu_duration.clear();
+	tech.cpu_duration_histogram.clear();
+	tech.gpu_duration_histogram.clear();
+	for (technique::pass_data &pass_data : tech.passes_data)
+		pass_data.gpu_duration_histogram.clear();
 
 	if (status_changed) // Decrease rendering reference count
 		_effects[tech.effect_index].rendering--;
@@ -2774,60 +3019,266 @@ void reshade::runtime::load_effects()
 }
 void reshade::runtime::load_textures()
 {
-	_last_texture_reload_successfull = true;
+	const trace::scope trace_scope("load_textures");
+
+	if (!_textures_loading)
+	{
+		_textures_loading = true;
+		_last_texture_reload_successfull = true;
+
+		// Check the image files again for every load, so that changes to them are picked up
+		_texture_source_lookup.clear();
+
+		LOG(INFO) << "Loading image files for textures ...";
+	}
 
-	LOG(INFO) << "Loading image files for textures ...";
+	// Limit the amount of data uploaded per frame, so that loading many large textures is spread across multiple frames instead of stalling a single one
+	constexpr size_t upload_budget = 16 * 1024 * 1024;
+	size_t upload_size = 0;
+	size_t num_pending = 0;
 
 	for (texture &texture : _textures)
 	{
-		if (texture.resource == 0 || !texture.semantic.empty())
-			continue; // Ignore textures that are not created yet and those that are handled in the runtime implementation
+		if (texture.resource == 0 || !texture.semantic.empty() || texture.loaded)
+			continue; // Ignore textures that are not created yet, those that are handled in the runtime implementation and those that were already loaded
 
-		std::filesystem::path source_path = std::filesystem::u8path(texture.annotation_as_string("source"));
+		const std::string source = std::string(texture.annotation_as_string("source"));
 		// Ignore textures that have no image file attached to them (e.g. plain render targets)
-		if (source_path.empty())
+		if (source.empty())
 			continue;
 
-		// Search for image file using the provided search paths unless the path provided is already absolute
-		if (!find_file(_texture_search_paths, source_path))
+		const bool compressed = texture.compressed_format != api::format::unknown;
+
+		// Block-compressed data is read from every DDS file, but only decode it if a texture needs it
+		auto source_it = _texture_source_lookup.find(source);
+		if (source_it == _texture_source_lookup.end() || (!compressed && source_it->second != nullptr && !source_it->second->decode))
+			source_it = _texture_source_lookup.insert_or_assign(source, request_texture_source(std::filesystem::u8path(source), !compressed)).first;
+
+		const std::shared_ptr<texture_source_image> &image = source_it->second;
+		if (image == nullptr)
+			continue; // Image file was not found, which is reported once all other textures were loaded
+
+		if (!image->decoded.load(std::memory_order_acquire) || (upload_size != 0 && upload_size >= upload_budget))
 		{
-			LOG(ERROR) << "Source " << source_path << " for texture '" << texture.unique_name << "' could not be found in any of the texture search paths!";
-			_last_texture_reload_successfull = false;
+			num_pending++;
 			continue;
 		}
 
-		stbi_uc *filedata = nullptr;
-		int width = 0, height = 0, channels = 0;
+		if (compressed)
+		{
+			// Image file may have changed since the texture was created, so check it still matches
+			if (image->compressed_data.empty() || api::format_to_typeless(image->compressed_format) != texture.compressed_format || image->width != texture.width || image->height != texture.height || image->compressed_levels < texture.levels)
+				continue;
 
-		if (FILE *file; _wfopen_s(&file, source_path.c_str(), L"rb") == 0)
+			update_texture_compressed(texture, image->compressed_data.data());
+
+			upload_size += image->compressed_data.size();
+		}
+		else
 		{
-			// Read texture data into memory in one go since that is faster than reading chunk by chunk
-			std::vector<uint8_t> mem(static_cast<size_t>(std::filesystem::file_size(source_path)));
-			fread(mem.data(), 1, mem.size(), file);
-			fclose(file);
+			if (image->pixels.empty())
+				continue; // Image file could not be decoded, which is reported once all other textures were loaded
 
-			if (stbi_dds_test_memory(mem.data(), static_cast<int>(mem.size())))
-				filedata = stbi_dds_load_from_memory(mem.data(), static_cast<int>(mem.size()), &width, &height, &channels, STBI_rgb_alpha);
-			else
-				filedata = stbi_load_from_memory(mem.data(), static_cast<int>(mem.size()), &width, &height, &channels, STBI_rgb_alpha);
+			update_texture(texture, image->width, image->height, image->pixels.data());
+
+			upload_size += static_cast<size_t>(texture.width) * static_cast<size_t>(texture.height) * 4;
 		}
 
-		if (filedata == nullptr)
-		{
-			LOG(ERROR) << "Source " << source_path << " for texture '" << texture.unique_name << "' could not be loaded! Make sure it is of a compatible file format.";
-			_last_texture_reload_successfull = false;
+		texture.loaded = true;
+	}
+
+	if (num_pending != 0)
+		return;
+
+	for (const texture &texture : _textures)
+	{
+		if (texture.resource == 0 || !texture.semantic.empty() || texture.loaded)
 			continue;
-		}
 
-		update_texture(texture, width, height, filedata);
+		const std::string source = std::string(texture.annotation_as_string("source"));
+		if (source.empty())
+			continue;
 
-		stbi_image_free(filedata);
+		if (const auto source_it = _texture_source_lookup.find(source);
+			source_it == _texture_source_lookup.end() || source_it->second == nullptr)
+			LOG(ERROR) << "Source " << std::filesystem::u8path(source) << " for texture '" << texture.unique_name << "' could not be found in any of the texture search paths!";
+		else
+			LOG(ERROR) << "Source " << source_it->second->path << " for texture '" << texture.unique_name << "' could not be loaded! Make sure it is of a compatible file format.";
 
-		texture.loaded = true;
+		_last_texture_reload_successfull = false;
+	}
+
+	// All images were decoded at this point, so loader threads are about to exit (or already did)
+	for (std::thread &thread : _texture_loader_threads)
+		thread.join();
+	_texture_loader_threads.clear();
+
+	// Release images of files that are no longer referenced since the last reload
+	for (auto it = _texture_source_cache.begin(); it != _texture_source_cache.end();)
+	{
+		if (it->second->generation != _texture_source_generation)
+			it = _texture_source_cache.erase(it);
+		else
+			++it;
+	}
+
+	// All textures were uploaded, so the cache only serves to speed up the next reload, which is not worth running out of memory for (especially in 32-bit processes)
+	constexpr size_t cache_budget = (sizeof(void *) == 4 ? 64 : 512) * 1024 * 1024;
+	std::vector<std::pair<size_t, std::string>> cache_entries;
+	size_t cache_size = 0;
+	for (const auto &[path, image] : _texture_source_cache)
+	{
+		const size_t image_size = image->pixels.size() + image->compressed_data.size();
+		cache_entries.emplace_back(image_size, path);
+		cache_size += image_size;
+	}
+
+	if (cache_size > cache_budget)
+	{
+		// Release the largest images first, so that as many files as possible stay cached
+		std::sort(cache_entries.begin(), cache_entries.end(), std::greater<>());
+		for (auto it = cache_entries.begin(); it != cache_entries.end() && cache_size > cache_budget; ++it)
+		{
+			_texture_source_cache.erase(it->second);
+			cache_size -= it->first;
+		}
 	}
 
+	// Drop references to the images that were uploaded, so that those released from the cache above are freed
+	_texture_source_lookup.clear();
+
+	_textures_loading = false;
 	_textures_loaded = true;
 }
+std::shared_ptr<reshade::runtime::texture_source_image> reshade::runtime::request_texture_source(std::filesystem::path source_path, bool decode)
+{
+	// Search for image file using the provided search paths unless the path provided is already absolute
+	if (!find_file(_texture_search_paths, source_path))
+		return nullptr;
+
+	std::error_code ec;
+	const std::filesystem::file_time_type modified_at = std::filesystem::last_write_time(source_path, ec);
+
+	// Share the decoded image between all textures referencing the same file (even when another texture is still waiting for it to be decoded)
+	std::shared_ptr<texture_source_image> &image = _texture_source_cache[source_path.u8string()];
+	if (image != nullptr && image->modified_at == modified_at)
+	{
+		image->generation = _texture_source_generation;
+		if (image->decode || !decode)
+			return image;
+
+		// Another texture only needed the block-compressed data of this file, so have it decoded as well if it was not picked up by a loader thread yet, rather than reading the file twice
+		const std::unique_lock<std::mutex> lock(_texture_loader_mutex);
+		if (std::find(_texture_loader_queue.begin(), _texture_loader_queue.end(), image) != _texture_loader_queue.end())
+		{
+			image->decode = true;
+			return image;
+		}
+	}
+
+	image = std::make_shared<texture_source_image>();
+	image->path = std::move(source_path);
+	image->modified_at = modified_at;
+	image->decode = decode;
+	image->generation = _texture_source_generation;
+
+	const std::unique_lock<std::mutex> lock(_texture_loader_mutex);
+
+	_texture_loader_queue.push_back(image);
+
+	// Read and decode image files on separate threads, leaving only the upload to the render thread
+	if (_texture_loader_running < std::max<size_t>(std::thread::hardware_concurrency(), 2u) - 1)
+	{
+		_texture_loader_running++;
+		_texture_loader_threads.emplace_back([this]() {
+			std::unique_lock<std::mutex> lock(_texture_loader_mutex);
+			while (!_texture_loader_queue.empty())
+			{
+				const std::shared_ptr<texture_source_image> image = std::move(_texture_loader_queue.front());
+				_texture_loader_queue.pop_front();
+
+				// Read this while still holding the lock, since it may be changed for queued images (see above)
+				const bool decode = image->decode;
+
+				lock.unlock();
+
+				std::error_code ec;
+				const uintmax_t file_size = std::filesystem::file_size(image->path, ec);
+
+				if (FILE *file; !ec && _wfopen_s(&file, image->path.c_str(), L"rb") == 0)
+				{
+					// Read texture data into memory in one go since that is faster than reading chunk by chunk
+					std::vector<uint8_t> mem(static_cast<size_t>(file_size));
+					fread(mem.data(), 1, mem.size(), file);
+					fclose(file);
+
+					if (decode)
+					{
+						stbi_uc *filedata = nullptr;
+						int width = 0, height = 0, channels = 0;
+
+						if (stbi_dds_test_memory(mem.data(), static_cast<int>(mem.size())))
+							filedata = stbi_dds_load_from_memory(mem.data(), static_cast<int>(mem.size()), &width, &height, &channels, STBI_rgb_alpha);
+						else
+							filedata = stbi_load_from_memory(mem.data(), static_cast<int>(mem.size()), &width, &height, &channels, STBI_rgb_alpha);
+
+						if (filedata != nullptr)
+						{
+							image->width = width;
+							image->height = height;
+							image->pixels.assign(filedata, filedata + static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+
+							stbi_image_free(filedata);
+						}
+					}
+
+					// Keep block-compressed data of DDS files, so it can be uploaded without decoding
+					if (dds_compressed_desc desc;
+						parse_dds_compressed(mem.data(), mem.size(), desc) && desc.data_offset + desc.data_size <= mem.size())
+					{
+						image->width = desc.width;
+						image->height = desc.height;
+						image->compressed_format = desc.format;
+						image->compressed_levels = desc.levels;
+						image->compressed_data.assign(mem.begin() + desc.data_offset, mem.begin() + desc.data_offset + desc.data_size);
+					}
+				}
+
+				image->decoded.store(true, std::memory_order_release);
+
+				lock.lock();
+			}
+
+			_texture_loader_running--;
+		});
+	}
+
+	return image;
+}
+void reshade::runtime::abort_texture_loading()
+{
+	{
+		const std::unique_lock<std::mutex> lock(_texture_loader_mutex);
+		_texture_loader_queue.clear();
+	}
+
+	// Wait for images that are currently being decoded
+	for (std::thread &thread : _texture_loader_threads)
+		thread.join();
+	_texture_loader_threads.clear();
+
+	// Images that were still queued will never be decoded now, so remove them from the cache again
+	for (auto it = _texture_source_cache.begin(); it != _texture_source_cache.end();)
+	{
+		if (!it->second->decoded.load(std::memory_order_acquire))
+			it = _texture_source_cache.erase(it);
+		else
+			++it;
+	}
+
+	_texture_source_lookup.clear();
+	_textures_loading = false;
+}
 bool reshade::runtime::reload_effect(size_t effect_index, bool preprocess_required)
 {
 #if RESHADE_GUI
@@ -2858,6 +3309,11 @@ void reshade::runtime::destroy_effects()
 		if (thread.joinable())
 			thread.join();
 	_worker_threads.clear();
+	// The preset indexer may be compiling effects ahead of time with the HLSL compiler that is unloaded below, so stop it after the effect it is currently compiling
+	_preset_index_cancel = true;
+	if (_preset_index_thread.joinable())
+		_preset_index_thread.join();
+	_preset_index_cancel = false;
 
 	for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
 		destroy_effect(effect_index);
@@ -2869,6 +3325,7 @@ void reshade::runtime::destroy_effects()
 
 	// Reset the effect list after all resources have been destroyed
 	_effects.clear();
+	_effect_generation++;
 
 	// Unload HLSL compiler which was previously loaded in 'load_effects' again
 	if (_d3d_compiler_module)
@@ -2881,6 +3338,11 @@ void reshade::runtime::destroy_effects()
 	assert(_textures.empty());
 	assert(_techniques.empty());
 
+	abort_texture_loading();
+
+	// Images that are not used again after the following reload are released once it finished loading textures
+	_texture_source_generation++;
+
 	_textures_loaded = false;
 }
 
@@ -2940,6 +3402,8 @@ void reshade::runtime::clear_effect_cache()
 
 void reshade::runtime::update_effects()
 {
+	const trace::scope trace_scope("update_effects");
+
 	// Delay first load to the first render call to avoid loading while the application is still initializing
 	if (_framecount == 0 && !_no_reload_on_init && !(_no_reload_for_non_vr && !_is_vr))
 		reload_effects();
@@ -2955,6 +3419,9 @@ void reshade::runtime::update_effects()
 		// Finished loading effects, so apply preset to figure out which ones need compiling
 		load_current_preset();
 
+		// Parse the other presets in the same folder ahead of time, so that switching to them is quick
+		update_preset_index(_current_preset_path.parent_path());
+
 		_last_reload_time = std::chrono::high_resolution_clock::now();
 		_reload_remaining_effects = std::numeric_limits<size_t>::max();
 
@@ -3039,6 +3506,8 @@ void reshade::runtime::update_effects()
 }
 void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource_view rtv, api::resource_view rtv_srgb)
 {
+	const trace::scope trace_scope("render_effects");
+
 	_effects_rendered_this_frame = true;
 
 	if (is_loading() || rtv == 0)
@@ -3274,6 +3743,22 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 		}
 	}
 
+	// Skip effects that still wait on image files to be loaded into their textures, rather than rendering with uninitialized texture contents
+	std::vector<bool> effects_loading_textures;
+	if (!_textures_loaded)
+	{
+		effects_loading_textures.resize(_effects.size());
+
+		for (const texture &tex : _textures)
+		{
+			if (tex.resource == 0 || !tex.semantic.empty() || tex.loaded || tex.annotation_as_string("source").empty())
+				continue;
+
+			for (const size_t effect_index : tex.shared)
+				effects_loading_textures[effect_index] = true;
+		}
+	}
+
 #if RESHADE_ADDON
 	invoke_addon_event<addon_event::reshade_begin_effects>(this, cmd_list, rtv, rtv_srgb);
 #endif
@@ -3289,14 +3774,16 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 				disable_technique(tech);
 		}
 
-		if (tech.passes_data.empty() || !tech.enabled)
+		if (tech.passes_data.empty() || !tech.enabled || (!effects_loading_textures.empty() && effects_loading_textures[tech.effect_index]))
 			continue; // Ignore techniques that are not fully loaded or currently disabled
 
 		const auto time_technique_started = std::chrono::high_resolution_clock::now();
 		render_technique(cmd_list, tech, rtv, rtv_srgb);
 		const auto time_technique_finished = std::chrono::high_resolution_clock::now();
 
-		tech.average_cpu_duration.append(std::chrono::duration_cast<std::chrono::nanoseconds>(time_technique_finished - time_technique_started).count());
+		const uint64_t cpu_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(time_technique_finished - time_technique_started).count();
+		tech.average_cpu_duration.append(cpu_duration);
+		tech.cpu_duration_histogram.append(cpu_duration);
 
 		if (tech.time_left > 0)
 		{
@@ -3312,19 +3799,44 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 }
 void reshade::runtime::render_technique(api::command_list *cmd_list, technique &tech, api::resource_view back_buffer_rtv, api::resource_view back_buffer_rtv_srgb)
 {
+	const trace::scope trace_scope("render_technique", tech.name.c_str());
+
 	const effect &effect = _effects[tech.effect_index];
 
+	// Only need to gather GPU statistics if they are actually visible or exported
+	bool gather_gpu_statistics = _gather_timing_statistics || _timing_export_key_data[0] != 0;
 #if RESHADE_GUI
-	if (_gather_gpu_statistics)
+	gather_gpu_statistics |= _gather_gpu_statistics;
+#endif
+
+	const uint32_t num_queries = static_cast<uint32_t>(tech.passes.size() + 1);
+
+	if (gather_gpu_statistics)
 	{
+		if (_timestamp_query_results.size() < num_queries)
+			_timestamp_query_results.resize(num_queries);
+		const uint64_t *const timestamps = _timestamp_query_results.data();
+
 		// Evaluate queries from oldest frame in queue
-		if (uint64_t timestamps[2];
-			_device->get_query_pool_results(effect.query_pool, tech.query_base_index + ((_framecount + 1) % 4) * 2, 2, timestamps, sizeof(uint64_t)))
-			tech.average_gpu_duration.append(timestamps[1] - timestamps[0]);
+		if (_timestamp_frequency != 0 &&
+			_device->get_query_pool_results(effect.query_pool, tech.query_base_index + ((_framecount + 1) % 4) * num_queries, num_queries, _timestamp_query_results.data(), sizeof(uint64_t)))
+		{
+			// Timestamps are in API-specific ticks, but durations are stored in nanoseconds
+			const double nanoseconds_per_tick = 1000000000.0 / _timestamp_frequency;
+			const auto ticks_to_nanoseconds = [nanoseconds_per_tick](uint64_t ticks) {
+				return static_cast<uint64_t>(ticks * nanoseconds_per_tick + 0.5);
+			};
 
-		cmd_list->end_query(effect.query_pool, api::query_type::timestamp, tech.query_base_index + (_framecount % 4) * 2);
+			const uint64_t technique_duration = ticks_to_nanoseconds(timestamps[num_queries - 1] - timestamps[0]);
+			tech.average_gpu_duration.append(technique_duration);
+			tech.gpu_duration_histogram.append(technique_duration);
+
+			for (size_t pass_index = 0; pass_index < tech.passes.size(); ++pass_index)
+				tech.passes_data[pass_index].gpu_duration_histogram.append(ticks_to_nanoseconds(timestamps[pass_index + 1] - timestamps[pass_index]));
+		}
+
+		cmd_list->end_query(effect.query_pool, api::query_type::timestamp, tech.query_base_index + (_framecount % 4) * num_queries);
 	}
-#endif
 
 #ifndef NDEBUG
 	const float debug_event_col[4] = { 1.0f, 0.8f, 0.8f, 1.0f };
@@ -3498,6 +4010,9 @@ void reshade::runtime::render_technique(api::command_list *cmd_list, technique &
 		for (const api::resource_view modified_texture : pass_data.generate_mipmap_views)
 			cmd_list->generate_mipmaps(modified_texture);
 
+		if (gather_gpu_statistics)
+			cmd_list->end_query(effect.query_pool, api::query_type::timestamp, tech.query_base_index + (_framecount % 4) * num_queries + static_cast<uint32_t>(pass_index) + 1);
+
 #ifndef NDEBUG
 		cmd_list->end_debug_event();
 #endif
@@ -3506,30 +4021,55 @@ void reshade::runtime::render_technique(api::command_list *cmd_list, technique &
 #ifndef NDEBUG
 	cmd_list->end_debug_event();
 #endif
-
-#if RESHADE_GUI
-	if (_gather_gpu_statistics)
-		cmd_list->end_query(effect.query_pool, api::query_type::timestamp, tech.query_base_index + (_framecount % 4) * 2 + 1);
-#endif
 }
 
 void reshade::runtime::save_texture(const texture &tex)
 {
-	std::string filename = tex.unique_name;
-	filename += (_screenshot_format == 0 ? ".bmp" : _screenshot_format == 1 ? ".png" : ".jpg");
+	// Block-compressed textures contain the data of their image file as is, which cannot be read back and converted like other formats, so save a copy of that file instead
+	if (tex.compressed_format != api::format::unknown)
+	{
+		std::filesystem::path source_path = std::filesystem::u8path(tex.annotation_as_string("source"));
+		const std::filesystem::path screenshot_path = g_reshade_base_path / _screenshot_path / std::filesystem::u8path(tex.unique_name + ".dds");
 
-	const std::filesystem::path screenshot_path = g_reshade_base_path / _screenshot_path / std::filesystem::u8path(filename);
+		if (!find_file(_texture_search_paths, source_path))
+		{
+			_last_screenshot_time = std::chrono::high_resolution_clock::now();
+			_last_screenshot_file = screenshot_path;
+			_last_screenshot_save_successfull = false;
+			return;
+		}
 
-	_last_screenshot_save_successfull = true;
+		_last_screenshot_save_successfull = true;
 
-	if (std::vector<uint8_t> data(static_cast<size_t>(tex.width) * static_cast<size_t>(tex.height * 4));
-		get_texture_data(tex.resource, api::resource_usage::shader_resource, data.data()))
-	{
-		_worker_threads.emplace_back([this, screenshot_path, data = std::move(data), width = tex.width, height = tex.height]() mutable {
-			// Default to a save failure unless it is reported to succeed below
-			bool save_success = false;
+		_worker_threads.emplace_back([this, source_path = std::move(source_path), screenshot_path]() {
+			std::error_code ec;
+			const bool save_success = std::filesystem::copy_file(source_path, screenshot_path, std::filesystem::copy_options::overwrite_existing, ec);
 
-			if (FILE *file; _wfopen_s(&file, screenshot_path.c_str(), L"wb") == 0)
+			if (_last_screenshot_save_successfull)
+			{
+				_last_screenshot_time = std::chrono::high_resolution_clock::now();
+				_last_screenshot_file = screenshot_path;
+				_last_screenshot_save_successfull = save_success;
+			}
+		});
+		return;
+	}
+
+	std::string filename = tex.unique_name;
+	filename += (_screenshot_format == 0 ? ".bmp" : _screenshot_format == 2 ? ".jpg" : ".png");
+
+	const std::filesystem::path screenshot_path = g_reshade_base_path / _screenshot_path / std::filesystem::u8path(filename);
+
+	_last_screenshot_save_successfull = true;
+
+	if (std::vector<uint8_t> data(static_cast<size_t>(tex.width) * static_cast<size_t>(tex.height * 4));
+		get_texture_data(tex.resource, api::resource_usage::shader_resource, data.data()))
+	{
+		_worker_threads.emplace_back([this, screenshot_path, data = std::move(data), width = tex.width, height = tex.height]() mutable {
+			// Default to a save failure unless it is reported to succeed below
+			bool save_success = false;
+
+			if (FILE *file; _wfopen_s(&file, screenshot_path.c_str(), L"wb") == 0)
 			{
 				const auto write_callback = [](void *context, void *data, int size) {
 					fwrite(data, 1, size, static_cast<FILE *>(context));
@@ -3541,6 +4081,7 @@ void reshade::runtime::save_texture(const texture &tex)
 					save_success = stbi_write_bmp_to_func(write_callback, file, width, height, 4, data.data()) != 0;
 					break;
 				case 1:
+				case 3: // Texture data was already converted to 8 bits per channel, so save as PNG rather than EXR
 				{
 #if 1
 					std::vector<uint8_t> encoded_data;
@@ -3570,6 +4111,10 @@ void reshade::runtime::save_texture(const texture &tex)
 }
 void reshade::runtime::update_texture(texture &tex, const uint32_t width, const uint32_t height, const uint8_t *pixels)
 {
+	// Textures using the block-compressed data of their image file cannot take uncompressed image data (e.g. from add-ons), so switch them to the format declared in the effect first
+	if (tex.compressed_format != api::format::unknown && !recreate_texture_uncompressed(tex))
+		return;
+
 	std::vector<uint8_t> resized(tex.width * tex.height * 4);
 	// Need to potentially resize image data to the texture dimensions
 	if (tex.width != width || tex.height != height)
@@ -3613,6 +4158,143 @@ void reshade::runtime::update_texture(texture &tex, const uint32_t width, const
 	if (tex.levels > 1)
 		cmd_list->generate_mipmaps(tex.srv[0]);
 }
+void reshade::runtime::update_texture_compressed(texture &tex, const uint8_t *data)
+{
+	api::command_list *const cmd_list = _graphics_queue->get_immediate_command_list();
+	cmd_list->barrier(tex.resource, api::resource_usage::shader_resource, api::resource_usage::copy_dest);
+
+	// Upload all mipmap levels, which follow each other tightly packed in the image file
+	for (uint32_t level = 0, width = tex.width, height = tex.height; level < tex.levels; ++level, width = std::max(width / 2, 1u), height = std::max(height / 2, 1u))
+	{
+		const uint32_t row_pitch = api::format_row_pitch(tex.compressed_format, width);
+		const uint32_t slice_pitch = api::format_slice_pitch(tex.compressed_format, row_pitch, height);
+
+		_device->update_texture_region({ data, row_pitch, slice_pitch }, tex.resource, level);
+
+		data += slice_pitch;
+	}
+
+	cmd_list->barrier(tex.resource, api::resource_usage::copy_dest, api::resource_usage::shader_resource);
+}
+bool reshade::runtime::recreate_texture_uncompressed(texture &tex)
+{
+	assert(tex.compressed_format != api::format::unknown);
+
+	LOG(INFO) << "Recreating block-compressed texture '" << tex.unique_name << "' with uncompressed format to upload image data to it ...";
+
+	// Make sure all previous frames have finished before destroying the texture and updating descriptors (since they may be in use otherwise)
+	_graphics_queue->wait_idle();
+
+	const api::resource_view previous_srv = tex.srv[0];
+
+	destroy_texture(tex);
+	const bool success = create_texture(tex, false);
+	if (!success)
+		destroy_texture(tex); // Errors were already logged in 'create_texture'
+
+#if RESHADE_GUI
+	if (_preview_texture == previous_srv)
+		_preview_texture = tex.srv[0];
+#endif
+
+	// Update descriptors of all effects referencing this texture to the new views (or the empty texture, since it is not valid to bind a zero handle)
+	size_t num_bindings = 0;
+	for (const size_t effect_index : tex.shared)
+		num_bindings += _effects[effect_index].compressed_texture_to_binding.size();
+
+	std::vector<api::descriptor_set_update> descriptor_writes;
+	std::vector<api::sampler_with_resource_view> sampler_descriptors(num_bindings);
+
+	for (const size_t effect_index : tex.shared)
+	{
+		for (const auto &binding : _effects[effect_index].compressed_texture_to_binding)
+		{
+			if (binding.semantic != tex.unique_name)
+				continue;
+
+			assert(num_bindings != 0);
+
+			api::descriptor_set_update &write = descriptor_writes.emplace_back();
+			write.set = binding.set;
+			write.binding = binding.index;
+			write.count = 1;
+
+			if (binding.sampler != 0)
+			{
+				write.type = api::descriptor_type::sampler_with_resource_view;
+				write.descriptors = &sampler_descriptors[--num_bindings];
+			}
+			else
+			{
+				write.type = api::descriptor_type::shader_resource_view;
+				write.descriptors = &sampler_descriptors[--num_bindings].view;
+			}
+
+			sampler_descriptors[num_bindings].sampler = binding.sampler;
+			sampler_descriptors[num_bindings].view = success ? tex.srv[binding.srgb] : _empty_srv;
+		}
+	}
+
+	_device->update_descriptor_sets(static_cast<uint32_t>(descriptor_writes.size()), descriptor_writes.data());
+
+	return success;
+}
+reshade::api::format reshade::runtime::find_compressed_texture_format(const texture &tex) const
+{
+	// Render targets and storage textures have to keep the declared format
+	if (tex.render_target || tex.storage_access)
+		return api::format::unknown;
+
+	// D3D9 copies texture data one pixel row at a time, not one block row, which would overrun both the source data and the locked texture for block-compressed formats
+	if (_device->get_api() == api::device_api::d3d9)
+		return api::format::unknown;
+
+	std::filesystem::path source_path = std::filesystem::u8path(tex.annotation_as_string("source"));
+	if (source_path.empty() || !find_file(_texture_search_paths, source_path))
+		return api::format::unknown;
+
+	// Only need the header here, the rest of the file is read later in 'load_textures'
+	uint8_t header[148];
+	size_t header_size = 0;
+	if (FILE *file; _wfopen_s(&file, source_path.c_str(), L"rb") == 0)
+	{
+		header_size = fread(header, 1, sizeof(header), file);
+		fclose(file);
+	}
+
+	dds_compressed_desc desc;
+	if (!parse_dds_compressed(header, header_size, desc))
+		return api::format::unknown;
+
+	// Block-compressed formats can only replace the declared format if sampling them returns the same channels
+	const api::format format = api::format_to_typeless(desc.format);
+	switch (tex.format)
+	{
+	case reshadefx::texture_format::r8:
+		if (format != api::format::bc4_typeless)
+			return api::format::unknown;
+		break;
+	case reshadefx::texture_format::rg8:
+		if (format != api::format::bc5_typeless)
+			return api::format::unknown;
+		break;
+	case reshadefx::texture_format::rgba8:
+		if (format != api::format::bc1_typeless && format != api::format::bc2_typeless && format != api::format::bc3_typeless && format != api::format::bc7_typeless)
+			return api::format::unknown;
+		break;
+	default:
+		return api::format::unknown;
+	}
+
+	// Cannot resize or generate mipmaps for block-compressed data, so the image file has to match the texture exactly (and dimensions have to be a multiple of the block size)
+	if (desc.width != tex.width || desc.height != tex.height || desc.levels < tex.levels || (tex.width % 4) != 0 || (tex.height % 4) != 0)
+		return api::format::unknown;
+
+	if (!_device->check_format_support(api::format_to_default_typed(format, 0), api::resource_usage::shader_resource))
+		return api::format::unknown;
+
+	return format;
+}
 
 void reshade::runtime::reset_uniform_value(uniform &variable)
 {
@@ -3942,6 +4624,8 @@ static std::string expand_macro_string(const std::string &input, std::vector<std
 
 void reshade::runtime::save_screenshot(const std::string &postfix)
 {
+	const trace::scope trace_scope("save_screenshot");
+
 	std::string screenshot_name = expand_macro_string(_screenshot_name, {
 		{ "AppName", g_target_executable_path.stem().u8string() },
 #if RESHADE_FX
@@ -3949,100 +4633,334 @@ void reshade::runtime::save_screenshot(const std::string &postfix)
 #endif
 	});
 
+	// Number the images of a burst, since they are usually all taken within the same second
+	if (_screenshot_burst_frames_remaining != 0)
+	{
+		char burst_index[16];
+		sprintf_s(burst_index, " %.4u", _screenshot_burst_frame_count - _screenshot_burst_frames_remaining);
+		screenshot_name += burst_index;
+	}
+
+	// Extension has to match the format the screenshot is encoded with later, so use the same value for both
+	const unsigned int screenshot_format = _screenshot_format;
+
 	screenshot_name += postfix;
-	screenshot_name += (_screenshot_format == 0 ? ".bmp" : _screenshot_format == 1 ? ".png" : ".jpg");
+	screenshot_name += (screenshot_format == 0 ? ".bmp" : screenshot_format == 1 ? ".png" : screenshot_format == 2 ? ".jpg" : ".exr");
 
 	const std::filesystem::path screenshot_path = g_reshade_base_path / _screenshot_path / std::filesystem::u8path(screenshot_name);
 
+	// Skip screenshots while too many are still waiting to be written, so that bursts cannot use an unbounded amount of memory (but always allow at least one)
+	const size_t reserved_memory = static_cast<size_t>(api::format_row_pitch(_back_buffer_format, _width)) * static_cast<size_t>(_height);
+	if (const size_t memory_usage = _screenshot_memory_usage.load();
+		memory_usage != 0 && memory_usage + reserved_memory > static_cast<size_t>(_screenshot_memory_limit) * 1024 * 1024)
+	{
+		LOG(WARN) << "Skipping screenshot " << screenshot_path << " because the screenshot memory limit of " << _screenshot_memory_limit << " MiB was reached.";
+		return;
+	}
+
 	LOG(INFO) << "Saving screenshot to " << screenshot_path << " ...";
 
 	_last_screenshot_save_successfull = true;
 
-	if (std::vector<uint8_t> data(static_cast<size_t>(_width) * static_cast<size_t>(_height) * 4);
-		capture_screenshot(data.data()))
+	const api::resource resource = _back_buffer_resolved != 0 ? _back_buffer_resolved : get_current_back_buffer();
+	const api::resource_usage state = _back_buffer_resolved != 0 ? api::resource_usage::render_target : api::resource_usage::present;
+
+	pending_screenshot &screenshot = _pending_screenshots.emplace_back();
+
+	// Reuse readback resources of previous screenshots where possible, so that bursts do not create new resources every frame
+	// The format has to match too, since the back buffer format can change without its size changing (e.g. when toggling HDR)
+	const api::resource_desc desc = _device->get_resource_desc(resource);
+	const api::format view_format = api::format_to_default_typed(desc.texture.format, 0);
+	if (const auto it = std::find_if(_free_screenshot_readbacks.begin(), _free_screenshot_readbacks.end(),
+			[&desc, view_format](const texture_readback &readback) { return readback.format == view_format && readback.width == desc.texture.width && readback.height == desc.texture.height; });
+		it != _free_screenshot_readbacks.end())
 	{
+		screenshot.readback = *it;
+		_free_screenshot_readbacks.erase(it);
+	}
+	else if (!create_texture_readback(resource, screenshot.readback))
+	{
+		_pending_screenshots.pop_back();
+		return;
+	}
+
+	// Only record the copy here and read it back once it finished executing, so that this does not have to wait for the GPU
+	record_texture_readback(_graphics_queue->get_immediate_command_list(), resource, state, screenshot.readback);
+
+	screenshot.frame = _framecount;
+	screenshot.submission_index = _graphics_queue->get_pending_submission_index();
+	screenshot.path = screenshot_path;
 #if RESHADE_FX
-		const bool include_preset = _screenshot_include_preset && postfix.empty() && ini_file::flush_cache(_current_preset_path);
-#else
-		const bool include_preset = false;
+	if (_screenshot_include_preset && postfix.empty() && ini_file::flush_cache(_current_preset_path))
+		screenshot.preset_path = _current_preset_path;
 #endif
+	screenshot.format = screenshot_format;
+	screenshot.jpeg_quality = _screenshot_jpeg_quality;
+	screenshot.clear_alpha = _screenshot_clear_alpha;
+	screenshot.tonemap_hdr = _screenshot_tonemap_hdr;
+	screenshot.high_bit_depth = _screenshot_high_bit_depth;
+	screenshot.reserved_memory = reserved_memory;
+	_screenshot_memory_usage += reserved_memory;
+}
+void reshade::runtime::update_screenshot_readbacks(bool wait_for_all)
+{
+	// Copies are executed when the immediate command list is flushed at the end of present, so after a few frames they have usually finished and mapping does not stall (which it would in D3D9, D3D10, D3D11 and OpenGL)
+	constexpr unsigned long long readback_latency = 3;
 
-		_worker_threads.emplace_back([this, screenshot_path, data = std::move(data), include_preset]() mutable {
-			// Remove alpha channel
-			int comp = 4;
-			if (_screenshot_clear_alpha)
-			{
-				comp = 3;
-				for (size_t i = 0; i < _width * _height; ++i)
-					*reinterpret_cast<uint32_t *>(data.data() + 3 * i) = *reinterpret_cast<const uint32_t *>(data.data() + 4 * i);
-			}
+	// Return readback resources the writer thread is done with, so that they can be reused for the next screenshots
+	{
+		const std::unique_lock<std::mutex> lock(_screenshot_writer_mutex);
 
-			// Create screenshot directory if it does not exist
-			if (std::error_code ec; !std::filesystem::exists(screenshot_path.parent_path(), ec))
-				_screenshot_directory_creation_successfull = std::filesystem::create_directories(screenshot_path.parent_path(), ec);
-			else
-				_screenshot_directory_creation_successfull = true;
+		for (const texture_readback &readback : _copied_screenshot_readbacks)
+		{
+			unmap_texture_readback(readback);
+			_free_screenshot_readbacks.push_back(readback);
+		}
+		_copied_screenshot_readbacks.clear();
+	}
 
-			// Default to a save failure unless it is reported to succeed below
-			bool save_success = false;
+	if (_pending_screenshots.empty())
+		return;
 
-			if (FILE *file; _wfopen_s(&file, screenshot_path.c_str(), L"wb") == 0)
-			{
-				const auto write_callback = [](void *context, void *data, int size) {
-					fwrite(data, 1, size, static_cast<FILE *>(context));
-				};
+	if (wait_for_all)
+		_graphics_queue->wait_idle();
 
-				switch (_screenshot_format)
-				{
-				case 0:
-					save_success = stbi_write_bmp_to_func(write_callback, file, _width, _height, comp, data.data()) != 0;
-					break;
-				case 1:
-				{
-#if 1
-					std::vector<uint8_t> encoded_data;
-					save_success = fpng::fpng_encode_image_to_memory(data.data(), _width, _height, comp, encoded_data);
-					fwrite(encoded_data.data(), 1, encoded_data.size(), file);
-#else
-					save_success = stbi_write_png_to_func(write_callback, file, _width, _height, comp, data.data(), 0) != 0;
-#endif
-					break;
-				}
-				case 2:
-					save_success = stbi_write_jpg_to_func(write_callback, file, _width, _height, comp, data.data(), _screenshot_jpeg_quality) != 0;
-					break;
-				}
+	const uint64_t completed_submission_index = _graphics_queue->get_completed_submission_index();
 
-				fclose(file);
-			}
+	size_t num_ready = 0;
+	for (pending_screenshot &screenshot : _pending_screenshots)
+	{
+		// Mapping does not wait for the copy to finish in D3D12 and Vulkan, so also check that its submission completed
+		if (!wait_for_all && (_framecount - screenshot.frame < readback_latency || screenshot.submission_index > completed_submission_index))
+			break; // Screenshots are ordered by frame, so all following ones are not ready yet either
 
-			if (save_success)
-			{
-				execute_screenshot_post_save_command(screenshot_path);
+		// Only map here, the writer thread copies the pixels out of the mapped memory, since that takes a while for large images
+		if (!map_texture_readback(screenshot.readback, screenshot.mapped_data))
+		{
+			_free_screenshot_readbacks.push_back(screenshot.readback);
+			screenshot.readback.intermediate = {};
+		}
 
-#if RESHADE_FX
-				if (include_preset)
+		num_ready++;
+	}
+
+	if (num_ready == 0)
+		return;
+
+	{
+		const std::unique_lock<std::mutex> lock(_screenshot_writer_mutex);
+
+		std::move(_pending_screenshots.begin(), _pending_screenshots.begin() + num_ready, std::back_inserter(_screenshot_writer_queue));
+
+		// Convert and encode images on a separate thread, since that takes much longer than a frame
+		if (!_screenshot_writer_thread.joinable())
+		{
+			_screenshot_writer_exit = false;
+			_screenshot_writer_thread = std::thread([this]() {
+				std::unique_lock<std::mutex> lock(_screenshot_writer_mutex);
+				while (true)
 				{
-					std::filesystem::path screenshot_preset_path = screenshot_path;
-					screenshot_preset_path.replace_extension(L".ini");
+					_screenshot_writer_condition.wait(lock, [this]() { return _screenshot_writer_exit || !_screenshot_writer_queue.empty(); });
+					// Write all remaining screenshots before exiting
+					if (_screenshot_writer_queue.empty())
+						break;
+
+					pending_screenshot screenshot = std::move(_screenshot_writer_queue.front());
+					_screenshot_writer_queue.pop_front();
+
+					if (screenshot.readback.intermediate != 0)
+					{
+						lock.unlock();
+
+						const uint32_t data_row_pitch = api::format_row_pitch(screenshot.readback.format, screenshot.readback.width);
+						screenshot.data.resize(static_cast<size_t>(data_row_pitch) * screenshot.readback.height);
+
+						auto mapped_pixels = static_cast<const uint8_t *>(screenshot.mapped_data.data);
+						for (uint32_t y = 0; y < screenshot.readback.height; ++y, mapped_pixels += screenshot.mapped_data.row_pitch)
+							std::memcpy(screenshot.data.data() + y * data_row_pitch, mapped_pixels, data_row_pitch);
 
-					// Preset was flushed to disk, so can just copy it over to the new location
-					std::error_code ec; std::filesystem::copy_file(_current_preset_path, screenshot_preset_path, std::filesystem::copy_options::overwrite_existing, ec);
+						lock.lock();
+						// Readback resource has to be unmapped on the render thread again
+						_copied_screenshot_readbacks.push_back(screenshot.readback);
+					}
+
+					lock.unlock();
+					write_screenshot(screenshot);
+					_screenshot_memory_usage -= screenshot.reserved_memory;
+					lock.lock();
 				}
-#endif
-			}
+			});
+		}
+	}
+
+	_pending_screenshots.erase(_pending_screenshots.begin(), _pending_screenshots.begin() + num_ready);
+
+	_screenshot_writer_condition.notify_one();
+}
+void reshade::runtime::destroy_screenshot_readbacks()
+{
+	// Read back and write any screenshots that are still in flight, rather than dropping them
+	update_screenshot_readbacks(true);
+
+	if (_screenshot_writer_thread.joinable())
+	{
+		{
+			const std::unique_lock<std::mutex> lock(_screenshot_writer_mutex);
+			_screenshot_writer_exit = true;
+		}
+
+		_screenshot_writer_condition.notify_one();
+		_screenshot_writer_thread.join();
+	}
+
+	for (const texture_readback &readback : _copied_screenshot_readbacks)
+	{
+		unmap_texture_readback(readback);
+		_free_screenshot_readbacks.push_back(readback);
+	}
+	_copied_screenshot_readbacks.clear();
+
+	for (const texture_readback &readback : _free_screenshot_readbacks)
+		_device->destroy_resource(readback.intermediate);
+	_free_screenshot_readbacks.clear();
+
+	_screenshot_burst_frames_remaining = 0;
+}
+void reshade::runtime::write_screenshot(pending_screenshot &screenshot)
+{
+	const trace::scope trace_scope("write_screenshot");
+
+	const api::format format = screenshot.readback.format;
+	const uint32_t width = screenshot.readback.width;
+	const uint32_t height = screenshot.readback.height;
+	const size_t num_pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+
+	// Default to a save failure unless it is reported to succeed below
+	bool save_success = false;
+
+	// Keep 16 bits per channel for EXR and for PNG from high bit depth back buffers, everything else is converted to 8 bits per channel
+	std::vector<uint8_t> pixels;
+	std::vector<uint16_t> pixels_16;
+	if (!screenshot.data.empty())
+	{
+		const bool high_bit_depth =
+			format == api::format::r10g10b10a2_unorm ||
+			format == api::format::b10g10r10a2_unorm ||
+			format == api::format::r16g16b16a16_unorm ||
+			format == api::format::r16g16b16a16_float;
+
+		const uint32_t row_pitch = api::format_row_pitch(format, width);
+
+		if (screenshot.format == 3)
+		{
+			pixels_16.resize(num_pixels * 4);
+			convert_pixels_to_rgba16f(format, width, height, screenshot.data.data(), row_pitch, pixels_16.data());
+		}
+		else if (screenshot.format == 1 && screenshot.high_bit_depth && high_bit_depth)
+		{
+			pixels_16.resize(num_pixels * 4);
+			convert_pixels_to_rgba16(format, width, height, screenshot.data.data(), row_pitch, pixels_16.data(), screenshot.tonemap_hdr);
+		}
+		else
+		{
+			pixels.resize(num_pixels * 4);
+			convert_pixels_to_rgba8(format, width, height, screenshot.data.data(), row_pitch, pixels.data(), screenshot.tonemap_hdr);
+		}
+
+		// Release the packed data early, since bursts can have many screenshots in flight
+		screenshot.data.clear();
+		screenshot.data.shrink_to_fit();
+	}
+
+	if (!pixels.empty() || !pixels_16.empty())
+	{
+		// Remove alpha channel
+		int comp = 4;
+		if (screenshot.clear_alpha)
+		{
+			comp = 3;
+			if (!pixels_16.empty())
+				convert_rgba_to_rgb(pixels_16.data(), pixels_16.data(), num_pixels);
 			else
+				convert_rgba_to_rgb(pixels.data(), pixels.data(), num_pixels);
+		}
+
+		// Create screenshot directory if it does not exist
+		if (std::error_code ec; !std::filesystem::exists(screenshot.path.parent_path(), ec))
+			_screenshot_directory_creation_successfull = std::filesystem::create_directories(screenshot.path.parent_path(), ec);
+		else
+			_screenshot_directory_creation_successfull = true;
+
+		if (FILE *file; _wfopen_s(&file, screenshot.path.c_str(), L"wb") == 0)
+		{
+			const auto write_callback = [](void *context, void *data, int size) {
+				fwrite(data, 1, size, static_cast<FILE *>(context));
+			};
+
+			switch (screenshot.format)
 			{
-				LOG(ERROR) << "Failed to write screenshot to " << screenshot_path << '!';
+			case 0:
+				save_success = stbi_write_bmp_to_func(write_callback, file, width, height, comp, pixels.data()) != 0;
+				break;
+			case 1:
+			{
+#if 1
+				std::vector<uint8_t> encoded_data;
+				// Large screenshots are split into strips that are compressed in parallel, smaller ones are encoded faster on a single thread
+				if (!pixels_16.empty())
+					save_success = encode_png(pixels_16.data(), width, height, comp, 16, encoded_data);
+				else if (num_pixels >= 2560 * 1440 && std::thread::hardware_concurrency() >= 4)
+					save_success = encode_png(pixels.data(), width, height, comp, 8, encoded_data);
+				else
+					save_success = fpng::fpng_encode_image_to_memory(pixels.data(), width, height, comp, encoded_data);
+				fwrite(encoded_data.data(), 1, encoded_data.size(), file);
+#else
+				save_success = stbi_write_png_to_func(write_callback, file, width, height, comp, pixels.data(), 0) != 0;
+#endif
+				break;
 			}
-
-			if (_last_screenshot_save_successfull)
+			case 2:
+				save_success = stbi_write_jpg_to_func(write_callback, file, width, height, comp, pixels.data(), screenshot.jpeg_quality) != 0;
+				break;
+			case 3:
 			{
-				_last_screenshot_time = std::chrono::high_resolution_clock::now();
-				_last_screenshot_file = screenshot_path;
-				_last_screenshot_save_successfull = save_success;
+				std::vector<uint8_t> encoded_data;
+				save_success = encode_exr(pixels_16.data(), width, height, comp, encoded_data);
+				fwrite(encoded_data.data(), 1, encoded_data.size(), file);
+				break;
 			}
-		});
+			}
+
+			fclose(file);
+		}
+	}
+
+	if (save_success)
+	{
+		execute_screenshot_post_save_command(screenshot.path);
+
+#if RESHADE_FX
+		if (!screenshot.preset_path.empty())
+		{
+			std::filesystem::path screenshot_preset_path = screenshot.path;
+			screenshot_preset_path.replace_extension(L".ini");
+
+			// Wait for the preset to be flushed to disk, then can just copy it over to the new location
+			ini_file::wait_for_flush();
+			std::error_code ec; std::filesystem::copy_file(screenshot.preset_path, screenshot_preset_path, std::filesystem::copy_options::overwrite_existing, ec);
+		}
+#endif
+	}
+	else
+	{
+		LOG(ERROR) << "Failed to write screenshot to " << screenshot.path << '!';
+	}
+
+	if (_last_screenshot_save_successfull)
+	{
+		_last_screenshot_time = std::chrono::high_resolution_clock::now();
+		_last_screenshot_file = screenshot.path;
+		_last_screenshot_save_successfull = save_success;
 	}
 }
 bool reshade::runtime::execute_screenshot_post_save_command(const std::filesystem::path &screenshot_path)
@@ -4096,148 +5014,222 @@ bool reshade::runtime::execute_screenshot_post_save_command(const std::filesyste
 	}
 }
 
-bool reshade::runtime::get_texture_data(api::resource resource, api::resource_usage state, uint8_t *pixels)
+bool reshade::runtime::save_timing_statistics(const std::filesystem::path &path) const
+{
+	std::filesystem::path statistics_path = path;
+	if (statistics_path.empty())
+	{
+		std::string statistics_name = expand_macro_string(_screenshot_name, {
+			{ "AppName", g_target_executable_path.stem().u8string() },
+#if RESHADE_FX
+			{ "PresetName",  _current_preset_path.stem().u8string() },
+#endif
+		});
+		statistics_name += " timing.csv";
+
+		statistics_path = g_reshade_base_path / _screenshot_path / std::filesystem::u8path(statistics_name);
+	}
+
+	FILE *file = nullptr;
+	if (_wfopen_s(&file, statistics_path.c_str(), L"w") != 0)
+	{
+		LOG(ERROR) << "Failed to open " << statistics_path << " for writing timing statistics!";
+		return false;
+	}
+
+	// Names are quoted, but not escaped, since neither file names nor identifiers can contain quotation marks
+	const auto write_row = [file](const char *scope, const std::string &effect_name, const std::string &technique_name, const std::string &pass_name, const char *clock, const duration_histogram &histogram) {
+		if (histogram.count() == 0)
+			return;
+
+		fprintf(file, "%s,\"%s\",\"%s\",\"%s\",%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+			scope, effect_name.c_str(), technique_name.c_str(), pass_name.c_str(), clock,
+			histogram.count(),
+			histogram.mean() * 1e-6,
+			histogram.percentile(50) * 1e-6,
+			histogram.percentile(95) * 1e-6,
+			histogram.percentile(99) * 1e-6,
+			histogram.max() * 1e-6);
+	};
+
+	fputs("scope,effect,technique,pass,clock,samples,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n", file);
+
+	write_row("frame", std::string(), std::string(), std::string(), "cpu", _frame_duration_histogram);
+
+#if RESHADE_FX
+	for (const technique &tech : _techniques)
+	{
+		if (tech.passes_data.empty())
+			continue;
+
+		const std::string effect_name = _effects[tech.effect_index].source_file.filename().u8string();
+
+		write_row("technique", effect_name, tech.name, std::string(), "cpu", tech.cpu_duration_histogram);
+		write_row("technique", effect_name, tech.name, std::string(), "gpu", tech.gpu_duration_histogram);
+
+		for (size_t pass_index = 0; pass_index < tech.passes.size(); ++pass_index)
+		{
+			const reshadefx::pass_info &pass_info = tech.passes[pass_index];
+
+			write_row("pass", effect_name, tech.name, pass_info.name.empty() ? "Pass " + std::to_string(pass_index) : pass_info.name, "gpu", tech.passes_data[pass_index].gpu_duration_histogram);
+		}
+	}
+#endif
+
+	const bool success = ferror(file) == 0;
+	fclose(file);
+
+	if (success)
+		LOG(INFO) << "Saved timing statistics to " << statistics_path << '.';
+	else
+		LOG(ERROR) << "Failed to write timing statistics to " << statistics_path << '!';
+
+	return success;
+}
+void reshade::runtime::toggle_trace_capture()
+{
+	if (!trace::capturing)
+	{
+		trace::start_capture();
+		return;
+	}
+
+	std::string trace_name = expand_macro_string(_screenshot_name, {
+		{ "AppName", g_target_executable_path.stem().u8string() },
+#if RESHADE_FX
+		{ "PresetName",  _current_preset_path.stem().u8string() },
+#endif
+	});
+	trace_name += " trace.json";
+
+	trace::stop_capture(g_reshade_base_path / _screenshot_path / std::filesystem::u8path(trace_name));
+}
+void reshade::runtime::clear_timing_statistics()
+{
+	_frame_duration_histogram.clear();
+
+#if RESHADE_FX
+	for (technique &tech : _techniques)
+	{
+		tech.cpu_duration_histogram.clear();
+		tech.gpu_duration_histogram.clear();
+		for (technique::pass_data &pass_data : tech.passes_data)
+			pass_data.gpu_duration_histogram.clear();
+	}
+#endif
+}
+
+bool reshade::runtime::create_texture_readback(api::resource resource, texture_readback &readback)
 {
 	const api::resource_desc desc = _device->get_resource_desc(resource);
 	const api::format view_format = api::format_to_default_typed(desc.texture.format, 0);
 
-	if (view_format != api::format::r8_unorm &&
-		view_format != api::format::r8g8_unorm &&
-		view_format != api::format::r8g8b8a8_unorm &&
-		view_format != api::format::b8g8r8a8_unorm &&
-		view_format != api::format::r8g8b8x8_unorm &&
-		view_format != api::format::b8g8r8x8_unorm &&
-		view_format != api::format::r10g10b10a2_unorm &&
-		view_format != api::format::b10g10r10a2_unorm)
+	if (!is_convertible_format(view_format))
 	{
 		LOG(ERROR) << "Screenshots are not supported for format " << static_cast<uint32_t>(desc.texture.format) << '!';
 		return false;
 	}
 
-	uint32_t row_pitch = api::format_row_pitch(view_format, desc.texture.width);
+	readback.format = view_format;
+	readback.width = desc.texture.width;
+	readback.height = desc.texture.height;
+	readback.row_pitch = api::format_row_pitch(view_format, desc.texture.width);
 	if (_device->get_api() == api::device_api::d3d12) // See D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
-		row_pitch = (row_pitch + 255) & ~255;
-	const uint32_t slice_pitch = api::format_slice_pitch(view_format, row_pitch, desc.texture.height);
-	const uint32_t pixels_row_pitch = desc.texture.width * 4;
+		readback.row_pitch = (readback.row_pitch + 255) & ~255;
+	readback.slice_pitch = api::format_slice_pitch(view_format, readback.row_pitch, desc.texture.height);
 
 	// Copy back buffer data into system memory buffer
-	api::resource intermediate;
 	if (_device->check_capability(api::device_caps::copy_buffer_to_texture))
 	{
-		if (!_device->create_resource(api::resource_desc(slice_pitch, api::memory_heap::gpu_to_cpu, api::resource_usage::copy_dest), nullptr, api::resource_usage::copy_dest, &intermediate))
+		if (!_device->create_resource(api::resource_desc(readback.slice_pitch, api::memory_heap::gpu_to_cpu, api::resource_usage::copy_dest), nullptr, api::resource_usage::copy_dest, &readback.intermediate))
 		{
 			LOG(ERROR) << "Failed to create system memory buffer for screenshot capture!";
 			return false;
 		}
 
-		_device->set_resource_name(intermediate, "ReShade screenshot buffer");
-
-		api::command_list *const cmd_list = _graphics_queue->get_immediate_command_list();
-		cmd_list->barrier(resource, state, api::resource_usage::copy_source);
-		cmd_list->copy_texture_to_buffer(resource, 0, nullptr, intermediate, 0, desc.texture.width, desc.texture.height);
-		cmd_list->barrier(resource, api::resource_usage::copy_source, state);
+		_device->set_resource_name(readback.intermediate, "ReShade screenshot buffer");
 	}
 	else
 	{
-		if (!_device->create_resource(api::resource_desc(desc.texture.width, desc.texture.height, 1, 1, view_format, 1, api::memory_heap::gpu_to_cpu, api::resource_usage::copy_dest), nullptr, api::resource_usage::copy_dest, &intermediate))
+		if (!_device->create_resource(api::resource_desc(desc.texture.width, desc.texture.height, 1, 1, view_format, 1, api::memory_heap::gpu_to_cpu, api::resource_usage::copy_dest), nullptr, api::resource_usage::copy_dest, &readback.intermediate))
 		{
 			LOG(ERROR) << "Failed to create system memory texture for screenshot capture!";
 			return false;
 		}
 
-		_device->set_resource_name(intermediate, "ReShade screenshot texture");
-
-		api::command_list *const cmd_list = _graphics_queue->get_immediate_command_list();
-		cmd_list->barrier(resource, state, api::resource_usage::copy_source);
-		cmd_list->copy_texture_region(resource, 0, nullptr, intermediate, 0, nullptr);
-		cmd_list->barrier(resource, api::resource_usage::copy_source, state);
+		_device->set_resource_name(readback.intermediate, "ReShade screenshot texture");
 	}
 
-	// Wait for any rendering by the application finish before submitting
-	// It may have submitted that to a different queue, so simply wait for all to idle here
-	_graphics_queue->wait_idle();
-
-	// Copy data from intermediate image into output buffer
-	api::subresource_data mapped_data = {};
+	return true;
+}
+void reshade::runtime::record_texture_readback(api::command_list *cmd_list, api::resource resource, api::resource_usage state, const texture_readback &readback)
+{
+	cmd_list->barrier(resource, state, api::resource_usage::copy_source);
+	if (_device->check_capability(api::device_caps::copy_buffer_to_texture))
+		cmd_list->copy_texture_to_buffer(resource, 0, nullptr, readback.intermediate, 0, readback.width, readback.height);
+	else
+		cmd_list->copy_texture_region(resource, 0, nullptr, readback.intermediate, 0, nullptr);
+	cmd_list->barrier(resource, api::resource_usage::copy_source, state);
+}
+bool reshade::runtime::map_texture_readback(const texture_readback &readback, api::subresource_data &mapped_data)
+{
+	mapped_data = {};
 	if (_device->check_capability(api::device_caps::copy_buffer_to_texture))
 	{
-		_device->map_buffer_region(intermediate, 0, std::numeric_limits<uint64_t>::max(), api::map_access::read_only, &mapped_data.data);
+		_device->map_buffer_region(readback.intermediate, 0, std::numeric_limits<uint64_t>::max(), api::map_access::read_only, &mapped_data.data);
 
-		mapped_data.row_pitch = row_pitch;
-		mapped_data.slice_pitch = slice_pitch;
+		mapped_data.row_pitch = readback.row_pitch;
+		mapped_data.slice_pitch = readback.slice_pitch;
 	}
 	else
 	{
-		_device->map_texture_region(intermediate, 0, nullptr, api::map_access::read_only, &mapped_data);
+		_device->map_texture_region(readback.intermediate, 0, nullptr, api::map_access::read_only, &mapped_data);
 	}
 
-	if (mapped_data.data != nullptr)
-	{
-		auto mapped_pixels = static_cast<const uint8_t *>(mapped_data.data);
+	return mapped_data.data != nullptr;
+}
+void reshade::runtime::unmap_texture_readback(const texture_readback &readback)
+{
+	if (_device->check_capability(api::device_caps::copy_buffer_to_texture))
+		_device->unmap_buffer_region(readback.intermediate);
+	else
+		_device->unmap_texture_region(readback.intermediate, 0);
+}
+bool reshade::runtime::read_texture_readback(const texture_readback &readback, uint8_t *data)
+{
+	// Copy data from intermediate image into output buffer
+	api::subresource_data mapped_data;
+	if (!map_texture_readback(readback, mapped_data))
+		return false;
 
-		for (uint32_t y = 0; y < desc.texture.height; ++y, pixels += pixels_row_pitch, mapped_pixels += mapped_data.row_pitch)
-		{
-			switch (view_format)
-			{
-			case api::format::r8_unorm:
-				for (uint32_t x = 0; x < desc.texture.width; ++x)
-				{
-					pixels[x * 4 + 0] = mapped_pixels[x];
-					pixels[x * 4 + 1] = 0;
-					pixels[x * 4 + 2] = 0;
-					pixels[x * 4 + 3] = 0xFF;
-				}
-				break;
-			case api::format::r8g8_unorm:
-				for (uint32_t x = 0; x < desc.texture.width; ++x)
-				{
-					pixels[x * 4 + 0] = mapped_pixels[x * 2 + 0];
-					pixels[x * 4 + 1] = mapped_pixels[x * 2 + 1];
-					pixels[x * 4 + 2] = 0;
-					pixels[x * 4 + 3] = 0xFF;
-				}
-				break;
-			case api::format::r8g8b8a8_unorm:
-			case api::format::r8g8b8x8_unorm:
-				std::memcpy(pixels, mapped_pixels, pixels_row_pitch);
-				if (view_format == api::format::r8g8b8x8_unorm)
-					for (uint32_t x = 0; x < pixels_row_pitch; x += 4)
-						pixels[x + 3] = 0xFF;
-				break;
-			case api::format::b8g8r8a8_unorm:
-			case api::format::b8g8r8x8_unorm:
-				std::memcpy(pixels, mapped_pixels, pixels_row_pitch);
-				// Format is BGRA, but output should be RGBA, so flip channels
-				for (uint32_t x = 0; x < pixels_row_pitch; x += 4)
-					std::swap(pixels[x + 0], pixels[x + 2]);
-				if (view_format == api::format::b8g8r8x8_unorm)
-					for (uint32_t x = 0; x < pixels_row_pitch; x += 4)
-						pixels[x + 3] = 0xFF;
-				break;
-			case api::format::r10g10b10a2_unorm:
-			case api::format::b10g10r10a2_unorm:
-				for (uint32_t x = 0; x < pixels_row_pitch; x += 4)
-				{
-					const uint32_t rgba = *reinterpret_cast<const uint32_t *>(mapped_pixels + x);
-					// Divide by 4 to get 10-bit range (0-1023) into 8-bit range (0-255)
-					pixels[x + 0] = (( rgba & 0x000003FF)        /  4) & 0xFF;
-					pixels[x + 1] = (((rgba & 0x000FFC00) >> 10) /  4) & 0xFF;
-					pixels[x + 2] = (((rgba & 0x3FF00000) >> 20) /  4) & 0xFF;
-					pixels[x + 3] = (((rgba & 0xC0000000) >> 30) * 85) & 0xFF;
-					if (view_format == api::format::b10g10r10a2_unorm)
-						std::swap(pixels[x + 0], pixels[x + 2]);
-				}
-				break;
-			}
-		}
+	const uint32_t data_row_pitch = api::format_row_pitch(readback.format, readback.width);
 
-		if (_device->check_capability(api::device_caps::copy_buffer_to_texture))
-			_device->unmap_buffer_region(intermediate);
-		else
-			_device->unmap_texture_region(intermediate, 0);
-	}
+	auto mapped_pixels = static_cast<const uint8_t *>(mapped_data.data);
+	for (uint32_t y = 0; y < readback.height; ++y, data += data_row_pitch, mapped_pixels += mapped_data.row_pitch)
+		std::memcpy(data, mapped_pixels, data_row_pitch);
 
-	_device->destroy_resource(intermediate);
+	unmap_texture_readback(readback);
 
-	return mapped_data.data != nullptr;
+	return true;
+}
+bool reshade::runtime::get_texture_data(api::resource resource, api::resource_usage state, uint8_t *pixels)
+{
+	texture_readback readback;
+	if (!create_texture_readback(resource, readback))
+		return false;
+
+	record_texture_readback(_graphics_queue->get_immediate_command_list(), resource, state, readback);
+
+	// Wait for any rendering by the application finish before submitting
+	// It may have submitted that to a different queue, so simply wait for all to idle here
+	_graphics_queue->wait_idle();
+
+	std::vector<uint8_t> data(static_cast<size_t>(api::format_row_pitch(readback.format, readback.width)) * readback.height);
+	const bool result = read_texture_readback(readback, data.data());
+	if (result)
+		convert_pixels_to_rgba8(readback.format, readback.width, readback.height, data.data(), api::format_row_pitch(readback.format, readback.width), pixels);
+
+	_device->destroy_resource(readback.intermediate);
+
+	return result;
 }
@@ -9,11 +9,16 @@
 #include <memory>
 #include <filesystem>
 #include <atomic>
+#include <thread>
+#include <mutex>
 #include <shared_mutex>
+#include <condition_variable>
 #include <string>
 #include <vector>
+#include <deque>
 #include <unordered_map>
 #include "reshade_api.hpp"
+#include "duration_histogram.hpp"
 #if RESHADE_GUI
 #include "imgui_code_editor.hpp"
 #endif
@@ -78,6 +83,7 @@ namespace reshade
 
 		/// <summary>
 		/// Captures a screenshot of the current back buffer resource and writes it to an image file on disk.
+		/// This only records a copy of the back buffer, which is read back a few frames later and then written to disk on a separate thread.
 		/// </summary>
 		void save_screenshot(const std::string &postfix = std::string());
 		/// <summary>
@@ -90,6 +96,20 @@ namespace reshade
 		/// </summary>
 		void get_screenshot_width_and_height(uint32_t *width, uint32_t *height) const final { *width = _width; *height = _height; }
 
+		/// <summary>
+		/// Writes percentiles of the recorded frame, technique and pass durations to the CSV file at the specified <paramref name="path"/>.
+		/// </summary>
+		bool save_timing_statistics(const std::filesystem::path &path) const;
+		/// <summary>
+		/// Discards all recorded frame, technique and pass durations.
+		/// </summary>
+		void clear_timing_statistics();
+
+		/// <summary>
+		/// Starts capturing trace events of the main runtime phases, or stops the running capture and writes them to a trace file in the screenshot directory.
+		/// </summary>
+		void toggle_trace_capture();
+
 		/// <summary>
 		/// Gets the current status of the specified key.
 		/// </summary>
@@ -246,6 +266,24 @@ namespace reshade
 		/// </summary>
 		void set_preprocessor_definition(const char *name, const char *value) final;
 
+		/// <summary>
+		/// Finds multiple uniform variables in the loaded effects at once and returns handles to them.
+		/// </summary>
+		void find_uniform_variables(const char *effect_name, uint32_t count, const char *const *variable_names, api::effect_uniform_variable *out_variables) const final;
+		/// <summary>
+		/// Finds multiple texture variables in the loaded effects at once and returns handles to them.
+		/// </summary>
+		void find_texture_variables(const char *effect_name, uint32_t count, const char *const *variable_names, api::effect_texture_variable *out_variables) const final;
+		/// <summary>
+		/// Finds multiple techniques in the loaded effects at once and returns handles to them.
+		/// </summary>
+		void find_techniques(const char *effect_name, uint32_t count, const char *const *technique_names, api::effect_technique *out_techniques) final;
+
+		/// <summary>
+		/// Writes percentiles of the recorded frame, technique and pass durations to a CSV file.
+		/// </summary>
+		bool export_timing_statistics(const char *path) final;
+
 	protected:
 		runtime(api::device *device, api::command_queue *graphics_queue);
 		~runtime();
@@ -275,13 +313,16 @@ namespace reshade
 		void save_current_preset() const;
 
 		bool switch_to_next_preset(std::filesystem::path filter_path, bool reversed = false);
+		void update_preset_index(std::filesystem::path preset_folder);
+		void precompile_preset_effects(const ini_file &preset, const std::vector<std::string> &preprocessor_definitions, const std::vector<std::filesystem::path> &effect_files);
 
 		bool load_effect(const std::filesystem::path &source_file, const ini_file &preset, size_t effect_index, bool preprocess_required = false);
+		bool compile_effect(effect &effect, const std::filesystem::path &source_file, const ini_file &preset, const std::vector<std::string> &preset_preprocessor_definitions, size_t effect_index, bool preprocess_required, bool &source_cached);
 		bool create_effect(size_t effect_index);
 		bool create_effect_sampler_state(const api::sampler_desc &desc, api::sampler &sampler);
 		void destroy_effect(size_t effect_index);
 
-		bool create_texture(texture &texture);
+		bool create_texture(texture &texture, bool allow_compressed = true);
 		void destroy_texture(texture &texture);
 
 		void enable_technique(technique &technique);
@@ -303,6 +344,32 @@ namespace reshade
 		void save_texture(const texture &texture);
 		void update_texture(texture &texture, const uint32_t width, const uint32_t height, const uint8_t *pixels);
 
+		void update_texture_compressed(texture &texture, const uint8_t *data);
+		bool recreate_texture_uncompressed(texture &texture);
+		api::format find_compressed_texture_format(const texture &texture) const;
+
+		struct texture_source_image
+		{
+			std::filesystem::path path;
+			std::filesystem::file_time_type modified_at;
+			// Whether the file should be decoded, rather than only having its block-compressed data read (which may only be changed while the image is queued, with the loader mutex held)
+			bool decode = true;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			// Tightly packed RGBA pixel data, which stays empty if the file could not be decoded
+			std::vector<uint8_t> pixels;
+			// Block-compressed data of all mipmap levels in a DDS file, which stays empty for other files
+			api::format compressed_format = api::format::unknown;
+			uint32_t compressed_levels = 0;
+			std::vector<uint8_t> compressed_data;
+			// Set by the loader thread once the fields above were filled in
+			std::atomic<bool> decoded = false;
+			unsigned int generation = 0;
+		};
+
+		std::shared_ptr<texture_source_image> request_texture_source(std::filesystem::path source_path, bool decode);
+		void abort_texture_loading();
+
 		void reset_uniform_value(uniform &variable);
 
 		void get_uniform_value_data(const uniform &variable, uint8_t *data, size_t size, size_t base_index) const;
@@ -323,8 +390,47 @@ namespace reshade
 		}
 #endif
 
+		struct texture_readback
+		{
+			api::resource intermediate = {};
+			api::format format = api::format::unknown;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t row_pitch = 0;
+			uint32_t slice_pitch = 0;
+		};
+		struct pending_screenshot
+		{
+			texture_readback readback;
+			unsigned long long frame = 0;
+			// Submission of the immediate command list that executes the copy to the readback resource
+			uint64_t submission_index = 0;
+			std::filesystem::path path;
+			// Preset to copy next to the screenshot, or empty to not include one
+			std::filesystem::path preset_path;
+			// Encoder settings at the time the screenshot was taken, since the writer thread must not read those while they may be changed
+			unsigned int format = 0;
+			unsigned int jpeg_quality = 90;
+			bool clear_alpha = true;
+			bool tonemap_hdr = false;
+			bool high_bit_depth = false;
+			// Readback resource memory, which is mapped once the copy finished executing and unmapped again after the writer thread copied it
+			api::subresource_data mapped_data;
+			// Tightly packed pixel data in the format of the readback, filled in by the writer thread
+			std::vector<uint8_t> data;
+			size_t reserved_memory = 0;
+		};
+
+		bool create_texture_readback(api::resource resource, texture_readback &readback);
+		void record_texture_readback(api::command_list *cmd_list, api::resource resource, api::resource_usage state, const texture_readback &readback);
+		bool map_texture_readback(const texture_readback &readback, api::subresource_data &mapped_data);
+		void unmap_texture_readback(const texture_readback &readback);
+		bool read_texture_readback(const texture_readback &readback, uint8_t *data);
 		bool get_texture_data(api::resource resource, api::resource_usage state, uint8_t *pixels);
 
+		void update_screenshot_readbacks(bool wait_for_all);
+		void destroy_screenshot_readbacks();
+		void write_screenshot(pending_screenshot &screenshot);
 		bool execute_screenshot_post_save_command(const std::filesystem::path &screenshot_path);
 
 		#pragma region Status
@@ -347,6 +453,17 @@ namespace reshade
 		std::chrono::high_resolution_clock::time_point _last_present_time;
 		unsigned long long _framecount = 0;
 
+		// Distribution of frame durations since the last reset, from which percentiles are computed for the statistics page and timing exports
+		duration_histogram _frame_duration_histogram;
+		unsigned int _timing_export_key_data[4] = {};
+		unsigned int _trace_capture_key_data[4] = {};
+		// Set once timing statistics were exported through the API, so that GPU durations are gathered for subsequent exports
+		bool _gather_timing_statistics = false;
+		// Ticks per second of GPU timestamps, queried during initialization (since that can stall in D3D10 and D3D11), or zero if they are not supported
+		uint64_t _timestamp_frequency = 0;
+		// Scratch space for the timestamp query results of a technique, which keeps its capacity between frames
+		std::vector<uint64_t> _timestamp_query_results;
+
 #if RESHADE_ADDON
 		bool _is_in_api_call = false;
 #endif
@@ -371,7 +488,16 @@ namespace reshade
 
 		std::atomic<bool> _last_reload_successfull = true;
 		bool _textures_loaded = false;
+		bool _textures_loading = false;
 		bool _last_texture_reload_successfull = true;
+		unsigned int _texture_source_generation = 0;
+		// Decoded image files, keyed by path and shared between all textures referencing the same file, which are kept across reloads until the file changes
+		std::unordered_map<std::string, std::shared_ptr<texture_source_image>> _texture_source_cache;
+		std::unordered_map<std::string, std::shared_ptr<texture_source_image>> _texture_source_lookup;
+		std::mutex _texture_loader_mutex;
+		std::deque<std::shared_ptr<texture_source_image>> _texture_loader_queue;
+		std::vector<std::thread> _texture_loader_threads;
+		size_t _texture_loader_running = 0;
 		std::shared_mutex _reload_mutex;
 		std::vector<size_t> _reload_create_queue;
 		std::atomic<size_t> _reload_remaining_effects = 0;
@@ -380,6 +506,18 @@ namespace reshade
 		std::vector<effect> _effects;
 		std::vector<texture> _textures;
 		std::vector<technique> _techniques;
+
+		// Name lookup tables used by the 'find_*' API functions, mapping the hash of a name (and optionally an effect name) to the element index and effect index
+		// Add-ons may call those functions from multiple threads at once, so the tables are only accessed while holding the lookup mutex (including by 'update_effect_lookup')
+		void update_effect_lookup() const;
+		mutable std::mutex _effect_lookup_mutex;
+		// Incremented whenever effects, textures or techniques are added, removed or reordered, so that the lookup tables are rebuilt on next use
+		std::atomic<size_t> _effect_generation = 1;
+		mutable size_t _effect_lookup_generation = 0;
+		mutable std::vector<std::string> _effect_lookup_names;
+		mutable std::unordered_multimap<size_t, std::pair<size_t, size_t>> _uniform_lookup;
+		mutable std::unordered_multimap<size_t, std::pair<size_t, size_t>> _texture_lookup;
+		mutable std::unordered_multimap<size_t, std::pair<size_t, size_t>> _technique_lookup;
 #endif
 		std::vector<std::thread> _worker_threads;
 		std::chrono::high_resolution_clock::time_point _last_reload_time;
@@ -417,6 +555,8 @@ namespace reshade
 		bool _screenshot_save_gui = false;
 #endif
 		bool _screenshot_clear_alpha = true;
+		bool _screenshot_tonemap_hdr = false;
+		bool _screenshot_high_bit_depth = false;
 		unsigned int _screenshot_format = 1;
 		unsigned int _screenshot_jpeg_quality = 90;
 		unsigned int _screenshot_key_data[4] = {};
@@ -427,7 +567,25 @@ namespace reshade
 		std::filesystem::path _screenshot_post_save_command_working_directory;
 		bool _screenshot_post_save_command_no_window = false;
 
+		unsigned int _screenshot_burst_key_data[4] = {};
+		unsigned int _screenshot_burst_frame_count = 60;
+		unsigned int _screenshot_memory_limit = 1024; // In MiB
+
 		bool _should_save_screenshot = false;
+		unsigned int _screenshot_burst_frames_remaining = 0;
+		// Screenshots whose copy was recorded, but not read back yet (in the order they were recorded)
+		std::vector<pending_screenshot> _pending_screenshots;
+		// Readback resources of screenshots that were already read back, which are reused for the next ones
+		std::vector<texture_readback> _free_screenshot_readbacks;
+		// Readback resources the writer thread finished copying from, which still have to be unmapped on the render thread (protected by the writer mutex)
+		std::vector<texture_readback> _copied_screenshot_readbacks;
+		// Memory reserved by screenshots that were not written to disk yet
+		std::atomic<size_t> _screenshot_memory_usage = 0;
+		std::thread _screenshot_writer_thread;
+		std::mutex _screenshot_writer_mutex;
+		std::condition_variable _screenshot_writer_condition;
+		std::deque<pending_screenshot> _screenshot_writer_queue;
+		bool _screenshot_writer_exit = false;
 		std::atomic<bool> _last_screenshot_save_successfull = true;
 		bool _screenshot_directory_creation_successfull = true;
 		std::filesystem::path _last_screenshot_file;
@@ -443,6 +601,24 @@ namespace reshade
 
 		bool _is_in_between_presets_transition = false;
 		std::chrono::high_resolution_clock::time_point _last_preset_switching_time;
+
+		struct preset_index_entry
+		{
+			std::filesystem::file_time_type modified_at;
+			bool is_preset = false;
+		};
+
+		std::thread _preset_index_thread;
+		std::mutex _preset_index_mutex;
+		std::atomic<bool> _preset_index_pending = false;
+		std::atomic<bool> _preset_index_cancel = false;
+		std::filesystem::path _preset_index_path;
+		// All files in the indexed folder and whether they are valid presets, which are validated by their own modification time (so saving a preset only invalidates that file, rather than the whole folder)
+		std::unordered_map<std::wstring, preset_index_entry> _preset_index;
+		// Valid presets in the indexed folder, in the order they were found in
+		std::vector<std::filesystem::path> _preset_index_list;
+		// Preset files parsed by the indexer that were not handed over to the INI cache yet
+		std::vector<ini_file> _preset_index_files;
 #endif
 		#pragma endregion
 
@@ -471,6 +647,7 @@ namespace reshade
 		void draw_gui_about();
 #if RESHADE_ADDON
 		void draw_gui_addons();
+		void reset_addon_event_statistics();
 #endif
 #if RESHADE_FX
 		void draw_variable_editor();
@@ -536,6 +713,7 @@ namespace reshade
 
 		#pragma region Overlay Add-ons
 		char _addons_filter[32] = {};
+		unsigned long long _addon_event_profiling_start_frame = 0;
 		#pragma endregion
 
 		#pragma region Overlay Settings
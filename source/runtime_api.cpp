@@ -7,6 +7,96 @@
 #include "runtime_objects.hpp"
 #include "input.hpp"
 #include <cassert>
+#include <string_view>
+#include <unordered_set>
+
+#if RESHADE_FX
+/// <summary>
+/// Hashes a name and optional effect name as separate parts, so that looking up a name does not have to build a combined string first.
+/// </summary>
+static size_t hash_lookup_key(const char *effect_name, const char *name)
+{
+	size_t hash = std::hash<std::string_view>()(name);
+	if (effect_name != nullptr)
+		hash ^= std::hash<std::string_view>()(effect_name) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	return hash;
+}
+
+/// <summary>
+/// Adds an entry to a lookup table, unless there already is one for the same name and effect name.
+/// </summary>
+static void add_lookup_entry(std::unordered_multimap<size_t, std::pair<size_t, size_t>> &lookup, std::unordered_set<std::string> &added_keys, const std::string &effect_name, const std::string &name, bool with_effect_name, size_t index, size_t effect_index)
+{
+	// Only add the first match for every name, to return the same result as searching through the lists in order would
+	// Names cannot contain null characters, so one is used to separate the effect name (rather than '@', which would make "a@b" equal to "a" in effect "b")
+	if (!added_keys.insert(with_effect_name ? name + '\0' + effect_name : name).second)
+		return;
+
+	lookup.emplace(hash_lookup_key(with_effect_name ? effect_name.c_str() : nullptr, name.c_str()), std::make_pair(index, effect_index));
+}
+
+void reshade::runtime::update_effect_lookup() const
+{
+	const size_t generation = _effect_generation;
+	if (_effect_lookup_generation == generation)
+		return;
+
+	_effect_lookup_generation = generation;
+
+	_uniform_lookup.clear();
+	_texture_lookup.clear();
+	_technique_lookup.clear();
+
+	_effect_lookup_names.clear();
+	_effect_lookup_names.reserve(_effects.size());
+	std::unordered_set<std::string> seen_effect_names;
+	std::unordered_set<std::string> added_keys;
+
+	for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
+	{
+		const effect &effect = _effects[effect_index];
+		const std::string &effect_name = _effect_lookup_names.emplace_back(effect.source_file.filename().u8string());
+
+		// Searching by effect name only ever considered the first effect with that file name
+		const bool first_with_name = seen_effect_names.insert(effect_name).second;
+
+		for (size_t variable_index = 0; variable_index < effect.uniforms.size(); ++variable_index)
+		{
+			const std::string &variable_name = effect.uniforms[variable_index].name;
+
+			add_lookup_entry(_uniform_lookup, added_keys, effect_name, variable_name, false, variable_index, effect_index);
+			if (first_with_name)
+				add_lookup_entry(_uniform_lookup, added_keys, effect_name, variable_name, true, variable_index, effect_index);
+		}
+	}
+
+	added_keys.clear();
+
+	for (size_t variable_index = 0; variable_index < _textures.size(); ++variable_index)
+	{
+		const texture &variable = _textures[variable_index];
+		if (variable.shared.empty())
+			continue;
+
+		for (const std::string *variable_name : { &variable.name, &variable.unique_name })
+		{
+			add_lookup_entry(_texture_lookup, added_keys, _effect_lookup_names[variable.shared[0]], *variable_name, false, variable_index, variable.shared[0]);
+			for (const size_t effect_index : variable.shared)
+				add_lookup_entry(_texture_lookup, added_keys, _effect_lookup_names[effect_index], *variable_name, true, variable_index, effect_index);
+		}
+	}
+
+	added_keys.clear();
+
+	for (size_t technique_index = 0; technique_index < _techniques.size(); ++technique_index)
+	{
+		const technique &tech = _techniques[technique_index];
+
+		add_lookup_entry(_technique_lookup, added_keys, _effect_lookup_names[tech.effect_index], tech.name, false, technique_index, tech.effect_index);
+		add_lookup_entry(_technique_lookup, added_keys, _effect_lookup_names[tech.effect_index], tech.name, true, technique_index, tech.effect_index);
+	}
+}
+#endif
 
 reshade::input::window_handle reshade::runtime::get_hwnd() const
 {
@@ -70,27 +160,39 @@ void reshade::runtime::enumerate_uniform_variables(const char *effect_name, void
 
 reshade::api::effect_uniform_variable reshade::runtime::find_uniform_variable(const char *effect_name, const char *variable_name) const
 {
+	api::effect_uniform_variable variable = { 0 };
+	find_uniform_variables(effect_name, 1, &variable_name, &variable);
+	return variable;
+}
+void reshade::runtime::find_uniform_variables(const char *effect_name, uint32_t count, const char *const *variable_names, api::effect_uniform_variable *out_variables) const
+{
+	for (uint32_t i = 0; i < count; ++i)
+		out_variables[i] = { 0 };
+
 #if RESHADE_FX
 	if (is_loading())
-		return { 0 };
+		return;
 
-	for (const effect &effect : _effects)
-	{
-		if (effect_name != nullptr && effect.source_file.filename() != effect_name)
-			continue;
+	const std::unique_lock<std::mutex> lock(_effect_lookup_mutex);
 
-		for (const uniform &variable : effect.uniforms)
+	update_effect_lookup();
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		// Different names may have the same hash, so validate entries and treat a mismatch as a miss
+		const auto [begin, end] = _uniform_lookup.equal_range(hash_lookup_key(effect_name, variable_names[i]));
+		for (auto it = begin; it != end; ++it)
 		{
-			if (variable.name == variable_name)
-				return { reinterpret_cast<uintptr_t>(&variable) };
+			if (const auto [variable_index, effect_index] = it->second;
+				effect_index < _effects.size() && variable_index < _effects[effect_index].uniforms.size() && _effects[effect_index].uniforms[variable_index].name == variable_names[i] &&
+				(effect_name == nullptr || _effect_lookup_names[effect_index] == effect_name))
+			{
+				out_variables[i] = { reinterpret_cast<uintptr_t>(&_effects[effect_index].uniforms[variable_index]) };
+				break;
+			}
 		}
-
-		if (effect_name != nullptr)
-			break;
 	}
 #endif
-
-	return { 0 };
 }
 
 void reshade::runtime::get_uniform_variable_type(api::effect_uniform_variable handle, api::format *out_base_type, uint32_t *out_rows, uint32_t *out_columns, uint32_t *out_array_length) const
@@ -419,23 +521,39 @@ void reshade::runtime::enumerate_texture_variables(const char *effect_name, void
 
 reshade::api::effect_texture_variable reshade::runtime::find_texture_variable(const char *effect_name, const char *variable_name) const
 {
+	api::effect_texture_variable variable = { 0 };
+	find_texture_variables(effect_name, 1, &variable_name, &variable);
+	return variable;
+}
+void reshade::runtime::find_texture_variables(const char *effect_name, uint32_t count, const char *const *variable_names, api::effect_texture_variable *out_variables) const
+{
+	for (uint32_t i = 0; i < count; ++i)
+		out_variables[i] = { 0 };
+
 #if RESHADE_FX
 	if (is_loading() || !_reload_create_queue.empty())
-		return { 0 };
+		return;
 
-	for (const texture &variable : _textures)
-	{
-		if (effect_name != nullptr &&
-			std::find_if(variable.shared.begin(), variable.shared.end(),
-				[this, effect_name](size_t effect_index) { return _effects[effect_index].source_file.filename() == effect_name; }) == variable.shared.end())
-			continue;
+	const std::unique_lock<std::mutex> lock(_effect_lookup_mutex);
+
+	update_effect_lookup();
 
-		if (variable.name == variable_name || variable.unique_name == variable_name)
-			return { reinterpret_cast<uintptr_t>(&variable) };
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		// Different names may have the same hash, so validate entries and treat a mismatch as a miss
+		const auto [begin, end] = _texture_lookup.equal_range(hash_lookup_key(effect_name, variable_names[i]));
+		for (auto it = begin; it != end; ++it)
+		{
+			if (const auto [variable_index, effect_index] = it->second;
+				variable_index < _textures.size() && (_textures[variable_index].name == variable_names[i] || _textures[variable_index].unique_name == variable_names[i]) &&
+				(effect_name == nullptr || (effect_index < _effect_lookup_names.size() && _effect_lookup_names[effect_index] == effect_name)))
+			{
+				out_variables[i] = { reinterpret_cast<uintptr_t>(&_textures[variable_index]) };
+				break;
+			}
+		}
 	}
 #endif
-
-	return { 0 };
 }
 
 void reshade::runtime::get_texture_variable_name(api::effect_texture_variable handle, char *value, size_t *length) const
@@ -674,21 +792,39 @@ void reshade::runtime::enumerate_techniques(const char *effect_name, void(*callb
 
 reshade::api::effect_technique reshade::runtime::find_technique(const char *effect_name, const char *technique_name)
 {
+	api::effect_technique technique = { 0 };
+	find_techniques(effect_name, 1, &technique_name, &technique);
+	return technique;
+}
+void reshade::runtime::find_techniques(const char *effect_name, uint32_t count, const char *const *technique_names, api::effect_technique *out_techniques)
+{
+	for (uint32_t i = 0; i < count; ++i)
+		out_techniques[i] = { 0 };
+
 #if RESHADE_FX
 	if (is_loading())
-		return { 0 };
+		return;
 
-	for (const technique &technique : _techniques)
-	{
-		if (effect_name != nullptr && _effects[technique.effect_index].source_file.filename() != effect_name)
-			continue;
+	const std::unique_lock<std::mutex> lock(_effect_lookup_mutex);
+
+	update_effect_lookup();
 
-		if (technique.name == technique_name)
-			return { reinterpret_cast<uintptr_t>(&technique) };
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		// Different names may have the same hash, so validate entries and treat a mismatch as a miss
+		const auto [begin, end] = _technique_lookup.equal_range(hash_lookup_key(effect_name, technique_names[i]));
+		for (auto it = begin; it != end; ++it)
+		{
+			if (const auto [technique_index, effect_index] = it->second;
+				technique_index < _techniques.size() && _techniques[technique_index].name == technique_names[i] && _techniques[technique_index].effect_index == effect_index &&
+				(effect_name == nullptr || _effect_lookup_names[effect_index] == effect_name))
+			{
+				out_techniques[i] = { reinterpret_cast<uintptr_t>(&_techniques[technique_index]) };
+				break;
+			}
+		}
 	}
 #endif
-
-	return { 0 };
 }
 
 void reshade::runtime::get_technique_name(api::effect_technique handle, char *value, size_t *length) const
@@ -928,3 +1064,10 @@ bool reshade::runtime::get_preprocessor_definition(const char *name, char *value
 	*length = 0;
 	return false;
 }
+bool reshade::runtime::export_timing_statistics(const char *path)
+{
+	// Keep gathering GPU durations from now on, so that subsequent exports include them
+	_gather_timing_statistics = true;
+
+	return save_timing_statistics(path != nullptr ? std::filesystem::u8path(path) : std::filesystem::path());
+}
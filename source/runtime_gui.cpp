@@ -15,6 +15,7 @@
 #include "input.hpp"
 #include "imgui_widgets.hpp"
 #include "process_utils.hpp"
+#include "trace_markers.hpp"
 #include "fonts/forkawesome.inl"
 #include <fstream>
 #include <algorithm>
@@ -560,6 +561,8 @@ void reshade::runtime::draw_gui()
 {
 	assert(_is_initialized);
 
+	const trace::scope trace_scope("draw_gui");
+
 #if RESHADE_FX
 	bool show_splash = _show_splash && (is_loading() || (_reload_count <= 1 && (_last_present_time - _last_reload_time) < std::chrono::seconds(5)) || (!_show_overlay && _tutorial_index == 0));
 #else
@@ -1455,6 +1458,13 @@ void reshade::runtime::draw_gui_settings()
 			ImGui::SetTooltip("Makes a smooth transition, but only for floating point values.\nRecommended for multiple presets that contain the same effects, otherwise set this to zero.\nValues are in milliseconds.");
 #endif
 
+		modified |= imgui::key_input_box("Timing statistics export key", _timing_export_key_data, *_input);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Writes percentiles of the frame, technique and pass durations to a CSV file in the screenshot directory.");
+		modified |= imgui::key_input_box("Trace capture key", _trace_capture_key_data, *_input);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Starts recording a timeline of the main runtime phases on all threads and writes it to a trace file in the screenshot directory when pressed again.\nThe file can be opened with Perfetto or \"chrome://tracing\".");
+
 		modified |= ImGui::Combo("Input processing", reinterpret_cast<int *>(&_input_processing_mode),
 			"Pass on all input\0"
 			"Block input when cursor is on overlay\0"
@@ -1485,6 +1495,17 @@ void reshade::runtime::draw_gui_settings()
 	if (ImGui::CollapsingHeader("Screenshots", ImGuiTreeNodeFlags_DefaultOpen))
 	{
 		modified |= imgui::key_input_box("Screenshot key", _screenshot_key_data, *_input);
+		modified |= imgui::key_input_box("Screenshot burst key", _screenshot_burst_key_data, *_input);
+
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Saves a screenshot every frame for the number of frames set below.");
+
+		modified |= ImGui::SliderInt("Screenshot burst frames", reinterpret_cast<int *>(&_screenshot_burst_frame_count), 1, 600);
+		modified |= ImGui::SliderInt("Screenshot memory limit", reinterpret_cast<int *>(&_screenshot_memory_limit), 64, 8192, "%d MiB");
+
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Maximum amount of memory used by screenshots that were taken but not written to disk yet.\nScreenshots are skipped while this is exceeded (e.g. during long bursts).");
+
 		modified |= imgui::directory_input_box("Screenshot path", _screenshot_path, _file_selection_path);
 
 		char name[260] = "";
@@ -1514,13 +1535,28 @@ void reshade::runtime::draw_gui_settings()
 				"HH-mm-ss");
 		}
 
-		modified |= ImGui::Combo("Screenshot format", reinterpret_cast<int *>(&_screenshot_format), "Bitmap (*.bmp)\0Portable Network Graphics (*.png)\0JPEG (*.jpeg)\0");
+		modified |= ImGui::Combo("Screenshot format", reinterpret_cast<int *>(&_screenshot_format), "Bitmap (*.bmp)\0Portable Network Graphics (*.png)\0JPEG (*.jpeg)\0OpenEXR (*.exr)\0");
 
 		if (_screenshot_format == 2)
 			modified |= ImGui::SliderInt("JPEG quality", reinterpret_cast<int *>(&_screenshot_jpeg_quality), 1, 100);
 		else
 			modified |= ImGui::Checkbox("Clear alpha channel", &_screenshot_clear_alpha);
 
+		if (_screenshot_format == 1)
+		{
+			modified |= ImGui::Checkbox("Save 16-bit PNG for high bit depth back buffers", &_screenshot_high_bit_depth);
+
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Keeps the full precision of 10-bit and 16-bit back buffers, rather than reducing them to 8 bits per channel.");
+		}
+		if (_screenshot_format != 3)
+		{
+			modified |= ImGui::Checkbox("Tone map HDR back buffers", &_screenshot_tonemap_hdr);
+
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Compresses highlights of floating-point (scRGB) back buffers into the displayable range, rather than clipping them.\nUse the OpenEXR format to keep the full range instead.");
+		}
+
 #if RESHADE_FX
 		modified |= ImGui::Checkbox("Save current preset file", &_screenshot_include_preset);
 		modified |= ImGui::Checkbox("Save before and after images", &_screenshot_save_before);
@@ -1542,7 +1578,7 @@ void reshade::runtime::draw_gui_settings()
 
 		if (ImGui::IsItemHovered())
 		{
-			const std::string extension = _screenshot_format == 0 ? ".bmp" : _screenshot_format == 1 ? ".png" : ".jpg";
+			const std::string extension = _screenshot_format == 0 ? ".bmp" : _screenshot_format == 1 ? ".png" : _screenshot_format == 2 ? ".jpg" : ".exr";
 
 			ImGui::SetTooltip(
 				"Macros you can add that are resolved during command execution:\n"
@@ -1908,6 +1944,66 @@ void reshade::runtime::draw_gui_statistics()
 		ImGui::EndGroup();
 	}
 
+	if (ImGui::CollapsingHeader("Timing Percentiles") && !is_loading())
+	{
+		// Per-pass GPU durations are gathered together with those of the techniques
+		_gather_gpu_statistics = true;
+
+		if (ImGui::Button("Reset", ImVec2(8.0f * _font_size, 0.0f)))
+			clear_timing_statistics();
+		ImGui::SameLine();
+		if (ImGui::Button("Export to CSV", ImVec2(10.0f * _font_size, 0.0f)))
+			save_timing_statistics({});
+
+		if (ImGui::BeginTable("##timing_percentiles", 7, ImGuiTableFlags_BordersInnerH))
+		{
+			ImGui::TableSetupColumn("Name");
+			ImGui::TableSetupColumn("Samples");
+			ImGui::TableSetupColumn("Mean");
+			ImGui::TableSetupColumn("P50");
+			ImGui::TableSetupColumn("P95");
+			ImGui::TableSetupColumn("P99");
+			ImGui::TableSetupColumn("Max");
+			ImGui::TableHeadersRow();
+
+			const auto draw_row = [](const std::string &name, const duration_histogram &histogram) {
+				if (histogram.count() == 0)
+					return;
+
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(name.c_str(), name.c_str() + name.size());
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", histogram.count());
+
+				for (const uint64_t value : { histogram.mean(), histogram.percentile(50), histogram.percentile(95), histogram.percentile(99), histogram.max() })
+				{
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f ms", value * 1e-6f);
+				}
+			};
+
+			draw_row("Frame", _frame_duration_histogram);
+
+			for (const technique &tech : _techniques)
+			{
+				if (!tech.enabled || tech.passes_data.empty())
+					continue;
+
+				draw_row(tech.name + " CPU", tech.cpu_duration_histogram);
+				draw_row(tech.name + " GPU", tech.gpu_duration_histogram);
+
+				if (tech.passes.size() > 1)
+				{
+					for (size_t pass_index = 0; pass_index < tech.passes.size(); ++pass_index)
+						draw_row("  " + (tech.passes[pass_index].name.empty() ? "Pass " + std::to_string(pass_index) : tech.passes[pass_index].name) + " GPU", tech.passes_data[pass_index].gpu_duration_histogram);
+				}
+			}
+
+			ImGui::EndTable();
+		}
+	}
+
 	if (ImGui::CollapsingHeader("Render Targets & Textures", ImGuiTreeNodeFlags_DefaultOpen) && !is_loading())
 	{
 		static const char *texture_formats[] = {
@@ -1929,6 +2025,7 @@ void reshade::runtime::draw_gui_statistics()
 		// Variables used to calculate memory size of textures
 		lldiv_t memory_view;
 		int64_t post_processing_memory_size = 0;
+		int64_t compressed_memory_saved = 0;
 		const char *memory_size_unit;
 
 		for (const texture &tex : _textures)
@@ -1940,8 +2037,18 @@ void reshade::runtime::draw_gui_statistics()
 			ImGui::BeginGroup();
 
 			int64_t memory_size = 0;
-			for (uint32_t level = 0, width = tex.width, height = tex.height; level < tex.levels; ++level, width /= 2, height /= 2)
-				memory_size += static_cast<size_t>(width) * static_cast<size_t>(height) * pixel_sizes[static_cast<int>(tex.format)];
+			int64_t uncompressed_memory_size = 0;
+			for (uint32_t level = 0, width = tex.width, height = tex.height; level < tex.levels; ++level, width = std::max(width / 2, 1u), height = std::max(height / 2, 1u))
+			{
+				uncompressed_memory_size += static_cast<size_t>(width) * static_cast<size_t>(height) * pixel_sizes[static_cast<int>(tex.format)];
+				if (tex.compressed_format != api::format::unknown)
+					memory_size += api::format_slice_pitch(tex.compressed_format, api::format_row_pitch(tex.compressed_format, width), height);
+			}
+
+			if (tex.compressed_format == api::format::unknown)
+				memory_size = uncompressed_memory_size;
+			else
+				compressed_memory_saved += uncompressed_memory_size - memory_size;
 
 			post_processing_memory_size += memory_size;
 
@@ -1958,11 +2065,37 @@ void reshade::runtime::draw_gui_statistics()
 			}
 
 			ImGui::TextColored(ImVec4(1, 1, 1, 1), "%s%s", tex.unique_name.c_str(), tex.shared.size() > 1 ? " (Pooled)" : "");
-			ImGui::Text("%ux%u | %u mipmap(s) | %s | %lld.%03lld %s",
+			const char *compressed_format_name = nullptr;
+			switch (tex.compressed_format)
+			{
+			case api::format::bc1_typeless:
+				compressed_format_name = "BC1";
+				break;
+			case api::format::bc2_typeless:
+				compressed_format_name = "BC2";
+				break;
+			case api::format::bc3_typeless:
+				compressed_format_name = "BC3";
+				break;
+			case api::format::bc4_typeless:
+				compressed_format_name = "BC4";
+				break;
+			case api::format::bc5_typeless:
+				compressed_format_name = "BC5";
+				break;
+			case api::format::bc7_typeless:
+				compressed_format_name = "BC7";
+				break;
+			}
+
+			ImGui::Text("%ux%u | %u mipmap(s) | %s%s%s%s | %lld.%03lld %s",
 				tex.width,
 				tex.height,
 				tex.levels - 1,
 				texture_formats[static_cast<int>(tex.format)],
+				compressed_format_name != nullptr ? " (" : "",
+				compressed_format_name != nullptr ? compressed_format_name : "",
+				compressed_format_name != nullptr ? ")" : "",
 				memory_view.quot, memory_view.rem, memory_size_unit);
 
 			size_t num_referenced_passes = 0;
@@ -2036,7 +2169,7 @@ void reshade::runtime::draw_gui_statistics()
 				if (ImGui::Button(ICON_FK_FLOPPY, ImVec2(button_size, 0)))
 					save_texture(tex);
 				if (ImGui::IsItemHovered())
-					ImGui::SetTooltip("Save %s", tex.unique_name.c_str());
+					ImGui::SetTooltip(tex.compressed_format != api::format::unknown ? "Save %s as DDS file" : "Save %s", tex.unique_name.c_str());
 			}
 			ImGui::PopStyleVar();
 
@@ -2136,6 +2269,23 @@ void reshade::runtime::draw_gui_statistics()
 		}
 
 		ImGui::Text("Total memory usage: %lld.%03lld %s", memory_view.quot, memory_view.rem, memory_size_unit);
+
+		if (compressed_memory_saved != 0)
+		{
+			if (compressed_memory_saved >= 1024 * 1024)
+			{
+				memory_view = std::lldiv(compressed_memory_saved, 1024 * 1024);
+				memory_view.rem /= 1000;
+				memory_size_unit = "MiB";
+			}
+			else
+			{
+				memory_view = std::lldiv(compressed_memory_saved, 1024);
+				memory_size_unit = "KiB";
+			}
+
+			ImGui::Text("Memory saved by block-compressed textures: %lld.%03lld %s", memory_view.quot, memory_view.rem, memory_size_unit);
+		}
 	}
 #endif
 }
@@ -2315,7 +2465,7 @@ void reshade::runtime::draw_gui_addons()
 	if (imgui::directory_input_box("Add-on search path", addon_search_path, _file_selection_path))
 	{
 		global_config().set("INSTALL", "AddonPath", addon_search_path);
-		global_config().save();
+		global_config().queue_save();
 	}
 #endif
 
@@ -2323,10 +2473,24 @@ void reshade::runtime::draw_gui_addons()
 	ImGui::Separator();
 	ImGui::Spacing();
 
+	if (ImGui::Checkbox("Profile event callbacks", &addon_event_profiling) && addon_event_profiling)
+		reset_addon_event_statistics();
+	if (addon_event_profiling)
+	{
+		ImGui::SameLine();
+		if (ImGui::Button("Reset statistics"))
+			reset_addon_event_statistics();
+	}
+
+	ImGui::Spacing();
+
 	imgui::search_input_box(_addons_filter, sizeof(_addons_filter));
 
 	ImGui::Spacing();
 
+	// Average statistics over all frames since profiling was enabled or reset
+	const double num_profiled_frames = static_cast<double>(std::max(_framecount - _addon_event_profiling_start_frame, 1ull));
+
 	std::vector<std::string> disabled_addons;
 	global_config().get("ADDON", "DisabledAddons", disabled_addons);
 
@@ -2359,7 +2523,7 @@ void reshade::runtime::draw_gui_addons()
 				disabled_addons.push_back(info.name);
 
 			global_config().set("ADDON", "DisabledAddons", disabled_addons);
-			global_config().save();
+			global_config().queue_save();
 		}
 
 		ImGui::PopStyleColor();
@@ -2370,6 +2534,16 @@ void reshade::runtime::draw_gui_addons()
 			ImGui::Text("(will be %s on next application restart)", enabled ? "enabled" : "disabled");
 		}
 
+		if (addon_event_profiling && info.event_stats != nullptr)
+		{
+			uint64_t total_time = 0;
+			for (uint32_t ev = 0; ev < static_cast<uint32_t>(addon_event::max); ++ev)
+				total_time += info.event_stats[ev].total_time.load(std::memory_order_relaxed);
+
+			ImGui::SameLine(child_window_width - 120.0f);
+			ImGui::Text("%8.3f ms/frame", total_time * 1e-6 / num_profiled_frames);
+		}
+
 		if (open)
 		{
 			ImGui::Spacing();
@@ -2396,6 +2570,36 @@ void reshade::runtime::draw_gui_addons()
 			}
 			ImGui::EndGroup();
 
+			if (addon_event_profiling && info.event_stats != nullptr &&
+				ImGui::BeginTable("##event_stats", 4, ImGuiTableFlags_BordersInnerH))
+			{
+				ImGui::TableSetupColumn("Event");
+				ImGui::TableSetupColumn("Calls/frame");
+				ImGui::TableSetupColumn("ms/frame");
+				ImGui::TableSetupColumn("us/call");
+				ImGui::TableHeadersRow();
+
+				for (uint32_t ev = 0; ev < static_cast<uint32_t>(addon_event::max); ++ev)
+				{
+					const uint64_t num_calls = info.event_stats[ev].num_calls.load(std::memory_order_relaxed);
+					if (num_calls == 0)
+						continue;
+					const uint64_t total_time = info.event_stats[ev].total_time.load(std::memory_order_relaxed);
+
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(addon_event_to_string(static_cast<addon_event>(ev)));
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", num_calls / num_profiled_frames);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", total_time * 1e-6 / num_profiled_frames);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", total_time * 1e-3 / num_calls);
+				}
+
+				ImGui::EndTable();
+			}
+
 			if (info.settings_overlay_callback != nullptr)
 			{
 				ImGui::Spacing();
@@ -2413,6 +2617,23 @@ void reshade::runtime::draw_gui_addons()
 		ImGui::GetStateStorage()->SetFloat(settings_id, settings_height);
 	}
 }
+
+void reshade::runtime::reset_addon_event_statistics()
+{
+	for (addon_info &info : addon_loaded_info)
+	{
+		if (info.event_stats == nullptr)
+			continue;
+
+		for (uint32_t ev = 0; ev < static_cast<uint32_t>(addon_event::max); ++ev)
+		{
+			info.event_stats[ev].num_calls.store(0, std::memory_order_relaxed);
+			info.event_stats[ev].total_time.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	_addon_event_profiling_start_frame = _framecount;
+}
 #endif
 
 #if RESHADE_FX
@@ -3174,6 +3395,7 @@ void reshade::runtime::draw_technique_editor()
 			{
 				_techniques.insert(_techniques.begin(), std::move(_techniques[index]));
 				_techniques.erase(_techniques.begin() + 1 + index);
+				_effect_generation++;
 				save_current_preset();
 				ImGui::CloseCurrentPopup();
 			}
@@ -3181,6 +3403,7 @@ void reshade::runtime::draw_technique_editor()
 			{
 				_techniques.push_back(std::move(_techniques[index]));
 				_techniques.erase(_techniques.begin() + index);
+				_effect_generation++;
 				save_current_preset();
 				ImGui::CloseCurrentPopup();
 			}
@@ -3299,6 +3522,7 @@ void reshade::runtime::draw_technique_editor()
 			}
 
 			_selected_technique = hovered_technique_index;
+			_effect_generation++;
 			save_current_preset();
 			return;
 		}
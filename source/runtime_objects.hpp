@@ -6,6 +6,7 @@
 #pragma once
 
 #include "effect_module.hpp"
+#include "duration_histogram.hpp"
 
 namespace reshade
 {
@@ -112,6 +113,8 @@ namespace reshade
 		size_t effect_index = std::numeric_limits<size_t>::max();
 		std::vector<size_t> shared;
 		bool loaded = false;
+		// Block-compressed format the resource was created with to upload the image file as is, or unknown if it is decoded instead
+		api::format compressed_format = api::format::unknown;
 
 		api::resource resource = {};
 		api::resource_view srv[2] = {};
@@ -227,9 +230,12 @@ namespace reshade
 		unsigned int toggle_key_data[4] = {};
 		moving_average<uint64_t, 60> average_cpu_duration;
 		moving_average<uint64_t, 60> average_gpu_duration;
+		duration_histogram cpu_duration_histogram;
+		duration_histogram gpu_duration_histogram;
 
 		struct pass_data
 		{
+			duration_histogram gpu_duration_histogram;
 			api::resource_view render_target_views[8] = {};
 			api::pipeline pipeline = {};
 			api::descriptor_set texture_set = {};
@@ -273,6 +279,8 @@ namespace reshade
 		api::descriptor_set sampler_set = {};
 		api::query_pool query_pool = {};
 		std::vector<binding_data> texture_semantic_to_binding;
+		// Descriptors of textures that use the block-compressed data of their image file, with the unique texture name in place of the semantic, so that they can be updated when such a texture is recreated uncompressed (see 'runtime::update_texture')
+		std::vector<binding_data> compressed_texture_to_binding;
 	};
 #endif
 }
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "trace_markers.hpp"
+#include "dll_log.hpp"
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <Windows.h>
+
+struct trace_event
+{
+	const char *name;
+	char detail[40];
+	std::chrono::steady_clock::time_point begin;
+	std::chrono::steady_clock::time_point end;
+};
+
+struct thread_buffer
+{
+	explicit thread_buffer(DWORD thread_id) : thread_id(thread_id) {}
+
+	const DWORD thread_id;
+	// Only ever contended while a capture is started or stopped, since every thread records into its own buffer
+	std::mutex mutex;
+	// Ring buffer of events, which grows up to its capacity, so that threads recording only a few events do not use much memory
+	std::vector<trace_event> events;
+	// Total number of events recorded during the current capture, including those that were overwritten
+	size_t num_events = 0;
+};
+
+static constexpr size_t s_buffer_capacity = 32768;
+
+static std::mutex s_buffers_mutex;
+// Buffers of all threads that recorded events, which are kept after a thread exits so that its events can still be written
+static std::vector<std::shared_ptr<thread_buffer>> s_buffers;
+static thread_local std::shared_ptr<thread_buffer> s_thread_buffer;
+static std::chrono::steady_clock::time_point s_capture_start;
+
+std::atomic<bool> reshade::trace::capturing = false;
+
+void reshade::trace::start_capture()
+{
+	const std::unique_lock<std::mutex> lock(s_buffers_mutex);
+
+	// Remove buffers of threads that exited, since only this list still references those
+	s_buffers.erase(std::remove_if(s_buffers.begin(), s_buffers.end(),
+		[](const std::shared_ptr<thread_buffer> &buffer) { return buffer.use_count() == 1; }), s_buffers.end());
+
+	for (const std::shared_ptr<thread_buffer> &buffer : s_buffers)
+	{
+		const std::unique_lock<std::mutex> buffer_lock(buffer->mutex);
+		buffer->events.clear();
+		buffer->num_events = 0;
+	}
+
+	s_capture_start = std::chrono::steady_clock::now();
+	capturing.store(true);
+
+	LOG(INFO) << "Started trace capture.";
+}
+
+static void write_json_string(FILE *file, const char *value)
+{
+	fputc('\"', file);
+	for (; *value != '\0'; ++value)
+	{
+		if (*value == '\"' || *value == '\\')
+			fputc('\\', file), fputc(*value, file);
+		else if (static_cast<unsigned char>(*value) < 0x20)
+			fprintf(file, "\\u%04x", static_cast<unsigned char>(*value));
+		else
+			fputc(*value, file);
+	}
+	fputc('\"', file);
+}
+
+bool reshade::trace::stop_capture(const std::filesystem::path &path)
+{
+	if (!capturing.exchange(false))
+		return false;
+
+	std::vector<std::pair<DWORD, std::vector<trace_event>>> thread_events;
+	size_t num_overwritten_events = 0;
+	std::chrono::steady_clock::time_point capture_start;
+
+	{
+		const std::unique_lock<std::mutex> lock(s_buffers_mutex);
+
+		capture_start = s_capture_start;
+
+		// Copy events out of the ring buffers, so that other threads are not blocked while the file is written
+		for (const std::shared_ptr<thread_buffer> &buffer : s_buffers)
+		{
+			const std::unique_lock<std::mutex> buffer_lock(buffer->mutex);
+
+			if (buffer->num_events == 0)
+				continue;
+
+			std::vector<trace_event> &events = thread_events.emplace_back(buffer->thread_id, std::vector<trace_event>()).second;
+
+			const size_t num_events = buffer->events.size();
+			num_overwritten_events += buffer->num_events - num_events;
+
+			events.reserve(num_events);
+			for (size_t i = buffer->num_events - num_events; i < buffer->num_events; ++i)
+				events.push_back(buffer->events[i % s_buffer_capacity]);
+		}
+	}
+
+	FILE *file = nullptr;
+	if (_wfopen_s(&file, path.c_str(), L"w") != 0)
+	{
+		LOG(ERROR) << "Failed to open " << path << " for writing trace events!";
+		return false;
+	}
+
+	const DWORD process_id = GetCurrentProcessId();
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+
+	bool first = true;
+	for (const auto &[thread_id, events] : thread_events)
+	{
+		for (const trace_event &event : events)
+		{
+			// Skip events that began before the capture was started (e.g. because their scope was entered during a previous capture)
+			if (event.begin < capture_start)
+				continue;
+
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%lu,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f",
+				first ? "" : ",\n",
+				event.name,
+				process_id,
+				thread_id,
+				std::chrono::duration<double, std::micro>(event.begin - capture_start).count(),
+				std::chrono::duration<double, std::micro>(event.end - event.begin).count());
+
+			if (event.detail[0] != '\0')
+			{
+				fputs(",\"args\":{\"detail\":", file);
+				write_json_string(file, event.detail);
+				fputc('}', file);
+			}
+
+			fputc('}', file);
+			first = false;
+		}
+	}
+
+	fputs("\n]}\n", file);
+
+	const bool success = ferror(file) == 0;
+	fclose(file);
+
+	if (!success)
+	{
+		LOG(ERROR) << "Failed to write trace events to " << path << '!';
+		return false;
+	}
+
+	if (num_overwritten_events != 0)
+		LOG(WARN) << "Trace capture was too long to keep all events, so the " << num_overwritten_events << " oldest were discarded.";
+
+	LOG(INFO) << "Saved trace capture to " << path << '.';
+	return true;
+}
+
+void reshade::trace::record(const char *name, const char *detail, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+{
+	if (s_thread_buffer == nullptr)
+	{
+		s_thread_buffer = std::make_shared<thread_buffer>(GetCurrentThreadId());
+
+		const std::unique_lock<std::mutex> lock(s_buffers_mutex);
+		s_buffers.push_back(s_thread_buffer);
+	}
+
+	thread_buffer &buffer = *s_thread_buffer;
+
+	const std::unique_lock<std::mutex> lock(buffer.mutex);
+
+	// Overwrite the oldest event once the buffer is full
+	trace_event &event = buffer.events.size() < s_buffer_capacity ? buffer.events.emplace_back() : buffer.events[buffer.num_events % s_buffer_capacity];
+	buffer.num_events++;
+	event.name = name;
+	if (detail != nullptr)
+		strncpy_s(event.detail, detail, _TRUNCATE);
+	else
+		event.detail[0] = '\0';
+	event.begin = begin;
+	event.end = end;
+}
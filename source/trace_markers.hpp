@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+namespace reshade::trace
+{
+	/// <summary>
+	/// Whether a capture is currently running. Markers check this before doing anything else, so that they cost a single load and branch while no capture is running.
+	/// </summary>
+	extern std::atomic<bool> capturing;
+
+	/// <summary>
+	/// Starts a new capture, discarding events recorded by any previous one.
+	/// Each thread records its events into its own ring buffer, which only keeps the most recent events if it overflows.
+	/// </summary>
+	void start_capture();
+	/// <summary>
+	/// Stops the running capture and writes all recorded events to a JSON file in the Chrome trace event format, which can be opened with Perfetto or "chrome://tracing".
+	/// </summary>
+	/// <param name="path">The path to the trace file.</param>
+	bool stop_capture(const std::filesystem::path &path);
+
+	/// <summary>
+	/// Appends a complete event to the ring buffer of the calling thread.
+	/// </summary>
+	/// <param name="name">Name of the event. This has to be a string literal, since only the pointer is stored.</param>
+	/// <param name="detail">Optional additional text shown with the event (like a file or technique name), which is copied and truncated to a few characters.</param>
+	void record(const char *name, const char *detail, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+
+	/// <summary>
+	/// Marks the lifetime of this object as an event on the timeline of the calling thread while a capture is running.
+	/// </summary>
+	class scope
+	{
+	public:
+		explicit scope(const char *name, const char *detail = nullptr)
+		{
+			if (capturing.load(std::memory_order_relaxed))
+			{
+				_name = name;
+				_detail = detail;
+				_begin = std::chrono::steady_clock::now();
+			}
+		}
+		~scope()
+		{
+			if (_name != nullptr)
+				record(_name, _detail, _begin, std::chrono::steady_clock::now());
+		}
+
+		scope(const scope &) = delete;
+		scope &operator=(const scope &) = delete;
+
+	private:
+		const char *_name = nullptr;
+		const char *_detail = nullptr;
+		std::chrono::steady_clock::time_point _begin;
+	};
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+
+/// <summary>
+/// Blocks of a <see cref="transient_descriptor_ring"/> that are owned by a single command list.
+/// This is not thread-safe, which is fine since a command list can only be recorded on one thread at a time.
+/// </summary>
+template <typename fence_type>
+struct transient_descriptor_block_list
+{
+	// Current position and end of the last acquired range of blocks, which descriptors are bump allocated from
+	uint32_t offset = 0;
+	uint32_t end = 0;
+	// Fence and value of the last submission of the command list, which has to complete before the blocks can be reused
+	fence_type *fence = nullptr;
+	uint64_t fence_value = 0;
+	// List of acquired ranges of blocks as pairs of first block index and block count
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+};
+
+/// <summary>
+/// Ring of transient descriptors, independent of the graphics API.
+/// The ring is divided into blocks that command lists acquire with atomic operations and then allocate descriptors from without any synchronization.
+/// Blocks are tagged with the fence value of the last submission of their command list when that is reset, and are only reused after the fence reached that value.
+/// </summary>
+/// <remarks>
+/// The <typeparamref name="fence_type"/> has to define a <c>uint64_t completed_value() const</c> and a <c>void wait(uint64_t value) const</c> method. Fences have to stay alive as long as the ring.
+/// Blocks of a command list that is never submitted itself (like a D3D12 bundle, which is executed by another command list) are reused right after release, unless whoever submits the executing command list calls <see cref="submit"/> for them too.
+/// </remarks>
+template <typename fence_type, uint32_t block_size>
+class transient_descriptor_ring
+{
+	// Block state while it is owned by a command list that was not reset yet (any other value is the fence value that has to be reached before the block may be reused)
+	static constexpr uint64_t in_use = ~0ull;
+
+public:
+	using block_list = transient_descriptor_block_list<fence_type>;
+
+	explicit transient_descriptor_ring(uint32_t size) :
+		_num_blocks(size / block_size), _blocks(new block_info[size / block_size]) {}
+
+	transient_descriptor_ring(const transient_descriptor_ring &) = delete;
+	transient_descriptor_ring &operator=(const transient_descriptor_ring &) = delete;
+
+	/// <summary>
+	/// Allocates a contiguous range of descriptors for a command list, acquiring new blocks if the current one is full.
+	/// </summary>
+	/// <param name="list">Blocks of the command list to allocate from.</param>
+	/// <param name="count">Number of descriptors to allocate.</param>
+	/// <param name="offset">Receives the index of the first allocated descriptor in the ring.</param>
+	/// <returns><c>true</c> if the descriptors were allocated, <c>false</c> if all blocks are owned by command lists that were not submitted yet.</returns>
+	bool allocate(block_list &list, uint32_t count, uint32_t &offset)
+	{
+		if (count > list.end - list.offset)
+		{
+			// Any space left in the current block is wasted, since allocations need to be contiguous
+			const uint32_t num_blocks = (count + block_size - 1) / block_size;
+
+			uint32_t first_block = 0;
+			if (!acquire_blocks(num_blocks, first_block))
+				return false;
+
+			list.ranges.emplace_back(first_block, num_blocks);
+			list.offset = first_block * block_size;
+			list.end = (first_block + num_blocks) * block_size;
+		}
+
+		offset = list.offset;
+		list.offset += count;
+		return true;
+	}
+
+	/// <summary>
+	/// Records the fence value that is signaled after the command list that owns the specified blocks was executed.
+	/// If a command list is executed multiple times before it is reset, only the last submission is tracked.
+	/// </summary>
+	void submit(block_list &list, fence_type *fence, uint64_t fence_value) const
+	{
+		assert(fence_value != in_use);
+
+		list.fence = fence;
+		list.fence_value = fence_value;
+	}
+
+	/// <summary>
+	/// Returns all blocks of a command list to the ring, after it was reset or destroyed.
+	/// Blocks of a command list that was never submitted can be reused right away, otherwise they are reused once the fence of the last submission completed.
+	/// </summary>
+	void release(block_list &list)
+	{
+		for (const std::pair<uint32_t, uint32_t> &range : list.ranges)
+		{
+			for (uint32_t i = range.first; i < range.first + range.second; ++i)
+			{
+				block_info &block = _blocks[i];
+				assert(block.state.load(std::memory_order_relaxed) == in_use);
+
+				block.fence = list.fence;
+				block.state.store(list.fence != nullptr ? list.fence_value : 0, std::memory_order_release);
+			}
+		}
+
+		list.ranges.clear();
+		list.offset = list.end = 0;
+		list.fence = nullptr;
+		list.fence_value = 0;
+	}
+
+private:
+	struct block_info
+	{
+		std::atomic<uint64_t> state = 0;
+		// Only accessed by the thread that set the state to 'in_use'
+		fence_type *fence = nullptr;
+	};
+
+	bool acquire_blocks(uint32_t num_blocks, uint32_t &first_block)
+	{
+		if (num_blocks > _num_blocks)
+			return false;
+
+		while (true)
+		{
+			// Start after the blocks that were acquired last, which are followed by the oldest ones, and skip past any that are still in flight
+			const uint32_t start = _next_block.load(std::memory_order_relaxed);
+
+			for (uint32_t i = 0; i < _num_blocks; ++i)
+			{
+				first_block = (start + i) % _num_blocks;
+				if (first_block + num_blocks > _num_blocks)
+					continue; // Ranges cannot wrap around the end of the ring
+
+				if (try_acquire_range(first_block, num_blocks))
+				{
+					_next_block.store((first_block + num_blocks) % _num_blocks, std::memory_order_relaxed);
+					return true;
+				}
+			}
+
+			// No range is available, so wait for the oldest submission that is still in flight before trying again
+			if (!wait_for_any_block(start))
+				return false; // Remaining blocks are all owned by command lists that were not submitted yet
+		}
+	}
+
+	bool try_acquire_range(uint32_t first_block, uint32_t num_blocks)
+	{
+		for (uint32_t i = 0; i < num_blocks; ++i)
+		{
+			if (!try_acquire_block(_blocks[first_block + i]))
+			{
+				// Blocks acquired so far were free, so can simply mark them as free again
+				for (uint32_t k = 0; k < i; ++k)
+					_blocks[first_block + k].state.store(0, std::memory_order_release);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool try_acquire_block(block_info &block)
+	{
+		uint64_t state = block.state.load(std::memory_order_relaxed);
+		if (state == in_use)
+			return false;
+
+		// Take ownership first, since the fence of the block may only be read while owning it
+		if (!block.state.compare_exchange_strong(state, in_use, std::memory_order_acquire, std::memory_order_relaxed))
+			return false;
+
+		if (state != 0 && block.fence->completed_value() < state)
+		{
+			// Block is still in flight, so give it back
+			block.state.store(state, std::memory_order_release);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool wait_for_any_block(uint32_t start)
+	{
+		for (uint32_t i = 0; i < _num_blocks; ++i)
+		{
+			block_info &block = _blocks[(start + i) % _num_blocks];
+
+			uint64_t state = block.state.load(std::memory_order_relaxed);
+			if (state == in_use || !block.state.compare_exchange_strong(state, in_use, std::memory_order_acquire, std::memory_order_relaxed))
+				continue;
+
+			fence_type *const fence = block.fence;
+			block.state.store(state, std::memory_order_release);
+
+			// Only wait on blocks that are actually still in flight, so that this eventually fails if nothing is left to wait for
+			if (state == 0 || fence->completed_value() >= state)
+				continue;
+
+			fence->wait(state);
+			return true;
+		}
+
+		return false;
+	}
+
+	const uint32_t _num_blocks;
+	const std::unique_ptr<block_info[]> _blocks;
+	std::atomic<uint32_t> _next_block = 0;
+};
@@ -4,12 +4,12 @@
  */
 
 #include "hook_manager.hpp"
-#include "lockfree_linear_map.hpp"
+#include "lockfree_hash_map.hpp"
 #include "vulkan_hooks.hpp"
 #include "vulkan_impl_device.hpp"
 
-extern lockfree_linear_map<void *, instance_dispatch_table, 4> g_instance_dispatch;
-extern lockfree_linear_map<void *, reshade::vulkan::device_impl *, 8> g_vulkan_devices;
+extern lockfree_hash_map<void *, instance_dispatch_table, 4> g_instance_dispatch;
+extern lockfree_hash_map<void *, reshade::vulkan::device_impl *, 8> g_vulkan_devices;
 
 #define HOOK_PROC(name) \
 	if (0 == std::strcmp(pName, "vk" #name)) \
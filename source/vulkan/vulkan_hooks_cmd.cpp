@@ -3,14 +3,14 @@
  * SPDX-License-Identifier: BSD-3-Clause OR MIT
  */
 
-#include "lockfree_linear_map.hpp"
+#include "lockfree_hash_map.hpp"
 #include "vulkan_hooks.hpp"
 #include "vulkan_impl_device.hpp"
 #include "vulkan_impl_command_list.hpp"
 #include "vulkan_impl_type_convert.hpp"
 #include <algorithm>
 
-extern lockfree_linear_map<void *, reshade::vulkan::device_impl *, 8> g_vulkan_devices;
+extern lockfree_hash_map<void *, reshade::vulkan::device_impl *, 8> g_vulkan_devices;
 
 #define GET_DISPATCH_PTR(name, object) \
 	GET_DISPATCH_PTR_FROM(name, g_vulkan_devices.at(dispatch_key_from_handle(object)))
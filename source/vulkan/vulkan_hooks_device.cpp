@@ -5,7 +5,7 @@
 
 #include "dll_log.hpp"
 #include "hook_manager.hpp"
-#include "lockfree_linear_map.hpp"
+#include "lockfree_hash_map.hpp"
 #include "vulkan_hooks.hpp"
 #include "vulkan_impl_device.hpp"
 #include "vulkan_impl_command_queue.hpp"
@@ -15,11 +15,11 @@
 // Set during Vulkan device creation and presentation, to avoid hooking internal D3D devices created e.g. by NVIDIA Ansel and Optimus
 extern thread_local bool g_in_dxgi_runtime;
 
-lockfree_linear_map<void *, reshade::vulkan::device_impl *, 8> g_vulkan_devices;
-static lockfree_linear_map<VkQueue, reshade::vulkan::command_queue_impl *, 16> s_vulkan_queues;
-extern lockfree_linear_map<void *, instance_dispatch_table, 4> g_instance_dispatch;
-extern lockfree_linear_map<VkSurfaceKHR, HWND, 16> g_surface_windows;
-static lockfree_linear_map<VkSwapchainKHR, reshade::vulkan::swapchain_impl *, 16> s_vulkan_swapchains;
+lockfree_hash_map<void *, reshade::vulkan::device_impl *, 8> g_vulkan_devices;
+static lockfree_hash_map<VkQueue, reshade::vulkan::command_queue_impl *, 16> s_vulkan_queues;
+extern lockfree_hash_map<void *, instance_dispatch_table, 4> g_instance_dispatch;
+extern lockfree_hash_map<VkSurfaceKHR, HWND, 16> g_surface_windows;
+static lockfree_hash_map<VkSwapchainKHR, reshade::vulkan::swapchain_impl *, 16> s_vulkan_swapchains;
 
 #define GET_DISPATCH_PTR(name, object) \
 	GET_DISPATCH_PTR_FROM(name, g_vulkan_devices.at(dispatch_key_from_handle(object)))
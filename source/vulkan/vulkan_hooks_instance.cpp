@@ -6,11 +6,11 @@
 #include "version.h"
 #include "dll_log.hpp"
 #include "hook_manager.hpp"
-#include "lockfree_linear_map.hpp"
+#include "lockfree_hash_map.hpp"
 #include "vulkan_hooks.hpp"
 
-lockfree_linear_map<void *, instance_dispatch_table, 4> g_instance_dispatch;
-lockfree_linear_map<VkSurfaceKHR, HWND, 16> g_surface_windows;
+lockfree_hash_map<void *, instance_dispatch_table, 4> g_instance_dispatch;
+lockfree_hash_map<VkSurfaceKHR, HWND, 16> g_surface_windows;
 
 #define GET_DISPATCH_PTR(name, object) \
 	PFN_vk##name trampoline = g_instance_dispatch.at(dispatch_key_from_handle(object)).name; \
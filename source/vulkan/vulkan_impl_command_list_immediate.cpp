@@ -130,6 +130,8 @@ bool reshade::vulkan::command_list_immediate_impl::flush(VkQueue queue, std::vec
 		return false;
 	}
 
+	_cmd_submission_index[_cmd_index] = ++_submission_index;
+
 	// Only signal and wait on a semaphore if the submit this flush is executed in originally did
 	if (!wait_semaphores.empty())
 	{
@@ -171,3 +173,13 @@ bool reshade::vulkan::command_list_immediate_impl::flush_and_wait(VkQueue queue)
 	// Wait for the submitted work to finish and reset fence again for next use
 	return vk.WaitForFences(_device_impl->_orig, 1, &_cmd_fences[cmd_index_to_wait_on], VK_TRUE, UINT64_MAX) == VK_SUCCESS;
 }
+
+uint64_t reshade::vulkan::command_list_immediate_impl::completed_submission_index() const
+{
+	// Take the oldest submission that has not finished yet, all submissions before it have finished as well
+	uint64_t completed_index = _submission_index;
+	for (uint32_t i = 0; i < NUM_COMMAND_FRAMES; ++i)
+		if (vk.GetFenceStatus(_device_impl->_orig, _cmd_fences[i]) == VK_NOT_READY)
+			completed_index = std::min(completed_index, _cmd_submission_index[i] - 1);
+	return completed_index;
+}
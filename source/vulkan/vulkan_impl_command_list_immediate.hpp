@@ -20,8 +20,13 @@ namespace reshade::vulkan
 		bool flush(VkQueue queue, std::vector<VkSemaphore> &wait_semaphores);
 		bool flush_and_wait(VkQueue queue);
 
+		uint64_t pending_submission_index() const { return _submission_index + (_has_commands ? 1 : 0); }
+		uint64_t completed_submission_index() const;
+
 	private:
 		uint32_t _cmd_index = 0;
+		uint64_t _submission_index = 0;
+		uint64_t _cmd_submission_index[NUM_COMMAND_FRAMES] = {};
 		VkCommandPool _cmd_pool = VK_NULL_HANDLE;
 		VkFence _cmd_fences[NUM_COMMAND_FRAMES] = {};
 		VkSemaphore _cmd_semaphores[NUM_COMMAND_FRAMES] = {};
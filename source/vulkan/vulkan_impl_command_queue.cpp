@@ -83,6 +83,18 @@ void reshade::vulkan::command_queue_impl::flush_immediate_command_list(std::vect
 		_immediate_cmd_list->flush(_orig, wait_semaphores);
 }
 
+uint64_t reshade::vulkan::command_queue_impl::get_timestamp_frequency() const
+{
+	VkPhysicalDeviceProperties properties = {};
+	_device_impl->_instance_dispatch_table.GetPhysicalDeviceProperties(_device_impl->_physical_device, &properties);
+
+	// Timestamp period is the number of nanoseconds per tick
+	if (properties.limits.timestampPeriod <= 0.0f)
+		return 0;
+
+	return static_cast<uint64_t>(1000000000.0 / properties.limits.timestampPeriod + 0.5);
+}
+
 void reshade::vulkan::command_queue_impl::begin_debug_event(const char *label, const float color[4])
 {
 	if (vk.QueueBeginDebugUtilsLabelEXT == nullptr)
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "api_trace_buffer.hpp"
+#include "test_utils.hpp"
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <sstream>
+
+struct draw_call
+{
+	uint32_t indices, instances, first_index;
+	int32_t vertex_offset;
+	uint32_t first_instance;
+};
+
+static std::vector<draw_call> generate_draws(size_t num_draws)
+{
+	std::mt19937 rng(0x5EED);
+	std::vector<draw_call> draws(num_draws);
+	for (draw_call &draw : draws)
+		draw = { 3 * (1 + rng() % 20000), 1 + rng() % 4, rng() % 100000, static_cast<int32_t>(rng() % 50000), 0 };
+	return draws;
+}
+
+// How the 'draw_indexed' callback recorded calls before, by formatting a string and appending it to a list under a global lock
+static std::mutex s_mutex;
+static std::vector<std::string> s_capture_log;
+
+static void record_as_string(const draw_call &draw)
+{
+	std::stringstream s; s << "draw_indexed(" << draw.indices << ", " << draw.instances << ", " << draw.first_index << ", " << draw.vertex_offset << ", " << draw.first_instance << ")";
+	const std::lock_guard<std::mutex> lock(s_mutex); s_capture_log.push_back(s.str());
+}
+
+int main()
+{
+	constexpr size_t num_draws = 1000000;
+	// The capture thread drains the buffers every millisecond, so read them back after this many calls, which is well below the buffer capacity
+	constexpr size_t drain_interval = api_trace::thread_buffer::capacity / 4;
+
+	const std::vector<draw_call> draws = generate_draws(num_draws);
+
+	const auto buffer = std::make_unique<api_trace::thread_buffer>();
+	std::vector<api_trace::record> records;
+	records.reserve(num_draws);
+
+	const double record_ms = test::measure_best_of_3([&]() {
+		records.clear();
+		for (size_t i = 0; i < num_draws; ++i)
+		{
+			const draw_call &draw = draws[i];
+			api_trace::write_records(*buffer, std::chrono::steady_clock::now().time_since_epoch().count(), api_trace::record_type::draw_indexed, 0, { draw.indices, draw.instances, draw.first_index, static_cast<uint32_t>(draw.vertex_offset), draw.first_instance });
+
+			if ((i + 1) % drain_interval == 0)
+				api_trace::read_records(*buffer, records);
+		}
+		api_trace::read_records(*buffer, records);
+	});
+
+	s_capture_log.reserve(num_draws);
+
+	const double string_ms = test::measure_best_of_3([&]() {
+		s_capture_log.clear();
+		for (const draw_call &draw : draws)
+			record_as_string(draw);
+	});
+
+	std::printf("%zu draw calls, best of 3 runs:\n", num_draws);
+	std::printf("  binary records:             %.1f ns/call (including reading them back every %zu calls)\n", record_ms * 1000000.0 / num_draws, drain_interval);
+	std::printf("  formatted string with lock: %.1f ns/call\n", string_ms * 1000000.0 / num_draws);
+
+	// Every call has to be recorded, and decode to the same text the string version wrote
+	if (records.size() != num_draws || buffer->dropped_records != 0)
+	{
+		std::fprintf(stderr, "Recorded %zu of %zu calls (%u dropped)\n", records.size(), num_draws, buffer->dropped_records.load());
+		return 1;
+	}
+
+	for (size_t i = 0; i < num_draws; i += num_draws / 100)
+	{
+		const api_trace::record *it = records.data() + i;
+		const std::string text = api_trace::format_record(it, records.data() + records.size());
+		if (text.find(s_capture_log[i]) == std::string::npos)
+		{
+			std::fprintf(stderr, "Record %zu decodes to \"%s\" instead of \"%s\"\n", i, text.c_str(), s_capture_log[i].c_str());
+			return 1;
+		}
+	}
+
+	return 0;
+}
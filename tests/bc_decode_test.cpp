@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "bc_decode.hpp"
+#include "test_utils.hpp"
+#include <random>
+#include <cstdio>
+
+// Scalar per-texel decoders the block decoders replaced, which their output has to match exactly
+
+static void unpack_r5g6b5(uint16_t data, uint8_t rgb[3])
+{
+	uint32_t temp;
+	temp =  (data           >> 11) * 255 + 16;
+	rgb[0] = static_cast<uint8_t>((temp / 32 + temp) / 32);
+	temp = ((data & 0x07E0) >>  5) * 255 + 32;
+	rgb[1] = static_cast<uint8_t>((temp / 64 + temp) / 64);
+	temp =  (data & 0x001F)        * 255 + 16;
+	rgb[2] = static_cast<uint8_t>((temp / 32 + temp) / 32);
+}
+static void unpack_bc1_value(const uint8_t color_0[3], const uint8_t color_1[3], uint32_t color_index, uint8_t result[4], bool not_degenerate = true)
+{
+	switch (color_index)
+	{
+	case 0:
+		for (int c = 0; c < 3; ++c)
+			result[c] = color_0[c];
+		result[3] = 255;
+		break;
+	case 1:
+		for (int c = 0; c < 3; ++c)
+			result[c] = color_1[c];
+		result[3] = 255;
+		break;
+	case 2:
+		for (int c = 0; c < 3; ++c)
+			result[c] = not_degenerate ? (2 * color_0[c] + color_1[c]) / 3 : (color_0[c] + color_1[c]) / 2;
+		result[3] = 255;
+		break;
+	case 3:
+		for (int c = 0; c < 3; ++c)
+			result[c] = not_degenerate ? (color_0[c] + 2 * color_1[c]) / 3 : 0;
+		result[3] = not_degenerate ? 255 : 0;
+		break;
+	}
+}
+static void unpack_bc4_value(uint8_t alpha_0, uint8_t alpha_1, uint32_t alpha_index, uint8_t *result)
+{
+	const bool interpolation_type = alpha_0 > alpha_1;
+
+	switch (alpha_index)
+	{
+	case 0:
+		*result = alpha_0;
+		break;
+	case 1:
+		*result = alpha_1;
+		break;
+	case 2:
+		*result = interpolation_type ? (6 * alpha_0 + 1 * alpha_1) / 7 : (4 * alpha_0 + 1 * alpha_1) / 5;
+		break;
+	case 3:
+		*result = interpolation_type ? (5 * alpha_0 + 2 * alpha_1) / 7 : (3 * alpha_0 + 2 * alpha_1) / 5;
+		break;
+	case 4:
+		*result = interpolation_type ? (4 * alpha_0 + 3 * alpha_1) / 7 : (2 * alpha_0 + 3 * alpha_1) / 5;
+		break;
+	case 5:
+		*result = interpolation_type ? (3 * alpha_0 + 4 * alpha_1) / 7 : (1 * alpha_0 + 4 * alpha_1) / 5;
+		break;
+	case 6:
+		*result = interpolation_type ? (2 * alpha_0 + 5 * alpha_1) / 7 : 0;
+		break;
+	case 7:
+		*result = interpolation_type ? (1 * alpha_0 + 6 * alpha_1) / 7 : 255;
+		break;
+	}
+}
+
+static uint64_t read_indices_3bit(const uint8_t *src)
+{
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; ++i)
+		indices |= static_cast<uint64_t>(src[i]) << (8 * i);
+	return indices;
+}
+
+static void reference_decode_bc1_block(const uint8_t *src, uint8_t rgba[64], bool allow_three_color_mode)
+{
+	const uint16_t color_0 = static_cast<uint16_t>(src[0] | (src[1] << 8));
+	const uint16_t color_1 = static_cast<uint16_t>(src[2] | (src[3] << 8));
+	const uint32_t color_i = src[4] | (src[5] << 8) | (src[6] << 16) | (static_cast<uint32_t>(src[7]) << 24);
+
+	uint8_t color_0_rgb[3];
+	unpack_r5g6b5(color_0, color_0_rgb);
+	uint8_t color_1_rgb[3];
+	unpack_r5g6b5(color_1, color_1_rgb);
+
+	for (int i = 0; i < 16; ++i)
+		unpack_bc1_value(color_0_rgb, color_1_rgb, (color_i >> (2 * i)) & 0x3, rgba + i * 4, !allow_three_color_mode || color_0 > color_1);
+}
+static void reference_decode_bc3_block(const uint8_t *src, uint8_t rgba[64])
+{
+	reference_decode_bc1_block(src + 8, rgba, false);
+
+	const uint64_t alpha_i = read_indices_3bit(src + 2);
+	for (int i = 0; i < 16; ++i)
+		unpack_bc4_value(src[0], src[1], (alpha_i >> (3 * i)) & 0x7, rgba + i * 4 + 3);
+}
+static void reference_decode_bc4_block(const uint8_t *src, uint8_t rgba[64])
+{
+	const uint64_t red_i = read_indices_3bit(src + 2);
+	for (int i = 0; i < 16; ++i)
+	{
+		uint8_t *const dst = rgba + i * 4;
+		unpack_bc4_value(src[0], src[1], (red_i >> (3 * i)) & 0x7, dst);
+		dst[1] = dst[0];
+		dst[2] = dst[0];
+		dst[3] = 255;
+	}
+}
+static void reference_decode_bc5_block(const uint8_t *src, uint8_t rgba[64])
+{
+	const uint64_t red_i = read_indices_3bit(src + 2);
+	const uint64_t green_i = read_indices_3bit(src + 10);
+	for (int i = 0; i < 16; ++i)
+	{
+		uint8_t *const dst = rgba + i * 4;
+		unpack_bc4_value(src[0], src[1], (red_i >> (3 * i)) & 0x7, dst);
+		unpack_bc4_value(src[8], src[9], (green_i >> (3 * i)) & 0x7, dst + 1);
+		dst[2] = 0;
+		dst[3] = 255;
+	}
+}
+
+static void unpack_texels(const uint32_t texels[16], uint8_t rgba[64])
+{
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < 4; ++c)
+			rgba[i * 4 + c] = static_cast<uint8_t>(texels[i] >> (8 * c));
+}
+
+template <void(*decode_block)(const uint8_t *src, uint32_t texels[16]), typename F>
+static void compare_with_reference(const char *name, size_t block_size, F reference_decode_block)
+{
+	std::mt19937 rng(0x5EED);
+
+	uint8_t block[16];
+	uint32_t texels[16];
+	uint8_t actual[64], expected[64];
+
+	for (uint32_t n = 0; n < 1000000; ++n)
+	{
+		for (size_t i = 0; i < block_size; ++i)
+			block[i] = static_cast<uint8_t>(rng());
+
+		// Also cover the special case of equal endpoints (in all formats, which store their endpoints in the first bytes of each 8 byte half)
+		if (n % 16 == 0)
+			for (size_t i = 0; i < block_size; i += 8)
+				block[i + 1] = block[i + 2] = block[i + 3] = block[i];
+
+		decode_block(block, texels);
+		unpack_texels(texels, actual);
+		reference_decode_block(block, expected);
+
+		CHECK_MESSAGE(std::memcmp(actual, expected, sizeof(actual)) == 0, "%s: block %u does not match the reference decoder", name, n);
+	}
+}
+
+class bit_writer
+{
+public:
+	void write(uint32_t value, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; ++i, ++_pos)
+			if ((value >> i) & 1)
+				_data[_pos / 8] |= static_cast<uint8_t>(1 << (_pos % 8));
+	}
+
+	const uint8_t *data() const { return _data; }
+	uint32_t pos() const { return _pos; }
+
+private:
+	uint8_t _data[16] = {};
+	uint32_t _pos = 0;
+};
+
+static void check_bc7_mode6()
+{
+	// Mode 6 has a single subset with 7-bit RGBA endpoints, a P-bit per endpoint and 4-bit indices
+	const uint32_t e0[4] = { 10, 20, 30, 40 }, p0 = 1;
+	const uint32_t e1[4] = { 100, 110, 120, 127 }, p1 = 0;
+
+	bit_writer bits;
+	bits.write(1 << 6, 7);
+	for (uint32_t c = 0; c < 4; ++c)
+		bits.write(e0[c], 7), bits.write(e1[c], 7);
+	bits.write(p0, 1);
+	bits.write(p1, 1);
+	for (uint32_t i = 0; i < 16; ++i)
+		bits.write(i, i == 0 ? 3 : 4);
+
+	CHECK_MESSAGE(bits.pos() == 128, "BC7 mode 6: test block has wrong size");
+
+	uint32_t texels[16];
+	bc_decode::decode_bc7_block(bits.data(), texels);
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const uint32_t weight = bc_decode::bc7_weights_4[i];
+
+		uint32_t expected = 0;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			const uint32_t a = (e0[c] << 1) | p0;
+			const uint32_t b = (e1[c] << 1) | p1;
+			expected |= (((64 - weight) * a + weight * b + 32) >> 6) << (8 * c);
+		}
+
+		CHECK_MESSAGE(texels[i] == expected, "BC7 mode 6: texel %u is %08X, expected %08X", i, texels[i], expected);
+	}
+}
+static void check_bc7_reserved_mode()
+{
+	const uint8_t block[16] = {};
+
+	uint32_t texels[16];
+	std::memset(texels, 0xFF, sizeof(texels));
+	bc_decode::decode_bc7_block(block, texels);
+
+	for (uint32_t i = 0; i < 16; ++i)
+		CHECK_MESSAGE(texels[i] == 0, "BC7 reserved mode: texel %u is not transparent black", i);
+}
+
+int main()
+{
+	compare_with_reference<bc_decode::decode_bc1_block>("BC1", 8, [](const uint8_t *src, uint8_t rgba[64]) { reference_decode_bc1_block(src, rgba, true); });
+	compare_with_reference<bc_decode::decode_bc3_block>("BC3", 16, reference_decode_bc3_block);
+	compare_with_reference<bc_decode::decode_bc4_block>("BC4", 8, reference_decode_bc4_block);
+	compare_with_reference<bc_decode::decode_bc5_block>("BC5", 16, reference_decode_bc5_block);
+
+	check_bc7_mode6();
+	check_bc7_reserved_mode();
+
+	return test::exit_code("All block decoders passed.");
+}
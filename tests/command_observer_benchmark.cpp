@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "mock_command_list.hpp"
+#include "addon_manager.hpp"
+#include "test_utils.hpp"
+#include <random>
+
+using namespace reshade;
+
+// These are defined in 'addon_manager.cpp' in the real build, which also loads add-ons and therefore depends on Windows
+bool reshade::addon_event_profiling = false;
+std::vector<addon_event_callback> reshade::addon_event_list[static_cast<uint32_t>(addon_event::max)];
+
+struct command
+{
+	addon_event ev;
+	uint32_t count;
+	uint32_t args[5];
+	uint64_t handles[4];
+	api::resource_usage old_states[4];
+	api::resource_usage new_states[4];
+};
+
+/// <summary>
+/// Generates a frame with a command mix similar to a recorded game frame: mostly indexed draws, with pipeline changes, render target changes and barriers in between.
+/// </summary>
+static std::vector<command> generate_frame(size_t num_commands)
+{
+	std::mt19937 rng(0x5EED);
+	std::vector<command> stream(num_commands);
+
+	for (command &cmd : stream)
+	{
+		const uint32_t kind = rng() % 100;
+		cmd.ev =
+			kind < 68 ? addon_event::draw_indexed :
+			kind < 72 ? addon_event::draw :
+			kind < 86 ? addon_event::bind_pipeline :
+			kind < 92 ? addon_event::barrier :
+			kind < 97 ? addon_event::bind_render_targets_and_depth_stencil :
+			addon_event::dispatch;
+		cmd.count = 1 + rng() % 4;
+		for (uint32_t &arg : cmd.args)
+			arg = rng() % 4096;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			cmd.handles[i] = 0x10000 + (rng() % 1024) * 16;
+			cmd.old_states[i] = api::resource_usage::render_target;
+			cmd.new_states[i] = api::resource_usage::shader_resource;
+		}
+	}
+
+	return stream;
+}
+
+/// <summary>
+/// Calls the add-on events for every command in the stream, like the API wrappers do while an application records commands.
+/// </summary>
+static void replay(api::command_list *cmd_list, const std::vector<command> &stream)
+{
+	for (const command &cmd : stream)
+	{
+		switch (cmd.ev)
+		{
+		case addon_event::barrier:
+			invoke_addon_event<addon_event::barrier>(cmd_list, cmd.count, reinterpret_cast<const api::resource *>(cmd.handles), cmd.old_states, cmd.new_states);
+			break;
+		case addon_event::bind_render_targets_and_depth_stencil:
+			invoke_addon_event<addon_event::bind_render_targets_and_depth_stencil>(cmd_list, cmd.count, reinterpret_cast<const api::resource_view *>(cmd.handles), api::resource_view { cmd.handles[3] });
+			break;
+		case addon_event::bind_pipeline:
+			invoke_addon_event<addon_event::bind_pipeline>(cmd_list, api::pipeline_stage::all, api::pipeline { cmd.handles[0] });
+			break;
+		case addon_event::draw:
+			invoke_addon_event<addon_event::draw>(cmd_list, cmd.args[0], cmd.args[1], cmd.args[2], cmd.args[3]);
+			break;
+		case addon_event::draw_indexed:
+			invoke_addon_event<addon_event::draw_indexed>(cmd_list, cmd.args[0], cmd.args[1], cmd.args[2], static_cast<int32_t>(cmd.args[3]), cmd.args[4]);
+			break;
+		case addon_event::dispatch:
+			invoke_addon_event<addon_event::dispatch>(cmd_list, cmd.args[0], cmd.args[1], cmd.args[2]);
+			break;
+		}
+	}
+}
+
+struct statistics
+{
+	uint64_t draws = 0;
+	uint64_t pipelines = 0;
+	uint64_t barriers = 0;
+	uint64_t render_targets = 0;
+};
+
+// Simple add-on that counts commands, once implemented with callbacks and once as a command observer
+static statistics s_callback_stats;
+static statistics s_observer_stats;
+
+static void on_barrier(api::command_list *, uint32_t count, const api::resource *, const api::resource_usage *, const api::resource_usage *)
+{
+	s_callback_stats.barriers += count;
+}
+static void on_bind_render_targets_and_depth_stencil(api::command_list *, uint32_t count, const api::resource_view *, api::resource_view)
+{
+	s_callback_stats.render_targets += count;
+}
+static void on_bind_pipeline(api::command_list *, api::pipeline_stage, api::pipeline)
+{
+	s_callback_stats.pipelines++;
+}
+static bool on_draw(api::command_list *, uint32_t, uint32_t, uint32_t, uint32_t)
+{
+	s_callback_stats.draws++;
+	return false;
+}
+static bool on_draw_indexed(api::command_list *, uint32_t, uint32_t, uint32_t, int32_t, uint32_t)
+{
+	s_callback_stats.draws++;
+	return false;
+}
+static bool on_dispatch(api::command_list *, uint32_t, uint32_t, uint32_t)
+{
+	s_callback_stats.draws++;
+	return false;
+}
+
+static void on_execute(api::command_queue *, api::command_list *, const command_record *records, size_t size)
+{
+	const command_record *const end = reinterpret_cast<const command_record *>(reinterpret_cast<const uint8_t *>(records) + size);
+	for (const command_record *record = records; record < end; record = record->next())
+	{
+		switch (record->ev)
+		{
+		case addon_event::barrier:
+			s_observer_stats.barriers += static_cast<const barrier_record *>(record)->count;
+			break;
+		case addon_event::bind_render_targets_and_depth_stencil:
+			s_observer_stats.render_targets += static_cast<const bind_render_targets_and_depth_stencil_record *>(record)->count;
+			break;
+		case addon_event::bind_pipeline:
+			s_observer_stats.pipelines++;
+			break;
+		case addon_event::draw:
+		case addon_event::draw_indexed:
+		case addon_event::dispatch:
+			s_observer_stats.draws++;
+			break;
+		}
+	}
+}
+
+static const addon_event s_observed_events[] = {
+	addon_event::barrier,
+	addon_event::bind_render_targets_and_depth_stencil,
+	addon_event::bind_pipeline,
+	addon_event::draw,
+	addon_event::draw_indexed,
+	addon_event::dispatch,
+};
+
+template <addon_event ev>
+static void register_callback(typename addon_event_traits<ev>::decl callback)
+{
+	addon_event_list[static_cast<uint32_t>(ev)].push_back({ reinterpret_cast<void *>(callback), 0xFFFFFFFF, nullptr });
+}
+
+int main()
+{
+	constexpr size_t num_commands = 23126;
+	constexpr int num_frames = 100;
+
+	const std::vector<command> stream = generate_frame(num_commands);
+	test::mock_command_list cmd_list;
+
+	const double none_ms = test::measure_best_of_3([&]() {
+		for (int frame = 0; frame < num_frames; ++frame)
+			replay(&cmd_list, stream);
+	}) / num_frames;
+
+	register_callback<addon_event::barrier>(&on_barrier);
+	register_callback<addon_event::bind_render_targets_and_depth_stencil>(&on_bind_render_targets_and_depth_stencil);
+	register_callback<addon_event::bind_pipeline>(&on_bind_pipeline);
+	register_callback<addon_event::draw>(&on_draw);
+	register_callback<addon_event::draw_indexed>(&on_draw_indexed);
+	register_callback<addon_event::dispatch>(&on_dispatch);
+
+	const double callback_ms = test::measure_best_of_3([&]() {
+		for (int frame = 0; frame < num_frames; ++frame)
+			replay(&cmd_list, stream);
+	}) / num_frames;
+
+	for (auto &event_list : addon_event_list)
+		event_list.clear();
+
+	addon_command_observers.push_back(&on_execute);
+	for (const addon_event ev : s_observed_events)
+		addon_event_observer_count[static_cast<uint32_t>(ev)]++;
+
+	// Warm up once, so that the record buffer has its final size
+	replay(&cmd_list, stream);
+	const size_t record_bytes = get_command_record_buffer(&cmd_list).size;
+	handle_command_records_reset(&cmd_list);
+
+	const double record_ms = test::measure_best_of_3([&]() {
+		for (int frame = 0; frame < num_frames; ++frame)
+		{
+			replay(&cmd_list, stream);
+			handle_command_records_reset(&cmd_list);
+		}
+	}) / num_frames;
+
+	const statistics callback_stats = s_callback_stats;
+	s_callback_stats = {};
+	s_observer_stats = {};
+
+	const double observer_ms = test::measure_best_of_3([&]() {
+		for (int frame = 0; frame < num_frames; ++frame)
+		{
+			replay(&cmd_list, stream);
+			handle_command_records_execute(nullptr, &cmd_list, true);
+		}
+	}) / num_frames;
+
+	handle_command_records_destroy(&cmd_list);
+
+	// Copying the same amount of data is the lower bound for recording it
+	std::vector<uint8_t> source(record_bytes, 0xCD), dest(record_bytes);
+	const double memcpy_ms = test::measure_best_of_3([&]() {
+		for (int frame = 0; frame < num_frames; ++frame)
+		{
+			std::memcpy(dest.data(), source.data(), record_bytes);
+			source[frame % record_bytes] = dest[(frame * 7) % record_bytes]; // Keep the copy from being optimized away
+		}
+	}) / num_frames;
+
+	std::printf("%zu commands per frame, %zu bytes of records, best of 3 runs of %d frames:\n", num_commands, record_bytes, num_frames);
+	std::printf("  no add-on:               %.3f ms/frame\n", none_ms);
+	std::printf("  callbacks:               %.3f ms/frame\n", callback_ms);
+	std::printf("  observer recording:      %.3f ms/frame (%.3f ms over no add-on)\n", record_ms, record_ms - none_ms);
+	std::printf("  observer with delivery:  %.3f ms/frame\n", observer_ms);
+	std::printf("  memcpy of the records:   %.3f ms/frame\n", memcpy_ms);
+	std::printf("  recording overhead is %.1fx a memcpy of the same data\n", (record_ms - none_ms) / memcpy_ms);
+
+	// Both modes have to see the same commands (callback statistics were gathered over 3 runs of all frames)
+	if (callback_stats.draws != s_observer_stats.draws ||
+		callback_stats.pipelines != s_observer_stats.pipelines ||
+		callback_stats.barriers != s_observer_stats.barriers ||
+		callback_stats.render_targets != s_observer_stats.render_targets)
+	{
+		std::fprintf(stderr, "Callback and observer statistics do not match\n");
+		return 1;
+	}
+
+	return 0;
+}
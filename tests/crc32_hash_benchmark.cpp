@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "crc32_hash.hpp"
+#include "test_utils.hpp"
+#include <random>
+#include <vector>
+
+// Keeps the compiler from optimizing away hashes whose result is otherwise unused
+static volatile uint64_t s_checksum = 0;
+
+// How the CRC-32 was computed before, one byte at a time
+static uint32_t compute_crc32_bytewise(const uint8_t *data, size_t size)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < size; ++i)
+		crc = (crc >> 8) ^ crc32_table[(crc ^ data[i]) & 0xFF];
+	return ~crc;
+}
+
+static uint32_t compute_crc32_slicing_by_8(const uint8_t *data, size_t size)
+{
+	return ~update_crc32_slicing_by_8(0xFFFFFFFF, data, size);
+}
+
+static bool check_results(const std::vector<uint8_t> &buffer)
+{
+	// Check value of the CRC-32 specification (for the "123456789" string) and the XXH64 reference value for empty input
+	const uint8_t check_string[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	if (compute_crc32(check_string, sizeof(check_string)) != 0xCBF43926 || compute_hash64(nullptr, 0) != 0xEF46DB3751D8E999ull)
+	{
+		std::fprintf(stderr, "Hash of check string does not match the specification\n");
+		return false;
+	}
+
+	// All paths have to produce the same CRC as the byte-wise loop, for any length and alignment (which also covers the tails after folding)
+	std::mt19937 rng(0x5EED);
+	for (int i = 0; i < 20000; ++i)
+	{
+		const size_t offset = rng() % 64;
+		const size_t size = i < 1024 ? i : rng() % 8192;
+
+		const uint32_t expected = compute_crc32_bytewise(buffer.data() + offset, size);
+		if (compute_crc32(buffer.data() + offset, size) != expected || compute_crc32_slicing_by_8(buffer.data() + offset, size) != expected)
+		{
+			std::fprintf(stderr, "CRC-32 of %zu bytes at offset %zu does not match the byte-wise result\n", size, offset);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main()
+{
+	constexpr size_t buffer_size = 64 * 1024 * 1024;
+
+	std::mt19937 rng(0x5EED);
+	std::vector<uint8_t> buffer(buffer_size);
+	for (uint8_t &value : buffer)
+		value = static_cast<uint8_t>(rng());
+
+	if (!check_results(buffer))
+		return 1;
+
+	const auto measure_throughput = [&buffer](const char *name, auto hash) {
+		const double ms = test::measure_best_of_3([&]() { s_checksum = s_checksum + hash(buffer.data(), buffer.size()); });
+		std::printf("  %-14s %.2f GB/s\n", name, buffer.size() / (ms * 1000000.0));
+	};
+
+	std::printf("Hashing %zu MiB, best of 3 runs:\n", buffer_size / (1024 * 1024));
+	measure_throughput("byte-wise:", compute_crc32_bytewise);
+	measure_throughput("slicing-by-8:", compute_crc32_slicing_by_8);
+#if CRC32_HASH_PCLMUL
+	if (crc32_has_pclmul())
+		measure_throughput("PCLMULQDQ:", compute_crc32);
+	else
+		std::printf("  PCLMULQDQ:     not supported by this CPU\n");
+#endif
+	measure_throughput("XXH64:", compute_hash64);
+
+	return 0;
+}
@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "depth_stencil_map.hpp"
+#include "api_trace_records.hpp"
+#include "test_utils.hpp"
+#include <new>
+#include <random>
+#include <cstdlib>
+#include <unordered_map>
+
+using namespace reshade::api;
+
+static std::atomic<size_t> s_num_allocations = 0;
+
+void *operator new(size_t size)
+{
+	s_num_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *const p = std::malloc(size != 0 ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+void operator delete(void *p, size_t) noexcept
+{
+	std::free(p);
+}
+
+struct event
+{
+	enum type : uint8_t { bind_depth_stencil, bind_viewport, draw, draw_indirect, clear_depth_stencil } type;
+	uint64_t handle;
+	uint32_t vertices;
+	uint32_t instances;
+};
+
+// A frame is the list of events recorded in each command list, which are executed on the queue in order and then presented
+using frame = std::vector<std::vector<event>>;
+
+/// <summary>
+/// Generates frames with a workload similar to a recorded game frame: 24 command lists per frame with about 45k draws in total, which render into a handful of depth-stencils (shadow cascades, the main depth buffer, a few smaller ones), with occasional clears.
+/// </summary>
+static std::vector<frame> generate_frames(size_t num_frames)
+{
+	static const uint64_t s_depth_stencils[] = { 0x1F0A40, 0x1F0B80, 0x1F0CC0, 0x1F0E00, 0x2A1000, 0x2A2340 };
+
+	std::mt19937 rng(0x5EED);
+	std::vector<frame> frames(num_frames);
+
+	for (frame &frame : frames)
+	{
+		frame.resize(24);
+
+		for (std::vector<event> &cmd_list : frame)
+		{
+			for (uint32_t draw = 0, num_draws = 1500 + rng() % 1000; draw < num_draws; ++draw)
+			{
+				if (draw == 0 || rng() % 40 == 0)
+				{
+					cmd_list.push_back({ event::bind_depth_stencil, s_depth_stencils[rng() % std::size(s_depth_stencils)], 0, 0 });
+					cmd_list.push_back({ event::bind_viewport, 0, 1920, 1080 });
+				}
+				if (rng() % 300 == 0)
+					cmd_list.push_back({ event::clear_depth_stencil, cmd_list.back().handle, 0, 0 });
+
+				cmd_list.push_back({ rng() % 50 == 0 ? event::draw_indirect : event::draw, 0, 3 * (1 + rng() % 2000), 1 + rng() % 2 });
+			}
+		}
+	}
+
+	return frames;
+}
+
+/// <summary>
+/// Reads the command lists of every frame from a capture of the API trace add-on, so that draw streams recorded from an actual game can be replayed.
+/// </summary>
+static std::vector<frame> load_frames(const char *path)
+{
+	std::vector<frame> frames;
+
+	FILE *const file = std::fopen(path, "rb");
+	if (file == nullptr)
+		return frames;
+
+	api_trace::capture_header header;
+	if (std::fread(&header, sizeof(header), 1, file) != 1 || header.magic != api_trace::capture_header().magic || header.version != api_trace::capture_header().version)
+	{
+		std::fclose(file);
+		return frames;
+	}
+
+	std::vector<uint64_t> cmd_lists;
+	frames.emplace_back();
+
+	for (api_trace::record record; std::fread(&record, sizeof(record), 1, file) == 1;)
+	{
+		if (record.type == api_trace::record_type::present)
+		{
+			frames.emplace_back();
+			cmd_lists.clear();
+			continue;
+		}
+
+		const size_t cmd_list_index = std::find(cmd_lists.begin(), cmd_lists.end(), record.cmd_list) - cmd_lists.begin();
+		if (cmd_list_index == cmd_lists.size())
+		{
+			cmd_lists.push_back(record.cmd_list);
+			frames.back().emplace_back();
+		}
+
+		std::vector<event> &events = frames.back()[cmd_list_index];
+
+		switch (record.type)
+		{
+		case api_trace::record_type::begin_render_pass:
+		case api_trace::record_type::bind_render_targets_and_depth_stencil:
+			// Views stand in for the depth-stencil resources they were created for
+			events.push_back({ event::bind_depth_stencil, record.args[0], 0, 0 });
+			break;
+		case api_trace::record_type::bind_viewports:
+			events.push_back({ event::bind_viewport, 0, 1920, 1080 });
+			break;
+		case api_trace::record_type::draw:
+		case api_trace::record_type::draw_indexed:
+			events.push_back({ event::draw, 0, static_cast<uint32_t>(record.args[0]), static_cast<uint32_t>(record.args[1]) });
+			break;
+		case api_trace::record_type::draw_or_dispatch_indirect:
+			if (static_cast<indirect_command>(record.args[0]) != indirect_command::dispatch)
+				events.push_back({ event::draw_indirect, 0, 0, static_cast<uint32_t>(record.args[3]) });
+			break;
+		case api_trace::record_type::clear_depth_stencil_view:
+			events.push_back({ event::clear_depth_stencil, record.args[0], 0, 0 });
+			break;
+		}
+	}
+
+	std::fclose(file);
+
+	if (frames.back().empty())
+		frames.pop_back();
+
+	return frames;
+}
+
+struct depth_stencil_hash
+{
+	inline size_t operator()(resource value) const
+	{
+		return static_cast<size_t>(value.handle >> 4);
+	}
+};
+
+// How depth-stencil statistics were tracked before, with a hash map that destroys all entries (and their lists of clears) when cleared
+using previous_map = std::unordered_map<resource, depth_stencil_info, depth_stencil_hash>;
+
+/// <summary>
+/// Tracks draw statistics the same way the 'generic_depth' add-on does in its event callbacks, minus the parts that require a device.
+/// </summary>
+template <typename map_type>
+struct state_tracking
+{
+	viewport current_viewport = {};
+	resource current_depth_stencil = { 0 };
+	map_type counters_per_used_depth_stencil;
+
+	state_tracking()
+	{
+		counters_per_used_depth_stencil.reserve(32);
+	}
+
+	void record(const event &e)
+	{
+		switch (e.type)
+		{
+		case event::bind_depth_stencil:
+			current_depth_stencil = { e.handle };
+			break;
+		case event::bind_viewport:
+			current_viewport.width = static_cast<float>(e.vertices);
+			current_viewport.height = static_cast<float>(e.instances);
+			break;
+		case event::draw:
+		{
+			depth_stencil_info &counters = counters_per_used_depth_stencil[current_depth_stencil];
+			counters.total_stats.vertices += e.vertices * e.instances;
+			counters.total_stats.drawcalls += 1;
+			counters.current_stats.vertices += e.vertices * e.instances;
+			counters.current_stats.drawcalls += 1;
+			counters.current_stats.last_viewport = current_viewport;
+			break;
+		}
+		case event::draw_indirect:
+		{
+			depth_stencil_info &counters = counters_per_used_depth_stencil[current_depth_stencil];
+			counters.total_stats.drawcalls += e.instances;
+			counters.total_stats.drawcalls_indirect += e.instances;
+			counters.current_stats.drawcalls += e.instances;
+			counters.current_stats.last_viewport = current_viewport;
+			counters.current_stats.drawcalls_indirect += e.instances;
+			break;
+		}
+		case event::clear_depth_stencil:
+		{
+			depth_stencil_info &counters = counters_per_used_depth_stencil[resource { e.handle }];
+			if (counters.current_stats.drawcalls == 0)
+				break;
+
+			counters.clears.push_back({ counters.current_stats, false });
+			counters.current_stats = { 0, 0 };
+			break;
+		}
+		}
+	}
+
+	void merge(const state_tracking &source)
+	{
+		current_depth_stencil = source.current_depth_stencil;
+
+		for (const auto &[depth_stencil_handle, snapshot] : source.counters_per_used_depth_stencil)
+			counters_per_used_depth_stencil[depth_stencil_handle].merge(snapshot);
+	}
+
+	void reset()
+	{
+		current_depth_stencil = { 0 };
+		counters_per_used_depth_stencil.clear();
+	}
+};
+
+struct totals
+{
+	uint64_t vertices = 0;
+	uint64_t drawcalls = 0;
+	uint64_t clears = 0;
+};
+
+/// <summary>
+/// Records all command lists of the frames, executes them on the queue and copies the queue statistics to the device list on present, like the add-on does.
+/// </summary>
+template <typename map_type>
+static totals replay(const std::vector<frame> &frames, std::vector<state_tracking<map_type>> &cmd_lists, state_tracking<map_type> &queue, map_type &device_list)
+{
+	totals result;
+
+	for (const frame &frame : frames)
+	{
+		if (cmd_lists.size() < frame.size())
+			cmd_lists.resize(frame.size());
+
+		for (size_t i = 0; i < frame.size(); ++i)
+		{
+			cmd_lists[i].reset();
+			for (const event &e : frame[i])
+				cmd_lists[i].record(e);
+		}
+
+		for (size_t i = 0; i < frame.size(); ++i)
+			queue.merge(cmd_lists[i]);
+
+		device_list.clear();
+		for (const auto &[resource, snapshot] : queue.counters_per_used_depth_stencil)
+		{
+			if (snapshot.total_stats.drawcalls == 0)
+				continue;
+
+			device_list[resource] = snapshot;
+
+			result.vertices += snapshot.total_stats.vertices;
+			result.drawcalls += snapshot.total_stats.drawcalls;
+			result.clears += snapshot.clears.size();
+		}
+
+		queue.reset();
+	}
+
+	return result;
+}
+
+template <typename map_type>
+static totals measure(const char *name, const std::vector<frame> &frames)
+{
+	std::vector<state_tracking<map_type>> cmd_lists;
+	state_tracking<map_type> queue;
+	map_type device_list;
+
+	// Warm up once, so that the flat map has reached its final size
+	totals result = replay(frames, cmd_lists, queue, device_list);
+
+	const size_t num_allocations_before = s_num_allocations;
+	const double ms = test::measure_best_of_3([&]() {
+		result = replay(frames, cmd_lists, queue, device_list);
+	}) / frames.size();
+	const size_t num_allocations = (s_num_allocations - num_allocations_before) / (3 * frames.size());
+
+	std::printf("  %-14s %.3f ms/frame, %zu allocations/frame\n", name, ms, num_allocations);
+
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<frame> frames;
+	if (argc > 1)
+	{
+		frames = load_frames(argv[1]);
+		if (frames.empty())
+		{
+			std::fprintf(stderr, "Failed to read frames from API trace capture \"%s\"\n", argv[1]);
+			return 1;
+		}
+	}
+	else
+	{
+		frames = generate_frames(20);
+	}
+
+	size_t num_cmd_lists = 0, num_events = 0;
+	for (const frame &frame : frames)
+		for (const std::vector<event> &cmd_list : frame)
+			num_cmd_lists++, num_events += cmd_list.size();
+
+	std::printf("%zu frames with %.1f command lists and %zu events per frame, best of 3 runs:\n", frames.size(), static_cast<double>(num_cmd_lists) / frames.size(), num_events / frames.size());
+
+	const totals previous_totals = measure<previous_map>("unordered_map:", frames);
+	const totals flat_totals = measure<depth_stencil_map>("flat map:", frames);
+
+	// Both have to arrive at the same statistics
+	if (previous_totals.vertices != flat_totals.vertices || previous_totals.drawcalls != flat_totals.drawcalls || previous_totals.clears != flat_totals.clears)
+	{
+		std::fprintf(stderr, "Statistics of the flat map do not match those of the hash map\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "descriptor_slot_allocator.hpp"
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <shared_mutex>
+
+static constexpr uint64_t increment_size = 32;
+static constexpr uint32_t heap_size = 1024;
+
+struct fake_backend
+{
+	using heap_type = uint32_t;
+
+	bool create_heap(uint32_t, heap_type &heap, uint64_t &base_address)
+	{
+		heap = num_heaps++;
+		base_address = 0x10000000 + heap * (heap_size + 64) * increment_size;
+		return true;
+	}
+
+	uint32_t num_heaps = 0;
+};
+
+/// <summary>
+/// Slot management of the D3D12 CPU descriptor heap the allocator replaced, which searched a 'std::vector&lt;bool&gt;' per heap under a single lock.
+/// </summary>
+class vector_bool_allocator
+{
+	struct heap_info
+	{
+		std::vector<bool> state;
+		uint64_t heap_base = 0;
+	};
+
+public:
+	bool allocate(uint64_t &address)
+	{
+		const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+		for (int attempt = 0; attempt < 2; ++attempt)
+		{
+			for (heap_info &heap_info : _heap_infos)
+			{
+				if (const auto it = std::find(heap_info.state.begin(), heap_info.state.end(), false);
+					it != heap_info.state.end())
+				{
+					const size_t index = it - heap_info.state.begin();
+					heap_info.state[index] = true;
+
+					address = heap_info.heap_base + index * increment_size;
+					return true;
+				}
+			}
+
+			heap_info &heap_info = _heap_infos.emplace_back();
+			uint32_t heap = 0;
+			_backend.create_heap(heap_size, heap, heap_info.heap_base);
+			heap_info.state.resize(heap_size);
+		}
+
+		return false;
+	}
+
+	bool free(uint64_t address)
+	{
+		const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+		for (heap_info &heap_info : _heap_infos)
+		{
+			if (address >= heap_info.heap_base && address < heap_info.heap_base + heap_size * increment_size)
+			{
+				heap_info.state[(address - heap_info.heap_base) / increment_size] = false;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+private:
+	fake_backend _backend;
+	std::vector<heap_info> _heap_infos;
+	std::shared_mutex _mutex;
+};
+
+template <typename T>
+static double measure_recreate(T &allocator, uint32_t num_threads)
+{
+	// Simulates an application that keeps many views alive and recreates a part of them every frame
+	constexpr uint32_t num_live = 20000;
+	constexpr uint32_t num_recreated_per_frame = 5000;
+	constexpr uint32_t num_frames = 20;
+
+	const uint32_t num_live_per_thread = num_live / num_threads;
+	const uint32_t num_recreated_per_thread = num_recreated_per_frame / num_threads;
+
+	std::vector<std::vector<uint64_t>> live_addresses(num_threads, std::vector<uint64_t>(num_live_per_thread));
+	for (std::vector<uint64_t> &addresses : live_addresses)
+		for (uint64_t &address : addresses)
+			allocator.allocate(address);
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (uint32_t thread_index = 0; thread_index < num_threads; ++thread_index)
+	{
+		threads.emplace_back([&allocator, &addresses = live_addresses[thread_index], num_recreated_per_thread, thread_index]() {
+			std::mt19937 rng(thread_index);
+			for (uint32_t frame = 0; frame < num_frames; ++frame)
+			{
+				for (uint32_t i = 0; i < num_recreated_per_thread; ++i)
+				{
+					uint64_t &address = addresses[rng() % addresses.size()];
+					allocator.free(address);
+					allocator.allocate(address);
+				}
+			}
+		});
+	}
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	const auto end = std::chrono::steady_clock::now();
+
+	for (const std::vector<uint64_t> &addresses : live_addresses)
+		for (const uint64_t address : addresses)
+			allocator.free(address);
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / (num_frames * num_recreated_per_thread * num_threads);
+}
+
+int main()
+{
+	std::printf("20000 live slots with 5000 recreated per frame (free + allocate):\n");
+
+	for (const uint32_t num_threads : { 1u, 4u })
+	{
+		vector_bool_allocator before;
+		descriptor_slot_allocator<fake_backend, heap_size> after(fake_backend(), increment_size);
+
+		const double before_ns = measure_recreate(before, num_threads);
+		const double after_ns = measure_recreate(after, num_threads);
+
+		std::printf("  %u thread(s): %8.1f ns/op before, %6.1f ns/op after\n", num_threads, before_ns, after_ns);
+	}
+
+	return 0;
+}
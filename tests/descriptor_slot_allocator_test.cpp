@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "descriptor_slot_allocator.hpp"
+#include "test_utils.hpp"
+#include <random>
+#include <cstdio>
+
+static constexpr uint64_t increment_size = 32;
+static constexpr uint32_t heap_size = 1024;
+// Leave a gap between heaps, so that addresses right after a heap do not belong to the next one
+static constexpr uint64_t heap_stride = (heap_size + 64) * increment_size;
+static constexpr uint64_t top_address = 0x10000000;
+
+/// <summary>
+/// Heap backend that does not create anything, but hands out base addresses in descending order (so that new heaps are inserted at the front of the sorted list).
+/// </summary>
+struct fake_backend
+{
+	using heap_type = uint32_t;
+
+	bool create_heap(uint32_t num_descriptors, heap_type &heap, uint64_t &base_address)
+	{
+		if (num_descriptors != heap_size || num_heaps == max_heaps)
+			return false;
+
+		heap = num_heaps++;
+		base_address = top_address - num_heaps * heap_stride;
+		return true;
+	}
+
+	uint32_t num_heaps = 0;
+	uint32_t max_heaps = 64;
+};
+
+static uint64_t slot_index(uint64_t address)
+{
+	return (top_address - address) / increment_size;
+}
+
+static void check_single_threaded()
+{
+	descriptor_slot_allocator<fake_backend, heap_size> allocator(fake_backend(), increment_size);
+
+	std::vector<uint64_t> addresses(3000);
+	std::vector<bool> used(64 * heap_stride / increment_size);
+
+	for (uint64_t &address : addresses)
+	{
+		CHECK(allocator.allocate(address));
+		CHECK(address % increment_size == 0);
+		CHECK(allocator.contains(address));
+		CHECK(!used[slot_index(address)]);
+		used[slot_index(address)] = true;
+	}
+
+	// Addresses in the gaps between heaps and outside all heaps do not belong to the allocator
+	for (uint64_t heap = 1; heap <= 3; ++heap)
+	{
+		const uint64_t heap_end = top_address - heap * heap_stride + heap_size * increment_size;
+		CHECK(!allocator.contains(heap_end));
+		CHECK(!allocator.free(heap_end));
+	}
+	CHECK(!allocator.contains(top_address));
+	CHECK(!allocator.free(0));
+
+	for (const uint64_t address : addresses)
+		CHECK(allocator.free(address));
+
+	// Freed slots have to be reused instead of creating more heaps
+	for (uint64_t &address : addresses)
+		CHECK(allocator.allocate(address));
+	for (const uint64_t address : addresses)
+		CHECK(allocator.free(address));
+	for (uint64_t &address : addresses)
+		CHECK(allocator.allocate(address) && address >= top_address - 3 * heap_stride);
+}
+
+static void check_heap_creation_failure()
+{
+	fake_backend backend;
+	backend.max_heaps = 1;
+	descriptor_slot_allocator<fake_backend, heap_size> allocator(backend, increment_size);
+
+	std::vector<uint64_t> addresses(heap_size);
+	for (uint64_t &address : addresses)
+		CHECK(allocator.allocate(address));
+
+	uint64_t address = 0;
+	CHECK(!allocator.allocate(address));
+
+	CHECK(allocator.free(addresses.back()));
+	CHECK(allocator.allocate(address) && address == addresses.back());
+}
+
+static void check_concurrent_allocate_and_free()
+{
+	// Every thread randomly allocates and frees slots, while a shared table detects slots that are handed out twice
+	descriptor_slot_allocator<fake_backend, heap_size> allocator(fake_backend(), increment_size);
+
+	std::vector<std::atomic<bool>> used(64 * heap_stride / increment_size);
+
+	std::vector<std::thread> threads;
+	for (uint32_t thread_index = 0; thread_index < 4; ++thread_index)
+	{
+		threads.emplace_back([&allocator, &used, thread_index]() {
+			std::mt19937 rng(thread_index);
+			std::vector<uint64_t> live_addresses;
+
+			for (uint32_t i = 0; i < 200000; ++i)
+			{
+				if (live_addresses.size() < 3000 && (live_addresses.empty() || rng() % 2 == 0))
+				{
+					uint64_t address = 0;
+					CHECK(allocator.allocate(address));
+					CHECK(!used[slot_index(address)].exchange(true));
+					live_addresses.push_back(address);
+				}
+				else
+				{
+					const size_t index = rng() % live_addresses.size();
+					const uint64_t address = live_addresses[index];
+					live_addresses[index] = live_addresses.back();
+					live_addresses.pop_back();
+
+					CHECK(used[slot_index(address)].exchange(false));
+					CHECK(allocator.free(address));
+				}
+			}
+
+			for (const uint64_t address : live_addresses)
+			{
+				used[slot_index(address)] = false;
+				CHECK(allocator.free(address));
+			}
+		});
+	}
+
+	for (std::thread &thread : threads)
+		thread.join();
+}
+
+int main()
+{
+	check_single_threaded();
+	check_heap_creation_failure();
+	check_concurrent_allocate_and_free();
+
+	return test::exit_code("All descriptor slot allocator checks passed.");
+}
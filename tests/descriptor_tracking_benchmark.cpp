@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include <reshade_api_pipeline.hpp>
+#include "descriptor_set_tracking.hpp"
+#include "test_utils.hpp"
+#include <map>
+#include <chrono>
+#include <thread>
+#include <random>
+
+using namespace reshade::api;
+
+static constexpr uint32_t num_pools = 4;
+static constexpr uint32_t pool_size = 200000;
+static constexpr uint32_t batch_size = 16;
+
+// Keeps the compiler from optimizing away lookups whose result is otherwise unused
+static std::atomic<uint64_t> s_checksum = 0;
+
+struct update
+{
+	descriptor_pool pool;
+	uint32_t offset;
+	uint32_t count;
+	descriptor_type type;
+	resource_view descriptors[8];
+};
+
+/// <summary>
+/// Generates descriptor updates like a D3D12 or Vulkan application writing into a few large descriptor heaps: 1 to 8 descriptors at a time, mostly shader resource views, spread over the whole heap.
+/// </summary>
+static std::vector<update> generate_updates(size_t num_updates)
+{
+	std::mt19937 rng(0x5EED);
+	std::vector<update> updates(num_updates);
+	for (update &update : updates)
+	{
+		update.pool = { 0x7FF6A0000000ull + (rng() % num_pools) * 0x1000 };
+		update.count = 1 + rng() % 8;
+		update.offset = rng() % (pool_size - update.count);
+		update.type = rng() % 4 != 0 ? descriptor_type::shader_resource_view : (rng() % 2 ? descriptor_type::constant_buffer : descriptor_type::sampler);
+		for (uint32_t k = 0; k < update.count; ++k)
+			update.descriptors[k] = { 0x1E0000000ull + (rng() % 100000) * 0x40 };
+	}
+	return updates;
+}
+
+/// <summary>
+/// How descriptor pools were tracked before, in a tree holding every descriptor with its type behind a single lock.
+/// </summary>
+struct previous_tracking
+{
+	struct descriptor_pool_data
+	{
+		std::vector<std::pair<descriptor_type, uint64_t>> descriptors;
+	};
+
+	mutable std::shared_mutex mutex;
+	std::map<descriptor_pool, descriptor_pool_data> pools;
+
+	void update_descriptor_sets(const update *updates, uint32_t count)
+	{
+		const std::unique_lock<std::shared_mutex> lock(mutex);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const update &update = updates[i];
+
+			descriptor_pool_data &pool_data = pools[update.pool];
+
+			if (update.offset + update.count > pool_data.descriptors.size())
+				pool_data.descriptors.resize(update.offset + update.count);
+
+			for (uint32_t k = 0; k < update.count; ++k)
+			{
+				pool_data.descriptors[update.offset + k].first = update.type;
+				pool_data.descriptors[update.offset + k].second = update.descriptors[k].handle;
+			}
+		}
+	}
+
+	resource_view get_shader_resource_view(descriptor_pool pool, uint32_t offset) const
+	{
+		const std::shared_lock<std::shared_mutex> lock(mutex);
+
+		const descriptor_pool_data &pool_data = pools.at(pool);
+
+		if (offset < pool_data.descriptors.size() && pool_data.descriptors[offset].first == descriptor_type::shader_resource_view)
+			return { pool_data.descriptors[offset].second };
+		else
+			return { 0 };
+	}
+};
+
+/// <summary>
+/// Same logic as the 'update_descriptor_sets' callback and 'descriptor_set_tracking::get_shader_resource_view' of the add-on.
+/// </summary>
+struct sharded_tracking
+{
+	sharded_handle_map<descriptor_pool_data> pools;
+
+	void update_descriptor_sets(const update *updates, uint32_t count)
+	{
+		// Resolve each pool only once per batch, like the 'descriptor_pool_cache' in the add-on
+		std::pair<descriptor_pool, descriptor_pool_data *> cache[4] = {};
+		uint32_t next_cache_entry = 0;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const update &update = updates[i];
+
+			descriptor_pool_data *pool_data = nullptr;
+			for (const std::pair<descriptor_pool, descriptor_pool_data *> &entry : cache)
+				if (entry.second != nullptr && entry.first == update.pool)
+					pool_data = entry.second;
+			if (pool_data == nullptr)
+				cache[next_cache_entry++ % std::size(cache)] = { update.pool, pool_data = &pools.find_or_create(update.pool.handle) };
+
+			if (update.type == descriptor_type::shader_resource_view)
+			{
+				for (uint32_t k = 0; k < update.count; ++k)
+					pool_data->set(update.offset + k, update.descriptors[k].handle);
+			}
+			else
+			{
+				for (uint32_t k = 0; k < update.count; ++k)
+					pool_data->set(update.offset + k, 0);
+			}
+		}
+	}
+
+	resource_view get_shader_resource_view(descriptor_pool pool, uint32_t offset) const
+	{
+		if (const descriptor_pool_data *const pool_data = pools.find(pool.handle))
+			return { pool_data->get(offset) };
+		return { 0 };
+	}
+};
+
+template <typename tracking_type>
+static void replay(tracking_type &tracking, const std::vector<update> &updates, size_t num_updates)
+{
+	for (size_t i = 0; i < num_updates; i += batch_size)
+		tracking.update_descriptor_sets(updates.data() + i, static_cast<uint32_t>(std::min<size_t>(batch_size, num_updates - i)));
+}
+
+template <typename tracking_type>
+static void measure(const char *name, const std::vector<update> &updates, std::unique_ptr<tracking_type> &result)
+{
+	constexpr int num_lookup_threads = 4;
+	constexpr size_t num_contended_updates = 100000;
+	constexpr size_t num_lookups = 1000000;
+
+	// Replay all updates on a single thread, like an application creating its descriptors up front
+	const double replay_ms = test::measure_best_of_3([&]() {
+		result = std::make_unique<tracking_type>();
+		replay(*result, updates, updates.size());
+	});
+
+	// Look up descriptors from the replayed pools, like the overlay does for every bound descriptor set
+	std::mt19937 rng(0x5EED);
+	std::vector<std::pair<descriptor_pool, uint32_t>> lookups(num_lookups);
+	for (std::pair<descriptor_pool, uint32_t> &lookup : lookups)
+		lookup = { updates[rng() % updates.size()].pool, rng() % pool_size };
+
+	const double lookup_ms = test::measure_best_of_3([&]() {
+		uint64_t checksum = 0;
+		for (const std::pair<descriptor_pool, uint32_t> &lookup : lookups)
+			checksum += result->get_shader_resource_view(lookup.first, lookup.second).handle;
+		s_checksum += checksum;
+	});
+
+	// Replay more updates on one thread while other threads keep looking up descriptors, like an application streaming in descriptors during rendering
+	std::atomic<bool> stop = false;
+	std::atomic<size_t> num_contended_lookups = 0;
+	std::vector<std::thread> threads;
+	const auto contended_start = std::chrono::steady_clock::now();
+	for (int t = 0; t < num_lookup_threads; ++t)
+	{
+		threads.emplace_back([&, t]() {
+			size_t i = t, n = 0;
+			uint64_t checksum = 0;
+			for (; !stop.load(std::memory_order_relaxed); ++n, i = (i + num_lookup_threads) % lookups.size())
+				checksum += result->get_shader_resource_view(lookups[i].first, lookups[i].second).handle;
+			num_contended_lookups += n;
+			s_checksum += checksum;
+		});
+	}
+
+	const double contended_ms = test::measure_best_of_3([&]() {
+		replay(*result, updates, num_contended_updates);
+	});
+
+	stop = true;
+	for (std::thread &thread : threads)
+		thread.join();
+
+	// Lookups happen during the whole time the threads run, so divide by that and not just by the time of the replay
+	const double contended_total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - contended_start).count();
+
+	std::printf("  %s\n", name);
+	std::printf("    replay of all updates:             %.1f ms\n", replay_ms);
+	std::printf("    single lookup:                     %.1f ns\n", lookup_ms * 1000000.0 / num_lookups);
+	std::printf("    replay of %zuk updates, %d readers: %.1f ms (%.1f M lookups/s)\n", num_contended_updates / 1000, num_lookup_threads, contended_ms, num_contended_lookups / (contended_total_ms * 1000.0));
+}
+
+int main()
+{
+	const std::vector<update> updates = generate_updates(2000000);
+
+	std::printf("%zu updates of 1-8 descriptors into %u pools of %u descriptors, in batches of %u, best of 3 runs:\n", updates.size(), num_pools, pool_size, batch_size);
+
+	std::unique_ptr<previous_tracking> previous;
+	measure("std::map with a single lock:", updates, previous);
+	std::unique_ptr<sharded_tracking> sharded;
+	measure("sharded pools with pages:", updates, sharded);
+
+	// Both have to end up with the same shader resource views after replaying the same updates
+	for (uint32_t p = 0; p < num_pools; ++p)
+	{
+		const descriptor_pool pool = { 0x7FF6A0000000ull + p * 0x1000 };
+		for (uint32_t offset = 0; offset < pool_size; ++offset)
+		{
+			if (previous->get_shader_resource_view(pool, offset) != sharded->get_shader_resource_view(pool, offset))
+			{
+				std::fprintf(stderr, "Descriptor %u of pool %u differs between the old and the sharded tracking\n", offset, p);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "image_utils.hpp"
+#include "test_utils.hpp"
+#include <zlib.h>
+#include <random>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+static uint32_t read_uint32(const std::vector<uint8_t> &data, size_t offset)
+{
+	return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | (static_cast<uint32_t>(data[offset + 3]) << 24);
+}
+
+/// <summary>
+/// Decodes a scanline OpenEXR file with half channels and ZIP compression, following the file layout specification.
+/// </summary>
+static bool decode_exr(const std::vector<uint8_t> &data, uint32_t &width, uint32_t &height, std::string &channel_names, std::vector<uint16_t> &pixels)
+{
+	if (data.size() < 8 || read_uint32(data, 0) != 20000630 || data[4] != 2)
+		return false;
+
+	// Parse header attributes, which are a sequence of name, type, size and value, terminated by an empty name
+	size_t offset = 8;
+	uint32_t compression = ~0u;
+	width = height = 0;
+	channel_names.clear();
+
+	while (offset < data.size() && data[offset] != '\0')
+	{
+		const std::string name(reinterpret_cast<const char *>(data.data() + offset));
+		offset += name.size() + 1;
+		const std::string type(reinterpret_cast<const char *>(data.data() + offset));
+		offset += type.size() + 1;
+		const uint32_t size = read_uint32(data, offset);
+		offset += 4;
+
+		if (name == "channels")
+		{
+			for (size_t i = offset; data[i] != '\0'; i += 2 + 16)
+			{
+				if (data[i + 1] != '\0' || read_uint32(data, i + 2) != 1) // Only single letter names with half pixel type are expected
+					return false;
+				channel_names += static_cast<char>(data[i]);
+			}
+		}
+		else if (name == "compression")
+		{
+			compression = data[offset];
+		}
+		else if (name == "dataWindow")
+		{
+			if (read_uint32(data, offset) != 0 || read_uint32(data, offset + 4) != 0)
+				return false;
+			width = read_uint32(data, offset + 8) + 1;
+			height = read_uint32(data, offset + 12) + 1;
+		}
+
+		offset += size;
+	}
+	offset++;
+
+	if (compression != 3 || width == 0 || height == 0 || channel_names.empty())
+		return false;
+
+	const uint32_t channels = static_cast<uint32_t>(channel_names.size());
+	const uint32_t num_blocks = (height + 15) / 16;
+	pixels.assign(static_cast<size_t>(width) * height * channels, 0);
+
+	for (uint32_t block = 0; block < num_blocks; ++block)
+	{
+		const size_t block_offset = read_uint32(data, offset + block * 8) | (static_cast<uint64_t>(read_uint32(data, offset + block * 8 + 4)) << 32);
+		if (block_offset + 8 > data.size() || read_uint32(data, block_offset) != block * 16)
+			return false;
+
+		const uint32_t lines = std::min(16u, height - block * 16);
+		const size_t raw_size = static_cast<size_t>(lines) * width * channels * 2;
+		const size_t packed_size = read_uint32(data, block_offset + 4);
+		const uint8_t *const packed = data.data() + block_offset + 8;
+		if (block_offset + 8 + packed_size > data.size())
+			return false;
+
+		std::vector<uint8_t> raw(raw_size);
+		if (packed_size < raw_size)
+		{
+			std::vector<uint8_t> reordered(raw_size);
+			uLongf size = static_cast<uLongf>(raw_size);
+			if (uncompress(reordered.data(), &size, packed, static_cast<uLong>(packed_size)) != Z_OK || size != raw_size)
+				return false;
+
+			for (size_t i = 1; i < reordered.size(); ++i)
+				reordered[i] = static_cast<uint8_t>(reordered[i - 1] + reordered[i] - 128);
+			const size_t half_size = (raw_size + 1) / 2;
+			for (size_t i = 0; i < raw_size; ++i)
+				raw[i] = reordered[(i % 2 == 0) ? i / 2 : half_size + i / 2];
+		}
+		else if (packed_size == raw_size)
+		{
+			std::memcpy(raw.data(), packed, raw_size);
+		}
+		else
+		{
+			return false;
+		}
+
+		// Each scanline stores all values of one channel after another
+		const uint8_t *src = raw.data();
+		for (uint32_t y = block * 16; y < block * 16 + lines; ++y)
+			for (uint32_t c = 0; c < channels; ++c)
+				for (uint32_t x = 0; x < width; ++x, src += 2)
+					pixels[(static_cast<size_t>(y) * width + x) * channels + c] = static_cast<uint16_t>(src[0] | (src[1] << 8));
+	}
+
+	return true;
+}
+
+static void check_round_trip(uint32_t width, uint32_t height, uint32_t channels, uint32_t num_threads, bool noise, std::mt19937 &rng)
+{
+	std::vector<uint16_t> pixels(static_cast<size_t>(width) * height * channels);
+	for (size_t i = 0; i < pixels.size(); ++i)
+		pixels[i] = noise ? static_cast<uint16_t>(rng()) : static_cast<uint16_t>(0x3C00 + (i % channels) * 0x100 + (i / (width * channels)) % 7);
+
+	std::vector<uint8_t> encoded;
+	std::vector<uint16_t> decoded;
+	uint32_t decoded_width, decoded_height;
+	std::string channel_names;
+
+	CHECK_MESSAGE(
+		reshade::encode_exr(pixels.data(), width, height, channels, encoded, num_threads) &&
+		decode_exr(encoded, decoded_width, decoded_height, channel_names, decoded),
+		"%ux%u %u channels %u threads: encoding or decoding failed", width, height, channels, num_threads);
+
+	// Channels are sorted by name in the file, so map them back to RGBA order
+	const char *const expected_names = channels == 4 ? "ABGR" : "BGR";
+	CHECK_MESSAGE(decoded_width == width && decoded_height == height && channel_names == expected_names, "%ux%u %u channels: header does not match", width, height, channels);
+
+	for (size_t i = 0; i < pixels.size(); ++i)
+	{
+		const size_t pixel = i / channels, c = i % channels;
+		CHECK_MESSAGE(decoded[pixel * channels + (channels - 1 - c)] == pixels[i], "%ux%u %u channels %u threads: value %zu does not match", width, height, channels, num_threads, i);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(0x5EED);
+
+	const uint32_t sizes[][2] = {
+		{ 1, 1 },
+		{ 37, 33 }, // Last block is only partially filled
+		{ 640, 360 },
+	};
+
+	for (const auto &size : sizes)
+		for (const uint32_t channels : { 3u, 4u })
+			for (const uint32_t num_threads : { 1u, 3u })
+				// Noise does not compress, so covers blocks that are stored uncompressed
+				for (const bool noise : { false, true })
+					check_round_trip(size[0], size[1], channels, num_threads, noise, rng);
+
+	return test::exit_code("All OpenEXR encoder checks passed.");
+}
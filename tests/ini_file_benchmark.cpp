@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "ini_file.hpp"
+#include "test_utils.hpp"
+#include <random>
+#include <fstream>
+#include <algorithm>
+
+// These are defined in 'dll_main.cpp' in the real build
+std::filesystem::path g_reshade_dll_path;
+std::filesystem::path g_reshade_base_path;
+std::filesystem::path g_target_executable_path;
+
+struct entry
+{
+	std::string section, key, value;
+};
+
+/// <summary>
+/// Generates the contents of a large preset, with a section per effect and uniform names in mixed case (some with non-ASCII characters), in random order.
+/// </summary>
+static std::vector<entry> generate_preset(size_t num_sections, size_t num_keys_per_section)
+{
+	static const char *const s_words[] = { "Blur", "blur", "Depth", "_depth", "Sharpen", "Color", "color_", "Tone", "Lum", "Grain", "Bloom", "Intensity", "\xC3\x84hnlich", "\xC3\xA4hnlich", "Radius", "Mix" };
+
+	std::mt19937 rng(0x5EED);
+	std::vector<entry> entries;
+
+	std::string techniques;
+	for (size_t s = 0; s < num_sections; ++s)
+		techniques += "Technique" + std::to_string(s) + '@' + s_words[s % std::size(s_words)] + std::to_string(s) + ".fx,";
+	techniques.pop_back();
+	entries.push_back({ std::string(), "Techniques", techniques });
+	entries.push_back({ std::string(), "PreprocessorDefinitions", "RESHADE_DEPTH_INPUT_IS_REVERSED=1,RESHADE_DEPTH_LINEARIZATION_FAR_PLANE=1000.0" });
+
+	for (size_t s = 0; s < num_sections; ++s)
+	{
+		const std::string section = s_words[rng() % std::size(s_words)] + std::to_string(s) + ".fx";
+
+		for (size_t k = 0; k < num_keys_per_section; ++k)
+		{
+			// Keys are unique even when compared case-insensitive, so that there is only one valid order to write them in
+			std::string key = s_words[rng() % std::size(s_words)];
+			key += s_words[rng() % std::size(s_words)];
+			key += std::to_string(k);
+
+			std::string value;
+			switch (rng() % 3)
+			{
+			case 0:
+				value = std::to_string(rng() % 100);
+				break;
+			case 1:
+				value = std::to_string((rng() % 1000) / 1000.0f);
+				break;
+			case 2:
+				value = std::to_string((rng() % 1000) / 1000.0f) + ',' + std::to_string((rng() % 1000) / 1000.0f) + ',' + std::to_string((rng() % 1000) / 1000.0f);
+				break;
+			}
+
+			entries.push_back({ section, std::move(key), std::move(value) });
+		}
+	}
+
+	std::shuffle(entries.begin(), entries.end(), rng);
+
+	return entries;
+}
+
+static std::string write_unordered(const std::vector<entry> &entries)
+{
+	std::string data;
+	for (const entry &e : entries)
+		if (e.section.empty())
+			data += e.key + '=' + e.value + '\n';
+	for (const entry &e : entries)
+		if (!e.section.empty())
+			data += '[' + e.section + "]\n" + e.key + '=' + e.value + '\n';
+	return data;
+}
+
+/// <summary>
+/// Sorts and writes the entries the way 'ini_file::save' did before sections and keys were kept in order, uppercasing a copy of each name for every comparison.
+/// </summary>
+static std::string write_sorted_like_before(std::vector<entry> entries)
+{
+	const auto less_uppercase = [](std::string a, std::string b) {
+		std::transform(a.begin(), a.end(), a.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
+		std::transform(b.begin(), b.end(), b.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(toupper(c)); });
+		return a < b;
+	};
+
+	std::sort(entries.begin(), entries.end(),
+		[&less_uppercase](const entry &lhs, const entry &rhs) {
+			if (lhs.section != rhs.section)
+				return less_uppercase(lhs.section, rhs.section);
+			return less_uppercase(lhs.key, rhs.key);
+		});
+
+	std::string data;
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		if (i == 0 || entries[i].section != entries[i - 1].section)
+		{
+			if (i != 0)
+				data += '\n';
+			if (!entries[i].section.empty())
+				data += '[' + entries[i].section + "]\n";
+		}
+
+		data += entries[i].key + '=' + entries[i].value + '\n';
+	}
+	data += '\n';
+
+	return data;
+}
+
+static std::string read_file(const std::filesystem::path &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+int main()
+{
+	constexpr size_t num_sections = 100;
+	constexpr size_t num_keys_per_section = 50;
+	constexpr int num_iterations = 20;
+
+	const std::vector<entry> entries = generate_preset(num_sections, num_keys_per_section);
+	const std::string source_data = write_unordered(entries);
+	const std::string expected_data = write_sorted_like_before(entries);
+
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "reshade_ini_file_benchmark.ini";
+	std::ofstream(path, std::ios::binary).write(source_data.data(), source_data.size());
+
+	const double load_ms = test::measure_best_of_3([&]() {
+		for (int i = 0; i < num_iterations; ++i)
+			ini_file preset(path);
+	}) / num_iterations;
+
+	ini_file preset(path);
+
+	const double set_ms = test::measure_best_of_3([&]() {
+		for (int i = 0; i < num_iterations; ++i)
+			for (const entry &e : entries)
+				preset.set(e.section, e.key, e.value);
+	}) / num_iterations;
+
+	const std::filesystem::path saved_path = path.parent_path() / "reshade_ini_file_benchmark_saved.ini";
+	const double save_ms = test::measure_best_of_3([&]() {
+		for (int i = 0; i < num_iterations; ++i)
+		{
+			std::filesystem::remove(saved_path);
+			std::filesystem::copy_file(path, saved_path);
+
+			// Setting a key to the value it already has is enough to mark the file as modified
+			ini_file saved(saved_path);
+			std::vector<std::string> techniques;
+			saved.get(std::string(), "Techniques", techniques);
+			saved.set(std::string(), "Techniques", techniques);
+			saved.save();
+		}
+	}) / num_iterations;
+
+	const double sort_before_ms = test::measure_best_of_3([&]() {
+		for (int i = 0; i < num_iterations; ++i)
+			write_sorted_like_before(entries);
+	}) / num_iterations;
+
+	const std::string saved_data = read_file(saved_path);
+	std::filesystem::remove(saved_path);
+	std::filesystem::remove(path);
+
+	std::printf("Preset with %zu sections and %zu keys, best of 3 runs of %d iterations:\n", num_sections + 1, entries.size(), num_iterations);
+	std::printf("  load:                        %.3f ms\n", load_ms);
+	std::printf("  set every key:               %.3f ms\n", set_ms);
+	std::printf("  load, modify and save:       %.3f ms\n", save_ms);
+	std::printf("  sort on save like before:    %.3f ms\n", sort_before_ms);
+
+	// The file has to be written in exactly the same order as before, so that presets do not change when saved by a newer version
+	if (saved_data != expected_data)
+	{
+		size_t offset = 0;
+		while (offset < saved_data.size() && offset < expected_data.size() && saved_data[offset] == expected_data[offset])
+			offset++;
+		std::fprintf(stderr, "Saved preset differs from the expected order at offset %zu: \"%.40s\" instead of \"%.40s\"\n", offset, saved_data.c_str() + offset, expected_data.c_str() + offset);
+		return 1;
+	}
+
+	return 0;
+}
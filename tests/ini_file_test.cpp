@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "ini_file.hpp"
+#include "test_utils.hpp"
+#include <fstream>
+
+// These are defined in 'dll_main.cpp' in the real build
+std::filesystem::path g_reshade_dll_path;
+std::filesystem::path g_reshade_base_path;
+std::filesystem::path g_target_executable_path;
+
+static void write_file(const std::filesystem::path &path, const char *data, std::filesystem::file_time_type modified_at)
+{
+	std::ofstream(path, std::ios::binary) << data;
+	std::filesystem::last_write_time(path, modified_at);
+}
+
+static int get_value(const ini_file &file)
+{
+	int value = 0;
+	file.get("SECTION", "Key", value);
+	return value;
+}
+
+static void check_insert_cache_replaces_older_entry()
+{
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "reshade_ini_file_test.ini";
+	const std::filesystem::file_time_type base_time = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+
+	write_file(path, "[SECTION]\nKey=1\n", base_time);
+	CHECK(get_value(ini_file::load_cache(path)) == 1);
+
+	// Parse a newer version of the file elsewhere, like the preset indexer does on its own thread
+	write_file(path, "[SECTION]\nKey=2\n", base_time + std::chrono::seconds(10));
+	ini_file newer_file(path);
+
+	// Change the contents without changing the modification time, so that 'load_cache' only returns the new value if it was handed over through 'insert_cache', rather than parsing the file again
+	write_file(path, "[SECTION]\nKey=3\n", base_time + std::chrono::seconds(10));
+
+	ini_file::insert_cache(std::move(newer_file));
+	CHECK_MESSAGE(get_value(ini_file::load_cache(path)) == 2, "cached entry was not replaced by the newer parse");
+
+	// An older parse must not replace the cached entry
+	write_file(path, "[SECTION]\nKey=4\n", base_time);
+	ini_file older_file(path);
+	write_file(path, "[SECTION]\nKey=3\n", base_time + std::chrono::seconds(10));
+
+	ini_file::insert_cache(std::move(older_file));
+	CHECK_MESSAGE(get_value(ini_file::load_cache(path)) == 2, "cached entry was replaced by an older parse");
+
+	// Neither may a newer parse replace an entry with modifications that were not written to disk yet
+	ini_file::load_cache(path).set("SECTION", "Key", 5);
+	write_file(path, "[SECTION]\nKey=6\n", std::filesystem::file_time_type::clock::now() + std::chrono::hours(1));
+	ini_file::insert_cache(ini_file(path));
+	CHECK_MESSAGE(get_value(ini_file::load_cache(path)) == 5, "modifications of the cached entry were discarded");
+
+	std::filesystem::remove(path);
+}
+
+static void check_save_while_writer_thread_is_busy()
+{
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "reshade_ini_file_save_test.ini";
+	write_file(path, "[SECTION]\nKey=0\n", std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+
+	ini_file &file = ini_file::load_cache(path);
+
+	for (int i = 1; i <= 100; ++i)
+	{
+		// Queue a write on the writer thread and then save newer data on this thread right away, like 'stop_flush_thread' does when the writer did not finish in time
+		file.set("SECTION", "Key", 2 * i - 1);
+		file.queue_save();
+		file.set("SECTION", "Key", 2 * i);
+		CHECK_MESSAGE(file.save(), "save %d failed", i);
+
+		ini_file::wait_for_flush();
+		CHECK_MESSAGE(get_value(ini_file(path)) == 2 * i, "save %d was replaced by an older write", i);
+	}
+
+	ini_file::flush_cache_and_wait();
+
+	// Each write has to use its own temporary file, which must not be left behind
+	for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(path.parent_path()))
+		CHECK_MESSAGE(entry.path().filename().string().rfind(path.filename().string() + '.', 0) != 0, "temporary file %s was left behind", entry.path().filename().string().c_str());
+
+	std::filesystem::remove(path);
+}
+
+int main()
+{
+	check_insert_cache_replaces_older_entry();
+	check_save_while_writer_thread_is_busy();
+
+	return test::exit_code("All INI file checks passed.");
+}
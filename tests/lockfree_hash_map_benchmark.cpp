@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2019 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "lockfree_hash_map.hpp"
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <algorithm>
+
+/// <summary>
+/// Look up of the linear search table the hash map replaced, which scanned a fixed array from the start.
+/// </summary>
+template <typename TKey, typename TValue, uint32_t MAX_ENTRIES>
+class linear_map
+{
+public:
+	TValue *at(TKey key) const
+	{
+		for (size_t i = 0; i < MAX_ENTRIES; ++i)
+			if (_data[i].first.load(std::memory_order_acquire) == key)
+				return _data[i].second;
+		return nullptr;
+	}
+
+	void emplace(TKey key, TValue *value)
+	{
+		for (size_t i = 0; i < MAX_ENTRIES; ++i)
+		{
+			if (_data[i].first.load(std::memory_order_relaxed) == 0)
+			{
+				_data[i].second = value;
+				_data[i].first.store(key, std::memory_order_release);
+				return;
+			}
+		}
+	}
+
+private:
+	std::pair<std::atomic<TKey>, TValue *> _data[MAX_ENTRIES] = {};
+};
+
+template <typename T>
+static double measure_look_up(const T &map, const std::vector<uint64_t> &keys, const std::vector<uint32_t> &order)
+{
+	constexpr uint32_t num_look_ups = 10000000;
+
+	uintptr_t sum = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < num_look_ups; ++i)
+		sum += reinterpret_cast<uintptr_t>(map.at(keys[order[i % order.size()]]));
+	const auto end = std::chrono::steady_clock::now();
+
+	// Keep the look ups from being optimized away
+	if (sum == 0)
+		std::printf(" ");
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / num_look_ups;
+}
+
+int main()
+{
+	std::mt19937_64 rng(0x5EED);
+
+	std::printf("Look up latency with random order:\n");
+	std::printf("  keys   linear     hash\n");
+
+	for (const uint32_t num_keys : { 1u, 2u, 8u, 16u, 64u, 500u })
+	{
+		// Keys are usually pointers, so make them look like those (aligned and close to each other)
+		const uint64_t base_address = 0x7FF000000000ull + (rng() & 0xFFFFF000);
+		std::vector<uint64_t> keys(num_keys);
+		for (uint32_t i = 0; i < num_keys; ++i)
+			keys[i] = base_address + i * 0x140;
+
+		uint64_t value = 0;
+		const auto linear = std::make_unique<linear_map<uint64_t, uint64_t, 512>>();
+		lockfree_hash_map<uint64_t, uint64_t *, 16> hash;
+		for (uint64_t key : keys)
+			linear->emplace(key, &value), hash.emplace(key, &value);
+
+		std::vector<uint32_t> order(4096);
+		for (uint32_t &index : order)
+			index = static_cast<uint32_t>(rng() % num_keys);
+
+		const double linear_ns = measure_look_up(*linear, keys, order);
+		const double hash_ns = measure_look_up(hash, keys, order);
+
+		std::printf("%6u %6.1f ns %6.1f ns\n", num_keys, linear_ns, hash_ns);
+	}
+
+	return 0;
+}
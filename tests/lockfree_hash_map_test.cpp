@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2019 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "lockfree_hash_map.hpp"
+#include "test_utils.hpp"
+#include <thread>
+#include <string>
+#include <cstdio>
+
+static void check_single_threaded()
+{
+	lockfree_hash_map<uint64_t, std::string, 4> map;
+
+	for (uint64_t key = 3; key < 1003; ++key)
+		map.emplace(key, std::to_string(key));
+
+	CHECK(map.capacity() >= 1000);
+
+	for (uint64_t key = 3; key < 1003; ++key)
+		CHECK(map.at(key) == std::to_string(key));
+
+	for (uint64_t key = 3; key < 1003; key += 2)
+		CHECK(map.erase(key));
+	CHECK(!map.erase(3));
+	CHECK(!map.erase(map.no_value));
+	CHECK(!map.erase(map.erased_value));
+
+	std::string value;
+	CHECK(map.erase(4, value) && value == "4");
+	CHECK(!map.erase(4, value));
+
+	for (uint64_t key = 6; key < 1003; key += 2)
+		CHECK(map.at(key) == std::to_string(key));
+
+	map.clear();
+
+	for (uint64_t key = 3; key < 1003; ++key)
+		CHECK(!map.erase(key));
+}
+
+static void check_small_keys()
+{
+	// Non-dispatchable Vulkan handles can be small integers, so those have to work like any other key
+	lockfree_hash_map<uint64_t, uint64_t *, 4> map;
+
+	uint64_t values[8] = {};
+	for (uint64_t key = 1; key <= 8; ++key)
+		CHECK(map.emplace(key, &values[key - 1]));
+
+	for (uint64_t key = 1; key <= 8; ++key)
+		CHECK(map.at(key) == &values[key - 1]);
+
+	CHECK(map.erase(2) == &values[1]);
+	CHECK(map.at(2) == nullptr);
+	CHECK(map.at(3) == &values[2]);
+
+	CHECK(map.erase(1) == &values[0]);
+	CHECK(map.emplace(2, &values[1]));
+	CHECK(map.at(1) == nullptr && map.at(2) == &values[1]);
+}
+
+static void check_concurrent_emplace_and_erase()
+{
+	// Every thread adds, looks up and removes its own keys in one map, which grows while they do so
+	lockfree_hash_map<uint64_t, uint64_t *, 16> map;
+
+	std::vector<std::thread> threads;
+	for (uint64_t thread_index = 0; thread_index < 8; ++thread_index)
+	{
+		threads.emplace_back([&map, thread_index]() {
+			const uint64_t first_key = 3 + thread_index * 100000;
+			std::vector<uint64_t> values(1000);
+
+			for (int round = 0; round < 50; ++round)
+			{
+				for (uint64_t i = 0; i < values.size(); ++i)
+				{
+					values[i] = first_key + round * 1000 + i;
+					map.emplace(values[i], &values[i]);
+				}
+
+				for (uint64_t i = 0; i < values.size(); ++i)
+					CHECK(map.at(values[i]) == &values[i]);
+
+				for (uint64_t i = 0; i < values.size(); ++i)
+					CHECK(map.erase(values[i]) == &values[i]);
+
+				for (uint64_t i = 0; i < values.size(); ++i)
+					CHECK(map.at(values[i]) == nullptr);
+			}
+		});
+	}
+
+	for (std::thread &thread : threads)
+		thread.join();
+}
+
+static void check_look_up_while_growing()
+{
+	// Look ups must never miss a key that is not erased, even while other threads replace the table with larger ones
+	lockfree_hash_map<uint64_t, uint64_t *, 4> map;
+
+	uint64_t stable_values[3];
+	for (uint64_t i = 0; i < 3; ++i)
+	{
+		stable_values[i] = i;
+		map.emplace(1000000 + i, &stable_values[i]);
+	}
+
+	std::atomic<bool> writers_done = false;
+	std::atomic<uint64_t> num_look_ups = 0;
+
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 2; ++i)
+	{
+		readers.emplace_back([&]() {
+			uint64_t n = 0;
+			while (!writers_done.load(std::memory_order_relaxed))
+			{
+				for (uint64_t k = 0; k < 3; ++k, ++n)
+					CHECK(map.at(1000000 + k) == &stable_values[k]);
+			}
+			num_look_ups += n;
+		});
+	}
+
+	std::vector<std::thread> writers;
+	for (uint64_t i = 0; i < 2; ++i)
+	{
+		writers.emplace_back([&map, i]() {
+			for (uint64_t key = 3 + i; key < 3 + 2 * 90000; key += 2)
+				map.emplace(key, nullptr);
+		});
+	}
+
+	for (std::thread &thread : writers)
+		thread.join();
+	writers_done = true;
+	for (std::thread &thread : readers)
+		thread.join();
+
+	CHECK(map.capacity() == 262144);
+
+	std::printf("Looked up stable keys %llu times while the table grew to %u entries.\n", static_cast<unsigned long long>(num_look_ups.load()), map.capacity());
+}
+
+static void check_erased_entries_are_reused()
+{
+	// Objects are frequently recreated (e.g. swap chains on resize), which must not make the table grow without bounds
+	lockfree_hash_map<uint64_t, uint64_t *, 16> map;
+
+	uint64_t value = 0;
+	for (uint64_t key = 3; key < 3 + 1000000; ++key)
+	{
+		map.emplace(key, &value);
+		if (key >= 3 + 4)
+			CHECK(map.erase(key - 4) == &value);
+	}
+
+	for (uint64_t key = 3 + 1000000 - 4; key < 3 + 1000000; ++key)
+		CHECK(map.at(key) == &value);
+
+	CHECK(map.capacity() == 16);
+}
+
+int main()
+{
+	check_single_threaded();
+	check_small_keys();
+	check_concurrent_emplace_and_erase();
+	check_look_up_while_growing();
+	check_erased_entries_are_reused();
+
+	return test::exit_code("All hash map checks passed.");
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "log_staging.hpp"
+#include "test_utils.hpp"
+#include <thread>
+#include <fstream>
+#include <sstream>
+
+using reshade::log::line_stager;
+using reshade::log::file_sink;
+
+static const std::string s_line_ending = line_stager::line_ending;
+
+static std::vector<std::string> split_lines(const std::string &data)
+{
+	std::vector<std::string> lines;
+	for (size_t offset = 0, next; offset < data.size(); offset = next + s_line_ending.size())
+	{
+		if ((next = data.find(s_line_ending, offset)) == std::string::npos)
+			break;
+		lines.push_back(data.substr(offset, next - offset));
+	}
+	return lines;
+}
+
+static void check_order_across_threads()
+{
+	line_stager stager;
+
+	stager.stage("first");
+	std::thread([&stager]() { stager.stage("second\nsecond continued"); }).join();
+	stager.stage("third");
+
+	std::string output;
+	stager.collect(output);
+	CHECK(output == "first" + s_line_ending + "second" + s_line_ending + "second continued" + s_line_ending + "third" + s_line_ending);
+
+	// The other thread exited, so its buffer is removed, while the buffer of this thread stays registered
+	CHECK(stager.num_staging_buffers() == 1);
+
+	output.clear();
+	stager.collect(output);
+	CHECK(output.empty());
+}
+
+static void check_concurrent_staging_to_file()
+{
+	constexpr int num_threads = 8;
+	constexpr int num_messages = 20000;
+
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "reshade_log_staging_test.log";
+
+	line_stager stager;
+	file_sink file;
+	CHECK(file.open(path));
+
+	std::atomic<bool> start = false;
+	std::atomic<int> num_running = num_threads;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < num_threads; ++t)
+	{
+		threads.emplace_back([&stager, &start, &num_running, t]() {
+			while (!start)
+				std::this_thread::yield();
+
+			for (int i = 0; i < num_messages; ++i)
+			{
+				// Every few messages span multiple lines, which have to stay together
+				if (i % 100 == 0)
+					stager.stage(std::to_string(t) + ' ' + std::to_string(i) + "\n" + std::to_string(t) + " continued");
+				else
+					stager.stage(std::to_string(t) + ' ' + std::to_string(i));
+
+				// Give the collecting thread a chance to run in between, even when there are fewer cores than threads
+				if (i % 1000 == 0)
+					std::this_thread::yield();
+			}
+			num_running--;
+		});
+	}
+
+	start = true;
+
+	// Collect while the other threads are still staging lines, like the background thread writing the log file does
+	std::string buffer;
+	size_t num_writes = 0;
+	bool write_succeeded = true;
+	while (num_running != 0)
+	{
+		buffer.clear();
+		stager.collect(buffer);
+		if (!buffer.empty())
+		{
+			write_succeeded &= file.write(buffer.data(), buffer.size());
+			num_writes++;
+		}
+	}
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	buffer.clear();
+	stager.collect(buffer);
+	write_succeeded &= file.write(buffer.data(), buffer.size());
+	file.close();
+
+	CHECK(write_succeeded);
+
+	CHECK_MESSAGE(stager.num_staging_buffers() == 0, "%zu staging buffers of exited threads were not removed", stager.num_staging_buffers());
+
+	std::ifstream stream(path, std::ios::binary);
+	const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	stream.close();
+	std::filesystem::remove(path);
+
+	const std::vector<std::string> lines = split_lines(contents);
+	CHECK_MESSAGE(lines.size() == num_threads * (num_messages + num_messages / 100), "file has %zu lines", lines.size());
+
+	// Lines of each thread have to appear exactly once and in the order they were staged in
+	int next_message[num_threads] = {};
+	for (size_t l = 0; l < lines.size(); ++l)
+	{
+		int t = -1, i = -1;
+		std::istringstream(lines[l]) >> t >> i;
+		CHECK_MESSAGE(t >= 0 && t < num_threads && i == next_message[t], "line %zu \"%s\" is out of order", l, lines[l].c_str());
+		next_message[t]++;
+
+		if (i % 100 == 0)
+			CHECK_MESSAGE(l + 1 < lines.size() && lines[++l] == std::to_string(t) + " continued", "line %zu does not continue the previous message", l);
+	}
+
+	std::printf("Wrote %d lines from %d threads in %zu writes.\n", num_threads * num_messages, num_threads, num_writes);
+}
+
+int main()
+{
+	check_order_across_threads();
+	check_concurrent_staging_to_file();
+
+	return test::exit_code("All log staging checks passed.");
+}
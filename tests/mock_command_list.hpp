@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "msvc_compat.hpp"
+#include "reshade_api.hpp"
+#include "addon.hpp"
+
+namespace test
+{
+	using namespace reshade::api;
+
+	/// <summary>
+	/// Command list that ignores all commands, but stores private data the same way the real back-ends do (see 'api_object_impl').
+	/// Add-on code and event dispatch can be run against it to measure their CPU overhead in isolation.
+	/// </summary>
+	class mock_command_list : public api_object_impl<void *, command_list>
+	{
+	public:
+		mock_command_list() : api_object_impl(nullptr) {}
+
+		device *get_device() override { return nullptr; }
+
+		void barrier(uint32_t count, const resource *resources, const resource_usage *old_states, const resource_usage *new_states) override {}
+		void begin_render_pass(uint32_t count, const render_pass_render_target_desc *rts, const render_pass_depth_stencil_desc *ds) override {}
+		void end_render_pass() override {}
+		void bind_render_targets_and_depth_stencil(uint32_t count, const resource_view *rtvs, resource_view dsv) override {}
+		void bind_pipeline(pipeline_stage stages, pipeline pipeline) override {}
+		void bind_pipeline_states(uint32_t count, const dynamic_state *states, const uint32_t *values) override {}
+		void bind_viewports(uint32_t first, uint32_t count, const viewport *viewports) override {}
+		void bind_scissor_rects(uint32_t first, uint32_t count, const rect *rects) override {}
+		void push_constants(shader_stage stages, pipeline_layout layout, uint32_t param, uint32_t first, uint32_t count, const void *values) override {}
+		void push_descriptors(shader_stage stages, pipeline_layout layout, uint32_t param, const descriptor_set_update &update) override {}
+		void bind_descriptor_sets(shader_stage stages, pipeline_layout layout, uint32_t first, uint32_t count, const descriptor_set *sets) override {}
+		void bind_index_buffer(resource buffer, uint64_t offset, uint32_t index_size) override {}
+		void bind_vertex_buffers(uint32_t first, uint32_t count, const resource *buffers, const uint64_t *offsets, const uint32_t *strides) override {}
+		void bind_stream_output_buffers(uint32_t first, uint32_t count, const resource *buffers, const uint64_t *offsets, const uint64_t *max_sizes) override {}
+		void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) override {}
+		void draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance) override {}
+		void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) override {}
+		void draw_or_dispatch_indirect(indirect_command type, resource buffer, uint64_t offset, uint32_t draw_count, uint32_t stride) override {}
+		void copy_resource(resource source, resource dest) override {}
+		void copy_buffer_region(resource source, uint64_t source_offset, resource dest, uint64_t dest_offset, uint64_t size) override {}
+		void copy_buffer_to_texture(resource source, uint64_t source_offset, uint32_t row_length, uint32_t slice_height, resource dest, uint32_t dest_subresource, const subresource_box *dest_box) override {}
+		void copy_texture_region(resource source, uint32_t source_subresource, const subresource_box *source_box, resource dest, uint32_t dest_subresource, const subresource_box *dest_box, filter_mode filter) override {}
+		void copy_texture_to_buffer(resource source, uint32_t source_subresource, const subresource_box *source_box, resource dest, uint64_t dest_offset, uint32_t row_length, uint32_t slice_height) override {}
+		void resolve_texture_region(resource source, uint32_t source_subresource, const subresource_box *source_box, resource dest, uint32_t dest_subresource, int32_t dest_x, int32_t dest_y, int32_t dest_z, format format) override {}
+		void clear_depth_stencil_view(resource_view dsv, const float *depth, const uint8_t *stencil, uint32_t rect_count, const rect *rects) override {}
+		void clear_render_target_view(resource_view rtv, const float color[4], uint32_t rect_count, const rect *rects) override {}
+		void clear_unordered_access_view_uint(resource_view uav, const uint32_t values[4], uint32_t rect_count, const rect *rects) override {}
+		void clear_unordered_access_view_float(resource_view uav, const float values[4], uint32_t rect_count, const rect *rects) override {}
+		void generate_mipmaps(resource_view srv) override {}
+		void begin_query(query_pool pool, query_type type, uint32_t index) override {}
+		void end_query(query_pool pool, query_type type, uint32_t index) override {}
+		void copy_query_pool_results(query_pool pool, query_type type, uint32_t first, uint32_t count, resource dest, uint64_t dest_offset, uint32_t stride) override {}
+		void begin_debug_event(const char *label, const float color[4]) override {}
+		void end_debug_event() override {}
+		void insert_debug_marker(const char *label, const float color[4]) override {}
+	};
+}
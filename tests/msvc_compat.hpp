@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+// The ReShade API headers are written for MSVC, so provide the few extensions they use when building the tests with GCC or Clang
+// Include this before any ReShade header
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef _MSC_VER
+
+#define __declspec(x)
+#define __forceinline inline __attribute__((always_inline))
+
+namespace test
+{
+	/// <summary>
+	/// Gets a GUID that is unique to the specified type, made up of the address of its own storage.
+	/// </summary>
+	template <typename T>
+	const uint8_t *type_guid()
+	{
+		static const uint64_t guid[2] = { reinterpret_cast<uintptr_t>(&guid), 0 };
+		return reinterpret_cast<const uint8_t *>(guid);
+	}
+}
+
+#define __uuidof(T) (*test::type_guid<T>())
+
+#endif
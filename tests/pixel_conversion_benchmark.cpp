@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "image_utils.hpp"
+#include "test_utils.hpp"
+#include <cmath>
+#include <random>
+#include <cstdio>
+#include <cstring>
+
+namespace api = reshade::api;
+
+/// <summary>
+/// Per-pixel conversion of half-float pixels with float math, which the lookup tables replaced.
+/// </summary>
+static void convert_half_per_pixel(const uint8_t *data, size_t num_pixels, uint8_t *pixels)
+{
+	for (size_t i = 0; i < num_pixels * 4; ++i)
+	{
+		uint16_t half;
+		std::memcpy(&half, data + i * 2, 2);
+
+		const int exponent = (half >> 10) & 0x1F;
+		const int mantissa = half & 0x3FF;
+		float value = exponent == 0 ? std::ldexp(static_cast<float>(mantissa), -24) : exponent == 0x1F ? 0.0f : std::ldexp(static_cast<float>(mantissa + 1024), exponent - 25);
+		if ((half & 0x8000) != 0)
+			value = 0.0f;
+		value = std::min(value, 1.0f);
+		if (i % 4 != 3)
+			value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		pixels[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+	}
+}
+/// <summary>
+/// Per-pixel conversion of 10-bit pixels with truncating shifts, which the SSE2 path replaced.
+/// </summary>
+static void convert_10bit_per_pixel(const uint8_t *data, size_t num_pixels, uint8_t *pixels)
+{
+	for (size_t i = 0; i < num_pixels; ++i)
+	{
+		uint32_t packed;
+		std::memcpy(&packed, data + i * 4, 4);
+		pixels[i * 4 + 0] = static_cast<uint8_t>(((packed & 0x3FF) * 255) / 1023);
+		pixels[i * 4 + 1] = static_cast<uint8_t>((((packed >> 10) & 0x3FF) * 255) / 1023);
+		pixels[i * 4 + 2] = static_cast<uint8_t>((((packed >> 20) & 0x3FF) * 255) / 1023);
+		pixels[i * 4 + 3] = static_cast<uint8_t>((packed >> 30) * 85);
+	}
+}
+
+int main()
+{
+	constexpr uint32_t width = 3840, height = 2160;
+	constexpr size_t num_pixels = static_cast<size_t>(width) * height;
+
+	std::mt19937 rng(0x5EED);
+
+	// Half-float data is generated in the range of typical HDR content (0 to about 16), so that the tables are not always hit at the same few entries
+	std::vector<uint8_t> data(num_pixels * 8);
+	for (size_t i = 0; i < num_pixels * 4; ++i)
+	{
+		const uint16_t value = static_cast<uint16_t>(rng() % 0x4C00);
+		std::memcpy(data.data() + i * 2, &value, 2);
+	}
+
+	std::vector<uint8_t> rgba8(num_pixels * 4);
+	std::vector<uint16_t> rgba16(num_pixels * 4), rgba16f(num_pixels * 4);
+
+	std::printf("4K conversion timings, best of 3 runs on 1 thread:\n");
+	std::printf("  format               rgba8   tonemapped   rgba16   rgba16f\n");
+
+	const struct { const char *name; api::format format; uint32_t bytes_per_pixel; } formats[] = {
+		{ "r8_unorm", api::format::r8_unorm, 1 },
+		{ "r8g8_unorm", api::format::r8g8_unorm, 2 },
+		{ "r8g8b8a8_unorm", api::format::r8g8b8a8_unorm, 4 },
+		{ "b8g8r8a8_unorm", api::format::b8g8r8a8_unorm, 4 },
+		{ "b8g8r8x8_unorm", api::format::b8g8r8x8_unorm, 4 },
+		{ "r10g10b10a2_unorm", api::format::r10g10b10a2_unorm, 4 },
+		{ "b10g10r10a2_unorm", api::format::b10g10r10a2_unorm, 4 },
+		{ "r16g16b16a16_unorm", api::format::r16g16b16a16_unorm, 8 },
+		{ "r16g16b16a16_float", api::format::r16g16b16a16_float, 8 },
+	};
+
+	for (const auto &entry : formats)
+	{
+		const uint32_t row_pitch = width * entry.bytes_per_pixel;
+
+		const double rgba8_ms = test::measure_best_of_3([&]() { reshade::convert_pixels_to_rgba8(entry.format, width, height, data.data(), row_pitch, rgba8.data()); });
+		const double tonemap_ms = test::measure_best_of_3([&]() { reshade::convert_pixels_to_rgba8(entry.format, width, height, data.data(), row_pitch, rgba8.data(), true); });
+		const double rgba16_ms = test::measure_best_of_3([&]() { reshade::convert_pixels_to_rgba16(entry.format, width, height, data.data(), row_pitch, rgba16.data()); });
+		const double rgba16f_ms = test::measure_best_of_3([&]() { reshade::convert_pixels_to_rgba16f(entry.format, width, height, data.data(), row_pitch, rgba16f.data()); });
+
+		std::printf("  %-18s %6.1f ms %9.1f ms %6.1f ms %6.1f ms\n", entry.name, rgba8_ms, tonemap_ms, rgba16_ms, rgba16f_ms);
+	}
+
+	const double half_before_ms = test::measure_best_of_3([&]() { convert_half_per_pixel(data.data(), num_pixels, rgba8.data()); });
+	const double half_after_ms = test::measure_best_of_3([&]() { reshade::convert_pixels_to_rgba8(api::format::r16g16b16a16_float, width, height, data.data(), width * 8, rgba8.data()); });
+	const double ten_bit_before_ms = test::measure_best_of_3([&]() { convert_10bit_per_pixel(data.data(), num_pixels, rgba8.data()); });
+	const double ten_bit_after_ms = test::measure_best_of_3([&]() { reshade::convert_pixels_to_rgba8(api::format::r10g10b10a2_unorm, width, height, data.data(), width * 4, rgba8.data()); });
+
+	std::printf("  rgba16f -> rgba8: %.1f ms per pixel with float math, %.1f ms with tables\n", half_before_ms, half_after_ms);
+	std::printf("  10-bit -> rgba8:  %.1f ms per pixel, %.1f ms with SSE2\n", ten_bit_before_ms, ten_bit_after_ms);
+
+	for (const uint32_t channels : { 3u, 4u })
+	{
+		std::vector<uint16_t> pixels(num_pixels * channels);
+		std::memcpy(pixels.data(), data.data(), pixels.size() * 2);
+
+		std::vector<uint8_t> out;
+		const double exr_ms = test::measure_best_of_3([&]() { reshade::encode_exr(pixels.data(), width, height, channels, out, 1); });
+
+		std::printf("  OpenEXR %s 4K: %.0f ms %.1f MB on 1 thread\n", channels == 4 ? "RGBA" : "RGB", exr_ms, out.size() / 1e6);
+	}
+
+	return 0;
+}
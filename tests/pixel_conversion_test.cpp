@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "image_utils.hpp"
+#include "test_utils.hpp"
+#include <cmath>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace api = reshade::api;
+
+// Double-precision references, which are written independently of the lookup tables and bit tricks used by the conversion functions
+
+static double reference_half_to_double(uint16_t value)
+{
+	const int exponent = (value >> 10) & 0x1F;
+	const int mantissa = value & 0x3FF;
+
+	double result;
+	if (exponent == 0x1F)
+		result = mantissa != 0 ? NAN : INFINITY;
+	else if (exponent == 0)
+		result = std::ldexp(mantissa, -24);
+	else
+		result = std::ldexp(mantissa + 1024, exponent - 25);
+	return (value & 0x8000) != 0 ? -result : result;
+}
+static double reference_srgb_to_linear(double value)
+{
+	return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+}
+static double reference_linear_to_srgb(double value)
+{
+	return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+}
+static double reference_tonemap(double value)
+{
+	if (value <= 0.8)
+		return value;
+	const double x = (value - 0.8) / 0.2;
+	const double white = (12.5 - 0.8) / 0.2;
+	return 0.8 + 0.2 * std::min(x * (1.0 + x / (white * white)) / (1.0 + x), 1.0);
+}
+
+/// <summary>
+/// Channel values of a pixel as they are stored in the source format, normalized to [0, 1] for integer formats, or linear for floating-point formats.
+/// </summary>
+struct reference_pixel
+{
+	double rgba[4];
+	// Exact integer source values, to check the integer conversions bit for bit
+	uint32_t bits[4];
+	uint32_t max_value[4];
+	bool is_float;
+};
+
+static reference_pixel decode_reference_pixel(api::format format, const uint8_t *data, uint32_t x)
+{
+	reference_pixel p = {};
+	const auto set_unorm = [&p](int c, uint32_t value, uint32_t max_value) {
+		p.bits[c] = value;
+		p.max_value[c] = max_value;
+		p.rgba[c] = value / static_cast<double>(max_value);
+	};
+
+	switch (format)
+	{
+	case api::format::r8_unorm:
+		set_unorm(0, data[x], 255); set_unorm(1, 0, 255); set_unorm(2, 0, 255); set_unorm(3, 255, 255);
+		break;
+	case api::format::r8g8_unorm:
+		set_unorm(0, data[x * 2 + 0], 255); set_unorm(1, data[x * 2 + 1], 255); set_unorm(2, 0, 255); set_unorm(3, 255, 255);
+		break;
+	case api::format::r8g8b8a8_unorm:
+	case api::format::r8g8b8x8_unorm:
+	case api::format::b8g8r8a8_unorm:
+	case api::format::b8g8r8x8_unorm:
+	{
+		const bool bgra = format == api::format::b8g8r8a8_unorm || format == api::format::b8g8r8x8_unorm;
+		const bool opaque = format == api::format::r8g8b8x8_unorm || format == api::format::b8g8r8x8_unorm;
+		set_unorm(0, data[x * 4 + (bgra ? 2 : 0)], 255);
+		set_unorm(1, data[x * 4 + 1], 255);
+		set_unorm(2, data[x * 4 + (bgra ? 0 : 2)], 255);
+		set_unorm(3, opaque ? 255 : data[x * 4 + 3], 255);
+		break;
+	}
+	case api::format::r10g10b10a2_unorm:
+	case api::format::b10g10r10a2_unorm:
+	{
+		const uint32_t packed = data[x * 4] | (data[x * 4 + 1] << 8) | (data[x * 4 + 2] << 16) | (static_cast<uint32_t>(data[x * 4 + 3]) << 24);
+		const bool bgra = format == api::format::b10g10r10a2_unorm;
+		set_unorm(bgra ? 2 : 0, packed & 0x3FF, 1023);
+		set_unorm(1, (packed >> 10) & 0x3FF, 1023);
+		set_unorm(bgra ? 0 : 2, (packed >> 20) & 0x3FF, 1023);
+		set_unorm(3, packed >> 30, 3);
+		break;
+	}
+	case api::format::r16g16b16a16_unorm:
+		for (int c = 0; c < 4; ++c)
+			set_unorm(c, data[x * 8 + c * 2] | (data[x * 8 + c * 2 + 1] << 8), 65535);
+		break;
+	case api::format::r16g16b16a16_float:
+		p.is_float = true;
+		for (int c = 0; c < 4; ++c)
+		{
+			p.bits[c] = data[x * 8 + c * 2] | (data[x * 8 + c * 2 + 1] << 8);
+			p.rgba[c] = reference_half_to_double(static_cast<uint16_t>(p.bits[c]));
+		}
+		break;
+	default:
+		break;
+	}
+
+	return p;
+}
+
+/// <summary>
+/// Computes the expected unsigned normalized output value of a channel.
+/// Integer values are expected to be rescaled exactly (with 10-bit to 16-bit replicating the high bits), floating-point values to be sRGB encoded within one step of rounding.
+/// </summary>
+static uint32_t expected_unorm(const reference_pixel &p, int c, uint32_t max_value, bool tonemap, uint32_t &tolerance)
+{
+	tolerance = 0;
+
+	if (!p.is_float)
+	{
+		if (p.max_value[c] == max_value)
+			return p.bits[c];
+		if (p.max_value[c] == 1023 && max_value == 65535)
+			return (p.bits[c] << 6) | (p.bits[c] >> 4);
+		return static_cast<uint32_t>(std::floor(p.bits[c] * static_cast<double>(max_value) / p.max_value[c] + 0.5));
+	}
+
+	// Tables are computed in single precision, so allow one step of difference
+	tolerance = 1;
+
+	double value = p.rgba[c];
+	if (!(value > 0.0))
+		value = 0.0;
+	if (c != 3 && tonemap)
+		value = reference_tonemap(value);
+	value = std::min(value, 1.0);
+	if (c != 3)
+		value = reference_linear_to_srgb(value);
+	return static_cast<uint32_t>(std::floor(value * max_value + 0.5));
+}
+
+static bool check_half_close(uint16_t actual, double expected)
+{
+	// Accept the two halves closest to the expected value
+	const double value = reference_half_to_double(actual);
+	if (value == expected)
+		return true;
+	const double next = reference_half_to_double(static_cast<uint16_t>(value < expected ? actual + 1 : actual - 1));
+	return (value < expected) != (next < expected) || next == expected;
+}
+
+static void check_format(api::format format, uint32_t bytes_per_pixel, const std::vector<uint8_t> &data, uint32_t width, uint32_t height)
+{
+	const uint32_t row_pitch = width * bytes_per_pixel + 12; // Padded rows, as they come from readback buffers
+	std::vector<uint8_t> padded(static_cast<size_t>(row_pitch) * height, 0xCD);
+	for (uint32_t y = 0; y < height; ++y)
+		std::memcpy(padded.data() + y * row_pitch, data.data() + static_cast<size_t>(y) * width * bytes_per_pixel, width * bytes_per_pixel);
+
+	const size_t num_pixels = static_cast<size_t>(width) * height;
+	std::vector<uint8_t> rgba8(num_pixels * 4);
+	std::vector<uint16_t> rgba16(num_pixels * 4);
+	std::vector<uint16_t> rgba16f(num_pixels * 4);
+
+	for (const bool tonemap : { false, true })
+	{
+		CHECK_MESSAGE(
+			reshade::convert_pixels_to_rgba8(format, width, height, padded.data(), row_pitch, rgba8.data(), tonemap) &&
+			reshade::convert_pixels_to_rgba16(format, width, height, padded.data(), row_pitch, rgba16.data(), tonemap) &&
+			reshade::convert_pixels_to_rgba16f(format, width, height, padded.data(), row_pitch, rgba16f.data()),
+			"Format %u: conversion failed", static_cast<uint32_t>(format));
+
+		for (size_t i = 0; i < num_pixels; ++i)
+		{
+			const reference_pixel p = decode_reference_pixel(format, data.data() + (i / width) * width * bytes_per_pixel, static_cast<uint32_t>(i % width));
+
+			for (int c = 0; c < 4; ++c)
+			{
+				uint32_t tolerance8, tolerance16;
+				const uint32_t expected8 = expected_unorm(p, c, 255, tonemap, tolerance8);
+				const uint32_t expected16 = expected_unorm(p, c, 65535, tonemap, tolerance16);
+
+				const uint32_t actual8 = rgba8[i * 4 + c];
+				const uint32_t actual16 = rgba16[i * 4 + c];
+				CHECK_MESSAGE(
+					std::max(actual8, expected8) - std::min(actual8, expected8) <= tolerance8 &&
+					std::max(actual16, expected16) - std::min(actual16, expected16) <= tolerance16,
+					"Format %u%s: pixel %zu channel %d is %u/%u, expected %u/%u", static_cast<uint32_t>(format), tonemap ? " (tone mapped)" : "", i, c, actual8, actual16, expected8, expected16);
+
+				// Floating-point formats are copied as is, integer formats are decoded from sRGB to linear (except for alpha)
+				const uint16_t actual_half = rgba16f[i * 4 + c];
+				CHECK_MESSAGE(
+					p.is_float ? actual_half == p.bits[c] : check_half_close(actual_half, c != 3 ? reference_srgb_to_linear(p.rgba[c]) : p.rgba[c]),
+					"Format %u: pixel %zu channel %d is half %04X, expected %f", static_cast<uint32_t>(format), i, c, actual_half, p.rgba[c]);
+			}
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(0x5EED);
+
+	const struct { api::format format; uint32_t bytes_per_pixel; } formats[] = {
+		{ api::format::r8_unorm, 1 },
+		{ api::format::r8g8_unorm, 2 },
+		{ api::format::r8g8b8a8_unorm, 4 },
+		{ api::format::r8g8b8x8_unorm, 4 },
+		{ api::format::b8g8r8a8_unorm, 4 },
+		{ api::format::b8g8r8x8_unorm, 4 },
+		{ api::format::r10g10b10a2_unorm, 4 },
+		{ api::format::b10g10r10a2_unorm, 4 },
+		{ api::format::r16g16b16a16_unorm, 8 },
+		{ api::format::r16g16b16a16_float, 8 },
+	};
+
+	for (const auto &entry : formats)
+	{
+		if (!reshade::is_convertible_format(entry.format))
+		{
+			std::fprintf(stderr, "Format %u is not reported as convertible\n", static_cast<uint32_t>(entry.format));
+			test::num_failures++;
+			continue;
+		}
+
+		// Odd width to cover the remainders of the vectorized loops
+		const uint32_t width = 1027, height = 67;
+		std::vector<uint8_t> data(static_cast<size_t>(width) * height * entry.bytes_per_pixel);
+		for (uint8_t &value : data)
+			value = static_cast<uint8_t>(rng());
+
+		check_format(entry.format, entry.bytes_per_pixel, data, width, height);
+	}
+
+	// Every possible half value in every channel, including denormals, negative values, infinity and NaN
+	{
+		const uint32_t width = 16384, height = 4;
+		std::vector<uint8_t> data(static_cast<size_t>(width) * height * 8);
+		for (uint32_t y = 0, i = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width * 4; ++x, ++i)
+			{
+				const uint16_t value = static_cast<uint16_t>(x + y * 16385);
+				data[i * 2 + 0] = static_cast<uint8_t>(value);
+				data[i * 2 + 1] = static_cast<uint8_t>(value >> 8);
+			}
+		}
+
+		check_format(api::format::r16g16b16a16_float, 8, data, width, height);
+	}
+
+	// Every possible 10-bit and 2-bit value
+	{
+		const uint32_t width = 1024, height = 4;
+		std::vector<uint8_t> data(static_cast<size_t>(width) * height * 4);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				const uint32_t packed = x | (((x + 341) & 0x3FF) << 10) | (((x + 682) & 0x3FF) << 20) | (y << 30);
+				std::memcpy(data.data() + (y * width + x) * 4, &packed, 4);
+			}
+		}
+
+		check_format(api::format::r10g10b10a2_unorm, 4, data, width, height);
+		check_format(api::format::b10g10r10a2_unorm, 4, data, width, height);
+	}
+
+	if (reshade::is_convertible_format(api::format::r32g32b32a32_float))
+	{
+		std::fprintf(stderr, "Unsupported format is reported as convertible\n");
+		test::num_failures++;
+	}
+
+	return test::exit_code("All pixel conversion checks passed.");
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "image_utils.hpp"
+#include "test_utils.hpp"
+#include <png.h>
+#include <random>
+#include <thread>
+#include <cstdio>
+
+static void write_png_data(png_structp png, png_bytep data, png_size_t size)
+{
+	std::vector<uint8_t> &out = *static_cast<std::vector<uint8_t> *>(png_get_io_ptr(png));
+	out.insert(out.end(), data, data + size);
+}
+static void flush_png_data(png_structp)
+{
+}
+
+/// <summary>
+/// Encodes with libpng at zlib level 1 and the same "Up" filter, as the single-threaded baseline.
+/// </summary>
+static void encode_png_zlib(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t channels, std::vector<uint8_t> &out)
+{
+	out.clear();
+
+	png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop info = png_create_info_struct(png);
+
+	if (setjmp(png_jmpbuf(png)))
+	{
+		png_destroy_write_struct(&png, &info);
+		return;
+	}
+
+	png_set_write_fn(png, &out, write_png_data, flush_png_data);
+	png_set_compression_level(png, 1);
+	png_set_filter(png, PNG_FILTER_TYPE_BASE, PNG_FILTER_UP);
+	png_set_IHDR(png, info, width, height, 8, channels == 4 ? PNG_COLOR_TYPE_RGBA : PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png, info);
+
+	for (uint32_t y = 0; y < height; ++y)
+		png_write_row(png, pixels + static_cast<size_t>(y) * width * channels);
+
+	png_write_end(png, nullptr);
+	png_destroy_write_struct(&png, &info);
+}
+
+/// <summary>
+/// Generates something closer to a rendered frame than plain noise: smooth gradients, flat areas, hard edges and a little film grain.
+/// </summary>
+static std::vector<uint8_t> generate_frame(uint32_t width, uint32_t height, uint32_t channels)
+{
+	std::mt19937 rng(0x5EED);
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * channels);
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			uint8_t *const pixel = pixels.data() + (static_cast<size_t>(y) * width + x) * channels;
+			const bool panel = (x / 256 + y / 192) % 5 == 0;
+			const uint32_t grain = rng() % 6;
+
+			pixel[0] = panel ? 40 : static_cast<uint8_t>(x * 255 / width + grain);
+			pixel[1] = panel ? 40 : static_cast<uint8_t>(y * 255 / height + grain);
+			pixel[2] = panel ? 48 : static_cast<uint8_t>(((x + y) / 8) % 64 + 96 + grain);
+			if (channels == 4)
+				pixel[3] = 0xFF;
+		}
+	}
+
+	return pixels;
+}
+
+int main()
+{
+	const uint32_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::printf("Best of 3 runs on synthetic frames, %u hardware threads:\n", hardware_threads);
+
+	const struct { const char *name; uint32_t width, height; } sizes[] = {
+		{ "4K", 3840, 2160 },
+		{ "8K", 7680, 4320 },
+	};
+
+	for (const auto &size : sizes)
+	{
+		for (const uint32_t channels : { 3u, 4u })
+		{
+			const std::vector<uint8_t> pixels = generate_frame(size.width, size.height, channels);
+			std::vector<uint8_t> out;
+
+			const double zlib_ms = test::measure_best_of_3([&]() { encode_png_zlib(pixels.data(), size.width, size.height, channels, out); });
+			const size_t zlib_size = out.size();
+			const double single_ms = test::measure_best_of_3([&]() { reshade::encode_png(pixels.data(), size.width, size.height, channels, 8, out, 1); });
+			const size_t single_size = out.size();
+			const double multi_ms = test::measure_best_of_3([&]() { reshade::encode_png(pixels.data(), size.width, size.height, channels, 8, out, hardware_threads); });
+			const size_t multi_size = out.size();
+
+			std::printf("  %s %-4s  zlib level 1 %6.0f ms %5.1f MB | encode_png 1 thread %6.0f ms %5.1f MB | %u threads %6.0f ms %5.1f MB\n",
+				size.name, channels == 4 ? "RGBA" : "RGB",
+				zlib_ms, zlib_size / 1e6, single_ms, single_size / 1e6, hardware_threads, multi_ms, multi_size / 1e6);
+		}
+	}
+
+	const size_t num_pixels = 3840 * 2160;
+	std::vector<uint8_t> bgra = generate_frame(3840, 2160, 4), rgba(num_pixels * 4);
+
+	const double swizzle_ms = test::measure_best_of_3([&]() { reshade::convert_bgra_to_rgba(bgra.data(), rgba.data(), num_pixels); });
+	const double strip_ms = test::measure_best_of_3([&]() { reshade::convert_rgba_to_rgb(bgra.data(), rgba.data(), num_pixels); });
+
+	std::printf("  BGRA->RGBA 4K: %.1f ms, alpha strip 4K: %.1f ms\n", swizzle_ms, strip_ms);
+
+	return 0;
+}
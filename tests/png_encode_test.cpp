@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "image_utils.hpp"
+#include "test_utils.hpp"
+#include <png.h>
+#include <random>
+#include <cstdio>
+#include <cstring>
+
+struct png_memory_reader
+{
+	const std::vector<uint8_t> &data;
+	size_t offset;
+};
+
+static void read_png_data(png_structp png, png_bytep out, png_size_t size)
+{
+	png_memory_reader &reader = *static_cast<png_memory_reader *>(png_get_io_ptr(png));
+	if (reader.offset + size > reader.data.size())
+		png_error(png, "read past end of file");
+	std::memcpy(out, reader.data.data() + reader.offset, size);
+	reader.offset += size;
+}
+
+/// <summary>
+/// Decodes a PNG file with libpng, which checks the CRCs of all chunks and the Adler-32 of the zlib stream.
+/// </summary>
+static bool decode_png(const std::vector<uint8_t> &data, uint32_t width, uint32_t height, uint32_t channels, uint32_t bits_per_channel, std::vector<uint8_t> &pixels)
+{
+	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop info = png_create_info_struct(png);
+
+	if (setjmp(png_jmpbuf(png)))
+	{
+		png_destroy_read_struct(&png, &info, nullptr);
+		return false;
+	}
+
+	png_memory_reader reader = { data, 0 };
+	png_set_read_fn(png, &reader, read_png_data);
+	png_read_info(png, info);
+
+	if (png_get_image_width(png, info) != width ||
+		png_get_image_height(png, info) != height ||
+		png_get_channels(png, info) != channels ||
+		png_get_bit_depth(png, info) != bits_per_channel)
+	{
+		png_destroy_read_struct(&png, &info, nullptr);
+		return false;
+	}
+
+	// The encoder takes 16-bit channels in native byte order, but PNG stores them big-endian
+	const uint16_t endian_test = 1;
+	if (bits_per_channel == 16 && *reinterpret_cast<const uint8_t *>(&endian_test) == 1)
+		png_set_swap(png);
+
+	const size_t row_size = static_cast<size_t>(width) * channels * (bits_per_channel / 8);
+	pixels.resize(row_size * height);
+	std::vector<png_bytep> rows(height);
+	for (uint32_t y = 0; y < height; ++y)
+		rows[y] = pixels.data() + y * row_size;
+
+	png_read_image(png, rows.data());
+	png_read_end(png, nullptr);
+	png_destroy_read_struct(&png, &info, nullptr);
+	return true;
+}
+
+enum class pattern
+{
+	noise,
+	constant,
+	gradient,
+};
+
+static std::vector<uint8_t> generate_image(pattern type, size_t size, std::mt19937 &rng)
+{
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		switch (type)
+		{
+		case pattern::noise:
+			data[i] = static_cast<uint8_t>(rng());
+			break;
+		case pattern::constant:
+			data[i] = 0x5A;
+			break;
+		case pattern::gradient:
+			// Rows repeat with a period that does not divide the row size, so that matches cross rows and strips
+			data[i] = static_cast<uint8_t>((i / 7) ^ (i % 251));
+			break;
+		}
+	}
+	return data;
+}
+
+static void check_round_trip(uint32_t width, uint32_t height, uint32_t channels, uint32_t bits_per_channel, uint32_t num_threads, pattern type, std::mt19937 &rng)
+{
+	const std::vector<uint8_t> pixels = generate_image(type, static_cast<size_t>(width) * height * channels * (bits_per_channel / 8), rng);
+
+	std::vector<uint8_t> encoded, decoded;
+	CHECK_MESSAGE(
+		reshade::encode_png(pixels.data(), width, height, channels, bits_per_channel, encoded, num_threads),
+		"%ux%u %u channels %u bits %u threads: encoding failed", width, height, channels, bits_per_channel, num_threads);
+	CHECK_MESSAGE(
+		decode_png(encoded, width, height, channels, bits_per_channel, decoded) && decoded == pixels,
+		"%ux%u %u channels %u bits %u threads pattern %d: decoded image does not match", width, height, channels, bits_per_channel, num_threads, static_cast<int>(type));
+}
+
+static void check_channel_conversions(std::mt19937 &rng)
+{
+	// Cover all remainders of the vectorized loops, which process four pixels at a time
+	for (size_t num_pixels = 0; num_pixels < 40; ++num_pixels)
+	{
+		const std::vector<uint8_t> bgra = generate_image(pattern::noise, num_pixels * 4, rng);
+
+		for (const bool force_opaque : { false, true })
+		{
+			std::vector<uint8_t> rgba(num_pixels * 4);
+			reshade::convert_bgra_to_rgba(bgra.data(), rgba.data(), num_pixels, force_opaque);
+
+			for (size_t i = 0; i < num_pixels; ++i)
+				CHECK_MESSAGE(
+					rgba[i * 4 + 0] == bgra[i * 4 + 2] &&
+					rgba[i * 4 + 1] == bgra[i * 4 + 1] &&
+					rgba[i * 4 + 2] == bgra[i * 4 + 0] &&
+					rgba[i * 4 + 3] == (force_opaque ? 0xFF : bgra[i * 4 + 3]),
+					"BGRA to RGBA: pixel %zu of %zu does not match", i, num_pixels);
+		}
+
+		// Removing alpha has to work in place, which is how the screenshot writer uses it
+		std::vector<uint8_t> rgb = bgra;
+		reshade::convert_rgba_to_rgb(rgb.data(), rgb.data(), num_pixels);
+
+		std::vector<uint16_t> rgba16(num_pixels * 4);
+		for (size_t i = 0; i < rgba16.size(); ++i)
+			rgba16[i] = static_cast<uint16_t>(rng());
+		std::vector<uint16_t> rgb16 = rgba16;
+		reshade::convert_rgba_to_rgb(rgb16.data(), rgb16.data(), num_pixels);
+
+		for (size_t i = 0; i < num_pixels * 3; ++i)
+			CHECK_MESSAGE(rgb[i] == bgra[(i / 3) * 4 + i % 3] && rgb16[i] == rgba16[(i / 3) * 4 + i % 3], "RGBA to RGB: channel %zu of %zu pixels does not match", i, num_pixels);
+	}
+}
+
+static void check_invalid_arguments()
+{
+	const uint8_t pixel[8] = {};
+	std::vector<uint8_t> encoded;
+
+	CHECK_MESSAGE(
+		!reshade::encode_png(pixel, 0, 1, 4, 8, encoded) &&
+		!reshade::encode_png(pixel, 1, 0, 4, 8, encoded) &&
+		!reshade::encode_png(pixel, 1, 1, 2, 8, encoded) &&
+		!reshade::encode_png(pixel, 1, 1, 4, 12, encoded),
+		"Invalid arguments were not rejected");
+}
+
+int main()
+{
+	std::mt19937 rng(0x5EED);
+
+	const uint32_t sizes[][2] = {
+		{ 1, 1 },
+		{ 7, 5 },
+		{ 333, 257 },
+		// Large enough to be split into multiple strips
+		{ 640, 480 },
+		{ 1921, 1081 },
+	};
+
+	for (const auto &size : sizes)
+		for (const uint32_t channels : { 3u, 4u })
+			for (const uint32_t bits_per_channel : { 8u, 16u })
+				for (const uint32_t num_threads : { 1u, 2u, 3u, 8u })
+					for (const pattern type : { pattern::noise, pattern::constant, pattern::gradient })
+						check_round_trip(size[0], size[1], channels, bits_per_channel, num_threads, type, rng);
+
+	check_channel_conversions(rng);
+	check_invalid_arguments();
+
+	return test::exit_code("All PNG encoder checks passed.");
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "mock_command_list.hpp"
+#include "test_utils.hpp"
+
+/// <summary>
+/// Command list that stores private data the way 'api_object_impl' did before GUIDs were assigned slots, in a list that is searched with 'memcmp' on every look up.
+/// </summary>
+class previous_command_list : public test::mock_command_list
+{
+public:
+	void get_private_data(const uint8_t guid[16], uint64_t *data) const override
+	{
+		for (auto it = _private_data.begin(); it != _private_data.end(); ++it)
+		{
+			if (std::memcmp(it->guid, guid, 16) == 0)
+			{
+				*data = it->data;
+				return;
+			}
+		}
+
+		*data = 0;
+	}
+	void set_private_data(const uint8_t guid[16], const uint64_t data) override
+	{
+		for (auto it = _private_data.begin(); it != _private_data.end(); ++it)
+		{
+			if (std::memcmp(it->guid, guid, 16) == 0)
+			{
+				if (data != 0)
+					it->data = data;
+				else
+					_private_data.erase(it);
+				return;
+			}
+		}
+
+		if (data != 0)
+		{
+			_private_data.push_back({ data, {
+				reinterpret_cast<const uint64_t *>(guid)[0],
+				reinterpret_cast<const uint64_t *>(guid)[1] } });
+		}
+	}
+
+private:
+	struct private_data
+	{
+		uint64_t data;
+		uint64_t guid[2];
+	};
+
+	std::vector<private_data> _private_data;
+};
+
+// GUIDs of the 'state_tracking' and 'state_tracking_context' structures of the 'generic_depth' add-on, and of data other add-ons attach to the same objects
+alignas(8) static const uint8_t s_state_tracking_guid[16] = { 0x83, 0x9e, 0x31, 0x43, 0x7c, 0x38, 0x8e, 0x44, 0x88, 0x1c, 0x7e, 0x68, 0xfc, 0x2e, 0x52, 0xc4 };
+alignas(8) static const uint8_t s_state_tracking_context_guid[16] = { 0x62, 0xe1, 0x06, 0xe0, 0xac, 0x33, 0x9f, 0x4b, 0xb1, 0x0f, 0x0e, 0x15, 0x33, 0x5c, 0x7b, 0xdb };
+alignas(8) static const uint8_t s_other_guids[4][16] = {
+	{ 0x83, 0x9e, 0x31, 0x33, 0x7c, 0x38, 0x8e, 0x44, 0x88, 0x1c, 0x7e, 0x68, 0xfc, 0x2e, 0x52, 0xc4 },
+	{ 0xc7, 0x63, 0x63, 0x7c, 0x4e, 0xf9, 0x7a, 0x43, 0x91, 0x60, 0x14, 0x17, 0x82, 0xc4, 0x4a, 0x98 },
+	{ 0x0a, 0x1b, 0x2c, 0x3d, 0x4e, 0x5f, 0x60, 0x71, 0x82, 0x93, 0xa4, 0xb5, 0xc6, 0xd7, 0xe8, 0xf9 },
+	{ 0xf0, 0xe1, 0xd2, 0xc3, 0xb4, 0xa5, 0x96, 0x87, 0x78, 0x69, 0x5a, 0x4b, 0x3c, 0x2d, 0x1e, 0x0f },
+};
+// GUID that is registered, but not set on the objects, like data an add-on only attaches to some command lists
+alignas(8) static const uint8_t s_missing_guid[16] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x00 };
+
+struct result
+{
+	double draw_ns;
+	double miss_ns;
+	uint64_t checksum;
+};
+
+/// <summary>
+/// Looks up private data like the 'generic_depth' add-on does: Every draw call gets the state of the command list (which holds 3 entries), and some calls (clears, copies) additionally get the state of the device (which holds 4 entries).
+/// </summary>
+template <typename object_type>
+static result measure(size_t num_draws)
+{
+	object_type cmd_list;
+	object_type device;
+
+	// Other add-ons usually create their data first, so the entries looked up most are behind those in a list
+	cmd_list.set_private_data(s_other_guids[0], 1);
+	cmd_list.set_private_data(s_other_guids[1], 2);
+	cmd_list.set_private_data(s_state_tracking_guid, 0xC0FFEE);
+	device.set_private_data(s_other_guids[0], 3);
+	device.set_private_data(s_other_guids[2], 4);
+	device.set_private_data(s_other_guids[3], 5);
+	device.set_private_data(s_state_tracking_context_guid, 0xDE71CE);
+	// Register the missing GUID with another object, so that the slot registry knows it
+	object_type other;
+	other.set_private_data(s_missing_guid, 6);
+
+	// Call through the interface like add-ons do, which hides the type of the objects from the compiler, so that calls cannot be devirtualized
+	reshade::api::api_object *volatile cmd_list_interface = &cmd_list;
+	reshade::api::api_object *volatile device_interface = &device;
+
+	result r = {};
+
+	const double draw_ms = test::measure_best_of_3([&]() {
+		reshade::api::api_object *const cmd_list_ptr = cmd_list_interface;
+		reshade::api::api_object *const device_ptr = device_interface;
+
+		uint64_t checksum = 0;
+		for (size_t i = 0; i < num_draws; ++i)
+		{
+			uint64_t data = 0;
+			cmd_list_ptr->get_private_data(s_state_tracking_guid, &data);
+			checksum += data;
+
+			if (i % 16 == 0)
+			{
+				device_ptr->get_private_data(s_state_tracking_context_guid, &data);
+				checksum += data;
+			}
+		}
+		r.checksum = checksum;
+	});
+
+	const double miss_ms = test::measure_best_of_3([&]() {
+		reshade::api::api_object *const cmd_list_ptr = cmd_list_interface;
+
+		uint64_t checksum = 0;
+		for (size_t i = 0; i < num_draws; ++i)
+		{
+			uint64_t data = 0;
+			cmd_list_ptr->get_private_data(s_missing_guid, &data);
+			checksum += data;
+		}
+		r.checksum += checksum;
+	});
+
+	r.draw_ns = draw_ms * 1000000.0 / num_draws;
+	r.miss_ns = miss_ms * 1000000.0 / num_draws;
+
+	// Remove everything again, like 'destroy_private_data' does
+	for (const uint8_t *guid : { s_other_guids[0], s_other_guids[1], s_state_tracking_guid })
+		cmd_list.set_private_data(guid, 0);
+	for (const uint8_t *guid : { s_other_guids[0], s_other_guids[2], s_other_guids[3], s_state_tracking_context_guid })
+		device.set_private_data(guid, 0);
+	other.set_private_data(s_missing_guid, 0);
+
+	return r;
+}
+
+int main()
+{
+	constexpr size_t num_draws = 10000000;
+
+	const result previous = measure<previous_command_list>(num_draws);
+	const result slots = measure<test::mock_command_list>(num_draws);
+
+	std::printf("%zu draw calls, best of 3 runs:\n", num_draws);
+	std::printf("  list with memcmp: %.2f ns/draw, %.2f ns/miss\n", previous.draw_ns, previous.miss_ns);
+	std::printf("  GUID slots:       %.2f ns/draw, %.2f ns/miss\n", slots.draw_ns, slots.miss_ns);
+
+	// Both have to find the same data
+	if (previous.checksum != slots.checksum)
+	{
+		std::fprintf(stderr, "Looked up data differs between the list and the GUID slots\n");
+		return 1;
+	}
+
+	return 0;
+}
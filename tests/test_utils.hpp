@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2022 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+namespace test
+{
+	/// <summary>
+	/// Number of checks that failed so far, which may be incremented from multiple threads.
+	/// </summary>
+	inline std::atomic<int> num_failures = 0;
+
+	/// <summary>
+	/// Gets the exit code to return from 'main', printing the specified message if all checks passed.
+	/// </summary>
+	inline int exit_code(const char *success_message)
+	{
+		if (num_failures != 0)
+		{
+			std::fprintf(stderr, "%d check(s) failed.\n", num_failures.load());
+			return 1;
+		}
+
+		std::printf("%s\n", success_message);
+		return 0;
+	}
+
+	/// <summary>
+	/// Runs the specified function three times and returns the fastest run in milliseconds.
+	/// </summary>
+	template <typename F>
+	double measure_best_of_3(F &&function)
+	{
+		double best = 1e30;
+		for (int i = 0; i < 3; ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			function();
+			const auto end = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		return best;
+	}
+}
+
+/// <summary>
+/// Records a failure with a formatted message and returns from the calling function if the condition is not met.
+/// </summary>
+#define CHECK_MESSAGE(condition, ...) \
+	do { \
+		if (!(condition)) { \
+			std::fprintf(stderr, "%s(%d): ", __FILE__, __LINE__); \
+			std::fprintf(stderr, __VA_ARGS__); \
+			std::fputc('\n', stderr); \
+			test::num_failures++; \
+			return; \
+		} \
+	} while (0)
+
+/// <summary>
+/// Records a failure and returns from the calling function if the condition is not met.
+/// </summary>
+#define CHECK(condition) \
+	CHECK_MESSAGE(condition, "check \"%s\" failed", #condition)
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "transient_descriptor_ring.hpp"
+#include "test_utils.hpp"
+#include <thread>
+#include <random>
+
+/// <summary>
+/// Fence on a simulated GPU timeline, which only completes submissions when told to (or when waited on, like a real fence completes eventually).
+/// </summary>
+struct fake_fence
+{
+	uint64_t completed_value() const
+	{
+		return completed.load(std::memory_order_acquire);
+	}
+
+	void wait(uint64_t value) const
+	{
+		num_waits++;
+		complete(value);
+	}
+
+	uint64_t signal()
+	{
+		return ++signaled;
+	}
+
+	void complete(uint64_t value) const
+	{
+		uint64_t current = completed.load(std::memory_order_relaxed);
+		while (current < value && !completed.compare_exchange_weak(current, value, std::memory_order_release, std::memory_order_relaxed))
+			continue;
+	}
+
+	mutable std::atomic<uint64_t> completed = 0;
+	mutable std::atomic<uint32_t> num_waits = 0;
+	std::atomic<uint64_t> signaled = 0;
+};
+
+static constexpr uint32_t block_size = 16;
+static constexpr uint32_t ring_size = 256;
+static constexpr uint32_t num_blocks = ring_size / block_size;
+
+using ring_type = transient_descriptor_ring<fake_fence, block_size>;
+
+static void check_reuse_after_fence()
+{
+	fake_fence fence;
+	ring_type ring(ring_size);
+
+	// Fill the whole ring from one command list and submit it
+	ring_type::block_list list;
+	uint32_t offsets[num_blocks];
+	for (uint32_t i = 0; i < num_blocks; ++i)
+	{
+		CHECK(ring.allocate(list, block_size, offsets[i]));
+		CHECK(offsets[i] % block_size == 0 && offsets[i] < ring_size);
+	}
+
+	// Nothing was submitted yet, so another command list cannot get any blocks (and must not wait for anything)
+	ring_type::block_list other_list;
+	uint32_t offset = 0;
+	CHECK(!ring.allocate(other_list, 1, offset));
+	CHECK(fence.num_waits == 0);
+
+	const uint64_t fence_value = fence.signal();
+	ring.submit(list, &fence, fence_value);
+	ring.release(list);
+
+	// The submission did not complete yet, so allocating has to wait for it
+	CHECK(ring.allocate(other_list, block_size, offset));
+	CHECK_MESSAGE(fence.num_waits == 1 && fence.completed_value() >= fence_value, "allocation did not wait for the fence (%u waits)", fence.num_waits.load());
+
+	ring.release(other_list);
+}
+
+static void check_unsubmitted_blocks_are_reused_immediately()
+{
+	fake_fence fence;
+	ring_type ring(ring_size);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		ring_type::block_list list;
+		uint32_t offset = 0;
+		for (uint32_t k = 0; k < num_blocks; ++k)
+			CHECK(ring.allocate(list, block_size, offset));
+
+		// Released without a submission, so all blocks can be handed out again right away
+		ring.release(list);
+	}
+
+	CHECK(fence.num_waits == 0);
+}
+
+static void check_bundle_tagged_by_executing_list()
+{
+	fake_fence fence;
+	ring_type ring(ring_size);
+
+	// Bundles are never submitted, so the command list executing them tags their blocks on its submission
+	ring_type::block_list bundle;
+	uint32_t bundle_offset = 0;
+	CHECK(ring.allocate(bundle, num_blocks * block_size, bundle_offset));
+
+	ring_type::block_list direct_list;
+	const uint64_t fence_value = fence.signal();
+	ring.submit(direct_list, &fence, fence_value);
+	ring.submit(bundle, &fence, fence_value);
+
+	ring.release(direct_list);
+	ring.release(bundle);
+
+	ring_type::block_list list;
+	uint32_t offset = 0;
+	CHECK(ring.allocate(list, 1, offset));
+	CHECK_MESSAGE(fence.num_waits == 1, "blocks of the bundle were reused before the submission executing it completed");
+
+	ring.release(list);
+}
+
+static void check_concurrent_command_lists()
+{
+	constexpr int num_threads = 4;
+	constexpr int num_submissions = 5000;
+
+	fake_fence fence;
+	ring_type ring(ring_size * 4);
+
+	// Fence value of the last submission that used each descriptor, which has to be complete before it is handed out again
+	std::vector<std::atomic<uint64_t>> last_used_by(ring_size * 4);
+
+	std::atomic<bool> stop_gpu = false;
+	std::atomic<uint32_t> num_overlaps = 0;
+	std::atomic<uint32_t> num_failed_allocations = 0;
+
+	// Simulated GPU that completes submissions with some delay
+	std::thread gpu([&fence, &stop_gpu]() {
+		while (!stop_gpu)
+		{
+			fence.complete(fence.signaled.load() > 2 ? fence.signaled.load() - 2 : 0);
+			std::this_thread::yield();
+		}
+	});
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < num_threads; ++t)
+	{
+		threads.emplace_back([&, t]() {
+			std::mt19937 rng(t);
+			ring_type::block_list list;
+			std::vector<std::pair<uint32_t, uint32_t>> allocations;
+
+			for (int s = 0; s < num_submissions; ++s)
+			{
+				allocations.clear();
+
+				for (uint32_t i = 0, num_allocations = 1 + rng() % 4; i < num_allocations; ++i)
+				{
+					const uint32_t count = 1 + rng() % (2 * block_size);
+
+					uint32_t offset = 0;
+					if (!ring.allocate(list, count, offset))
+					{
+						num_failed_allocations++;
+						continue;
+					}
+
+					for (uint32_t k = offset; k < offset + count; ++k)
+						if (last_used_by[k].load(std::memory_order_acquire) > fence.completed_value())
+							num_overlaps++;
+
+					allocations.emplace_back(offset, count);
+				}
+
+				const uint64_t fence_value = fence.signal();
+				for (const std::pair<uint32_t, uint32_t> &allocation : allocations)
+					for (uint32_t k = allocation.first; k < allocation.first + allocation.second; ++k)
+						last_used_by[k].store(fence_value, std::memory_order_release);
+
+				// Alternate between submitting and resetting without submitting, like command lists that are recorded but discarded
+				if (s % 4 != 3)
+					ring.submit(list, &fence, fence_value);
+				else
+					for (const std::pair<uint32_t, uint32_t> &allocation : allocations)
+						for (uint32_t k = allocation.first; k < allocation.first + allocation.second; ++k)
+							last_used_by[k].store(0, std::memory_order_release);
+
+				ring.release(list);
+			}
+		});
+	}
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	stop_gpu = true;
+	gpu.join();
+
+	CHECK_MESSAGE(num_overlaps == 0, "%u descriptors were handed out while still in use by a submission that did not complete", num_overlaps.load());
+	CHECK_MESSAGE(num_failed_allocations == 0, "%u allocations failed", num_failed_allocations.load());
+
+	std::printf("Recorded %d submissions on %d threads, waited on the fence %u times.\n", num_threads * num_submissions, num_threads, fence.num_waits.load());
+}
+
+int main()
+{
+	check_reuse_after_fence();
+	check_unsubmitted_blocks_are_reused_immediately();
+	check_bundle_tagged_by_executing_list();
+	check_concurrent_command_lists();
+
+	return test::exit_code("All transient descriptor ring checks passed.");
+}